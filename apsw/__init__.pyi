@@ -4,6 +4,8 @@ import sys
 from typing import Optional, Callable, Any, Iterator, Iterable, Sequence, Literal, final, Protocol, TypeAlias
 from collections.abc import Mapping
 import array
+import concurrent.futures
+import mmap
 import types
 
 SQLiteValue = None | int | float | bytes | str
@@ -32,6 +34,18 @@ class AggregateClass(Protocol):
         ...
 
 
+class AggregateBatchClass(Protocol):
+    "Represents a running aggregate function registered with a batch_size"
+
+    def step_batch(self, columns: tuple[array.array | list[SQLiteValue], ...]) -> None:
+        "Called with each argument's values from a batch of matching rows"
+        ...
+
+    def final(self) -> SQLiteValue:
+        "Called after all matching rows have been processed to get the final value"
+        ...
+
+
 # Neither TypeVar nor ParamSpec work, when either should
 AggregateT = Any
 "An object provided as first parameter of step and final aggregate functions"
@@ -51,7 +65,7 @@ AggregateStep = (
 AggregateFinal = Callable[[AggregateT], SQLiteValue]
 "Final is called after all matching rows have been processed by step, and returns a SQLiteValue"
 
-AggregateFactory = Callable[[], AggregateClass | tuple[AggregateT, AggregateStep, AggregateFinal]]
+AggregateFactory = Callable[[], AggregateClass | AggregateBatchClass | tuple[AggregateT, AggregateStep, AggregateFinal]]
 """Called each time for the start of a new calculation using an aggregate function,
 returning an object, a step function and a final function"""
 
@@ -143,6 +157,34 @@ CommitHook = Callable[[], bool]
 """Commit hook is called with no arguments and should return True to abort the commit and False
 to let it continue"""
 
+UpdateHook = Callable[[int, str, str, int], None] | Callable[[list[tuple[int, str, str, int]]], None]
+"""Update hook is called with the operation, database name, table name, and rowid.  When batching
+it is instead called with a list of those as tuples"""
+
+
+class BlobSink(Protocol):
+    "Where :meth:`Blob.copy_to` writes, such as a file opened in binary mode"
+
+    def write(self, data: memoryview, /) -> Any:
+        "Called with each chunk of the blob, and must write all of it"
+        ...
+
+
+class BlobSource(Protocol):
+    "What :meth:`Blob.copy_from` reads, such as a file opened in binary mode"
+
+    def readinto(self, buffer: memoryview, /) -> int:
+        "Fills the buffer returning how many bytes were filled, with zero meaning there is no more"
+        ...
+
+
+ChangesetInput = bytes | Callable[[int], bytes]
+"""A changeset as bytes (or anything supporting the buffer protocol), or a function called with the
+maximum number of bytes wanted, returning at most that many and empty bytes at the end"""
+
+SessionStreamOutput = Callable[[memoryview], None]
+"""Called with each chunk of streamed session output.  The memoryview is only valid during the call"""
+
 SQLITE_VERSION_NUMBER: int
 """The integer version number of SQLite that APSW was compiled
 against.  For example SQLite 3.44.1 will have the value *3440100*.
@@ -205,6 +247,11 @@ def config(op: int, *args: Any) -> None:
     Some operations don't make sense from a Python program.  All the
     remaining are supported.
 
+    Memory for `SQLITE_CONFIG_PAGECACHE
+    <https://sqlite.org/c3ref/c_config_chunkalloc.html#sqliteconfigpagecache>`__
+    is allocated by SQLite, so only the size and count are given.  See
+    :ref:`memory` for suggested settings.
+
     Calls: `sqlite3_config <https://sqlite.org/c3ref/config.html>`__"""
     ...
 
@@ -513,6 +560,14 @@ def vfs_names() -> list[str]:
 
 vfsnames = vfs_names ## OLD-NAME
 
+def whole_row_fetch(value: bool) -> bool:
+    """Sets the default for :attr:`Connection.whole_row_fetch` used by
+    connections opened after this call.  Existing connections are not
+    changed.
+
+    The previous value is returned."""
+    ...
+
 @final
 class Backup:
     """You create a backup instance by calling :meth:`Connection.backup`."""
@@ -567,6 +622,52 @@ class Backup:
 
     Calls: `sqlite3_backup_remaining <https://sqlite.org/c3ref/backup_finish.html#sqlite3backupremaining>`__"""
 
+    def run(self, pages_per_step: int = 100, sleep_ms: int = 10, progress: Optional[Callable[[int, int], None]] = None, *, progress_interval_ms: int = 100, busy_timeout_ms: int = 60000) -> concurrent.futures.Future[int]:
+        """Copies all the pages in a background thread, returning a
+        :class:`concurrent.futures.Future` that completes with the
+        number of pages copied, or the exception.  The GIL is only
+        acquired to call *progress*, so the copy does not hold up Python
+        or your other threads.
+
+        The backup is not used from Python until the future completes.
+        Calling methods on it meanwhile gives a
+        :exc:`ThreadingViolationError`.  You still need to call
+        :meth:`finish` afterwards so that the copy takes effect.
+
+        .. code-block:: python
+
+          with destination.backup("main", source, "main") as backup:
+              # in asyncio use: await asyncio.wrap_future(backup.run())
+              backup.run(progress=lambda remaining, total: print(remaining, total)).result()
+
+        :param pages_per_step: How many pages to copy in each
+           :meth:`step`.  The source database is only locked during each
+           step.
+        :param sleep_ms: How long to sleep between steps so that other
+           connections can use the source database.
+        :param progress: Called with the :attr:`remaining` and
+           :attr:`page_count`.  It is called at most once every
+           *progress_interval_ms* milliseconds, and once more when the
+           copy is complete.   If it raises an exception then the copy
+           stops, and the future has the exception.
+        :param progress_interval_ms: The minimum time between calls to
+           *progress*
+        :param busy_timeout_ms: How long to keep retrying while the source
+           database is busy or locked, after which the future has the
+           :exc:`BusyError` or :exc:`LockedError`
+
+        If the source database is busy or locked then the step is retried
+        after sleeping, doubling the sleep each consecutive time up to a
+        second.  The future can't be cancelled once the copy has started,
+        so *busy_timeout_ms* is what stops it waiting forever for another
+        connection to release its lock.
+
+        Calls:
+          * `sqlite3_backup_step <https://sqlite.org/c3ref/backup_finish.html#sqlite3backupstep>`__
+          * `sqlite3_backup_remaining <https://sqlite.org/c3ref/backup_finish.html#sqlite3backupremaining>`__
+          * `sqlite3_backup_pagecount <https://sqlite.org/c3ref/backup_finish.html#sqlite3backuppagecount>`__"""
+        ...
+
     def step(self, npages: int = -1) -> bool:
         """Copies *npages* pages from the source to destination database.  The source database is locked during the copy so
         using smaller values allows other access to the source database.  The destination database is always locked until the
@@ -584,6 +685,33 @@ class Backup:
         Calls: `sqlite3_backup_step <https://sqlite.org/c3ref/backup_finish.html#sqlite3backupstep>`__"""
         ...
 
+@final
+class BlobView:
+    """A read only view of a blob value in the current row of a
+    :class:`Cursor`, returned instead of :class:`bytes` when
+    :attr:`Cursor.blob_views` is True.  It supports the buffer protocol
+    so it can be passed to :class:`memoryview`, :mod:`hashlib`,
+    :mod:`zlib`, file writes etc without any copying.
+
+    The memory belongs to SQLite and is only valid until the cursor
+    moves to another row.  After that any access raises
+    :exc:`ValueError`.  The cursor won't move or be closed while there
+    are exported buffers (for example a :class:`memoryview` that hasn't
+    been released) and raises :exc:`BufferError`.  That includes closing
+    with force, and :meth:`Connection.close` with force which closes
+    the cursor."""
+    def __len__(self) -> int:
+        """Size of the blob in bytes"""
+        ...
+
+    def tobytes(self) -> bytes:
+        """Returns a copy of the value"""
+        ...
+
+    valid: bool
+    """False once the cursor has moved on from the row this value
+    was in."""
+
 @final
 class Blob:
     """This object is created by :meth:`Connection.blob_open` and provides
@@ -620,6 +748,53 @@ class Blob:
         Calls: `sqlite3_blob_close <https://sqlite.org/c3ref/blob_close.html>`__"""
         ...
 
+    def copy_from(self, source: int | BlobSource, length: int = -1, chunk_size: int = 1048576) -> int:
+        """Copies data from *source* into the blob at the current position
+        until the source has no more, advancing the position, and returns
+        how many bytes were copied.  This is much faster than calling
+        :meth:`write` in a loop.
+
+        :param source: An open file descriptor, which is read with the GIL
+            released.  On platforms other than Windows this can be a socket.
+            Otherwise an object whose ``readinto`` method is called with a
+            :class:`memoryview` to fill, which is only valid during the call.
+            It returns how many bytes it filled, with zero meaning there is
+            no more.
+        :param length: The most bytes to copy, with negative numbers meaning
+            up to the end of the blob.  It is limited to the end of the blob.
+        :param chunk_size: How many bytes are read and then written to the
+            blob at a time.
+
+        No more than *length* bytes are read from *source*, so anything
+        after remains to be read.  If an exception occurs the position is
+        after what was copied.
+
+        Calls: `sqlite3_blob_write <https://sqlite.org/c3ref/blob_write.html>`__"""
+        ...
+
+    def copy_to(self, destination: int | BlobSink, length: int = -1, chunk_size: int = 1048576) -> int:
+        """Copies the blob from the current position to *destination*,
+        advancing the position, and returns how many bytes were copied.
+        This is much faster than calling :meth:`read` in a loop.
+
+        :param destination: An open file descriptor, which is written with
+            the GIL released.  On platforms other than Windows this can be a
+            socket.  Otherwise an object whose ``write`` method is called with
+            a :class:`memoryview` of each chunk, which is only valid during
+            the call.  Flush any Python buffering around a descriptor first.
+        :param length: How many bytes to copy, with negative numbers meaning
+            all remaining data.  It is limited to the end of the blob.
+        :param chunk_size: How many bytes are read from the blob and then
+            written at a time.
+
+        Writing to a descriptor continues until all of each chunk has been
+        written.  A ``write`` method must write all the data it is given, as
+        buffered files do.  If an exception occurs the position is after
+        what was copied.
+
+        Calls: `sqlite3_blob_read <https://sqlite.org/c3ref/blob_read.html>`__"""
+        ...
+
     def __enter__(self) -> Blob:
         """You can use a blob as a `context manager
         <https://docs.python.org/3/reference/datamodel.html#with-statement-context-managers>`_
@@ -685,6 +860,20 @@ class Blob:
         Calls: `sqlite3_blob_reopen <https://sqlite.org/c3ref/blob_reopen.html>`__"""
         ...
 
+    def reopen_each(self, rowids: Iterable[int]) -> Iterator[int]:
+        """Returns an iterator that :meth:`reopens <reopen>` this blob on each
+        rowid from *rowids* in turn, returning the rowid.  One blob can then
+        work through many rows, such as serving stored files.
+
+        .. code-block:: python
+
+          with connection.blob_open("main", "media", "content", first, False) as blob:
+              for rowid in blob.reopen_each(rowids):
+                  blob.copy_to(sock.fileno())
+
+        Calls: `sqlite3_blob_reopen <https://sqlite.org/c3ref/blob_reopen.html>`__"""
+        ...
+
     def seek(self, offset: int, whence: int = 0) -> None:
         """Changes current position to *offset* biased by *whence*.
 
@@ -714,6 +903,244 @@ class Blob:
         Calls: `sqlite3_blob_write <https://sqlite.org/c3ref/blob_write.html>`__"""
         ...
 
+@final
+class ChangesetBuilder:
+    """Combines any number of changesets (or patchsets) into one with
+    their net effect, such as to send a replica one changeset covering
+    a period of time.  Wraps a `sqlite3_changegroup
+    <https://www.sqlite.org/session/changegroup.html>`__."""
+    def add(self, changeset: ChangesetInput) -> None:
+        """Adds the changes, combining them with those already added.  All
+        the changesets added must be changesets, or all must be patchsets.
+
+        Calls:
+          * `sqlite3changegroup_add <https://sqlite.org/session/sqlite3changegroup_add.html>`__
+          * `sqlite3changegroup_add_strm <https://sqlite.org/session/sqlite3changegroup_add_strm.html>`__"""
+        ...
+
+    def close(self) -> None:
+        """Releases the memory used.  It is also released when the builder is
+        garbage collected.
+
+        Calls: `sqlite3changegroup_delete <https://sqlite.org/session/sqlite3changegroup_delete.html>`__"""
+        ...
+
+    def output(self) -> bytes:
+        """Returns the combined changeset.
+
+        Calls: `sqlite3changegroup_output <https://sqlite.org/session/sqlite3changegroup_output.html>`__"""
+        ...
+
+    def output_stream(self, output: SessionStreamOutput) -> None:
+        """Provides the combined changeset in chunks to *output*.
+
+        Calls: `sqlite3changegroup_output_strm <https://sqlite.org/session/sqlite3changegroup_output_strm.html>`__"""
+        ...
+
+@final
+class Changeset:
+    """A changeset or patchset, from :class:`bytes` (or anything supporting
+    the buffer protocol), or a function providing it in chunks as
+    described in :ref:`streaming <session>`.  A function can only be
+    read once, so only one operation can be done with it."""
+    def apply(self, db: Connection, *, filter: Optional[Callable[[str], bool]] = None, conflict: Optional[Callable[[int, TableChange], int]] = None, flags: int = 0) -> None:
+        """Applies the changes to the ``main`` database of *db*, all inside a
+        savepoint so either all or none of them are made.  That includes
+        when *filter* or *conflict* raise an exception.
+
+        :param filter: Called with each table name, returning True if
+           changes to it should be applied.  All tables are applied if
+           None.
+        :param conflict: Called when a change can't be applied cleanly,
+           with the conflict type (such as ``SQLITE_CHANGESET_DATA``) and
+           a :class:`TableChange`.  It returns ``SQLITE_CHANGESET_OMIT`` to
+           skip the change, ``SQLITE_CHANGESET_REPLACE`` to apply it anyway,
+           or ``SQLITE_CHANGESET_ABORT`` to undo all the changes and raise
+           :exc:`AbortError`.  If None then every conflict aborts.
+        :param flags: ``SQLITE_CHANGESETAPPLY_`` constants such as
+           ``SQLITE_CHANGESETAPPLY_NOSAVEPOINT``
+
+        Calls:
+          * `sqlite3changeset_apply_v2 <https://sqlite.org/session/sqlite3changeset_apply_v2.html>`__
+          * `sqlite3changeset_apply_v2_strm <https://sqlite.org/session/sqlite3changeset_apply_v2_strm.html>`__"""
+        ...
+
+    def concat(self, other: ChangesetInput) -> bytes:
+        """Returns a changeset with the effect of this one followed by *other*.
+        Use :class:`ChangesetBuilder` to combine more than two.
+
+        Calls:
+          * `sqlite3changeset_concat <https://sqlite.org/session/sqlite3changeset_concat.html>`__
+          * `sqlite3changeset_concat_strm <https://sqlite.org/session/sqlite3changeset_concat_strm.html>`__"""
+        ...
+
+    def concat_stream(self, other: ChangesetInput, output: SessionStreamOutput) -> None:
+        """Provides a changeset with the effect of this one followed by
+        *other* in chunks to *output*.
+
+        Calls: `sqlite3changeset_concat_strm <https://sqlite.org/session/sqlite3changeset_concat_strm.html>`__"""
+        ...
+
+    def __init__(self, changeset: ChangesetInput):
+        """:param changeset: The changeset as bytes, or a function returning
+           chunks of it"""
+        ...
+
+    def invert(self) -> bytes:
+        """Returns the changeset that undoes this one.  Patchsets can't be
+        inverted.
+
+        Calls:
+          * `sqlite3changeset_invert <https://sqlite.org/session/sqlite3changeset_invert.html>`__
+          * `sqlite3changeset_invert_strm <https://sqlite.org/session/sqlite3changeset_invert_strm.html>`__"""
+        ...
+
+    def invert_stream(self, output: SessionStreamOutput) -> None:
+        """Provides the changeset that undoes this one in chunks to *output*.
+
+        Calls: `sqlite3changeset_invert_strm <https://sqlite.org/session/sqlite3changeset_invert_strm.html>`__"""
+        ...
+
+    def __iter__(self) -> Iterator[TableChange]:
+        """Iterates over each change.  Each :class:`TableChange` is only valid
+        until the next one.
+
+        Calls:
+          * `sqlite3changeset_start <https://sqlite.org/session/sqlite3changeset_start.html>`__
+          * `sqlite3changeset_start_strm <https://sqlite.org/session/sqlite3changeset_start_strm.html>`__"""
+        ...
+
+@final
+class ConnectionPool:
+    """Provides :class:`Connection` from a pool, opening new ones as needed
+    up to a maximum size."""
+    def acquire(self, timeout: int = -1) -> Connection:
+        """Returns a connection from the pool for your exclusive use until you
+        :meth:`~ConnectionPool.release` it.
+
+        An idle connection is used if available, preferring the one last
+        used by this thread.  Otherwise a new connection is opened if the
+        pool is below its maximum size, or else this waits for a connection
+        to be released.
+
+        :param timeout: Maximum milliseconds to wait.  Negative waits
+           forever, and zero doesn't wait at all.
+
+        :raises TimeoutError: No connection became available in time"""
+        ...
+
+    def close(self) -> None:
+        """Closes idle connections, and wakes waiting threads which get
+        :exc:`ConnectionClosedError`.  Connections that are currently
+        acquired are closed when they are released.  It is safe to call
+        this method multiple times."""
+        ...
+
+    def __init__(self, filename: str, flags: int = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, vfs: Optional[str] = None, statementcachesize: int = 100, size: int = 8, setup: Optional[Callable[[Connection], None]] = None):
+        """The first four parameters are passed to :class:`Connection` when
+        opening each connection.
+
+        :param size: Maximum number of connections open at once
+        :param setup: Called with each newly opened connection, for example
+           to set pragmas or register functions.  If it raises an exception
+           then the connection is closed and the exception is raised by
+           :meth:`~ConnectionPool.acquire`."""
+        ...
+
+    def parallel_execute(self, queries: Iterable[str | tuple[str, Optional[Bindings]]], timeout: int = -1) -> list[list[Any]]:
+        """Runs read only queries at the same time on connections from the
+        pool, returning a list of each query's rows in the same order as
+        *queries*.  Each query is either a string, or a tuple of the string
+        and its bindings.
+
+        .. code-block:: python
+
+          orders, customers = pool.parallel_execute([
+              ("select * from orders where placed > ?", (yesterday,)),
+              "select count(*) from customers",
+          ])
+
+        The first connection is acquired waiting up to *timeout*
+        milliseconds, and then as many more as are available without
+        waiting.  The queries are divided between the connections, each
+        running its share in its own thread with the GIL released so that
+        multiple cores are used.  Once all the queries have finished the
+        rows are converted to Python objects, calling the connection's
+        :attr:`~Connection.row_trace` if set, and the connections are
+        released back to the pool.
+
+        The database should be in `WAL mode <https://sqlite.org/wal.html>`__
+        so that the readers don't block each other.  Functions you have
+        registered with the connections are called in the worker threads.
+
+        :raises TimeoutError: No connection became available in time
+        :raises ValueError: A query has more than one statement or is not
+          read only
+
+        Calls:
+          * `sqlite3_stmt_readonly <https://sqlite.org/c3ref/stmt_readonly.html>`__
+          * `sqlite3_step <https://sqlite.org/c3ref/step.html>`__"""
+        ...
+
+    def release(self, connection: Connection) -> None:
+        """Returns a connection obtained from :meth:`~ConnectionPool.acquire`
+        to the pool.  Any open transaction is rolled back.  If you closed the
+        connection, or the pool has been closed, then it is discarded
+        instead.
+
+        :raises ValueError: The connection is not currently acquired from
+          this pool"""
+        ...
+
+    def release_idle(self, min_idle: int = 0) -> int:
+        """Writes out dirty pages (`sqlite3_db_cacheflush
+        <https://sqlite.org/c3ref/db_cacheflush.html>`__) and frees as much
+        memory as possible (`sqlite3_db_release_memory
+        <https://sqlite.org/c3ref/db_release_memory.html>`__) for
+        connections that have been idle in the pool for at least *min_idle*
+        milliseconds.  The connections (and their statement caches) remain
+        open.  You could call this periodically.
+
+        :returns: How many connections were processed"""
+        ...
+
+    def stats(self) -> dict[str, int | float]:
+        """Returns information about the pool.
+
+        .. list-table::
+          :header-rows: 1
+          :widths: auto
+
+          * - Key
+            - Explanation
+          * - size
+            - Maximum number of connections
+          * - open
+            - Connections currently open (including being opened)
+          * - idle
+            - Open connections not currently acquired
+          * - waiting
+            - Threads currently waiting in :meth:`~ConnectionPool.acquire`
+          * - opened
+            - How many connections have been opened
+          * - checkouts
+            - How many times :meth:`~ConnectionPool.acquire` succeeded
+          * - affinity_hits
+            - How many of those returned the connection the thread used last
+          * - waits
+            - How many times :meth:`~ConnectionPool.acquire` had to wait
+          * - timeouts
+            - How many times :meth:`~ConnectionPool.acquire` timed out
+          * - checkout_time
+            - Total seconds spent in successful :meth:`~ConnectionPool.acquire`
+          * - max_checkout_time
+            - Longest successful :meth:`~ConnectionPool.acquire` in seconds
+          * - wait_time
+            - Total seconds spent waiting for a connection
+          * - max_wait_time
+            - Longest wait for a connection in seconds"""
+        ...
+
 class Connection:
     """This object wraps a `sqlite3 pointer
     <https://sqlite.org/c3ref/sqlite3.html>`_."""
@@ -849,6 +1276,13 @@ class Connection:
               in the misses count.
           * - max_cacheable_bytes
             - Maximum size of query (in bytes of utf8) that will be considered for caching
+          * - prepare_time
+            - Total seconds spent preparing statements, whether cached or not
+          * - recycle_hits
+            - Statement bookkeeping memory reused from the connection's
+              recycle bin
+          * - recycle_misses
+            - Statement bookkeeping memory that had to be allocated
           * - entries
             - (Only present if `include_entries` is True) A list of the cache entries
 
@@ -870,9 +1304,46 @@ class Connection:
               if >= 0
           * - uses
             - How many times this entry has been (re)used
+          * - prepare_time
+            - Seconds it took to prepare this entry
+          * - priority
+            - Eviction priority.  The entry with the lowest value is discarded
+              next when space is needed
           * - has_more
             - Boolean indicating if there was more query text than
-              the first statement"""
+              the first statement
+          * - fullscan_steps
+            - How many times SQLite stepped forward in a table as part of a full table scan
+          * - sorts
+            - How many sort operations have occurred
+          * - autoindexes
+            - How many rows were inserted into transient indices that were
+              automatically created to help joins run faster
+          * - vm_steps
+            - How many virtual machine operations were run
+          * - reprepares
+            - How many times the statement was automatically regenerated due to
+              schema changes
+          * - runs
+            - How many times the statement has been run
+          * - memory_used
+            - Approximate bytes of heap memory used to store the statement
+          * - rows
+            - Result rows returned while :attr:`profile_statements` is on
+          * - step_time
+            - Seconds spent in SQLite evaluating the statement while
+              :attr:`profile_statements` is on
+          * - convert_time
+            - Seconds spent converting result values into Python objects
+              while :attr:`profile_statements` is on
+
+        The counters from `sqlite3_stmt_status
+        <https://sqlite.org/c3ref/stmt_status.html>`__ (fullscan_steps through
+        memory_used) are always gathered by SQLite, and cover every use of the
+        cache entry.  Statements that are currently executing are not in the
+        cache and so are not included.
+
+        Calls: `sqlite3_stmt_status <https://sqlite.org/c3ref/stmt_status.html>`__"""
         ...
 
     def changes(self) -> int:
@@ -964,10 +1435,17 @@ class Connection:
         A parameter of zero would turn it off, 1 turns on, and negative
         leaves unaltered.  The effective value is always returned.
 
+        `SQLITE_DBCONFIG_LOOKASIDE
+        <https://sqlite.org/c3ref/c_dbconfig_defensive.html#sqlitedbconfiglookaside>`__
+        takes the slot size and count, with SQLite allocating the memory,
+        and returns zero.  It raises :exc:`BusyError` if lookaside memory
+        is in use, so it is best done straight after opening.  See
+        :ref:`memory`.
+
         Calls: `sqlite3_db_config <https://sqlite.org/c3ref/db_config.html>`__"""
         ...
 
-    def create_aggregate_function(self, name: str, factory: Optional[AggregateFactory], numargs: int = -1, *, flags: int = 0) -> None:
+    def create_aggregate_function(self, name: str, factory: Optional[AggregateFactory], numargs: int = -1, *, flags: int = 0, batch_size: int = 0, arg_types: Optional[Sequence[type[int] | type[float] | type[str] | type[bytes] | None]] = None) -> None:
         """Registers an aggregate function.  Aggregate functions operate on all
         the relevant rows such as counting how many there are.
 
@@ -975,6 +1453,10 @@ class Connection:
         :param factory: The function that will be called.  Use None to delete the function.
         :param numargs: How many arguments the function takes, with -1 meaning any number
         :param flags: `Function flags <https://www.sqlite.org/c3ref/c_deterministic.html>`__
+        :param batch_size: When non-zero the rows are given to the step
+           function in batches of this many.  See below.
+        :param arg_types: Declares the type of each argument, with the same
+           meaning as in :meth:`create_scalar_function`.
 
         When a query starts, the *factory* will be called.  It can return an object
         with a *step* function called for each matching row, and a *final* function
@@ -997,6 +1479,31 @@ class Connection:
              exception was raised by the step function. This allows you to
              ensure any resources are cleaned up.
 
+        With *batch_size* the arguments are buffered, and *step_batch* (the
+        second tuple item for the non-class approach) is called with up to
+        *batch_size* rows at a time, and before *final* with any remaining
+        rows.  It is given a tuple with one item per argument, each containing
+        that argument for every row.  Arguments declared as :class:`int` or
+        :class:`float` in *arg_types* are :class:`array.array` of typecode
+        ``q`` or ``d``, which libraries like numpy can use without copying,
+        while other arguments are a :class:`list`.
+
+        .. code-block:: python
+
+          class Mean:
+              def __init__(self):
+                  self.total, self.count = 0.0, 0
+
+              def step_batch(self, columns):
+                  values = numpy.frombuffer(columns[0], dtype=numpy.float64)
+                  self.total += values.sum()
+                  self.count += len(values)
+
+              def final(self):
+                  return self.total / self.count if self.count else None
+
+          connection.create_aggregate_function("mean", Mean, batch_size=4096, arg_types=[float])
+
         .. note::
 
           You can register the same named function but with different
@@ -1045,7 +1552,7 @@ class Connection:
 
     createcollation = create_collation ## OLD-NAME
 
-    def create_module(self, name: str, datasource: Optional[VTModule], *, use_bestindex_object: bool = False, use_no_change: bool = False, iVersion: int = 1, eponymous: bool=False, eponymous_only: bool = False, read_only: bool = False) -> None:
+    def create_module(self, name: str, datasource: Optional[VTModule], *, use_bestindex_object: bool = False, use_no_change: bool = False, iVersion: int = 1, eponymous: bool=False, eponymous_only: bool = False, read_only: bool = False, cache_best_index: bool = False) -> None:
         """Registers a virtual table, or drops it if *datasource* is *None*.
         See :ref:`virtualtables` for details.
 
@@ -1057,6 +1564,14 @@ class Connection:
         :param eponymous: Configures module to be `eponymous <https://www.sqlite.org/vtab.html#eponymous_virtual_tables>`__
         :param eponymous_only: Configures module to be `eponymous only <https://www.sqlite.org/vtab.html#eponymous_only_virtual_tables>`__
         :param read_only: Leaves `sqlite3_module <https://www.sqlite.org/c3ref/module.html>`__ methods that involve writing and transactions as NULL
+        :param cache_best_index: Each table remembers the results of :meth:`~VTTable.BestIndex`
+            (or :meth:`~VTTable.BestIndexObject`) for the last 16 different sets of
+            constraints, order bys and columns used, and reuses them without calling your
+            method again.  Only use this if your results don't depend on anything else.
+            Results are not remembered if you looked at a
+            :meth:`constraint value <IndexInfo.get_aConstraint_rhs>`, a
+            :meth:`collation <IndexInfo.get_aConstraint_collation>`, or used
+            :meth:`IndexInfo.set_aConstraintUsage_in`.
 
         .. seealso::
 
@@ -1067,7 +1582,7 @@ class Connection:
 
     createmodule = create_module ## OLD-NAME
 
-    def create_scalar_function(self, name: str, callable: Optional[ScalarProtocol], numargs: int = -1, *, deterministic: bool = False, flags: int = 0) -> None:
+    def create_scalar_function(self, name: str, callable: Optional[ScalarProtocol], numargs: int = -1, *, deterministic: bool = False, flags: int = 0, arg_types: Optional[Sequence[type[int] | type[float] | type[str] | type[bytes] | None]] = None, return_type: Optional[type[int] | type[float] | type[str] | type[bytes]] = None) -> None:
         """Registers a scalar function.  Scalar functions operate on one set of parameters once.
 
         :param name: The string name of the function.  It should be less than 255 characters
@@ -1080,6 +1595,27 @@ class Connection:
                  function is not deterministic while one that returns the
                  length of a string is.
         :param flags: Additional `function flags <https://www.sqlite.org/c3ref/c_deterministic.html>`__
+        :param arg_types: Declares the type of each argument as :class:`int`,
+                 :class:`float`, :class:`str`, or :class:`bytes`, with None
+                 meaning any type.  *numargs* defaults to, and must match,
+                 the length.  Arguments are converted by SQLite to the
+                 declared type without checking their actual type, using
+                 `SQLite's rules <https://www.sqlite.org/c3ref/value_blob.html>`__,
+                 so for example a NULL declared as :class:`int` becomes
+                 ``0``.
+        :param return_type: Declares the type your function usually returns.
+                 Matching values are given straight to SQLite, while other
+                 values still work and take the normal path.
+
+        Using *arg_types* or *return_type* makes each call quicker, which
+        matters for functions called on millions of rows.  When you use them
+        and *callable* is a builtin known to always return the same result
+        for the same arguments, such as :func:`math.sqrt`, :func:`len`, or
+        :meth:`str.upper`, the function is also registered as deterministic.
+
+        .. code-block:: python
+
+          connection.create_scalar_function("name_length", len, arg_types=[str], return_type=int)
 
         .. note::
 
@@ -1270,6 +1806,42 @@ class Connection:
         rollback."""
         ...
 
+    def export_query(self, destination: int | str, query: str, *, format: str = "sql", table: str = "table", separator: str = ",", quoting: bool = True, header: bool = False) -> int:
+        """Writes the rows from *query* to *destination*, returning how many
+        rows were written.  Each value is formatted directly from SQLite
+        without making Python objects, and a background thread writes out
+        the previous block of output while the next is formatted, all
+        without holding the GIL.  This is considerably faster than
+        formatting rows in Python.
+
+        :param destination: A file name, which is created or truncated, or
+            an open file descriptor which is written at its current position
+            and left open.  Flush any Python buffering around a descriptor
+            first.
+        :param query: A single SQL statement that returns rows.  It does
+            not take bindings.
+        :param format: ``sql`` for each row as an ``INSERT`` statement in
+            the same syntax as :meth:`apsw.format_sql_value`, ``csv`` for
+            values separated by *separator*, or ``jsonl`` for `JSON lines
+            <https://jsonlines.org/>`__ where each row is an object keyed
+            by column name.
+        :param table: The table name used in ``sql`` format, quoted if
+            necessary.
+        :param separator: The single character between values in ``csv``.
+        :param quoting: If True then ``csv`` values containing *separator*,
+            double quotes, or newlines are in double quotes with double
+            quotes written twice.
+        :param header: If True then ``csv`` starts with a row of column
+            names.
+
+        All output is UTF-8 and each row ends with a newline.  ``csv`` writes
+        null as an empty value.  Blobs are base64 encoded in ``csv`` and
+        ``jsonl``.  Infinity is ``1e999`` in ``sql`` and ``jsonl``.
+
+        The output can be read back with :meth:`import_file`.  The
+        :ref:`shell <shell>` ``.dump`` command uses this."""
+        ...
+
     def file_control(self, dbname: str, op: int, pointer: int) -> bool:
         """Calls the :meth:`~VFSFile.xFileControl` method on the :ref:`VFS`
         implementing :class:`file access <VFSFile>` for the database.
@@ -1362,6 +1934,48 @@ class Connection:
 
     getrowtrace = get_row_trace ## OLD-NAME
 
+    def import_file(self, filename: str, table: str, *, format: str = "csv", separator: str = ",", quoting: bool = True, header: bool = False, commit_every: int = 0) -> int:
+        """Imports rows from a file into an existing *table*, returning how
+        many rows were inserted.  This is considerably faster than parsing
+        the file in Python and using :meth:`executemany`, and is usually
+        limited by how fast the file can be read.  A background thread reads
+        the file in large chunks while this thread parses the previous chunk
+        and inserts its rows with a single prepared statement, all without
+        holding the GIL.
+
+        :param filename: The file to read, which must be UTF-8.  A leading
+            byte order mark is skipped.
+        :param table: The table to insert into, which must already exist.
+        :param format: ``csv`` for each line being values separated by
+            *separator*, or ``jsonl`` for `JSON lines <https://jsonlines.org/>`__
+            where each line is an array of values in column order, or an
+            object keyed by column name.
+        :param separator: The single character between values in ``csv``.
+            For example use ``"\t"`` for tab separated values.
+        :param quoting: If True then ``csv`` values can be in double quotes,
+            which allows them to contain separators, newlines, and double
+            quotes written twice.  Use False when quotes have no special
+            meaning.
+        :param header: If True the first row is column names, and is not
+            imported.
+        :param commit_every: If non-zero the transaction is committed after
+            this many rows, and another started.  That keeps the journal
+            small for very large files, but if there is an error then the
+            rows already committed remain.  The default of zero imports
+            everything in one transaction, so nothing is imported if there
+            is an error.
+
+        All ``csv`` values are inserted as text, so use declared column
+        types for `type affinity <https://www.sqlite.org/datatype3.html#type_affinity>`__
+        to store numbers.  Blank lines are ignored.  :exc:`ValueError` is
+        raised if a row has the wrong number of values.
+
+        If a transaction is already in progress then a savepoint is used
+        instead and *commit_every* is ignored.
+
+        The :ref:`shell <shell>` ``.import`` command uses this."""
+        ...
+
     in_transaction: bool
     """True if currently in a transaction, else False
 
@@ -1377,7 +1991,7 @@ class Connection:
 
         :param statementcachesize: Use zero to disable the statement cache,
           or a number larger than the total distinct SQL statements you
-          execute frequently.
+          execute frequently.  The maximum is 4,096.
 
         Calls: `sqlite3_open_v2 <https://sqlite.org/c3ref/open.html>`__
 
@@ -1447,6 +2061,24 @@ class Connection:
 
     loadextension = load_extension ## OLD-NAME
 
+    def metadata_cache_clear(self) -> None:
+        """Discards results cached by :meth:`pragma` and :meth:`table_metadata`.
+
+        The cache is discarded automatically when the schema version of any
+        attached database changes, or databases are attached or detached.
+        You only need this if a pragma result depends on more than the
+        schema, or the schema version was changed with the `schema_version
+        pragma <https://sqlite.org/pragma.html#pragma_schema_version>`__."""
+        ...
+
+    named_rows: bool
+    """When True result rows are returned as :class:`Row`, which can also
+    be accessed by column name as an attribute or key, instead of
+    :class:`tuple`.  The column names are worked out once per prepared
+    statement, so this is considerably faster than using a
+    :attr:`row tracer <row_trace>` such as
+    :class:`apsw.ext.DataClassRowFactory`.  The default is False."""
+
     open_flags: int
     """The combination of :attr:`flags <apsw.mapping_open_flags>` used to open the database."""
 
@@ -1465,7 +2097,7 @@ class Connection:
 
     overloadfunction = overload_function ## OLD-NAME
 
-    def pragma(self, name: str, value: Optional[SQLiteValue] = None, *, schema: Optional[str] = None) -> Any:
+    def pragma(self, name: str, value: Optional[SQLiteValue] = None, *, schema: Optional[str] = None, cache: bool = False) -> Any:
         """Issues the pragma (with the value if supplied) and returns the result with
         :attr:`the least amount of structure <Cursor.get>`.  For example
         :code:`pragma("user_version")` will return just the number, while
@@ -1481,9 +2113,27 @@ class Connection:
         Use the `schema` parameter to run the pragma against a different
         attached database (eg ``temp``).
 
+        If `cache` is True then the result is kept and returned again
+        until the `schema version
+        <https://sqlite.org/pragma.html#pragma_schema_version>`__ of any
+        attached database changes.  This is only correct for pragmas whose
+        result depends solely on the schema such as ``table_info``,
+        ``table_xinfo``, ``index_list``, ``index_xinfo``, and
+        ``foreign_key_list``.  Results are not added to the cache while a
+        transaction is open.  See :meth:`metadata_cache_clear`.
+
         * :ref:`Example <example_pragma>`"""
         ...
 
+    profile_statements: bool
+    """When True each statement records the number of result rows, the
+    time spent in SQLite evaluating it, and the time spent converting its
+    result values into Python objects.  The totals are kept with each
+    :meth:`statement cache <cache_stats>` entry, so you can find the most
+    expensive queries without a :meth:`profile <set_profile>` callback.
+    The default is False, and the overhead when True is measuring the
+    time around each step."""
+
     def read(self, schema: str, which: int, offset: int, amount: int) -> tuple[bool, bytes]:
         """Invokes the underlying VFS method to read data from the database.  It
         is strongly recommended to read aligned complete pages, since that is
@@ -1516,6 +2166,53 @@ class Connection:
         Calls: `sqlite3_db_readonly <https://sqlite.org/c3ref/db_readonly.html>`__"""
         ...
 
+    def register_adapter(self, klass: type, callable: Optional[Callable[[Any], SQLiteValue]]) -> None:
+        """Registers a callable that converts values of type *klass* into one of
+        the :ref:`types SQLite supports <types>` when they are used as
+        bindings in this connection.  The lookup is by the
+        exact type, so subclasses need their own registration.  :class:`int`,
+        :class:`float`, :class:`str`, :class:`bytes`, and *None* are always
+        bound directly, with no lookup.  Use *None* as *callable* to remove
+        the registration.
+
+        The adapter can return any supported value, but that isn't adapted
+        again.
+
+        .. code-block:: python
+
+          connection.register_adapter(datetime.date, datetime.date.isoformat)
+
+        This is done in C without wrapping cursors or bindings, so is
+        considerably faster than
+        :class:`apsw.ext.TypesConverterCursorFactory`.
+
+        .. seealso::
+
+          * :meth:`register_converter`"""
+        ...
+
+    def register_converter(self, decltype: str, callable: Optional[Callable[[SQLiteValue], Any]]) -> None:
+        """Registers a callable that converts result values from columns
+        declared as *decltype* in the schema.  For example a table created
+        with ``CREATE TABLE events(happened DATE)`` has a declared type of
+        ``DATE`` for the ``happened`` column.  The match is exact, including
+        case, against `sqlite3_column_decltype
+        <https://sqlite.org/c3ref/column_decltype.html>`__, which is worked out
+        once per prepared statement.  The converter is not called for null
+        values.  Use *None* as *callable* to remove the registration.
+
+        .. code-block:: python
+
+          connection.register_converter("DATE", datetime.date.fromisoformat)
+
+        Only values from columns with a converter pay any cost.  Conversion
+        happens before any :attr:`row tracer <row_trace>` is called.
+
+        .. seealso::
+
+          * :meth:`register_adapter`"""
+        ...
+
     def release_memory(self) -> None:
         """Attempts to free as much heap memory as possible used by this connection.
 
@@ -1679,7 +2376,7 @@ class Connection:
 
     setrowtrace = set_row_trace ## OLD-NAME
 
-    def set_update_hook(self, callable: Optional[Callable[[int, str, str, int], None]]) -> None:
+    def set_update_hook(self, callable: Optional[UpdateHook], *, batch: int = 0) -> None:
         """Calls *callable* whenever a row is updated, deleted or inserted.  If
         *callable* is *None* then any existing update hook is
         unregistered.  The update hook cannot make changes to the database while
@@ -1697,6 +2394,26 @@ class Connection:
           rowid (int)
             The affected row
 
+        If *batch* is non-zero then the rows are held without calling Python,
+        and *callable* is called with one parameter - a list of tuples of
+        the 4 values above.  That happens when the transaction commits, and
+        when *batch* rows have been held in which case it is before the
+        outcome of the transaction is known.  Held rows are discarded if the
+        transaction rolls back.  An exception in *callable* at commit turns
+        the commit into a rollback.  This is considerably faster when many
+        rows change.  Rows are also discarded when the connection is
+        closed.  Rows held when the update hook is changed are given to the
+        existing *callable* after the new one is installed, with any
+        exception it raises coming from this method.
+
+        .. note::
+
+          Changes undone by a `ROLLBACK TO <https://sqlite.org/lang_savepoint.html>`__
+          or a single failed statement inside a transaction are not seen
+          by the rollback hook, so their rows are still delivered.  The
+          exception is a :meth:`with <__exit__>` block that rolls back,
+          which discards rows held since the block started.
+
         .. seealso::
 
             * :ref:`Example <example_update_hook>`
@@ -1767,6 +2484,19 @@ class Connection:
         Calls: `sqlite3_table_column_metadata <https://sqlite.org/c3ref/table_column_metadata.html>`__"""
         ...
 
+    def table_metadata(self, dbname: Optional[str], table_name: str) -> dict[str, tuple[str, str, bool, bool, bool]]:
+        """Returns :meth:`column_metadata` for every column of the table in one
+        call, as a dict keyed by column name in table order.
+
+        `dbname` is `main`, `temp`, the name in `ATTACH <https://sqlite.org/lang_attach.html>`__, or None to search
+        all databases.
+
+        The result is cached until the schema changes, the same as
+        :meth:`pragma` with *cache*.
+
+        Calls: `sqlite3_table_column_metadata <https://sqlite.org/c3ref/table_column_metadata.html>`__"""
+        ...
+
     def total_changes(self) -> int:
         """Returns the total number of database rows that have be modified,
         inserted, or deleted since the database connection was opened.
@@ -1874,6 +2604,37 @@ class Connection:
         Calls: `sqlite3_wal_checkpoint_v2 <https://sqlite.org/c3ref/wal_checkpoint_v2.html>`__"""
         ...
 
+    whole_row_fetch: bool
+    """Controls how result rows are read from SQLite.  The default (False)
+    releases the Python Global Interpreter Lock (GIL) around reading
+    each value from SQLite.  When True the GIL is released once to read
+    all the values of a row, and then held while converting them to
+    Python objects.  That is considerably faster in multi-threaded
+    programs where the GIL is contended.
+
+    The initial value comes from :func:`apsw.whole_row_fetch`."""
+
+    zero_copy_bindings: bool
+    """Controls how :class:`str`, :class:`bytes`, and other buffer values
+    are bound to queries.  The default (False) has SQLite make its own
+    copy of each value.  When True SQLite uses the memory of the Python
+    object directly, which avoids doubling memory for large values.
+
+    SQLite can read a bound value at any point until the statement it
+    is bound to finishes.  That is when the cursor moves on to the next
+    statement in the query, to the next set of bindings in
+    :meth:`Cursor.executemany`, or when the cursor is reset because the
+    results were exhausted, an error occurred, another query was
+    executed, or the cursor was closed.  The cursor keeps a reference to
+    each bound object (and holds the buffer export for buffers) until
+    then, so you don't have to keep them alive yourself.
+
+    .. note::
+
+      Buffers such as :class:`bytearray` can't be resized during that
+      time, but their contents can be changed and SQLite would then see
+      the new contents.  Don't modify them until the statement finishes."""
+
 class Cursor:
     """"""
     bindings_count: int
@@ -1894,6 +2655,17 @@ class Cursor:
 
     Calls: `sqlite3_bind_parameter_name <https://sqlite.org/c3ref/bind_parameter_name.html>`__"""
 
+    blob_views: bool
+    """When True, blob values in rows are returned as :class:`BlobView`
+    which points directly at SQLite's memory for the value instead of
+    copying it into :class:`bytes`.  The views of a row become invalid
+    when the cursor moves on to the next row, so this is for iterating
+    over the cursor.  :meth:`fetchall` and :attr:`get` still return
+    :class:`bytes`.
+
+    This is useful when handing large blobs to code such as hashing and
+    compression that accepts a buffer."""
+
     def close(self, force: bool = False) -> None:
         """It is very unlikely you will need to call this method.
         Cursors are automatically garbage collected and when there
@@ -1992,7 +2764,15 @@ class Cursor:
 
         The return is the cursor itself which acts as an iterator.  Your
         statements can return data.  See :meth:`~Cursor.execute` for more
-        information, and the :ref:`example <example_executemany>`."""
+        information, and the :ref:`example <example_executemany>`.
+
+        When the statements are a single statement that doesn't return data
+        (for example an ``INSERT`` without ``RETURNING``), the statement is
+        prepared once and reused for all the bindings.  The types of the
+        values in each sequence of bindings are tracked, and when they are
+        the same exact types (:class:`int`, :class:`float`, :class:`str`,
+        :class:`bytes`, or None) as previous rows then binding and execution
+        of the row are done with a single release of the GIL."""
         ...
 
     expanded_sql: str
@@ -2019,6 +2799,65 @@ class Cursor:
         amount of structure to unpack."""
         ...
 
+    def fetchmany_columns(self, size: int = 1024) -> tuple[dict[str, Any], ...] | None:
+        """Returns up to *size* result rows laid out by column instead of by
+        row, or None if there are no more rows.  No per row tuples are
+        created, and integers and floats are not converted into Python
+        objects, making this considerably faster for large result sets.
+        The rows of each statement are gathered in one release of the GIL
+        into native memory, which is then copied once into the returned
+        buffers.  The buffers are in the layout used by `Apache Arrow
+        <https://arrow.apache.org/docs/format/Columnar.html>`__ so
+        libraries like numpy and pyarrow can use them without further
+        copying.
+
+        Rows are gathered until *size* is reached, the results are
+        exhausted, or the next row has a different number of columns
+        (such as the next of multiple statements) which is left for the
+        next call.
+
+        A tuple is returned with a dict for each column containing:
+
+        .. list-table::
+          :header-rows: 1
+          :widths: auto
+
+          * - Key
+            - Value
+          * - name
+            - Column name
+          * - type
+            - ``int``, ``float``, ``str``, ``bytes``, ``null`` if every row
+              is null, or ``object`` if rows have values of different types
+          * - rows
+            - Number of rows
+          * - null_count
+            - How many rows are null
+          * - valid
+            - :class:`bytes` bitmap with the bit set (least significant bit
+              first) for each row that is not null
+          * - values
+            - ``int`` and ``float`` are :class:`array.array` of typecode
+              ``q`` and ``d`` with zero for null rows.  ``str`` and
+              ``bytes`` are :class:`bytes` of the concatenated values, with
+              text in UTF-8.  ``object`` is a :class:`list` of the values.
+              ``null`` is None.
+          * - offsets
+            - For ``str`` and ``bytes`` an :class:`array.array` of typecode
+              ``q`` with rows + 1 entries.  A row's value is
+              ``values[offsets[row]:offsets[row+1]]``.  None for other types.
+
+        Row tracers are not called when using this method.
+
+        Calls:
+          * `sqlite3_column_type <https://sqlite.org/c3ref/column_blob.html>`__
+          * `sqlite3_column_int64 <https://sqlite.org/c3ref/column_blob.html>`__
+          * `sqlite3_column_double <https://sqlite.org/c3ref/column_blob.html>`__
+          * `sqlite3_column_text <https://sqlite.org/c3ref/column_blob.html>`__
+          * `sqlite3_column_blob <https://sqlite.org/c3ref/column_blob.html>`__
+          * `sqlite3_column_bytes <https://sqlite.org/c3ref/column_blob.html>`__"""
+        ...
+
     def fetchone(self) -> Optional[Any]:
         """Returns the next row of data or None if there are no more rows."""
         ...
@@ -2240,12 +3079,34 @@ class IndexInfo:
     idxStr: Optional[str]
     """Name used to identify the index"""
 
+    limit_constraint: int
+    """(Read-only) Which constraint is the usable `LIMIT
+    <https://sqlite.org/lang_select.html#limitoffset>`__, or -1 if there
+    isn't one.  If you set its :meth:`argvIndex
+    <IndexInfo.set_aConstraintUsage_argvIndex>` then
+    :meth:`VTCursor.Filter` gets the limit value, and you only need to
+    provide that many rows (after any offset).
+
+    SQLite only provides LIMIT (and OFFSET) when your table is the only
+    one in the query, and there are no constraints you haven't consumed.
+
+    .. code-block:: python
+
+      if index_info.limit_constraint >= 0:
+          index_info.set_aConstraintUsage_argvIndex(index_info.limit_constraint, 1)"""
+
     nConstraint: int
     """(Read-only) Number of constraint entries"""
 
     nOrderBy: int
     """(Read-only) Number of order by  entries"""
 
+    offset_constraint: int
+    """(Read-only) Which constraint is the usable OFFSET, or -1 if there
+    isn't one.  See :attr:`~IndexInfo.limit_constraint`.  If you use it
+    then also set its :meth:`omit <IndexInfo.set_aConstraintUsage_omit>`
+    so that SQLite doesn't skip the offset rows again."""
+
     orderByConsumed: bool
     """True if index output is already ordered"""
 
@@ -2264,6 +3125,202 @@ class IndexInfo:
         """Sets *omit* for *aConstraintUsage[which]*"""
         ...
 
+@final
+class Row:
+    """A result row returned instead of :class:`tuple` when
+    :attr:`Connection.named_rows` is True.  It behaves like a tuple of
+    the values (indexing, slicing, iteration, length, comparison with
+    tuples, hashing) and values can also be accessed by column name,
+    either as an attribute ``row.name`` or a key ``row["name"]``.  If
+    more than one column has the same name then the first is used.
+
+    The column names come from `sqlite3_column_name
+    <https://sqlite.org/c3ref/column_name.html>`__ and are worked out
+    once per prepared statement, shared by all its rows.  Column names
+    take precedence over the attributes and methods below, which
+    follow :func:`collections.namedtuple` naming.
+
+    .. code-block:: python
+
+      connection.named_rows = True
+      for row in connection.execute("select id, title from items"):
+          print(row.id, row["title"], row[1])"""
+    def _asdict(self) -> dict[str, SQLiteValue]:
+        """Returns a new :class:`dict` of column names to values"""
+        ...
+
+    _fields: tuple[str, ...]
+    """The column names"""
+
+    def __getattr__(self, name: str) -> SQLiteValue:
+        """Returns the value for a column name"""
+        ...
+
+    def __getitem__(self, key: int | slice | str) -> SQLiteValue | tuple[SQLiteValue, ...]:
+        """Returns the value at an index, a :class:`tuple` of values for a
+        slice, or the value for a column name.  Unknown column names raise
+        :exc:`KeyError`."""
+        ...
+
+    def __len__(self) -> int:
+        """Number of columns"""
+        ...
+
+@final
+class Session:
+    """Records changes made to tables in one database of a
+    :class:`Connection`.  Wraps a `sqlite3_session
+    <https://www.sqlite.org/session/session.html>`__."""
+    def attach(self, name: Optional[str] = None) -> None:
+        """Records changes to the named table, or all tables if *name* is None.
+
+        Calls: `sqlite3session_attach <https://sqlite.org/session/sqlite3session_attach.html>`__"""
+        ...
+
+    def changeset(self) -> bytes:
+        """Returns a changeset of all the recorded changes.  Rows changed
+        several times have one entry with the net effect.
+
+        Calls: `sqlite3session_changeset <https://sqlite.org/session/sqlite3session_changeset.html>`__"""
+        ...
+
+    def changeset_stream(self, output: SessionStreamOutput) -> None:
+        """Provides the changeset in chunks to *output*, without needing it
+        all in memory.
+
+        Calls: `sqlite3session_changeset_strm <https://sqlite.org/session/sqlite3session_changeset_strm.html>`__"""
+        ...
+
+    def close(self, force: bool = False) -> None:
+        """Ends the session.  It is also closed when the :class:`Connection`
+        is closed.  *force* is accepted for consistency with the other
+        close methods, as ending a session can't fail.
+
+        Calls: `sqlite3session_delete <https://sqlite.org/session/sqlite3session_delete.html>`__"""
+        ...
+
+    def diff(self, from_schema: str, table: str) -> None:
+        """Records the changes needed to make *table* in this session's
+        database the same as in *from_schema*, such as another attached
+        database.  The table must have the same columns and primary key in
+        both.
+
+        Calls: `sqlite3session_diff <https://sqlite.org/session/sqlite3session_diff.html>`__"""
+        ...
+
+    enabled: bool
+    """Changes are only recorded while the session is enabled, which it
+    is initially.
+
+    Calls: `sqlite3session_enable <https://sqlite.org/session/sqlite3session_enable.html>`__"""
+
+    indirect: bool
+    """Changes recorded while this is True are marked as
+    :attr:`indirect <TableChange.indirect>`.  It is initially False.
+
+    Calls: `sqlite3session_indirect <https://sqlite.org/session/sqlite3session_indirect.html>`__"""
+
+    def __init__(self, db: Connection, schema: str):
+        """Starts a session, which won't record anything until you
+        :meth:`attach` tables.
+
+        :param db: The connection, which must remain open.  Closing it
+           closes the session.
+        :param schema: `main`, `temp`, the name in `ATTACH <https://sqlite.org/lang_attach.html>`__
+
+        Calls: `sqlite3session_create <https://sqlite.org/session/sqlite3session_create.html>`__"""
+        ...
+
+    is_empty: bool
+    """True if no changes have been recorded
+
+    Calls: `sqlite3session_isempty <https://sqlite.org/session/sqlite3session_isempty.html>`__"""
+
+    memory_used: int
+    """Bytes of memory used by the session
+
+    Calls: `sqlite3session_memory_used <https://sqlite.org/session/sqlite3session_memory_used.html>`__"""
+
+    def patchset(self) -> bytes:
+        """Returns a patchset of all the recorded changes.  Patchsets are
+        smaller than changesets because updates only include changed
+        columns and deletes only include the primary key, but can't be
+        inverted and detect fewer conflicts.
+
+        Calls: `sqlite3session_patchset <https://sqlite.org/session/sqlite3session_patchset.html>`__"""
+        ...
+
+    def patchset_stream(self, output: SessionStreamOutput) -> None:
+        """Provides the patchset in chunks to *output*, without needing it
+        all in memory.
+
+        Calls: `sqlite3session_patchset_strm <https://sqlite.org/session/sqlite3session_patchset_strm.html>`__"""
+        ...
+
+    def table_filter(self, callback: Optional[Callable[[str], bool]]) -> None:
+        """When :meth:`attach` was called with None for all tables, the
+        *callback* is called with each table name the first time it is
+        changed, and returns True if changes should be recorded.
+
+        Calls: `sqlite3session_table_filter <https://sqlite.org/session/sqlite3session_table_filter.html>`__"""
+        ...
+
+@final
+class TableChange:
+    """Describes one change in a changeset, provided by iterating over a
+    :class:`Changeset` and to the conflict handler of
+    :meth:`Changeset.apply`.  It is only valid until the next change, or
+    the conflict handler returns, after which accessing it raises
+    :exc:`ValueError`.
+
+    Columns are in table order, and columns whose values are not part of
+    the change are :attr:`apsw.no_change`.  That happens for columns not
+    updated, and non primary key columns in patchsets."""
+    column_count: int
+    """Number of columns in the table"""
+
+    conflict: SQLiteValues | None
+    """In the conflict handler for ``SQLITE_CHANGESET_DATA`` and
+    ``SQLITE_CHANGESET_CONFLICT`` the current values of the conflicting
+    row in the database, otherwise None
+
+    Calls: `sqlite3changeset_conflict <https://sqlite.org/session/sqlite3changeset_conflict.html>`__"""
+
+    fk_conflicts: int | None
+    """In the conflict handler for ``SQLITE_CHANGESET_FOREIGN_KEY`` how
+    many foreign key constraints would be violated, otherwise None.  The
+    other attributes are not meaningful in that case.
+
+    Calls: `sqlite3changeset_fk_conflicts <https://sqlite.org/session/sqlite3changeset_fk_conflicts.html>`__"""
+
+    indirect: bool
+    """True if the change was made while the session was
+    :attr:`indirect <Session.indirect>`, such as by a trigger"""
+
+    name: str
+    """Name of the table"""
+
+    new: SQLiteValues | None
+    """Values after an ``UPDATE`` or ``INSERT``, and None for ``DELETE``
+
+    Calls: `sqlite3changeset_new <https://sqlite.org/session/sqlite3changeset_new.html>`__"""
+
+    old: SQLiteValues | None
+    """Values before an ``UPDATE`` or ``DELETE``, and None for ``INSERT``
+
+    Calls: `sqlite3changeset_old <https://sqlite.org/session/sqlite3changeset_old.html>`__"""
+
+    op: str
+    """The operation - ``INSERT``, ``UPDATE``, or ``DELETE``"""
+
+    opcode: int
+    """The operation as ``SQLITE_INSERT``, ``SQLITE_UPDATE``, or ``SQLITE_DELETE``"""
+
+    pk_columns: set[int]
+    """Which columns make up the primary key
+
+    Calls: `sqlite3changeset_pk <https://sqlite.org/session/sqlite3changeset_pk.html>`__"""
+
 @final
 class URIFilename:
     """SQLite packs `uri parameters
@@ -2429,6 +3486,28 @@ class VFSFile:
         someone else has locked it, then raise :exc:`BusyError`."""
         ...
 
+    def xMmap(self) -> Optional[mmap.mmap | bytes | bytearray | memoryview]:
+        """Override this to let SQLite access the file contents directly in
+        memory, when `memory mapped I/O <https://sqlite.org/mmap.html>`__
+        is enabled with a non-zero `mmap_size
+        <https://sqlite.org/pragma.html#pragma_mmap_size>`__.  Return an
+        object supporting the buffer protocol, such as :class:`mmap.mmap`,
+        covering the file contents from the start, or None to use
+        :meth:`xRead`.  This implementation returns None.
+
+        SQLite then reads pages by using pointers into the buffer instead
+        of calling :meth:`xRead`, except for pages beyond the end of the
+        buffer or the mmap_size.  The buffer is held (so an
+        :class:`mmap.mmap` can't be closed or resized) until SQLite no
+        longer needs it, such as when the file is truncated or closed.
+        If the file grows, xMmap is called again at the start of a
+        later transaction.
+
+        The buffer contents must always be the same as the file.  Writes
+        are still made via :meth:`xWrite`, so you should use a shared
+        mapping of the file so those writes are visible in it."""
+        ...
+
     def xRead(self, amount: int, offset: int) -> bytes:
         """Read the specified *amount* of data starting at *offset*. You
         should make every effort to read all the data requested, or return
@@ -2442,6 +3521,71 @@ class VFSFile:
         :param offset: Where to start reading."""
         ...
 
+    def xReadBatch(self, reads: list[tuple[int, int]]) -> list[bytes]:
+        """Does multiple reads in one call, with each item of *reads* being
+        ``(amount, offset)`` as for :meth:`xRead`.  You should return a
+        sequence of buffers (bytes etc) with one per read, each being
+        shorter than *amount* only at the end of the file.
+
+        This is used to fill the block cache for main database files
+        opened with the following `URI parameters <https://sqlite.org/uri.html>`__.
+        It is a good place to issue concurrent or combined requests, such
+        as a single multi-range HTTP request.  If xReadBatch isn't
+        available then :meth:`xReadInto` or :meth:`xRead` are called once
+        per read instead.
+
+        .. list-table::
+          :header-rows: 1
+          :widths: auto
+
+          * - Parameter
+            - Default
+            - Description
+          * - ``apsw_cache``
+            - ``0``
+            - How many blocks to cache.  Zero disables the cache.
+          * - ``apsw_cache_block``
+            - ``4096``
+            - Size of each block, which must be a power of two between
+              512 and 65536.  Using your database page size is best.
+          * - ``apsw_readahead``
+            - ``64``
+            - Maximum number of blocks to read ahead.  The read-ahead
+              starts at one block on the first sequential read, and doubles
+              on each sequential read after.
+
+        The cache is cleared at the start of each read transaction,
+        because another connection could have changed the file.  It is
+        kept across transactions with ``immutable=1`` because there is no
+        locking, and with ``pragma locking_mode=EXCLUSIVE``.  Writes
+        through the file discard the affected blocks.  :meth:`xFileSize` is
+        called once per transaction so read-ahead stops at the end of the
+        file."""
+        ...
+
+    def xReadInto(self, buffer: memoryview, offset: int) -> int:
+        """Optional alternative to :meth:`xRead` that reads directly into
+        SQLite's *buffer*, avoiding allocating and copying a bytes for
+        every read.  The *buffer* length is the amount to read.  It is
+        used instead of :meth:`xRead` when present on the file returned
+        from :meth:`VFS.xOpen`, unless it is this inherited
+        implementation while :meth:`xRead` has been overridden.
+
+        The *buffer* is only valid during the call, and is released
+        afterwards.  An error is reported if you still have exports
+        (eg a numpy array) from it.
+
+        When your class provides its own xReadInto, it is considered
+        buffer aware and :meth:`xWrite` will also be called with a
+        read only :class:`memoryview` instead of bytes, with the
+        same lifetime.
+
+        :param buffer: Writable memory to fill
+        :param offset: Where to start reading.
+        :returns: Number of bytes read which will be less than the buffer length
+          for a short read"""
+        ...
+
     def xSectorSize(self) -> int:
         """Return the native underlying sector size. SQLite uses the value
         returned in determining the default database page size. If you do
@@ -2474,6 +3618,9 @@ class VFSFile:
         underlying operating system to do a partial write. You will need to
         write the remaining data.
 
+        *data* is a :class:`memoryview` only valid during the call when
+        the file is buffer aware as described in :meth:`xReadInto`.
+
         :param offset: Where to start writing."""
         ...
 
@@ -2701,7 +3848,23 @@ class VTCursor(Protocol):
 
     The :class:`VTCursor` object is used for iterating over a table.
     There may be many cursors simultaneously so each one needs to keep
-    track of where in the table it is."""
+    track of where in the table it is.
+
+    Calling :meth:`~VTCursor.Eof`, :meth:`~VTCursor.Column` for each
+    column, and :meth:`~VTCursor.Next` means several Python calls for
+    every row.  If your cursor has a :meth:`~VTCursor.NextRows` or
+    :meth:`~VTCursor.NextColumns` method then it is used instead, with
+    each call returning multiple rows.  SQLite's requests for the end of
+    data, column values, and moving to the next row are answered from the
+    returned rows, only calling your method again once they have all been
+    used.
+
+    Columns past the end of a provided row (for example `hidden
+    <https://sqlite.org/vtab.html#hidden_columns_in_virtual_tables>`__
+    columns with the same value for every row) are requested by calling
+    :meth:`~VTCursor.Column` as normal.  The rowid is the number of rows
+    visited since :meth:`~VTCursor.Filter`, so don't use batches if rowid
+    values matter to you, or declare the table ``WITHOUT rowid``."""
     def Close(self) -> None:
         """This is the destructor for the cursor. Note that you must
         cleanup. The method will not be called again if you raise an
@@ -2771,6 +3934,21 @@ class VTCursor(Protocol):
         appropriate indexed and constrained row."""
         ...
 
+    def NextColumns(self) -> Optional[Sequence[Sequence[SQLiteValue]]]:
+        """Optional.  Like :meth:`~VTCursor.NextRows` except the result is a
+        sequence of columns, with each column being a sequence of values of
+        the same length such as a :class:`list` or :class:`array.array`."""
+        ...
+
+    def NextRows(self) -> Optional[Sequence[Sequence[SQLiteValue]]]:
+        """Optional.  Returns the next rows, with each row being a sequence of
+        column values.  Return None or an empty sequence when there are no
+        more rows.  It is called after :meth:`~VTCursor.Filter`, and then
+        each time the previous rows have been used.  :meth:`~VTCursor.Eof`,
+        :meth:`~VTCursor.Next` and :meth:`~VTCursor.Rowid` are then not
+        called."""
+        ...
+
     def Rowid(self) -> int:
         """Return the current rowid."""
         ...
@@ -3248,6 +4426,30 @@ SQLITE_CANTOPEN_NOTEMPDIR: int = 270
 """For `Extended Result Codes <https://sqlite.org/rescode.html>'__"""
 SQLITE_CANTOPEN_SYMLINK: int = 1550
 """For `Extended Result Codes <https://sqlite.org/rescode.html>'__"""
+SQLITE_CHANGESETAPPLY_FKNOACTION: int = 8
+"""For `Flags for sqlite3changeset_apply_v2 <https://sqlite.org/session/c_changesetapply_fknoaction.html>'__"""
+SQLITE_CHANGESETAPPLY_IGNORENOOP: int = 4
+"""For `Flags for sqlite3changeset_apply_v2 <https://sqlite.org/session/c_changesetapply_fknoaction.html>'__"""
+SQLITE_CHANGESETAPPLY_INVERT: int = 2
+"""For `Flags for sqlite3changeset_apply_v2 <https://sqlite.org/session/c_changesetapply_fknoaction.html>'__"""
+SQLITE_CHANGESETAPPLY_NOSAVEPOINT: int = 1
+"""For `Flags for sqlite3changeset_apply_v2 <https://sqlite.org/session/c_changesetapply_fknoaction.html>'__"""
+SQLITE_CHANGESET_ABORT: int = 2
+"""For `Constants Returned By The Conflict Handler <https://sqlite.org/session/c_changeset_abort.html>'__"""
+SQLITE_CHANGESET_CONFLICT: int = 3
+"""For `Constants Passed To The Conflict Handler <https://sqlite.org/session/c_changeset_conflict.html>'__"""
+SQLITE_CHANGESET_CONSTRAINT: int = 4
+"""For `Constants Passed To The Conflict Handler <https://sqlite.org/session/c_changeset_conflict.html>'__"""
+SQLITE_CHANGESET_DATA: int = 1
+"""For `Constants Passed To The Conflict Handler <https://sqlite.org/session/c_changeset_conflict.html>'__"""
+SQLITE_CHANGESET_FOREIGN_KEY: int = 5
+"""For `Constants Passed To The Conflict Handler <https://sqlite.org/session/c_changeset_conflict.html>'__"""
+SQLITE_CHANGESET_NOTFOUND: int = 2
+"""For `Constants Passed To The Conflict Handler <https://sqlite.org/session/c_changeset_conflict.html>'__"""
+SQLITE_CHANGESET_OMIT: int = 0
+"""For `Constants Returned By The Conflict Handler <https://sqlite.org/session/c_changeset_abort.html>'__"""
+SQLITE_CHANGESET_REPLACE: int = 1
+"""For `Constants Returned By The Conflict Handler <https://sqlite.org/session/c_changeset_abort.html>'__"""
 SQLITE_CHECKPOINT_FULL: int = 1
 """For `Checkpoint Mode Values <https://sqlite.org/c3ref/c_checkpoint_full.html>'__"""
 SQLITE_CHECKPOINT_PASSIVE: int = 0
@@ -0,0 +1,318 @@
+#
+
+"""Use APSW from :mod:`asyncio`, with each connection owning a worker thread."""
+
+from __future__ import annotations
+
+import asyncio
+import collections
+import itertools
+import queue
+import threading
+import weakref
+
+from typing import Any, Callable, TypeVar
+
+import apsw
+
+T = TypeVar("T")
+
+
+def _set_future(future: asyncio.Future, result: Any, exc: BaseException | None) -> None:
+    # runs in the event loop
+    if future.cancelled():
+        return
+    if exc is not None:
+        future.set_exception(exc)
+    else:
+        future.set_result(result)
+
+
+class _WorkItem:
+    "A call queued for the worker"
+
+    __slots__ = ("loop", "future", "func", "args", "cancelled")
+
+    def __init__(self, loop: asyncio.AbstractEventLoop, future: asyncio.Future, func: Callable[..., Any], args: tuple):
+        self.loop = loop
+        self.future = future
+        self.func = func
+        self.args = args
+        # set with _Worker.lock held
+        self.cancelled = False
+
+
+class _Worker:
+    "Runs submitted calls in order on its own thread, completing asyncio futures"
+
+    def __init__(self, name: str):
+        self.queue: queue.SimpleQueue = queue.SimpleQueue()
+        # protects running and _WorkItem.cancelled
+        self.lock = threading.Lock()
+        self.running: _WorkItem | None = None
+        self.stopped = False
+        self.thread = threading.Thread(target=self._run, name=name, daemon=True)
+        self.thread.start()
+
+    def submit(self, func: Callable[..., T], *args: Any) -> _WorkItem:
+        if self.stopped:
+            raise apsw.ConnectionClosedError("The connection has been closed")
+        loop = asyncio.get_running_loop()
+        item = _WorkItem(loop, loop.create_future(), func, args)
+        self.queue.put(item)
+        return item
+
+    def cancel(self, item: _WorkItem, interrupt: Callable[[], None]) -> None:
+        "Makes sure item won't run, calling interrupt if it already is"
+        with self.lock:
+            item.cancelled = True
+            if self.running is item:
+                interrupt()
+
+    def stop(self) -> None:
+        if not self.stopped:
+            self.stopped = True
+            self.queue.put(None)
+
+    def _run(self) -> None:
+        while True:
+            item = self.queue.get()
+            if item is None:
+                return
+            with self.lock:
+                if item.cancelled:
+                    continue
+                self.running = item
+            result, exc = None, None
+            try:
+                result = item.func(*item.args)
+            except BaseException as e:
+                exc = e
+            with self.lock:
+                self.running = None
+            try:
+                item.loop.call_soon_threadsafe(_set_future, item.future, result, exc)
+            except RuntimeError:
+                # the event loop has been closed
+                pass
+            del item, result, exc
+
+
+async def connect(filename: str, *, batch_size: int = 64, **kwargs: Any) -> Connection:
+    """Opens an :class:`apsw.Connection` on a new worker thread
+
+    :param filename: Passed to :class:`apsw.Connection`
+    :param batch_size: How many rows are fetched at a time, and
+        delivered to the event loop together.  See
+        :attr:`Connection.batch_size`
+    :param kwargs: Passed to :class:`apsw.Connection`
+
+    .. code-block:: python
+
+        db = await apsw.aio.connect("database.db")
+        async for row in await db.execute("select * from items"):
+            print(row)
+        await db.close()
+    """
+    if batch_size < 1:
+        raise ValueError(f"batch_size must be at least 1, not {batch_size}")
+    worker = _Worker(f"apsw.aio {filename}")
+    try:
+        connection = await worker.submit(apsw.Connection, filename, **kwargs).future
+    except BaseException:
+        worker.stop()
+        raise
+    return Connection(connection, worker, batch_size)
+
+
+class Connection:
+    """Wraps an :class:`apsw.Connection` for use from :mod:`asyncio`
+
+    Use :func:`connect` to make one.  All use of the underlying
+    connection happens on the worker thread in the order requested,
+    while the event loop waits on the results.  The GIL is released
+    while SQLite is working, so your event loop keeps running.
+
+    The underlying objects are only used by the worker.  If you do
+    accidentally use a cursor from the event loop while the worker is
+    using it, then the usual :exc:`~apsw.ThreadingViolationError`
+    protection raises an exception rather than corrupting state.
+
+    Using the connection as an asynchronous context manager is a
+    transaction, the same as :meth:`apsw.Connection.__enter__`.
+
+    The worker thread stops once the connection is closed, or
+    if it is garbage collected without being closed.
+
+    Cancelling a task interrupts its query if the query is running,
+    but only when no other :class:`Cursor` from this connection is
+    part way through its rows.  SQLite's interrupt stops every
+    statement on the connection, so those cursors would otherwise get
+    an :exc:`~apsw.InterruptError`.  Use one connection per concurrent
+    task if you need cancellation to always stop the query.
+    """
+
+    def __init__(self, connection: apsw.Connection, worker: _Worker, batch_size: int):
+        self._connection = connection
+        self._worker = worker
+        self.batch_size = batch_size
+        "How many rows are fetched at a time and delivered to the event loop together"
+        # cursors whose statement is still active, used from the event loop
+        self._active: weakref.WeakSet[Cursor] = weakref.WeakSet()
+        weakref.finalize(self, worker.stop)
+
+    @property
+    def connection(self) -> apsw.Connection:
+        """The underlying :class:`apsw.Connection`
+
+        Only use this from functions given to :meth:`run`."""
+        return self._connection
+
+    async def _call(self, func: Callable[..., T], *args: Any, owner: Cursor | None = None) -> T:
+        # owner is the cursor the call is fetching for
+        item = self._worker.submit(func, *args)
+        try:
+            return await item.future
+        except asyncio.CancelledError:
+            # skip it if still queued, or stop the query if it is
+            # what is running right now
+            self._worker.cancel(item, lambda: self._interrupt_for(owner))
+            raise
+
+    def _interrupt_for(self, owner: Cursor | None) -> None:
+        # interrupting would also stop other cursors part way through
+        if all(cursor is owner for cursor in self._active):
+            self._connection.interrupt()
+
+    async def run(self, func: Callable[..., T], *args: Any) -> T:
+        """Calls ``func(connection, *args)`` on the worker thread, returning its result
+
+        Use this to access any functionality not otherwise wrapped, or to
+        do several things in only one trip to the worker.
+
+        .. code-block:: python
+
+            def setup(connection):
+                connection.pragma("journal_mode", "wal")
+                connection.create_scalar_function("double", lambda x: x * 2)
+
+            await db.run(setup)
+        """
+        return await self._call(func, self._connection, *args)
+
+    def _execute(self, method: str, args: tuple, kwargs: dict[str, Any]) -> tuple[apsw.Cursor, list[Any], bool]:
+        # runs in the worker, returning the first batch of rows to save a trip
+        cursor = self._connection.cursor()
+        getattr(cursor, method)(*args, **kwargs)
+        rows = list(itertools.islice(cursor, self.batch_size))
+        return cursor, rows, len(rows) < self.batch_size
+
+    async def execute(self, statements: str, bindings: apsw.Bindings | None = None, **kwargs: Any) -> Cursor:
+        "Runs :meth:`apsw.Cursor.execute` on a new cursor"
+        return Cursor(self, *(await self._call(self._execute, "execute", (statements, bindings), kwargs)))
+
+    async def executemany(self, statements: str, sequenceofbindings: Any, **kwargs: Any) -> Cursor:
+        """Runs :meth:`apsw.Cursor.executemany` on a new cursor
+
+        *sequenceofbindings* is iterated on the worker thread."""
+        return Cursor(
+            self, *(await self._call(self._execute, "executemany", (statements, sequenceofbindings), kwargs))
+        )
+
+    async def pragma(self, name: str, value: apsw.SQLiteValue | None = None) -> Any:
+        "Runs :meth:`apsw.Connection.pragma`"
+        if value is None:
+            return await self._call(self._connection.pragma, name)
+        return await self._call(self._connection.pragma, name, value)
+
+    def interrupt(self) -> None:
+        """Interrupts whatever the worker is currently running
+
+        This is safe to call from any thread.  Every statement on the
+        connection is stopped, including cursors part way through
+        their rows which then get :exc:`~apsw.InterruptError`."""
+        self._connection.interrupt()
+
+    async def close(self, force: bool = False) -> None:
+        "Closes the connection, and stops the worker thread"
+        if self._worker.stopped:
+            return
+        try:
+            await self._call(self._connection.close, force)
+        finally:
+            self._worker.stop()
+
+    async def __aenter__(self) -> Connection:
+        await self._call(self._connection.__enter__)
+        return self
+
+    async def __aexit__(self, etype, evalue, etraceback) -> bool | None:
+        return await self._call(self._connection.__exit__, etype, evalue, etraceback)
+
+
+class Cursor:
+    """Results from :meth:`Connection.execute` and :meth:`Connection.executemany`
+
+    Rows are fetched in batches of :attr:`Connection.batch_size` on the
+    worker thread, with the first batch fetched as part of the execute.
+    Use ``async for`` to get each row.
+    """
+
+    def __init__(self, connection: Connection, cursor: apsw.Cursor, rows: list[Any], exhausted: bool):
+        self._connection = connection
+        self._cursor = cursor
+        self._rows = collections.deque(rows)
+        self._exhausted = exhausted
+        if not exhausted:
+            connection._active.add(self)
+
+    def _finished(self) -> None:
+        self._exhausted = True
+        self._connection._active.discard(self)
+
+    @property
+    def cursor(self) -> apsw.Cursor:
+        """The underlying :class:`apsw.Cursor`
+
+        Only use this from functions given to :meth:`Connection.run`."""
+        return self._cursor
+
+    def _fetch(self, count: int) -> list[Any]:
+        return list(itertools.islice(self._cursor, count))
+
+    async def _fill(self) -> None:
+        if not self._rows and not self._exhausted:
+            batch_size = self._connection.batch_size
+            rows = await self._connection._call(self._fetch, batch_size, owner=self)
+            if len(rows) < batch_size:
+                self._finished()
+            self._rows.extend(rows)
+
+    def __aiter__(self) -> Cursor:
+        return self
+
+    async def __anext__(self) -> Any:
+        await self._fill()
+        if not self._rows:
+            raise StopAsyncIteration
+        return self._rows.popleft()
+
+    async def fetchone(self) -> Any | None:
+        "Returns the next row, or None if there are no more"
+        await self._fill()
+        return self._rows.popleft() if self._rows else None
+
+    async def fetchall(self) -> list[Any]:
+        "Returns all remaining rows"
+        rows = list(self._rows)
+        self._rows.clear()
+        if not self._exhausted:
+            rows.extend(await self._connection._call(list, self._cursor, owner=self))
+            self._finished()
+        return rows
+
+    async def close(self, force: bool = False) -> None:
+        "Closes the cursor, discarding any remaining rows"
+        self._rows.clear()
+        self._finished()
+        await self._connection._call(self._cursor.close, force)
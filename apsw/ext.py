@@ -11,6 +11,7 @@ from typing import Union, Any, Callable, Sequence, Iterable, TextIO, Literal, It
 import types
 
 import functools
+import itertools
 import abc
 import enum
 import inspect
@@ -66,6 +67,10 @@ class DataClassRowFactory:
     You can use as many instances of this class as you want, each across as many
     :class:`connections <apsw.Connection>` as you want.
 
+    If you only need access by column name then
+    :attr:`Connection.named_rows <apsw.Connection.named_rows>` is
+    considerably faster.
+
     :param rename:     Column names could be duplicated, or not
         valid in Python (eg a column named `continue`).
         If `rename` is True, then invalid/duplicate names are replaced
@@ -172,6 +177,10 @@ class TypesConverterCursorFactory:
     or back from SQLite
 
     :param abstract_base_class: Which metaclass to consider as conversion capable
+
+    :meth:`Connection.register_adapter <apsw.Connection.register_adapter>` and
+    :meth:`Connection.register_converter <apsw.Connection.register_converter>`
+    do the same lookups in C, and are considerably faster.
     """
 
     def __init__(self, abstract_base_class: abc.ABCMeta = SQLiteTypeAdapter):
@@ -1056,10 +1065,15 @@ def make_virtual_module(db: apsw.Connection,
     ++++++++
 
     The *callable* may also have an attribute named *primary_key*.
-    By default the :func:`id` of each row is used as the primary key.
-    If present then it must be a column number to use as the primary
+    By default the :func:`id` of each row is used as the primary key
+    (or the row number with :attr:`VTColumnAccess.By_Index`).  If
+    present then it must be a column number to use as the primary
     key.  The contents of that column must be unique for every row.
 
+    With :attr:`VTColumnAccess.By_Index` (and *repr_invalid* False)
+    rows are provided to SQLite in :meth:`batches
+    <apsw.VTCursor.NextRows>` avoiding several Python calls per row.
+
     If you specify a parameter to the table and in WHERE, or have
     non-equality for WHERE clauses of parameters then the query will
     fail with :class:`apsw.SQLError` and a message from SQLite of
@@ -1180,13 +1194,18 @@ def make_virtual_module(db: apsw.Connection,
                     setattr(self, "_Column_get", f)
                 else:
                     setattr(self, "Column", f)
+                # rows can be given to SQLite as is
+                self.batched = self.access is VTColumnAccess.By_Index and not self.repr_invalid
+                if self.batched:
+                    setattr(self, "NextRows", self._NextRows)
 
             def Filter(self, idx_num: int, idx_str: str, args: tuple[apsw.SQLiteValue]) -> None:
                 params: dict[str, apsw.SQLiteValue] = self.param_values.copy()
                 params.update(zip(idx_str.split(","), args))
                 self.iterating = iter(self.module.callable(**params))
-                # proactively advance so we can tell if eof
-                self.Next()
+                if not self.batched:
+                    # proactively advance so we can tell if eof
+                    self.Next()
 
                 self.hidden_values: list[apsw.SQLiteValue] = self.module.defaults[:]
                 for k, v in params.items():
@@ -1241,6 +1260,12 @@ def make_virtual_module(db: apsw.Connection,
                         self.iterating.close()  # type: ignore[union-attr]
                     self.iterating = None
 
+            def _NextRows(self) -> list[Any]:
+                rows = list(itertools.islice(self.iterating, 256))  # type: ignore[arg-type]
+                if not rows:
+                    self.Close()
+                return rows
+
             def Rowid(self):
                 if self.module.primary_key is None:
                     return id(self.current_row)
@@ -37,11 +37,18 @@ def doit():
         print("   Testing with APSW file ", apsw.__file__)
         print("             APSW version ", apsw.apsw_version())
         print("       SQLite lib version ", apsw.sqlite_lib_version())
-        print("   SQLite headers version ", apsw.SQLITE_VERSION_NUMBER, end="\n\n")
+        print("   SQLite headers version ", apsw.SQLITE_VERSION_NUMBER)
+
+        print("          Whole row fetch ", options.whole_row_fetch)
+        print("          Typed functions ", options.typed_functions, end="\n\n")
 
         def apsw_setup(dbfile):
             con = apsw.Connection(dbfile, statementcachesize=options.scsize, vfs=options.vfs)
-            con.create_scalar_function("number_name", number_name, 1)
+            con.whole_row_fetch = options.whole_row_fetch
+            if options.typed_functions:
+                con.create_scalar_function("number_name", number_name, arg_types=[int], return_type=str)
+            else:
+                con.create_scalar_function("number_name", number_name, 1)
             return con
 
     if options.sqlite3:
@@ -273,6 +280,13 @@ def doit():
 
         yield ("SELECT count(*) FROM t1", )
 
+    # 20 columns of mixed types
+    widerows_setup = f"""
+        CREATE TABLE wide({ ", ".join(f"c{ i }" for i in range(20)) });
+        WITH RECURSIVE counter(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM counter LIMIT { options.scale * 2000 })
+        INSERT INTO wide SELECT { ", ".join(("x", "x * 1.5", "'row ' || x", "NULL")[i % 4] for i in range(20)) } FROM counter;
+    """
+
     # Do a correctness test first
     if options.correctness:
         print("Correctness test\n")
@@ -311,6 +325,15 @@ def doit():
                     print(str(len(res[name])) + "\n")
                     continue
 
+                if test == 'widerows':
+                    if driver == 'apsw':
+                        con.execute(widerows_setup)
+                    else:
+                        con.executescript(widerows_setup)
+                    res[name] = [row for row in con.execute("SELECT * FROM wide")]
+                    print(str(len(res[name])) + "\n")
+                    continue
+
                 cursor = con.cursor()
                 if test == 'statements':
                     sql = withbindings
@@ -376,6 +399,20 @@ def doit():
             for row in cursor.execute(*b):
                 pass
 
+    def apsw_widerows(con):
+        "APSW reading rows with many columns"
+        con.execute(widerows_setup)
+        for i in range(10):
+            for row in con.execute("SELECT * FROM wide"):
+                pass
+
+    def sqlite3_widerows(con):
+        "sqlite3 reading rows with many columns"
+        con.executescript(widerows_setup)
+        for i in range(10):
+            for row in con.execute("SELECT * FROM wide"):
+                pass
+
     def apsw_statements_nobindings(con):
         "APSW individual statements without bindings"
         return apsw_statements(con, withoutbindings)
@@ -468,7 +505,7 @@ parser.add_argument(
 parser.add_argument("--database", dest="database", default=":memory:", help="The database file to use [%(default)s]")
 parser.add_argument("--tests",
                     dest="tests",
-                    default="bigstmt,statements,statements_nobindings",
+                    default="bigstmt,statements,statements_nobindings,widerows",
                     help="What tests to run [%(default)s]")
 parser.add_argument("--iterations",
                     dest="iterations",
@@ -513,6 +550,16 @@ parser.add_argument(
     help=
     "Use the named vfs.  'passthru' creates a dummy APSW vfs.  You need to provide a real database filename otherwise the memory vfs is used."
 )
+parser.add_argument("--whole-row-fetch",
+                    dest="whole_row_fetch",
+                    action="store_true",
+                    default=False,
+                    help="Set apsw Connection.whole_row_fetch [%(default)s]")
+parser.add_argument("--typed-functions",
+                    dest="typed_functions",
+                    action="store_true",
+                    default=False,
+                    help="Register apsw functions with arg_types and return_type [%(default)s]")
 parser.add_argument(
     "--sqlite-cache",
     type=float,
@@ -550,6 +597,13 @@ statements_nobindings:
   This test has no statement cache hits and shows the overhead of
        having a statement cache.
 
+widerows:
+
+  Reads all the rows of a table with 20 columns of integers, floats,
+  text, and nulls ten times.  This shows the cost of converting
+  values to Python objects.  Use --whole-row-fetch to compare the
+  APSW row fetch modes.
+
   In theory all the tests above should run in almost identical time
   as well as when using the SQLite command line shell.  This tool
   shows you what happens in practise.
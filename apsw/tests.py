@@ -13,6 +13,7 @@ import dataclasses
 import gc
 import getpass
 import glob
+import hashlib
 import inspect
 import io
 import itertools
@@ -37,6 +38,7 @@ import time
 import traceback
 import typing
 import warnings
+import weakref
 
 
 def ShouldFault(name, pending_exception):
@@ -319,7 +321,8 @@ class APSW(unittest.TestCase):
 
     def deltempfiles(self):
         for name in ("testdb", "testdb2", "testdb3", "testfile", "testfile2", "testdb2x", "test-shell-1",
-                     "test-shell-1.py", "test-shell-in", "test-shell-out", "test-shell-err"):
+                     "test-shell-1.py", "test-shell-in", "test-shell-out", "test-shell-err", "testimport", "testexport",
+                     "testdump"):
             for i in "-shm", "-wal", "-journal", "":
                 if os.path.exists(TESTFILEPREFIX + name + i):
                     deletefile(TESTFILEPREFIX + name + i)
@@ -592,6 +595,17 @@ class APSW(unittest.TestCase):
         self.assertEqual(1, self.db.config(apsw.SQLITE_DBCONFIG_REVERSE_SCANORDER, -1))
         self.db.config(apsw.SQLITE_DBCONFIG_REVERSE_SCANORDER, 0)
         self.assertEqual(0, self.db.pragma("reverse_unordered_selects"))
+        # lookaside
+        db = apsw.Connection("")
+        self.assertRaises(TypeError, db.config, apsw.SQLITE_DBCONFIG_LOOKASIDE, 1200)
+        self.assertEqual(0, db.config(apsw.SQLITE_DBCONFIG_LOOKASIDE, 1200, 500))
+        for _ in range(3):
+            db.execute("create table if not exists foo(x); select * from foo").fetchall()
+        self.assertGreater(db.status(apsw.SQLITE_DBSTATUS_LOOKASIDE_HIT)[1], 0)
+        # in use by the statement
+        cur = db.execute("select * from foo")
+        self.assertRaises(apsw.BusyError, db.config, apsw.SQLITE_DBCONFIG_LOOKASIDE, 1200, 100)
+        cur.close()
 
     def testConnectionMetadata(self):
         "Test uses of sqlite3_table_column_metadata"
@@ -621,6 +635,96 @@ class APSW(unittest.TestCase):
             self.assertEqual(self.db.column_metadata(None, "table3", colname), expected)
         self.assertRaises(apsw.SQLError, self.db.column_metadata, "not a db", "not a table", "not a column")
 
+        self.assertRaises(TypeError, self.db.table_metadata, 1, 2)
+        expected = {name: self.db.column_metadata(None, "table3", name) for name in ("one", "two", "three")}
+        self.assertEqual(list(self.db.table_metadata(None, "table3").items()), list(expected.items()))
+        self.assertEqual(self.db.table_metadata("main", "table3"), expected)
+        self.assertEqual(self.db.table_metadata(None, "table2"), {"x": (None, "BINARY", False, False, False)})
+        self.assertRaises(apsw.SQLError, self.db.table_metadata, "main", "table2")
+        self.assertRaises(apsw.SQLError, self.db.table_metadata, "not a db", "table1")
+        self.db.execute("create view view1 as select * from table1")
+        self.assertRaises(apsw.SQLError, self.db.table_metadata, None, "view1")
+
+    def testMetadataCache(self):
+        "Test caching of schema dependent results"
+        self.assertRaises(TypeError, self.db.pragma, "table_info", "foo", cache="yes")
+        self.assertRaises(TypeError, self.db.metadata_cache_clear, 3)
+        self.db.execute("create table foo(x, y)")
+
+        # returned values are copies
+        info = self.db.pragma("table_info", "foo", cache=True)
+        self.assertEqual(2, len(info))
+        info.clear()
+        self.assertEqual(2, len(self.db.pragma("table_info", "foo", cache=True)))
+        meta = self.db.table_metadata(None, "foo")
+        meta.clear()
+        self.assertEqual(2, len(self.db.table_metadata(None, "foo")))
+
+        # results are reused
+        cached = self.db.pragma("table_info", "foo", cache=True)
+        self.assertIs(cached[0], self.db.pragma("table_info", "foo", cache=True)[0])
+        self.assertIsNot(cached[0], self.db.pragma("table_info", "foo")[0])
+
+        def columns():
+            return len(self.db.pragma("table_info", "foo", cache=True)), len(self.db.table_metadata(None, "foo"))
+
+        # changes by another connection
+        db2 = apsw.Connection(self.db.filename)
+        db2.execute("alter table foo add column z")
+        self.assertEqual((3, 3), columns())
+        # table_metadata must not be answered from this connection's stale schema
+        self.assertEqual(["x", "y", "z"], list(self.db.table_metadata(None, "foo")))
+        db2.execute("alter table foo add column q")
+        self.assertEqual(["x", "y", "z", "q"], list(self.db.table_metadata(None, "foo")))
+        db2.execute("alter table foo drop column q")
+        self.assertEqual(["x", "y", "z"], list(self.db.table_metadata(None, "foo")))
+        db2.close()
+
+        # changes inside transactions including rollbacks
+        self.db.execute("begin; alter table foo add column a")
+        self.assertEqual((4, 4), columns())
+        self.db.execute("savepoint sp; alter table foo add column b")
+        self.assertEqual((5, 5), columns())
+        self.db.execute("rollback to sp; release sp")
+        self.assertEqual((4, 4), columns())
+        self.db.execute("rollback")
+        self.assertEqual((3, 3), columns())
+        self.db.execute("begin; alter table foo add column c")
+        self.assertEqual((4, 4), columns())
+        self.db.execute("commit")
+        self.assertEqual((4, 4), columns())
+
+        # schema in other databases
+        self.db.execute("create temp table foo(x, y)")
+        self.assertEqual((2, 2), columns())
+        self.db.execute("drop table temp.foo")
+        self.assertEqual((4, 4), columns())
+        self.db.execute("attach '' as aux; create table aux.bar(x)")
+        self.assertEqual(["x"], list(self.db.table_metadata("aux", "bar")))
+        self.db.execute("detach aux; attach '' as aux; create table aux.bar(y)")
+        self.assertEqual(["y"], list(self.db.table_metadata("aux", "bar")))
+        self.db.execute("detach aux")
+        self.assertRaises(apsw.SQLError, self.db.table_metadata, "aux", "bar")
+
+        # explicit clear
+        before = self.db.pragma("table_info", "foo", cache=True)
+        self.db.metadata_cache_clear()
+        self.assertIsNot(before[0], self.db.pragma("table_info", "foo", cache=True)[0])
+        self.assertEqual((4, 4), columns())
+
+        # errors checking the schema version
+        def auth(op, *args):
+            return apsw.SQLITE_DENY if op == apsw.SQLITE_PRAGMA else apsw.SQLITE_OK
+
+        self.db.authorizer = auth
+        self.assertRaises(apsw.AuthError, self.db.table_metadata, None, "foo")
+        self.db.authorizer = None
+        self.assertEqual((4, 4), columns())
+
+        self.db.close()
+        self.assertRaises(apsw.ConnectionClosedError, self.db.table_metadata, None, "foo")
+        self.assertRaises(apsw.ConnectionClosedError, self.db.metadata_cache_clear)
+
     def testConnectionNames(self):
         "Test Connection.db_names"
         self.assertRaises(TypeError, self.db.db_names, 3)
@@ -927,6 +1031,221 @@ class APSW(unittest.TestCase):
         for i, v in enumerate(c.execute("select * from xxset order by x")):
             self.assertEqual(v, result[i])
 
+    def testExecutemanyBulk(self):
+        "executemany reusing the statement with binding plans"
+        c = self.db.cursor()
+        c.execute("create table bulk(a, b, c)")
+
+        class myint(int):
+            pass
+
+        vals = [
+            (1, 2.5, "three"),
+            (None, None, None),
+            (2**62, -0.0, b"bytes"),
+            (myint(7), bytearray(b"ba"), memoryview(b"mv")),
+            ("str", 3, apsw.zeroblob(3)),
+            {"1": 4, "2": 5, "3": 6},
+            [7, 8, 9],
+            (1, 2.5, "x" * 10000),
+        ]
+        expected = [tuple(bytes(v) if isinstance(v, (bytearray, memoryview)) else v for v in row) for row in vals]
+        expected[3] = (7, b"ba", b"mv")
+        expected[4] = ("str", 3, b"\0\0\0")
+        expected[5] = (4, 5, 6)
+        c.executemany("insert into bulk values(?1, ?2, ?3)", vals)
+        self.assertEqual(c.execute("select * from bulk order by rowid").fetchall(), expected)
+        self.assertEqual(type(self.db.execute("select a from bulk where rowid=4").get), int)
+
+        # more bindings than fit on the stack
+        many = [tuple(range(i, i + 100)) for i in range(10)]
+        c.execute("create table wide(" + ", ".join(f"c{ i }" for i in range(100)) + ")")
+        c.executemany("insert into wide values(" + ", ".join("?" * 100) + ")", many)
+        self.assertEqual(c.execute("select * from wide order by rowid").fetchall(), many)
+
+        # previous row's bindings must not leak into missing dict bindings
+        c.execute("delete from bulk")
+        old = apsw.allow_missing_dict_bindings(True)
+        try:
+            c.executemany("insert into bulk values(:a, :b, :c)", [(1, 2, 3), {"a": 4}])
+        finally:
+            apsw.allow_missing_dict_bindings(old)
+        self.assertEqual(c.execute("select * from bulk order by rowid").fetchall(), [(1, 2, 3), (4, None, None)])
+
+        # exec tracer installed part way through
+        c.execute("delete from bulk")
+        traced = []
+
+        def tracer(cur, sql, bindings):
+            traced.append(bindings)
+            return True
+
+        def gen():
+            yield (1, 2, 3)
+            self.db.exec_trace = tracer
+            yield (4, 5, 6)
+            yield (7, 8, 9)
+
+        c.executemany("insert into bulk values(?, ?, ?)", gen())
+        self.db.exec_trace = None
+        self.assertEqual(traced, [(4, 5, 6), (7, 8, 9)])
+        self.assertEqual(c.execute("select count(*) from bulk").get, 3)
+
+        # errors part way through leave earlier rows done
+        for bad, exc in (
+            ((1, 2, 2**64), OverflowError),
+            ((1, 2, self), TypeError),
+            ((1, 2), apsw.BindingsError),
+            ((1, 2, "\udc00"), UnicodeEncodeError),
+            ((1, 2, 1 / 3), apsw.ConstraintError),
+            ((1, 2, "fail"), ZeroDivisionError),
+        ):
+            c.execute("drop table if exists bulk; create table bulk(a, b, c check(c != 1.0 / 3))")
+            self.db.create_scalar_function("failer", lambda x: 1 / 0 if x == "fail" else x)
+            self.assertRaises(exc, c.executemany, "insert into bulk values(?, ?, failer(?))", [(1, 2, 3), (4, 5, 6), bad, (7, 8, 9)])
+            self.assertEqual(c.execute("select count(*) from bulk").get, 2)
+            # cursor is usable afterwards
+            c.executemany("insert into bulk values(?, ?, ?)", [(7, 8, 9)])
+            self.assertEqual(c.execute("select count(*) from bulk").get, 3)
+
+        def gen():
+            yield (1, 2, 3)
+            1 / 0
+
+        self.assertRaises(ZeroDivisionError, c.executemany, "insert into bulk values(?, ?, ?)", gen())
+        self.assertEqual(c.execute("select count(*) from bulk").get, 4)
+
+    def testZeroCopyBindings(self):
+        "Connection.zero_copy_bindings"
+        self.assertFalse(self.db.zero_copy_bindings)
+        self.assertRaises(TypeError, setattr, self.db, "zero_copy_bindings", "yes")
+
+        big = b"\x01" * 4_000_000
+        bigtext = "\N{BLACK STAR}" * 1_000_000
+        used = {}
+        for setting in (False, True):
+            self.db.zero_copy_bindings = setting
+            self.assertEqual(self.db.zero_copy_bindings, setting)
+            before = apsw.memory_used()
+            cur = self.db.execute("select length(?), length(?) union all select 1, 2", (big, bigtext))
+            self.assertEqual(next(cur), (len(big), len(bigtext)))
+            used[setting] = apsw.memory_used() - before
+            self.assertEqual(next(cur), (1, 2))
+            self.assertRaises(StopIteration, next, cur)
+        # no copies of the values
+        self.assertGreater(used[False], len(big) + len(bigtext.encode()))
+        self.assertLess(used[True], 1_000_000)
+
+        self.db.zero_copy_bindings = True
+        vals = (None, 1, 2.5, "three", b"four", bytearray(b"five"), memoryview(b"xsixx")[1:-1], apsw.zeroblob(2))
+        self.assertEqual(self.db.execute("select " + ", ".join("?" * len(vals)), vals).get,
+                         (None, 1, 2.5, "three", b"four", b"five", b"six", b"\0\0"))
+        self.assertRaises(TypeError, self.db.execute, "select ?", (memoryview(b"abcdef")[::2], ))
+
+        # buffer is exported while the statement is active
+        ba = bytearray(b"abc")
+        cur = self.db.execute("select ? union all select 2", (ba, ))
+        self.assertEqual(next(cur), (b"abc", ))
+        self.assertRaises(BufferError, ba.extend, b"def")
+        self.assertEqual(next(cur), (2, ))
+        self.assertRaises(StopIteration, next, cur)
+        ba.extend(b"def")
+
+        # values are kept alive even if the bindings are changed during execution
+        bindings = {"a": "a" * 100, "b": b"b" * 100}
+
+        def mutate():
+            bindings.clear()
+            return 0
+
+        self.db.create_scalar_function("mutate", mutate)
+        self.assertEqual(self.db.execute("select mutate(), :a, :b", bindings).get, (0, "a" * 100, b"b" * 100))
+
+        # multiple statements and executemany
+        self.assertEqual(self.db.execute("select ?; select ?", ("x", b"y")).fetchall(), [("x", ), (b"y", )])
+        self.db.execute("create table zc(x)")
+        rows = [("a" * 1000, ), (b"b" * 1000, ), (bytearray(b"c" * 1000), ), {"1": "d"}, (memoryview(b"e"), )]
+        self.db.executemany("insert into zc values(?1)", rows)
+        self.assertEqual([r[0] for r in self.db.execute("select x from zc order by rowid")],
+                         ["a" * 1000, b"b" * 1000, b"c" * 1000, "d", b"e"])
+        self.assertEqual(self.db.executemany("select ?", rows[:3]).fetchall(),
+                         [("a" * 1000, ), (b"b" * 1000, ), (b"c" * 1000, )])
+        del rows
+        gc.collect()
+        # cached statements have no bindings pointing to freed memory
+        self.assertEqual(self.db.execute("select ?1", (1, )).get, 1)
+
+    def testBlobViews(self):
+        "Cursor.blob_views and BlobView"
+        cur = self.db.cursor()
+        self.assertFalse(cur.blob_views)
+        self.assertRaises(TypeError, setattr, cur, "blob_views", "yes")
+        cur.blob_views = True
+        self.assertTrue(cur.blob_views)
+
+        self.db.execute("create table bv(x, y)")
+        rows = [(b"one", 1), (b"", "two"), (b"\x00" * 100000, None), (None, b"four")]
+        self.db.executemany("insert into bv values(?, ?)", rows)
+
+        kept = []
+        for got, expected in zip(cur.execute("select * from bv order by rowid"), rows):
+            for g, e in zip(got, expected):
+                if isinstance(e, bytes):
+                    self.assertIsInstance(g, apsw.BlobView)
+                    self.assertTrue(g.valid)
+                    self.assertEqual(len(g), len(e))
+                    self.assertEqual(g.tobytes(), e)
+                    self.assertEqual(bytes(g), e)
+                    with memoryview(g) as m:
+                        self.assertTrue(m.readonly)
+                        self.assertEqual(m.tobytes(), e)
+                    self.assertEqual(hashlib.sha256(g).digest(), hashlib.sha256(e).digest())
+                    self.assertIn("bytes", str(g))
+                    kept.append(g)
+                else:
+                    self.assertEqual(g, e)
+
+        # stale access is detected
+        for v in kept:
+            self.assertFalse(v.valid)
+            self.assertEqual(len(v), len(v))
+            self.assertRaises(ValueError, v.tobytes)
+            self.assertRaises(ValueError, memoryview, v)
+            self.assertIn("out of scope", str(v))
+
+        # can't move on while exported
+        cur.execute("select x from bv order by rowid")
+        v = next(cur)[0]
+        m = memoryview(v)
+        self.assertRaises(BufferError, next, cur)
+        self.assertRaises(BufferError, cur.execute, "select 3")
+        self.assertRaises(BufferError, cur.close)
+        self.assertEqual(m.tobytes(), b"one")
+        m.release()
+        self.assertEqual(next(cur)[0].tobytes(), b"")
+        self.assertFalse(v.valid)
+
+        # force close is not allowed either because the memory would be freed
+        cur.execute("select x from bv order by rowid")
+        m = memoryview(next(cur)[0])
+        self.assertRaises(BufferError, cur.close, True)
+        self.assertRaises(BufferError, self.db.close, True)
+        self.assertEqual(m.tobytes(), b"one")
+        self.assertEqual(bytes(m), b"one")
+        m.release()
+        cur.close(True)
+
+        # fetchall and get return bytes
+        cur = self.db.cursor()
+        cur.blob_views = True
+        self.assertEqual(cur.execute("select x, y from bv order by rowid").fetchall(), rows)
+        self.assertEqual(cur.execute("select x, y from bv order by rowid").get, rows)
+        self.assertEqual(cur.execute("select x from bv order by rowid limit 1").get, b"one")
+
+        # whole row fetch is not used with views
+        self.db.whole_row_fetch = True
+        self.assertIsInstance(next(cur.execute("select x'aa', 3"))[0], apsw.BlobView)
+
     def testCursor(self):
         "Check functionality of the cursor"
         c = self.db.cursor()
@@ -1925,6 +2244,257 @@ class APSW(unittest.TestCase):
         self.db.create_module("testing", Source(), eponymous=True, use_no_change=True)
         self.db.execute("update testing set c1=c2+1")
 
+    def testVTableBatch(self):
+        "Test virtual table cursors providing rows in batches"
+        calls = []
+
+        class Source:
+
+            def __init__(self, mode, data, batch):
+                self.mode, self.data, self.batch = mode, data, batch
+
+            def Create(self, *args):
+                return "create table ignored(c0, c1, c2, hidden_one HIDDEN)", Source.Table(self)
+
+            Connect = Create
+
+            class Table:
+
+                def __init__(self, source):
+                    self.source = source
+
+                def BestIndex(self, *args):
+                    return None
+
+                def Open(self):
+                    return {"rows": Source.RowsCursor, "columns": Source.ColumnsCursor}[self.source.mode](self.source)
+
+                def Disconnect(self):
+                    pass
+
+                Destroy = Disconnect
+
+            class Cursor:
+
+                def __init__(self, source):
+                    self.source = source
+
+                def Filter(self, *args):
+                    calls.append("Filter")
+                    self.pos = 0
+
+                def next_rows(self):
+                    rows = self.source.data[self.pos:self.pos + self.source.batch]
+                    self.pos += self.source.batch
+                    return rows
+
+                def Column(self, which):
+                    calls.append(("Column", which))
+                    return "hidden"
+
+                def Close(self):
+                    pass
+
+            class RowsCursor(Cursor):
+
+                def NextRows(self):
+                    calls.append("NextRows")
+                    return self.next_rows()
+
+            class ColumnsCursor(Cursor):
+
+                def NextColumns(self):
+                    calls.append("NextColumns")
+                    rows = self.next_rows()
+                    return list(zip(*rows)) if rows else None
+
+        data = [(i, "x" * i, float(i)) for i in range(100)]
+        source = Source("rows", data, 7)
+        self.db.create_module("batch", source)
+        self.db.execute("create virtual table rows using batch()")
+        self.assertEqual(self.db.execute("select c0, c1, c2 from rows").fetchall(), data)
+        self.assertEqual(calls, ["Filter"] + ["NextRows"] * 16)
+        self.assertEqual(self.db.execute("select rowid from rows").fetchall(), [(i, ) for i in range(100)])
+        self.assertEqual(self.db.execute("select count(*) from rows where c0 > 90").get, 9)
+
+        # hidden columns aren't in the rows
+        calls.clear()
+        self.assertEqual(self.db.execute("select hidden_one from rows limit 2").fetchall(), [("hidden", ), ("hidden", )])
+        self.assertEqual(calls, ["Filter", "NextRows", ("Column", 3), ("Column", 3)])
+
+        # rows of varying type and length
+        source.data = [[1, 2, 3], (4, 5), array.array("i", [6, 7, 8])]
+        self.assertEqual(self.db.execute("select c0, c1, c2 from rows").fetchall(), [(1, 2, 3), (4, 5, "hidden"), (6, 7, 8)])
+
+        source.data = []
+        self.assertEqual(self.db.execute("select * from rows").fetchall(), [])
+
+        source.mode = "columns"
+        source.data = data
+        calls.clear()
+        self.assertEqual(self.db.execute("select c0, c1, c2 from rows").fetchall(), data)
+        self.assertEqual(calls, ["Filter"] + ["NextColumns"] * 16)
+
+        # errors
+        source.batch = 1000
+        source.data = 3
+        self.assertRaises(TypeError, lambda: self.db.execute("select * from rows").fetchall())
+        for mode in ("rows", "columns"):
+            source.mode = mode
+            source.data = [(1, 2, object())]
+            self.assertRaises(TypeError, lambda: self.db.execute("select * from rows").fetchall())
+            source.data = [3]
+            self.assertRaises(TypeError, lambda: self.db.execute("select * from rows").fetchall())
+
+        class Uneven(Source.Cursor):
+
+            def NextColumns(self):
+                return [(1, 2), (3, )]
+
+        source.mode = "uneven"
+        Source.Table.Open = lambda self: Uneven(self.source)
+        self.assertRaisesRegex(ValueError, "column 1 has 1 values but column 0 has 2",
+                               lambda: self.db.execute("select * from rows").fetchall())
+
+        # make_virtual_module uses batches
+        def gen(count):
+            for i in range(count):
+                yield (i, i * 2)
+
+        gen.columns = ("a", "b")
+        gen.column_access = apsw.ext.VTColumnAccess.By_Index
+        apsw.ext.make_virtual_module(self.db, "gen", gen)
+        self.assertEqual(self.db.execute("select a, b, count from gen(1000) where a > 995").fetchall(),
+                         [(996, 1992, 1000), (997, 1994, 1000), (998, 1996, 1000), (999, 1998, 1000)])
+        self.assertEqual(self.db.execute("select count(*) from gen(0)").get, 0)
+
+    def testVTablePlanCache(self):
+        "Test virtual table LIMIT/OFFSET and remembering BestIndex results"
+        calls = []
+
+        class Source:
+
+            def __init__(self, look_at_rhs=False):
+                self.look_at_rhs = look_at_rhs
+
+            def Create(self, *args):
+                return "create table ignored(c0, c1)", Source.Table(self)
+
+            Connect = Create
+
+            class Table:
+
+                def __init__(self, source):
+                    self.source = source
+
+                def BestIndexObject(self, o):
+                    calls.append((o.limit_constraint, o.offset_constraint))
+                    argv = 1
+                    names = []
+                    for c in range(o.nConstraint):
+                        if o.get_aConstraint_usable(c) and o.get_aConstraint_op(c) == apsw.SQLITE_INDEX_CONSTRAINT_EQ:
+                            o.set_aConstraintUsage_argvIndex(c, argv)
+                            o.set_aConstraintUsage_omit(c, True)
+                            names.append("eq")
+                            argv += 1
+                            if self.source.look_at_rhs:
+                                o.get_aConstraint_rhs(c)
+                    for c, name in ((o.limit_constraint, "limit"), (o.offset_constraint, "offset")):
+                        if c >= 0:
+                            o.set_aConstraintUsage_argvIndex(c, argv)
+                            o.set_aConstraintUsage_omit(c, True)
+                            names.append(name)
+                            argv += 1
+                    o.idxStr = ",".join(names)
+                    o.idxNum = len(names)
+                    return True
+
+                def BestIndex(self, constraints, orderbys):
+                    calls.append(("tuples", constraints))
+                    return None
+
+                def Open(self):
+                    return Source.Cursor()
+
+                def Disconnect(self):
+                    pass
+
+                Destroy = Disconnect
+
+            class Cursor:
+
+                def Filter(self, idxnum, idxstr, args):
+                    self.filters = (idxnum, idxstr, args)
+                    params = dict(zip(idxstr.split(",") if idxstr else [], args))
+                    rows = [(i, i * 10) for i in range(100)]
+                    if "eq" in params:
+                        rows = [r for r in rows if r[0] == params["eq"]]
+                    offset = params.get("offset", 0)
+                    self.rows = rows[offset:offset + params["limit"]] if "limit" in params else rows[offset:]
+                    self.pos = 0
+
+                def Eof(self):
+                    return self.pos >= len(self.rows)
+
+                def Column(self, which):
+                    return self.rows[self.pos][which]
+
+                def Next(self):
+                    self.pos += 1
+
+                def Rowid(self):
+                    return self.rows[self.pos][0]
+
+                def Close(self):
+                    pass
+
+        self.db.create_module("plans", Source(), use_bestindex_object=True, cache_best_index=True)
+        self.db.execute("create virtual table plans1 using plans()")
+
+        query = "select c0 from plans1 limit 3 offset 4"
+        for _ in range(5):
+            self.assertEqual(self.db.execute(query, can_cache=False).fetchall(), [(4, ), (5, ), (6, )])
+        self.assertEqual(len(calls), 1)
+        self.assertNotEqual(calls[0], (-1, -1))
+        self.assertEqual(self.db.execute("select c0 from plans1 limit ? offset ?", (2, 97), can_cache=False).fetchall(),
+                         [(97, ), (98, )])
+        self.assertEqual(len(calls), 1)
+
+        # different shapes
+        self.assertEqual(self.db.execute("select c1 from plans1 where c0 = 7", can_cache=False).fetchall(), [(70, )])
+        self.assertEqual(calls[-1], (-1, -1))
+        ncalls = len(calls)
+        self.assertEqual(self.db.execute("select c1 from plans1 where c0 = 8", can_cache=False).fetchall(), [(80, )])
+        self.assertEqual(len(calls), ncalls)
+        self.assertEqual(len(self.db.execute("select * from plans1", can_cache=False).fetchall()), 100)
+        self.assertGreater(len(calls), ncalls)
+
+        # looking at values means not cached
+        calls.clear()
+        self.db.create_module("plans_rhs", Source(True), use_bestindex_object=True, cache_best_index=True)
+        self.db.execute("create virtual table plans2 using plans_rhs()")
+        for _ in range(3):
+            self.assertEqual(self.db.execute("select c1 from plans2 where c0 = 9", can_cache=False).fetchall(), [(90, )])
+        self.assertEqual(len(calls), 3)
+
+        # not cached by default
+        calls.clear()
+        self.db.create_module("plans_nocache", Source(), use_bestindex_object=True)
+        self.db.execute("create virtual table plans3 using plans_nocache()")
+        for _ in range(3):
+            self.assertEqual(self.db.execute(query.replace("plans1", "plans3"), can_cache=False).fetchall(),
+                             [(4, ), (5, ), (6, )])
+        self.assertEqual(self.db.execute("select c0 from plans3 limit 2", can_cache=False).fetchall(), [(0, ), (1, )])
+        self.assertEqual(len(calls), 4)
+
+        # tuple BestIndex
+        calls.clear()
+        self.db.create_module("plans_tuples", Source(), cache_best_index=True)
+        self.db.execute("create virtual table plans4 using plans_tuples()")
+        for _ in range(3):
+            self.assertEqual(len(self.db.execute("select * from plans4 where c1 > 5", can_cache=False).fetchall()), 99)
+        self.assertEqual(len(calls), 1)
+
     def testWAL(self):
         "Test WAL functions"
         # note that it is harmless calling wal functions on a db not in wal mode
@@ -2367,6 +2937,68 @@ class APSW(unittest.TestCase):
         self.assertEqual(c.execute("select unspecdeterministic()=unspecdeterministic()").fetchall()[0][0], 0)
         self.assertRaises(apsw.SQLError, c.execute, "create index tdb on td(b) where nondeterministic()")
 
+    def testTypedScalarFunctions(self):
+        "Verify scalar functions with declared types"
+        import math
+
+        seen = []
+
+        def record(*args):
+            seen.append(args)
+            return args[0] if args else None
+
+        self.assertRaises(TypeError, self.db.create_scalar_function, "f", record, arg_types=3)
+        self.assertRaises(TypeError, self.db.create_scalar_function, "f", record, arg_types=[list])
+        self.assertRaises(TypeError, self.db.create_scalar_function, "f", record, return_type=dict)
+        self.assertRaises(ValueError, self.db.create_scalar_function, "f", record, 2, arg_types=[int])
+        self.assertRaises(ValueError, self.db.create_scalar_function, "f", None, arg_types=[int])
+
+        self.db.create_scalar_function("f", record, arg_types=[int, float, str, bytes, None])
+        vals = (3, 4.5, "six", b"seven", None)
+        self.assertEqual(self.db.execute("select f(?,?,?,?,?)", vals).get, 3)
+        self.assertEqual(seen[-1], vals)
+        # SQLite's conversions
+        self.assertEqual(self.db.execute("select f('12abc', '3.5', 7, 'eight', 9.5)").get, 12)
+        self.assertEqual(seen[-1], (12, 3.5, "7", b"eight", 9.5))
+        self.assertEqual(self.db.execute("select f(null, null, null, null, null)").get, 0)
+        self.assertEqual(seen[-1], (0, 0.0, "", b"", None))
+        # numargs comes from arg_types
+        self.assertRaises(apsw.SQLError, self.db.execute, "select f(1)")
+
+        # return types
+        for return_type, value, expected in (
+            (int, 7, 7),
+            (float, 7.5, 7.5),
+            (str, "seven", "seven"),
+            (bytes, b"seven", b"seven"),
+            # mismatches take the normal path
+            (int, "seven", "seven"),
+            (str, None, None),
+            (bytes, bytearray(b"seven"), b"seven"),
+            (float, 2**62, 2**62),
+        ):
+            self.db.create_scalar_function("g", lambda: value, return_type=return_type)
+            self.assertEqual(self.db.execute("select g()").get, expected)
+
+        self.db.create_scalar_function("g", lambda: 2**70, return_type=int)
+        self.assertRaises(OverflowError, self.db.execute, "select g()")
+        self.db.create_scalar_function("g", lambda: [], return_type=int)
+        self.assertRaises(TypeError, self.db.execute, "select g()")
+        self.db.create_scalar_function("g", lambda x: 1 / 0, arg_types=[int])
+        self.assertRaises(ZeroDivisionError, self.db.execute, "select g(1)")
+
+        # known builtins become deterministic so they can be used in indices
+        self.db.execute("create table foo(x)")
+        for func in (len, math.sqrt, str.upper, abs):
+            self.db.create_scalar_function("h", func, arg_types=[None], return_type=int)
+            self.db.execute("create index foo_h on foo(h(x)); drop index foo_h")
+        for func in (record, print, self.db.execute):
+            self.db.create_scalar_function("h", func, arg_types=[None], return_type=int)
+            self.assertRaises(apsw.SQLError, self.db.execute, "create index foo_h on foo(h(x))")
+        # but not without the types
+        self.db.create_scalar_function("h", len)
+        self.assertRaises(apsw.SQLError, self.db.execute, "create index foo_h on foo(h(x))")
+
     def testAggregateFunctions(self):
         "Verify aggregate functions"
         c = self.db
@@ -2558,6 +3190,110 @@ class APSW(unittest.TestCase):
         self.db.create_aggregate_function("summer2", summer, -1)
         self.assertRaisesRegex(TypeError, "final function must be callable", c.execute, "select summer2(val) from xyz")
 
+    def testAggregateBatch(self):
+        "Verify aggregate functions getting rows in batches"
+        import array
+
+        self.db.execute("create table foo(g, x, y)")
+        self.db.executemany("insert into foo values(?,?,?)", ((i % 3, i, f"{i}") for i in range(100)))
+
+        batches = []
+
+        class Batched:
+            def __init__(self):
+                self.total = 0
+                self.strings = []
+
+            def step_batch(self, columns):
+                batches.append(columns)
+                self.total += sum(columns[0])
+                self.strings.extend(columns[1])
+
+            def final(self):
+                return f"{self.total} {len(self.strings)}"
+
+        self.assertRaises(ValueError, self.db.create_aggregate_function, "b", Batched, batch_size=-1)
+        self.assertRaises(ValueError, self.db.create_aggregate_function, "b", None, batch_size=7)
+        self.assertRaises(TypeError, self.db.create_aggregate_function, "b", Batched, arg_types=[dict])
+
+        self.db.create_aggregate_function("b", Batched, batch_size=7, arg_types=[int, None])
+        self.assertEqual(self.db.execute("select b(x, y) from foo").get, f"{sum(range(100))} 100")
+        self.assertEqual([len(b[0]) for b in batches], [7] * 14 + [2])
+        for ints, others in batches:
+            self.assertIsInstance(ints, array.array)
+            self.assertEqual(ints.typecode, "q")
+            self.assertIsInstance(others, list)
+            self.assertEqual(list(ints), [int(o) for o in others])
+        # arg_types sets numargs
+        self.assertRaises(apsw.SQLError, self.db.execute, "select b(x) from foo")
+
+        # groups have separate batches, and no rows means no step_batch
+        batches.clear()
+        self.assertEqual(
+            self.db.execute("select g, b(x, y) from foo group by g order by g").get,
+            [(g, f"{sum(range(g, 100, 3))} {len(range(g, 100, 3))}") for g in range(3)],
+        )
+        self.assertEqual(sum(len(b[0]) for b in batches), 100)
+        batches.clear()
+        self.assertEqual(self.db.execute("select b(x, y) from foo where x < 0").get, "0 0")
+        self.assertEqual(batches, [])
+
+        # tuple form, float and untyped
+        def factory():
+            return [], lambda ctx, columns: ctx.append(columns), lambda ctx: repr(ctx)
+
+        self.db.create_aggregate_function("t", factory, batch_size=2, arg_types=[float])
+        self.assertEqual(
+            self.db.execute("select t(x) from foo where x < 3").get, repr([(array.array("d", [0, 1]),), (array.array("d", [2]),)])
+        )
+        self.db.create_aggregate_function("t", factory, 3, batch_size=2)
+        self.assertEqual(
+            self.db.execute("select t(x, y, null) from foo where x < 3").get,
+            repr([([0, 1], ["0", "1"], [None, None]), ([2], ["2"], [None])]),
+        )
+
+        # arg_types without batching
+        seen = []
+
+        class Typed:
+            def step(self, *args):
+                seen.append(args)
+
+            def final(self):
+                return len(seen)
+
+        self.db.create_aggregate_function("ty", Typed, arg_types=[str, float])
+        self.assertEqual(self.db.execute("select ty(x, y) from foo where x < 2").get, 2)
+        self.assertEqual(seen, [("0", 0.0), ("1", 1.0)])
+
+        # errors
+        class Bad:
+            def __init__(self):
+                self.calls = 0
+
+            def step_batch(self, columns):
+                self.calls += 1
+                if self.calls == 2:
+                    1 / 0
+
+            def final(self):
+                return self.calls
+
+        self.db.create_aggregate_function("bad", Bad, batch_size=10)
+        self.assertEqual(self.db.execute("select bad(x) from foo where x < 10").get, 1)
+        self.assertRaises(ZeroDivisionError, self.db.execute, "select bad(x) from foo where x < 25")
+        self.assertRaises(ZeroDivisionError, self.db.execute, "select bad(x) from foo")
+
+        class NoStepBatch:
+            def step(self, *args):
+                pass
+
+            def final(self):
+                return 0
+
+        self.db.create_aggregate_function("bad", NoStepBatch, batch_size=10)
+        self.assertRaises(AttributeError, self.db.execute, "select bad(x) from foo")
+
     def testWindowFunctions(self):
         "Verify window functions"
 
@@ -3207,6 +3943,123 @@ class APSW(unittest.TestCase):
         c.execute("insert into foo values(1000,1000)")
         self.assertEqual(1, curnext(c.execute("select count(*) from foo where x=1000"))[0])
 
+    def testUpdateHookBatch(self):
+        "Verify batched update hooks"
+        self.db.execute("create table foo(x integer primary key, y); attach '' as other; create table other.bar(z)")
+        batches = []
+        self.db.set_update_hook(batches.append, batch=1000)
+
+        self.db.execute("insert into foo values(1, 1), (2, 2); update foo set y=3 where x=1; insert into bar values(7)")
+        # each statement is its own transaction
+        self.assertEqual(batches, [[(apsw.SQLITE_INSERT, "main", "foo", 1), (apsw.SQLITE_INSERT, "main", "foo", 2)],
+                                   [(apsw.SQLITE_UPDATE, "main", "foo", 1)], [(apsw.SQLITE_INSERT, "other", "bar", 1)]])
+        del batches[:]
+
+        # held until commit
+        with self.db:
+            self.db.execute("insert into foo values(3, 3); delete from foo where x=2; insert into bar values(8)")
+            self.assertEqual(batches, [])
+        self.assertEqual(batches, [[(apsw.SQLITE_INSERT, "main", "foo", 3), (apsw.SQLITE_DELETE, "main", "foo", 2),
+                                    (apsw.SQLITE_INSERT, "other", "bar", 2)]])
+        del batches[:]
+
+        # discarded on rollback
+        self.db.execute("begin; insert into foo values(4, 4); rollback")
+        self.assertEqual(batches, [])
+        rolled = []
+        self.db.set_rollback_hook(lambda: rolled.append(1))
+        self.db.execute("begin; insert into foo values(4, 4); rollback")
+        self.assertEqual((batches, rolled), ([], [1]))
+        self.db.set_rollback_hook(None)
+
+        # commit hook veto discards too
+        self.db.set_commit_hook(lambda: True)
+        self.assertRaises(apsw.ConstraintError, self.db.execute, "insert into foo values(4, 4)")
+        self.assertEqual(batches, [])
+        self.db.set_commit_hook(lambda: False)
+        self.db.execute("insert into foo values(4, 4)")
+        self.assertEqual(batches, [[(apsw.SQLITE_INSERT, "main", "foo", 4)]])
+        self.db.set_commit_hook(None)
+        del batches[:]
+
+        # batch size reached
+        self.db.set_update_hook(batches.append, batch=3)
+        with self.db:
+            self.db.executemany("insert into foo values(?, ?)", ((i, i) for i in range(10, 18)))
+            self.assertEqual([len(b) for b in batches], [3, 3])
+        self.assertEqual([len(b) for b in batches], [3, 3, 2])
+        self.assertEqual([row[3] for b in batches for row in b], list(range(10, 18)))
+        del batches[:]
+
+        # with blocks that roll back discard their rows
+        self.db.set_update_hook(batches.append, batch=1000)
+        with self.db:
+            self.db.execute("insert into foo values(50, 50)")
+            with self.assertRaises(ZeroDivisionError):
+                with self.db:
+                    self.db.execute("insert into foo values(51, 51)")
+                    1 / 0
+            self.db.execute("insert into foo values(52, 52)")
+        self.assertEqual([row[3] for b in batches for row in b], [50, 52])
+        del batches[:]
+        # except those already delivered because the batch filled
+        self.db.set_update_hook(batches.append, batch=2)
+        with self.assertRaises(ZeroDivisionError):
+            with self.db:
+                self.db.execute("insert into foo values(53, 53), (54, 54), (55, 55)")
+                1 / 0
+        self.assertEqual([row[3] for b in batches for row in b], [53, 54])
+        self.assertEqual(self.db.execute("select count(*) from foo where x between 50 and 55").get, 2)
+        del batches[:]
+
+        # pending rows go to the existing hook when changed
+        self.db.execute("begin; insert into foo values(20, 20)")
+        self.db.set_update_hook(None)
+        self.db.execute("insert into foo values(21, 21); commit")
+        self.assertEqual(batches, [[(apsw.SQLITE_INSERT, "main", "foo", 20)]])
+        del batches[:]
+
+        # changing the hook while a statement on another thread adds rows
+        cur = self.db.cursor()
+        t = ThreadRunner(cur.execute, """with recursive c(i) as (values(1000) union all select i+1 from c where i<60999)
+                                         insert into foo select i, i from c""")
+        t.start()
+        i = 0
+        while t.is_alive():
+            self.db.set_update_hook(batches.append, batch=1 + i % 7)
+            i += 1
+        t.go()
+        self.db.set_update_hook(None)
+        rowids = [row[3] for b in batches for row in b]
+        self.assertEqual(len(rowids), len(set(rowids)))
+        self.assertTrue(set(rowids) <= set(range(1000, 61000)))
+        self.db.execute("delete from foo where x >= 1000")
+        del batches[:]
+
+        # exceptions
+        self.assertRaises(ValueError, self.db.set_update_hook, batches.append, batch=-1)
+
+        def uh(rows):
+            1 / 0
+
+        self.db.set_update_hook(uh, batch=10)
+        self.assertRaises(ZeroDivisionError, self.db.execute, "insert into foo values(30, 30)")
+        self.assertEqual(self.db.execute("select count(*) from foo where x=30").get, 0)
+        self.db.set_update_hook(uh, batch=2)
+        self.assertRaises(ZeroDivisionError, self.db.execute, "insert into foo values(31, 31), (32, 32)")
+        self.db.execute("begin; insert into foo values(33, 33)")
+        self.assertRaises(ZeroDivisionError, self.db.set_update_hook, None)
+        self.db.execute("rollback")
+        self.db.set_update_hook(None)
+
+        # unbatched hook with commit and rollback hooks unaffected
+        self.db.set_update_hook(batches.append, batch=10)
+        self.db.set_update_hook(lambda *args: None)
+        self.db.execute("insert into foo values(40, 40)")
+        self.db.set_update_hook(batches.append, batch=5)
+        self.db.execute("begin; insert into foo values(41, 41)")
+        self.db.close()
+
     def testProfile(self):
         "Verify profiling"
         # we do the test by looking for the maximum of PROFILESTEPS random
@@ -3298,6 +4151,37 @@ class APSW(unittest.TestCase):
         t.go()
         self.assertEqual(vals["raised"], True)
 
+    def testThreadingContention(self):
+        "Verify many threads contending for the same objects only get ThreadingViolation"
+        self.db.execute("create table foo(x); insert into foo values(1), (2), (3)")
+        c = self.db.cursor()
+        vals = {"stop": False, "violations": 0, "ok": 0}
+
+        def wt(n):
+            while not vals["stop"]:
+                try:
+                    if n % 3 == 0:
+                        self.db.execute("select sum(x) from foo").get
+                    elif n % 3 == 1:
+                        c.execute("select x from foo").fetchall()
+                    else:
+                        self.db.set_busy_timeout(10)
+                    vals["ok"] += 1
+                except apsw.ThreadingViolationError:
+                    vals["violations"] += 1
+
+        threads = [ThreadRunner(wt, n) for n in range(6)]
+        for t in threads:
+            t.start()
+        time.sleep(1)
+        vals["stop"] = True
+        for t in threads:
+            t.go()
+        self.assertGreater(vals["ok"], 0)
+        # everything still works
+        self.assertEqual(self.db.execute("select sum(x) from foo").get, 6)
+        self.assertEqual(c.execute("select x from foo").fetchall(), [(1, ), (2, ), (3, )])
+
     def testStringsWithNulls(self):
         "Verify that strings with nulls in them are handled correctly"
 
@@ -3513,6 +4397,260 @@ class APSW(unittest.TestCase):
             """select json_extract('{"a":2,"c":[4,5,{"f":7}]}', '$.c[2].f')""").fetchall()[0][0]
         self.assertEqual(l, 7)
 
+    def testSessionExtension(self):
+        "Check session extension if present"
+        if not hasattr(apsw, "Session"):
+            self.assertNotIn("APSW_TEST_SESSION", os.environ)
+            return
+
+        schema = "create table foo(x integer primary key, y, z); create table bar(a, b, primary key(a, b))"
+        self.db.execute(schema)
+        replica = apsw.Connection("")
+        replica.execute(schema)
+
+        session = apsw.Session(self.db, "main")
+        self.assertTrue(session.enabled)
+        self.assertFalse(session.indirect)
+        self.assertTrue(session.is_empty)
+        session.attach()
+        self.db.execute("""insert into foo values(1, 'one', 1.1), (2, x'aabb', null), (3, 3, 3);
+                           insert into bar values('a', 'b');
+                           update foo set z=99 where x=3;
+                           delete from foo where x=2""")
+        self.assertFalse(session.is_empty)
+        self.assertGreater(session.memory_used, 0)
+
+        changeset = session.changeset()
+        self.assertIsInstance(changeset, bytes)
+        patchset = session.patchset()
+        self.assertLess(len(patchset), len(changeset) + 1)
+
+        changes = {}
+        for change in apsw.Changeset(changeset):
+            self.assertEqual(change.op, "INSERT")
+            self.assertEqual(change.opcode, apsw.SQLITE_INSERT)
+            self.assertIsNone(change.old)
+            self.assertIsNone(change.conflict)
+            self.assertIsNone(change.fk_conflicts)
+            self.assertFalse(change.indirect)
+            self.assertIn("INSERT", str(change))
+            changes.setdefault(change.name, []).append(change.new)
+            if change.name == "bar":
+                self.assertEqual(change.pk_columns, {0, 1})
+                self.assertEqual(change.column_count, 2)
+            else:
+                self.assertEqual(change.pk_columns, {0})
+                self.assertEqual(change.column_count, 3)
+        self.assertEqual(sorted(changes["foo"]), [(1, "one", 1.1), (3, 3, 99)])
+        self.assertEqual(changes["bar"], [("a", "b")])
+        # out of scope
+        self.assertRaises(ValueError, getattr, change, "name")
+        self.assertIn("out of scope", str(change))
+
+        apsw.Changeset(changeset).apply(replica)
+        self.assertEqual(self.db.execute("select * from foo order by x").get,
+                         replica.execute("select * from foo order by x").get)
+        self.assertEqual(replica.execute("select * from bar").get, ("a", "b"))
+
+        # updates provide unchanged columns as no_change
+        session.close()
+        session = apsw.Session(self.db, "main")
+        session.attach("foo")
+        self.db.execute("update foo set y='uno' where x=1; insert into bar values(1, 2)")
+        changes = list((c.op, c.old, c.new) for c in apsw.Changeset(session.changeset()))
+        self.assertEqual(changes, [("UPDATE", (1, "one", apsw.no_change), (apsw.no_change, "uno", apsw.no_change))])
+
+        # conflicts
+        replica.execute("update foo set y='ichi' where x=1")
+        self.assertRaises(apsw.AbortError, apsw.Changeset(session.changeset()).apply, replica)
+        self.assertEqual(replica.execute("select y from foo where x=1").get, "ichi")
+
+        seen = []
+
+        def conflict(kind, change):
+            seen.append((kind, change.op, change.conflict))
+            return apsw.SQLITE_CHANGESET_OMIT
+
+        apsw.Changeset(session.changeset()).apply(replica, conflict=conflict)
+        self.assertEqual(seen, [(apsw.SQLITE_CHANGESET_DATA, "UPDATE", (1, "ichi", 1.1))])
+        self.assertEqual(replica.execute("select y from foo where x=1").get, "ichi")
+
+        apsw.Changeset(session.changeset()).apply(replica, conflict=lambda *args: apsw.SQLITE_CHANGESET_REPLACE)
+        self.assertEqual(replica.execute("select y from foo where x=1").get, "uno")
+
+        def conflict(kind, change):
+            1 / 0
+
+        replica.execute("update foo set y='ichi' where x=1")
+        self.assertRaises(ZeroDivisionError, apsw.Changeset(session.changeset()).apply, replica, conflict=conflict)
+        self.assertRaises(ValueError,
+                          apsw.Changeset(session.changeset()).apply,
+                          replica,
+                          conflict=lambda *args: 42)
+        self.assertRaises(TypeError,
+                          apsw.Changeset(session.changeset()).apply,
+                          replica,
+                          conflict=lambda *args: "omit")
+
+        # filter
+        tables = []
+        apsw.Changeset(changeset).apply(replica,
+                                        filter=lambda name: tables.append(name) or False,
+                                        conflict=lambda *args: apsw.SQLITE_CHANGESET_ABORT)
+        self.assertEqual(sorted(tables), ["bar", "foo"])
+        self.assertRaises(ZeroDivisionError, apsw.Changeset(changeset).apply, replica, filter=lambda name: 1 / 0)
+        # an exception for one table undoes the others
+        replica.execute("delete from foo; delete from bar")
+        self.assertRaises(ZeroDivisionError,
+                          apsw.Changeset(changeset).apply,
+                          replica,
+                          filter=lambda name: name == "foo" or 1 / 0)
+        self.assertEqual(replica.execute("select count(*) from foo").get, 0)
+        self.assertEqual(replica.execute("select count(*) from bar").get, 0)
+
+        # invert
+        replica.execute("delete from foo; delete from bar")
+        apsw.Changeset(changeset).apply(replica)
+        apsw.Changeset(apsw.Changeset(changeset).invert()).apply(replica)
+        self.assertEqual(replica.execute("select count(*) from foo").get, 0)
+        self.assertEqual(replica.execute("select count(*) from bar").get, 0)
+
+        # concat and builder
+        second = session.changeset()
+        combined = apsw.Changeset(changeset).concat(second)
+        builder = apsw.ChangesetBuilder()
+        builder.add(changeset)
+        builder.add(second)
+        self.assertEqual(builder.output(), combined)
+        self.assertIn(("foo", (1, "uno", 1.1)), [(c.name, c.new) for c in apsw.Changeset(combined)])
+        builder.close()
+        builder.close()
+        self.assertRaises(apsw.ConnectionClosedError, builder.output)
+        self.assertRaises(TypeError, apsw.ChangesetBuilder, 3)
+
+        # streaming
+        def reader(data, sizes):
+            data = io.BytesIO(data)
+
+            def read(n):
+                sizes.append(n)
+                return data.read(min(n, 7))
+
+            return read
+
+        def collect():
+            chunks = []
+
+            def output(view):
+                self.assertIsInstance(view, memoryview)
+                chunks.append(bytes(view))
+
+            return chunks, output
+
+        sizes = []
+        self.assertEqual([(c.name, c.new) for c in apsw.Changeset(reader(changeset, sizes))],
+                         [(c.name, c.new) for c in apsw.Changeset(changeset)])
+        self.assertTrue(sizes)
+        chunks, output = collect()
+        self.assertIsNone(session.changeset_stream(output))
+        self.assertEqual(b"".join(chunks), second)
+        chunks, output = collect()
+        session.patchset_stream(output)
+        self.assertEqual(b"".join(chunks), session.patchset())
+        self.assertEqual(apsw.Changeset(reader(changeset, [])).invert(), apsw.Changeset(changeset).invert())
+        chunks, output = collect()
+        apsw.Changeset(changeset).invert_stream(output)
+        self.assertEqual(b"".join(chunks), apsw.Changeset(changeset).invert())
+        self.assertEqual(apsw.Changeset(reader(changeset, [])).concat(reader(second, [])), combined)
+        chunks, output = collect()
+        apsw.Changeset(changeset).concat_stream(second, output)
+        self.assertEqual(b"".join(chunks), combined)
+        builder = apsw.ChangesetBuilder()
+        builder.add(reader(changeset, []))
+        chunks, output = collect()
+        builder.output_stream(output)
+        self.assertEqual(b"".join(chunks), changeset)
+        replica.execute("delete from foo; delete from bar")
+        apsw.Changeset(reader(changeset, [])).apply(replica)
+        self.assertEqual(replica.execute("select count(*) from foo").get, 2)
+
+        self.assertRaises(ZeroDivisionError, list, apsw.Changeset(lambda n: 1 / 0))
+        self.assertRaises(ValueError, list, apsw.Changeset(lambda n: b"x" * (n + 1)))
+        self.assertRaises(TypeError, list, apsw.Changeset(lambda n: 3))
+        self.assertRaises(ZeroDivisionError, session.changeset_stream, lambda view: 1 / 0)
+        self.assertRaises(apsw.CorruptError, list, apsw.Changeset(b"\x00" * 10))
+        self.assertRaises(TypeError, apsw.Changeset, 3)
+        self.assertRaises(RuntimeError, apsw.Changeset(b"").__init__, b"")
+        self.assertEqual(list(apsw.Changeset(b"")), [])
+
+        # diff
+        self.db.execute("attach '' as other; create table other.foo(x integer primary key, y, z);"
+                        "insert into other.foo values(7, 7, 7)")
+        session.close()
+        session = apsw.Session(self.db, "main")
+        session.attach("foo")
+        session.diff("other", "foo")
+        changes = sorted((c.op, c.old, c.new) for c in apsw.Changeset(session.changeset()))
+        self.assertEqual(changes[0], ("DELETE", (7, 7, 7), None))
+        self.assertEqual([c[0] for c in changes[1:]], ["INSERT"] * 2)
+        session.attach("bar")
+        self.assertRaises(apsw.SchemaChangeError, session.diff, "other", "bar")
+
+        # table filter, enabled and indirect
+        session.close()
+        session = apsw.Session(self.db, "main")
+        session.attach()
+        session.table_filter(lambda name: name == "bar")
+        session.indirect = True
+        self.db.execute("insert into foo values(10, 10, 10); insert into bar values(10, 10)")
+        session.enabled = False
+        self.assertFalse(session.enabled)
+        self.db.execute("insert into bar values(11, 11)")
+        changes = [(c.name, c.new, c.indirect) for c in apsw.Changeset(session.changeset())]
+        self.assertEqual(changes, [("bar", (10, 10), True)])
+        self.assertRaises(TypeError, setattr, session, "enabled", 1)
+        session.enabled = True
+        session.table_filter(lambda name: 1 / 0)
+        self.assertRaises(ZeroDivisionError, self.db.execute, "insert into foo values(11, 11, 11)")
+        # the session can't be closed from inside the filter
+        session.close()
+        session = apsw.Session(self.db, "main")
+        session.attach()
+        session.table_filter(lambda name: session.close())
+        self.assertRaises(apsw.ThreadingViolationError, self.db.execute, "insert into foo values(12, 12, 12)")
+        self.assertTrue(session.is_empty)
+        session.table_filter(None)
+
+        # reference cycles through callbacks are collected
+        class Marker:
+            pass
+
+        db2 = apsw.Connection("")
+        cycle = apsw.Session(db2, "main")
+        marker = Marker()
+        cycle.table_filter(lambda name, refs=[cycle, marker]: True)
+        collected = [weakref.ref(marker)]
+        holder = [Marker()]
+        changeset = apsw.Changeset(lambda size, refs=holder: b"")
+        holder.append(changeset)
+        collected.append(weakref.ref(holder[0]))
+        holder = [Marker()]
+        it = iter(apsw.Changeset(lambda size, refs=holder: b""))
+        holder.append(it)
+        collected.append(weakref.ref(holder[0]))
+        del cycle, marker, holder, changeset, it
+        gc.collect()
+        self.assertEqual([None, None, None], [ref() for ref in collected])
+        db2.close()
+
+        # closing
+        self.assertIn("Session", str(session))
+        self.db.close()
+        self.assertRaises(apsw.ConnectionClosedError, session.changeset)
+        self.assertRaises(apsw.ConnectionClosedError, setattr, session, "indirect", True)
+        session.close()
+        self.assertRaises(apsw.ConnectionClosedError, apsw.Session, self.db, "main")
+
     def testTracebacks(self):
         "Verify augmented tracebacks"
 
@@ -5141,6 +6279,423 @@ class APSW(unittest.TestCase):
         cur.execute("select 3").fetchall()
         self.assertEqual(cur.get, None)
 
+    def testCursorFetchmanyColumns(self):
+        "Cursor.fetchmany_columns"
+        cur = self.db.cursor()
+        self.assertRaises(TypeError, cur.fetchmany_columns, "three")
+        self.assertRaises(ValueError, cur.execute("select 3").fetchmany_columns, 0)
+        self.assertIsNone(cur.execute("select 3 where 0").fetchmany_columns())
+
+        rows = [(1, 1.5, "one", b"\x01", None, 7), (None, None, None, None, None, "seven"), (3, 3.5, "three\N{BLACK STAR}", b"", None, b"7")]
+        self.db.execute("create table fmc(i, f, t, b, n, m)")
+        self.db.executemany("insert into fmc values(?,?,?,?,?,?)", rows)
+
+        cur.execute("select i, f, t, b, n, m from fmc order by rowid")
+        batch = cur.fetchmany_columns(2)
+        self.assertEqual([c["name"] for c in batch], ["i", "f", "t", "b", "n", "m"])
+        self.assertEqual(batch[0]["rows"], 2)
+        batch2 = cur.fetchmany_columns(2)
+        self.assertEqual(batch2[0]["rows"], 1)
+        self.assertIsNone(cur.fetchmany_columns(2))
+
+        def decode(column):
+            rows = []
+            for row in range(column["rows"]):
+                if not column["valid"][row // 8] & (1 << (row % 8)):
+                    rows.append(None)
+                elif column["type"] in {"int", "float"}:
+                    rows.append(column["values"][row])
+                elif column["type"] in {"str", "bytes"}:
+                    v = column["values"][column["offsets"][row]:column["offsets"][row + 1]]
+                    rows.append(v.decode("utf8") if column["type"] == "str" else v)
+                else:
+                    rows.append(column["values"][row])
+            return rows
+
+        batch = cur.execute("select * from fmc order by rowid").fetchmany_columns(100)
+        self.assertEqual([c["type"] for c in batch], ["int", "float", "str", "bytes", "null", "object"])
+        self.assertEqual(list(zip(*(decode(c) for c in batch))), rows)
+        for c in batch:
+            self.assertEqual(c["null_count"], sum(1 for r in decode(c) if r is None))
+        self.assertEqual(batch[0]["values"].typecode, "q")
+        self.assertEqual(batch[0]["values"].tolist(), [1, 0, 3])
+        self.assertEqual(batch[1]["values"].typecode, "d")
+        self.assertEqual(batch[2]["offsets"].tolist(), [0, 3, 3, 3 + len("three\N{BLACK STAR}".encode("utf8"))])
+        self.assertEqual(batch[4]["values"], None)
+        self.assertEqual(batch[4]["offsets"], None)
+
+        # leading nulls then a value, and switching type after nulls
+        for vals in ((None, None, 3), (None, "a", None, 3), (None, b"a", 2.2)):
+            got = self.db.execute(" union all ".join("select ?" for _ in vals), vals).fetchmany_columns()
+            self.assertEqual(decode(got[0]), list(vals))
+
+        # large batches grow buffers
+        cur.execute("with recursive c(x) as (select 1 union all select x+1 from c limit 10000) select x, x*1.5, 'x' || x from c")
+        got = cur.fetchmany_columns(100000)
+        self.assertEqual(got[0]["values"].tolist(), list(range(1, 10001)))
+        self.assertEqual(decode(got[2]), ["x%d" % i for i in range(1, 10001)])
+
+        # multiple statements stop at different column count
+        cur.execute("select 1, 2 ; select 3")
+        self.assertEqual(cur.fetchmany_columns()[1]["values"].tolist(), [2])
+        self.assertEqual(len(cur.fetchmany_columns()), 1)
+        self.assertIsNone(cur.fetchmany_columns())
+
+        # executemany continues across bindings
+        got = self.db.executemany("select ?", [(i, ) for i in range(10)]).fetchmany_columns()
+        self.assertEqual(got[0]["values"].tolist(), list(range(10)))
+
+        # row tracer is not used
+        cur.row_trace = lambda *args: 1 / 0
+        self.assertEqual(cur.execute("select 3").fetchmany_columns()[0]["values"].tolist(), [3])
+        cur.row_trace = None
+
+        # errors part way through a batch
+        self.db.create_scalar_function("fail_at", lambda x: 1 / (x - 5))
+        cur.execute("with recursive c(x) as (select 1 union all select x+1 from c limit 10) select fail_at(x) from c")
+        self.assertRaises(ZeroDivisionError, cur.fetchmany_columns)
+
+        # profiling still counts the rows
+        self.db.profile_statements = True
+        sql = "with recursive c(x) as (select 1 union all select x+1 from c limit 50) select x from c"
+        self.assertEqual(50, self.db.execute(sql).fetchmany_columns()[0]["rows"])
+        self.db.profile_statements = False
+        entry = [e for e in self.db.cache_stats(True)["entries"] if e["query"] == sql][0]
+        self.assertEqual(entry["rows"], 50)
+
+    def testWholeRowFetch(self):
+        "Connection.whole_row_fetch"
+        self.assertRaises(TypeError, apsw.whole_row_fetch)
+        self.assertRaises(TypeError, apsw.whole_row_fetch, "yes")
+        self.assertFalse(self.db.whole_row_fetch)
+        self.assertRaises(TypeError, setattr, self.db, "whole_row_fetch", "yes")
+
+        self.assertFalse(apsw.whole_row_fetch(True))
+        try:
+            self.assertFalse(self.db.whole_row_fetch)
+            self.assertTrue(apsw.Connection("").whole_row_fetch)
+        finally:
+            self.assertTrue(apsw.whole_row_fetch(False))
+        self.assertFalse(apsw.Connection("").whole_row_fetch)
+
+        # more columns than fit on the stack
+        sql = "select " + ", ".join(("?", "3.25", "'a\N{BLACK STAR}' || ?", "x'aabb'", "null", "zeroblob(3)")[i % 6] + f" as c{ i }" for i in range(100))
+        sql += " from (select 1 union all select 2 union all select 3)"
+        bindings = tuple(range(sql.count("?")))
+
+        results = {}
+        for setting in (False, True):
+            self.db.whole_row_fetch = setting
+            self.assertEqual(self.db.whole_row_fetch, setting)
+            got = []
+            for ncols in (1, 6, 100):
+                q = "select " + ", ".join(f"c{ i }" for i in range(ncols)) + " from (" + sql + ")"
+                got.append(self.db.execute(q, bindings).fetchall())
+                got.append(self.db.execute(q, bindings).get)
+                got.append(list(self.db.execute(q + "; select 7, 8", bindings)))
+            cur = self.db.cursor()
+            cur.row_trace = lambda cur, row: row[:2]
+            got.append(cur.execute(sql, bindings).fetchall())
+            results[setting] = got
+        self.assertEqual(results[False], results[True])
+        self.assertEqual(results[True][-1], [(0, 3.25)] * 3)
+
+    def testNamedRows(self):
+        "Connection.named_rows and apsw.Row"
+        self.assertFalse(self.db.named_rows)
+        self.assertRaises(TypeError, setattr, self.db, "named_rows", 1)
+        self.assertIs(type(self.db.execute("select 1, 2").get), tuple)
+        self.db.named_rows = True
+        self.assertRaises(TypeError, apsw.Row)
+
+        for whole_row_fetch in (False, True):
+            self.db.whole_row_fetch = whole_row_fetch
+            row = self.db.execute("select 1 as one, 'two' as two, null as [_asdict], 4 as one").fetchall()[0]
+            self.assertIs(type(row), apsw.Row)
+            self.assertEqual(row._fields, ("one", "two", "_asdict", "one"))
+            self.assertEqual(len(row), 4)
+            wide = self.db.execute("select " + ", ".join(f"{i} as c{i}" for i in range(40))).fetchall()[0]
+            self.assertEqual((type(wide), wide.c39, tuple(wide)), (apsw.Row, 39, tuple(range(40))))
+            self.assertEqual(row, (1, "two", None, 4))
+            self.assertEqual((1, "two", None, 4), row)
+            self.assertNotEqual(row, [1, "two", None, 4])
+            self.assertLess(row, (2,))
+            self.assertEqual(hash(row), hash((1, "two", None, 4)))
+            self.assertEqual(list(row), [1, "two", None, 4])
+            self.assertIn("two", row)
+            # first column with a name wins, and names shadow methods
+            self.assertEqual(row.one, 1)
+            self.assertEqual(row["one"], 1)
+            self.assertIsNone(row._asdict)
+            self.assertEqual(row[1], "two")
+            self.assertEqual(row[-1], 4)
+            self.assertEqual(row[1:3], ("two", None))
+            self.assertEqual(row[::-2], (4, "two"))
+            self.assertRaises(IndexError, lambda: row[4])
+            self.assertRaises(IndexError, lambda: row[-5])
+            self.assertRaises(KeyError, lambda: row["three"])
+            self.assertRaises(AttributeError, lambda: row.three)
+            self.assertRaises(TypeError, lambda: row[1.0])
+            self.assertEqual(repr(row), "Row(one=1, two='two', _asdict=None, one=4)")
+
+        row = self.db.execute("select 1 as a, 2 as b, 3 as a").get
+        self.assertEqual(row._asdict(), {"a": 1, "b": 2})
+        self.assertEqual(self.db.execute("select 3").get, 3)
+        self.assertEqual(self.db.execute("select 3 as x, 0 union all select 4, 0").get, [(3, 0), (4, 0)])
+        self.assertEqual(self.db.execute("select 3 as x, 0 union all select 4, 0").get[1].x, 4)
+
+        # names are made once per statement, and again after a reprepare
+        self.db.execute("create table named(x, y)")
+        self.db.execute("insert into named values(1, 2), (3, 4)")
+        rows = self.db.execute("select * from named").fetchall()
+        self.assertEqual([r._fields for r in rows], [("x", "y")] * 2)
+        self.assertIs(rows[0]._fields, rows[1]._fields)
+        self.assertIs(self.db.execute("select * from named").get[0]._fields, rows[0]._fields)
+        self.db.execute("alter table named rename column y to z")
+        self.assertEqual(self.db.execute("select * from named").get[0]._fields, ("x", "z"))
+
+        # row tracers get the Row
+        cur = self.db.cursor()
+        cur.row_trace = lambda cursor, row: row.x
+        self.assertEqual(cur.execute("select * from named").fetchall(), [1, 3])
+
+        # converters can make values that refer back to the row
+        class Marker:
+            pass
+
+        self.db.register_converter("CYCLE", lambda value: [Marker()])
+        self.db.execute("create table cycle(c CYCLE); insert into cycle values(1)")
+        row = self.db.execute("select c from cycle").fetchall()[0]
+        self.assertTrue(gc.is_tracked(row))
+        row.c.append(row)
+        marker = weakref.ref(row.c[0])
+        del row
+        gc.collect()
+        self.assertIsNone(marker())
+        self.db.register_converter("CYCLE", None)
+
+        self.db.named_rows = False
+        self.assertIs(type(self.db.execute("select 1, 2").get), tuple)
+
+    def testTypeRegistry(self):
+        "Connection.register_adapter and register_converter"
+        import datetime, decimal
+        self.assertRaises(TypeError, self.db.register_adapter, "date", str)
+        self.assertRaises(TypeError, self.db.register_adapter, datetime.date, 3)
+        self.assertRaises(TypeError, self.db.register_converter, b"DATE", str)
+        self.assertRaises(TypeError, self.db.register_converter, "DATE")
+        # removing something not registered is fine
+        self.db.register_adapter(datetime.date, None)
+        self.db.register_converter("DATE", None)
+
+        self.assertRaises(TypeError, self.db.execute, "select ?", (datetime.date(2024, 1, 2),))
+        self.db.register_adapter(datetime.date, datetime.date.isoformat)
+        self.db.register_adapter(decimal.Decimal, str)
+        self.db.register_adapter(bool, lambda b: "yes" if b else "no")
+        # builtin types are never looked up
+        self.db.register_adapter(int, lambda i: 1 / 0)
+        self.assertEqual(self.db.execute("select ?, ?, ?, ?", (datetime.date(2024, 1, 2), decimal.Decimal("1.5"), True, 7)).get,
+                         ("2024-01-02", "1.5", "yes", 7))
+        self.assertEqual(self.db.execute("select :d", {"d": datetime.date(2024, 1, 2)}).get, "2024-01-02")
+        # exact type only
+        class mydate(datetime.date): pass
+        self.assertRaises(TypeError, self.db.execute, "select ?", (mydate(2024, 1, 2),))
+        # adapted values aren't adapted again
+        self.db.register_adapter(mydate, lambda d: datetime.date(d.year, d.month, d.day))
+        self.assertRaises(TypeError, self.db.execute, "select ?", (mydate(2024, 1, 2),))
+        self.db.register_adapter(mydate, lambda d: 1 / 0)
+        self.assertRaises(ZeroDivisionError, self.db.execute, "select ?", (mydate(2024, 1, 2),))
+
+        self.db.execute("create table events(id INTEGER, happened DATE, amount DECIMAL)")
+        self.db.executemany("insert into events values(?, ?, ?)", ((1, datetime.date(2024, 1, 2), decimal.Decimal("3.25")),
+                                                                    (2, None, decimal.Decimal("-1"))))
+        self.assertEqual(self.db.execute("select * from events").fetchall(), [(1, "2024-01-02", 3.25), (2, None, -1)])
+
+        self.db.register_converter("DATE", datetime.date.fromisoformat)
+        self.db.register_converter("DECIMAL", decimal.Decimal)
+        expected = [(1, datetime.date(2024, 1, 2), decimal.Decimal("3.25")), (2, None, decimal.Decimal("-1"))]
+        for whole_row_fetch in (False, True):
+            for named_rows in (False, True):
+                self.db.whole_row_fetch = whole_row_fetch
+                self.db.named_rows = named_rows
+                self.assertEqual(self.db.execute("select * from events").fetchall(), expected)
+                self.assertEqual(self.db.execute("select * from events").get, expected)
+                self.assertEqual(self.db.execute("select happened from events where id=1").get, expected[0][1])
+        self.db.whole_row_fetch = self.db.named_rows = False
+        # expressions have no declared type
+        self.assertEqual(self.db.execute("select happened || '' from events where id=1").get, "2024-01-02")
+        # row tracers see converted values
+        cur = self.db.cursor()
+        cur.row_trace = lambda cursor, row: row[1:2]
+        self.assertEqual(cur.execute("select * from events").fetchall(), [(expected[0][1],), (None,)])
+
+        # changes to converters apply to cached statements
+        self.db.register_converter("DECIMAL", None)
+        self.assertEqual(self.db.execute("select amount from events").get, [3.25, -1])
+        self.db.register_converter("DECIMAL", float)
+        self.assertEqual(self.db.execute("select amount from events").get, [3.25, -1.0])
+        # and schema changes
+        self.db.execute("alter table events add column other DATE")
+        self.db.execute("update events set other='2000-01-01'")
+        self.assertEqual(self.db.execute("select * from events where id=2").get, (2, None, -1.0, datetime.date(2000, 1, 1)))
+
+        self.db.register_converter("DATE", lambda v: 1 / 0)
+        self.assertRaises(ZeroDivisionError, self.db.execute("select * from events").fetchall)
+        self.assertRaises(ZeroDivisionError, lambda: self.db.execute("select * from events").get)
+
+    def testImportFile(self):
+        "Connection.import_file"
+        import csv, json
+        fn = TESTFILEPREFIX + "testimport"
+
+        def write(data):
+            with open(fn, "wb") as f:
+                f.write(data.encode("utf8") if isinstance(data, str) else data)
+            return fn
+
+        self.db.execute("create table imp(a, b, c)")
+
+        def imported(data, **kwargs):
+            self.db.execute("delete from imp")
+            count = self.db.import_file(write(data), "imp", **kwargs)
+            rows = self.db.execute("select * from imp").fetchall()
+            self.assertEqual(count, len(rows))
+            return rows
+
+        self.assertRaises(TypeError, self.db.import_file, fn)
+        self.assertRaises(ValueError, self.db.import_file, write(""), "imp", format="json")
+        for sep in ("", ",,", '"', "\n", "\N{BLACK STAR}"):
+            self.assertRaises(ValueError, self.db.import_file, fn, "imp", separator=sep)
+        self.assertRaises(ValueError, self.db.import_file, fn, "imp", commit_every=-1)
+        self.assertRaises(FileNotFoundError, self.db.import_file, fn + "-nosuch", "imp")
+        self.assertRaisesRegex(apsw.SQLError, "no such table", self.db.import_file, fn, "nosuch")
+
+        self.assertEqual(imported(""), [])
+        self.assertEqual(
+            imported('\ufeff1,"two, three",\r\n\n"a""b","multi\nline"x,"\N{BLACK STAR}"\n\n4,5,6'),
+            [("1", "two, three", ""), ('a"b', "multi\nlinex", "\N{BLACK STAR}"), ("4", "5", "6")])
+        self.assertEqual(imported("h1,h2,h3\n1,2,3\n", header=True), [("1", "2", "3")])
+        self.assertEqual(imported('"1"\t2\t"3\t4"\n', separator="\t"), [("1", "2", "3\t4")])
+        self.assertEqual(imported('"1"|2"|"3\n', separator="|", quoting=False), [('"1"', '2"', '"3')])
+        self.assertRaisesRegex(ValueError, "row 2 has 2 columns but should have 3", imported, "1,2,3\n4,5\n6,7,8")
+        imported("1,2,3\n")
+        self.assertRaises(ValueError, imported, "1,2,3\n4,5")
+        # the whole import was rolled back
+        self.assertEqual(self.db.execute("select count(*) from imp").get, 0)
+
+        self.assertEqual(
+            imported('[1, "two", null]\n\n{"c": 3.5, "a": [1, 2]}\r\n["x"]\n', format="jsonl"),
+            [(1, "two", None), ("[1,2]", None, 3.5), ("x", None, None)])
+        self.assertRaisesRegex(apsw.SQLError, "malformed JSON", imported, "[1,2,3]\n{nope}\n", format="jsonl")
+
+        # commit_every leaves earlier rows on error
+        self.db.execute("delete from imp")
+        self.assertRaises(ValueError, self.db.import_file, write("1,2,3\n4,5,6\n7,8,9\n0\n"), "imp", commit_every=2)
+        self.assertEqual(self.db.execute("select count(*) from imp").get, 2)
+        self.assertEqual(imported("1,2,3\n4,5,6\n7,8,9\n", commit_every=2), [("1", "2", "3"), ("4", "5", "6"), ("7", "8", "9")])
+        self.assertFalse(self.db.in_transaction)
+
+        # a savepoint is used inside a transaction
+        self.db.execute("delete from imp")
+        with self.db:
+            self.db.execute("insert into imp values(0, 0, 0)")
+            self.assertEqual(self.db.import_file(write("1,2,3\n"), "imp", commit_every=1), 1)
+            self.assertRaises(ValueError, self.db.import_file, write("4,5,6\n7\n"), "imp")
+            self.assertTrue(self.db.in_transaction)
+        self.assertEqual(self.db.execute("select count(*) from imp").get, 2)
+
+        # many chunks of data with records spanning them, compared to the csv module
+        rows = []
+        for i in range(120000):
+            rows.append((str(i), "x" * (i % 97) + ('"quoted,\nvalue"' if i % 7 == 0 else ""), "\N{BLACK STAR}" * (i % 5)))
+        with open(fn, "w", newline="", encoding="utf8") as f:
+            csv.writer(f).writerows(rows)
+        self.assertGreater(os.path.getsize(fn), 4 * 1024 * 1024)
+        self.db.execute("delete from imp")
+        self.assertEqual(self.db.import_file(fn, "imp", commit_every=10000), len(rows))
+        self.assertEqual(self.db.execute("select * from imp order by rowid").fetchall(), rows)
+        with open(fn, "w", encoding="utf8") as f:
+            for row in rows:
+                f.write(json.dumps(dict(zip("abc", row))) + "\n")
+        self.db.execute("delete from imp")
+        self.assertEqual(self.db.import_file(fn, "imp", format="jsonl"), len(rows))
+        self.assertEqual(self.db.execute("select * from imp order by rowid").fetchall(), rows)
+
+    def testExportQuery(self):
+        "Connection.export_query"
+        import json
+        fn = TESTFILEPREFIX + "testexport"
+
+        def exported(query, **kwargs):
+            count = self.db.export_query(fn, query, **kwargs)
+            self.assertEqual(count, self.db.execute("select count(*) from (" + query + ")").get)
+            with open(fn, "rb") as f:
+                return f.read().decode("utf8")
+
+        self.assertRaises(TypeError, self.db.export_query, fn)
+        self.assertRaises(TypeError, self.db.export_query, 3.2, "select 3")
+        self.assertRaises(ValueError, self.db.export_query, -1, "select 3")
+        self.assertRaises(ValueError, self.db.export_query, fn, "select 3", format="json")
+        for sep in ("", ",,", '"', "\n", "\N{BLACK STAR}"):
+            self.assertRaises(ValueError, self.db.export_query, fn, "select 3", format="csv", separator=sep)
+        self.assertRaises(FileNotFoundError, self.db.export_query, fn + "-nosuch/file", "select 3")
+        self.assertRaises(OSError, self.db.export_query, 1234, "select 3")
+        self.assertRaisesRegex(ValueError, "empty", self.db.export_query, fn, " -- comment")
+        self.assertRaisesRegex(ValueError, "one statement", self.db.export_query, fn, "select 3; select 4")
+        self.assertRaisesRegex(ValueError, "columns", self.db.export_query, fn, "create table nope(x)")
+        self.assertRaises(apsw.SQLError, self.db.export_query, fn, "select * from nosuch")
+        self.assertRaisesRegex(ValueError, "bindings", self.db.export_query, fn, "select ?")
+        self.assertRaisesRegex(apsw.SQLError, "integer overflow", self.db.export_query, fn,
+                               "select 1 union all select abs(-9223372036854775808)")
+
+        self.db.execute("create table exp(a, b, c)")
+        self.assertEqual(exported("select * from exp"), "")
+        values = [(1, -2.5, "x,y"), (None, b"\x01\x02\xff", "it's"), (float("inf"), float("-inf"), 'a"b\n\N{BLACK STAR}'),
+                  (-(2**63), 1 / 3, "nul\0char"), (0.0, 1e300, b"")]
+        self.db.executemany("insert into exp values(?,?,?)", values)
+
+        sql = exported("select * from exp")
+        self.assertEqual(
+            sql.splitlines()[0:2],
+            ["INSERT INTO \"table\" VALUES(1,-2.5,'x,y');", "INSERT INTO \"table\" VALUES(NULL,X'0102FF','it''s');"])
+        for value in values[0] + values[1] + values[2]:
+            self.assertIn(apsw.format_sql_value(value), sql)
+        self.assertTrue(exported("select * from exp", table="exp2").startswith("INSERT INTO exp2 VALUES("))
+        self.assertTrue(exported("select * from exp", table='a "b').startswith('INSERT INTO "a ""b" VALUES('))
+        self.db.execute("create table exp2(a, b, c);" + sql.replace('"table"', "exp2"))
+        self.assertEqual(self.db.execute("select * from exp2").fetchall(), values)
+
+        self.assertEqual(
+            exported("select * from exp limit 3", format="csv", header=True),
+            'a,b,c\n1,-2.5,"x,y"\n,AQL/,it\'s\n1e999,-1e999,"a""b\n\N{BLACK STAR}"\n')
+        self.assertEqual(exported("select * from exp limit 1", format="csv", separator=";", quoting=False), "1;-2.5;x,y\n")
+
+        data = exported("select * from exp", format="jsonl")
+        rows = [json.loads(line) for line in data.splitlines()]
+        self.assertEqual(rows[1], {"a": None, "b": "AQL/", "c": "it's"})
+        self.assertEqual(rows[2]["c"], values[2][2])
+        self.assertEqual(rows[3]["c"], values[3][2])
+
+        # a descriptor is written at its position and left open
+        with open(fn, "wb") as f:
+            f.write(b"start\n")
+            f.flush()
+            self.assertEqual(self.db.export_query(f.fileno(), "select 1, 'two'", format="csv"), 1)
+            f.write(b"end\n")
+        with open(fn, "rb") as f:
+            self.assertEqual(f.read(), b"start\n1,two\nend\n")
+
+        # many buffers worth, read back with import_file
+        self.db.execute("delete from exp2")
+        self.db.execute(
+            "with recursive c(i) as (values(1) union all select i+1 from c where i<100000) "
+            "insert into exp select i, i * 1.25, printf('%.*c', i % 97, 'x') from c")
+        self.assertEqual(self.db.export_query(fn, "select * from exp where rowid > 5", format="jsonl"), 100000)
+        self.assertGreater(os.path.getsize(fn), 2 * 1024 * 1024)
+        self.assertEqual(self.db.import_file(fn, "exp2", format="jsonl"), 100000)
+        self.assertEqual(self.db.execute("select * from exp where rowid > 5").fetchall(),
+                         self.db.execute("select * from exp2").fetchall())
+
     def testConnectionPragma(self):
         "Connection.pragma"
         self.assertRaises(TypeError, self.db.pragma)
@@ -5294,7 +6849,7 @@ class APSW(unittest.TestCase):
                     self.fail("Query is empty")
         # check with stats
         s = self.db.cache_stats()
-        self.assertEqual(s["size"], min(scsize, 512))  # 512 is current max
+        self.assertEqual(s["size"], min(scsize, 4096))  # 4096 is current max
         s2 = self.db.cache_stats(True)
         s2.pop("entries")
         self.assertEqual(s, s2)
@@ -5309,6 +6864,14 @@ class APSW(unittest.TestCase):
         self.db.execute("select 997", can_cache=True).fetchall()
         self.assertEqual(s["misses"] + 2 + (1 if not scsize else 0), self.db.cache_stats().pop("misses"))
 
+        # statement memory is recycled
+        s = self.db.cache_stats()
+        for i in range(10):
+            self.db.execute("select ?", (i, ), can_cache=False).fetchall()
+        s2 = self.db.cache_stats()
+        self.assertGreaterEqual(s2["recycle_hits"], s["recycle_hits"] + 9)
+        self.assertLessEqual(s2["recycle_misses"], s["recycle_misses"] + 1)
+
         # prepare_flags
         class VTModule:
 
@@ -5366,6 +6929,136 @@ class APSW(unittest.TestCase):
         self.db = apsw.Connection(TESTFILEPREFIX + "testdb", statementcachesize=-1)
         self.testStatementCache(0)
 
+    def testStatementCacheIndex(self):
+        "Statement cache lookups with many entries"
+        db = apsw.Connection("", statementcachesize=3000)
+        queries = [f"select { i }" for i in range(2500)]
+        for _ in range(2):
+            for q in queries:
+                db.execute(q).get
+        stats = db.cache_stats()
+        self.assertEqual(stats["hits"], 2500)
+        self.assertEqual(stats["evictions"], 0)
+
+        # multiple entries for the same query
+        curs = [db.execute("select 'dup'") for _ in range(5)]
+        for c in curs:
+            c.fetchall()
+        before = db.cache_stats()["hits"]
+        curs = [db.execute("select 'dup'") for _ in range(5)]
+        self.assertEqual(db.cache_stats()["hits"], before + 5)
+        for c in curs:
+            c.fetchall()
+        self.assertEqual(sum(1 for e in db.cache_stats(True)["entries"] if e["query"] == "select 'dup'"), 5)
+
+        # eviction keeps the size bounded
+        db = apsw.Connection("", statementcachesize=10)
+        for i in range(25):
+            db.execute(f"select { i }").get
+        stats = db.cache_stats(True)
+        self.assertEqual(stats["evictions"], 15)
+        self.assertEqual(len(stats["entries"]), 10)
+        self.assertEqual(len(set(e["query"] for e in stats["entries"])), 10)
+        self.assertTrue(all(e["query"] in {f"select { i }" for i in range(25)} for e in stats["entries"]))
+
+        # cost and reuse aware eviction
+        db = apsw.Connection("", statementcachesize=10)
+        self.assertEqual(db.cache_stats()["prepare_time"], 0)
+        for i in range(2000):
+            db.execute("select 'hot'").get
+        for i in range(30):
+            db.execute(f"select { i }").get
+        stats = db.cache_stats(True)
+        self.assertGreater(stats["prepare_time"], 0)
+        self.assertEqual(stats["evictions"], 21)
+        hot = [e for e in stats["entries"] if e["query"] == "select 'hot'"]
+        self.assertEqual(len(hot), 1)
+        self.assertEqual(hot[0]["uses"], 2000)
+        for e in stats["entries"]:
+            self.assertIsInstance(e["prepare_time"], float)
+            self.assertGreaterEqual(e["priority"] * (1 + 1e-9), e["prepare_time"] * e["uses"])
+        # the lowest priority is what gets evicted next
+        lowest = min(stats["entries"], key=lambda e: e["priority"])["query"]
+        db.execute("select 'new'").get
+        self.assertNotIn(lowest, [e["query"] for e in db.cache_stats(True)["entries"]])
+
+        # executemany reusing the statement counts each row
+        db = apsw.Connection("")
+        db.execute("create table bulk(x)")
+        db.executemany("insert into bulk values(?)", ((i,) for i in range(100)))
+        bulk = [e for e in db.cache_stats(True)["entries"] if e["query"] == "insert into bulk values(?)"]
+        self.assertEqual(bulk[0]["uses"], 100)
+
+    def testProfileStatements(self):
+        "Verify per statement profiling in the statement cache"
+
+        def entry(query):
+            for e in self.db.cache_stats(include_entries=True)["entries"]:
+                if e["query"] == query:
+                    return e
+            self.fail(f"{query} not in cache")
+
+        self.assertFalse(self.db.profile_statements)
+        self.assertRaises(TypeError, setattr, self.db, "profile_statements", 1)
+
+        self.db.execute("create table foo(x, y); create table bar(x, y)")
+        self.db.executemany("insert into foo values(?, ?)", ((i, str(i)) for i in range(500)))
+        self.db.executemany("insert into bar values(?, ?)", ((i, str(i)) for i in range(50)))
+
+        scan = "select * from foo where y > ? order by x desc"
+        for _ in range(3):
+            self.db.execute(scan, ("2",)).fetchall()
+        e = entry(scan)
+        # sqlite counters are always available
+        self.assertEqual(e["runs"], 3)
+        self.assertGreaterEqual(e["fullscan_steps"], 3 * 499)
+        self.assertEqual(e["sorts"], 3)
+        self.assertGreater(e["vm_steps"], 0)
+        self.assertGreater(e["memory_used"], 0)
+        self.assertEqual(e["reprepares"], 0)
+        self.assertEqual((e["rows"], e["step_time"], e["convert_time"]), (0, 0, 0))
+
+        self.db.profile_statements = True
+        self.assertTrue(self.db.profile_statements)
+        expected = len(self.db.execute(scan, ("2",)).fetchall())
+        e = entry(scan)
+        self.assertEqual(e["rows"], expected)
+        self.assertGreater(e["step_time"], 0)
+        self.assertGreater(e["convert_time"], 0)
+
+        # get also converts
+        total = "select count(*) from foo"
+        self.assertEqual(self.db.execute(total).get, 500)
+        e = entry(total)
+        self.assertEqual(e["rows"], 1)
+        self.assertGreater(e["convert_time"], 0)
+
+        join = "select * from foo, bar where foo.y = bar.y"
+        self.assertEqual(len(self.db.execute(join).fetchall()), 50)
+        self.assertGreater(entry(join)["autoindexes"], 0)
+
+        # executemany
+        insert = "insert into bar values(?, ?)"
+        self.db.executemany(insert, ((i, i) for i in range(10)))
+        e = entry(insert)
+        self.assertGreater(e["step_time"], 0)
+        self.assertEqual(e["rows"], 0)
+
+        # schema change
+        self.db.execute("create index foo_y on foo(y)")
+        self.db.execute(scan, ("2",)).fetchall()
+        self.assertGreaterEqual(entry(scan)["reprepares"], 1)
+
+        self.db.profile_statements = False
+        before = entry(scan)
+        self.db.execute(scan, ("2",)).fetchall()
+        after = entry(scan)
+        self.assertEqual(after["runs"], before["runs"] + 1)
+        self.assertEqual(
+            (after["rows"], after["step_time"], after["convert_time"]),
+            (before["rows"], before["step_time"], before["convert_time"]),
+        )
+
     def testStatementCacheLargeSize(self):
         "Rerun statement cache tests with a large cache"
         self.db = apsw.Connection(TESTFILEPREFIX + "testdb", statementcachesize=17000)
@@ -5435,7 +7128,7 @@ class APSW(unittest.TestCase):
         'sqlite3api': { # items of interest - sqlite3 calls
                         'match': re.compile(r"(sqlite3_[A-Za-z0-9_]+)\s*\("),
                         # what must also be on same or preceding line
-                        'needs': re.compile("PYSQLITE(_|_BLOB_|_CON_|_CUR_|_SC_|_VOID_|_BACKUP_)CALL"),
+                        'needs': re.compile("PYSQLITE(_|_BLOB_|_CON_|_CUR_|_SC_|_VOID_|_BACKUP_|_SESSION_)CALL"),
 
            # except if match.group(1) matches this - these don't
            # acquire db mutex so no need to wrap (determined by
@@ -5455,20 +7148,39 @@ class APSW(unittest.TestCase):
                                                 "|column_name|column_decltype|column_database_name|column_table_name|column_origin_name"
                                                 "|stmt_isexplain|stmt_readonly|filename_journal|filename_wal|stmt_status|sql|log|vtab_collation"
                                                 "|vtab_rhs_value|vtab_distinct|vtab_config|vtab_on_conflict|vtab_in_first|vtab_in_next|vtab_in"
-                                                "|vtab_nochange|is_interrupted|extended_errcode)$"),
+                                                "|vtab_nochange|is_interrupted|extended_errcode|sleep)$"),
                         # error message
                         'desc': "sqlite3_ calls must wrap with PYSQLITE_CALL",
                         },
         'inuse':        {
-                        'match': re.compile(r"(convert_column_to_pyobject|statementcache_prepare|statementcache_finalize|statementcache_next)\s*\("),
+                        'match': re.compile(r"(convert_column_to_pyobject|convert_row_to_pyobject|statementcache_prepare|statementcache_finalize|statementcache_next)\s*\("),
                         'needs': re.compile("INUSE_CALL"),
                         'desc': "call needs INUSE wrapper",
                         "skipfiles": re.compile(r".*[/\\]statementcache.c$"),
                         },
+        'nogil':        {
+                        'match': re.compile(r"(read_row_values|executemany_bind_step)\s*\("),
+                        'needs': re.compile("PYSQLITE(_|_CUR_)CALL"),
+                        'desc': "call must be made with the GIL released",
+                        },
         }
 
+    # these functions are only called with the GIL released and hold the
+    # db mutex themselves, so their sqlite3 calls are not wrapped
+    nogil_functions = {
+        "read_row_values", "executemany_bind_step", "parallel_query_save_row", "parallel_worker_run", "backup_run_step",
+        "dataimport_reader_thread", "dataimport_error", "dataimport_exec", "dataimport_prepare", "dataimport_record",
+        "dataimport_chunk", "dataimport_run", "dataexport_error", "dataexport_reserve", "dataexport_format_double", "dataexport_value", "dataexport_row",
+        "dataexport_prepare", "dataexport_run", "blob_copy_to_fd", "blob_copy_from_fd", "columnbatch_add", "columnbatch_collect",
+        "Connection_schema_versions_free",
+        "Connection_schema_versions_update", "Connection_update_batch_replace",
+        "Connection_update_batch_rollback_to"
+    }
+
     def sourceCheckMutexCall(self, filename, name, lines):
         # we check that various calls are wrapped with various macros
+        if name in self.nogil_functions:
+            return
         for i, line in enumerate(lines):
             if "PYSQLITE_CALL" in line and "Py" in line:
                 self.fail("%s: %s() line %d - Py call while GIL released - %s" % (filename, name, i, line.strip()))
@@ -5492,12 +7204,12 @@ class APSW(unittest.TestCase):
                     f"file { filename } function { name } calls PyGILState_Ensure but does not have MakeExistingException"
                 )
         # not further checked
-        if name.split("_")[0] in ("ZeroBlobBind", "APSWVFS", "APSWVFSFile", "APSWBuffer", "FunctionCBInfo"):
+        if name.split("_")[0] in ("ZeroBlobBind", "APSWVFS", "APSWVFSFile", "APSWBuffer", "FunctionCBInfo", "APSWBlobView", "APSWRow"):
             return
 
         checks = {
             "APSWCursor": {
-                "skip": ("dealloc", "init", "dobinding", "dobindings", "do_exec_trace", "do_row_trace", "step", "close",
+                "skip": ("dealloc", "init", "dobinding", "dobindings", "pin_binding", "unpin_bindings", "invalidate_blob_views", "blob_view", "row_fields", "new_row", "whole_row", "column_converters", "convert_values", "dobinding_value", "do_exec_trace", "do_row_trace", "step", "executemany_bulk", "prepare_execute", "close", "step_from",
                          "close_internal", "tp_traverse", "tp_str"),
                 "req": {
                     "use": "CHECK_USE",
@@ -5508,7 +7220,10 @@ class APSW(unittest.TestCase):
             "Connection": {
                 "skip": ("internal_cleanup", "dealloc", "init", "close", "interrupt", "close_internal",
                          "remove_dependent", "readonly", "getmainfilename", "db_filename", "traverse", "clear",
-                         "tp_traverse", "get_cursor_factory", "set_cursor_factory", "tp_str"),
+                         "tp_traverse", "get_cursor_factory", "set_cursor_factory", "tp_str", "update_batch_free",
+                         "update_batch_add", "update_batch_deliver", "update_batch_replace",
+                         "update_batch_rollback_to", "set_transaction_hooks",
+                         "schema_versions_free", "schema_versions_update", "metadata_cache_validate"),
                 "req": {
                     "use": "CHECK_USE",
                     "closed": "CHECK_CLOSED",
@@ -5516,7 +7231,15 @@ class APSW(unittest.TestCase):
                 "order": ("use", "closed")
             },
             "APSWBlob": {
-                "skip": ("dealloc", "init", "close", "close_internal", "tp_str"),
+                "skip": ("dealloc", "init", "close", "close_internal", "reopen_internal", "tp_str"),
+                "req": {
+                    "use": "CHECK_USE",
+                    "closed": "CHECK_BLOB_CLOSED"
+                },
+                "order": ("use", "closed")
+            },
+            "APSWBlobReopenIterator": {
+                "skip": ("dealloc", "tp_traverse", "tp_clear"),
                 "req": {
                     "use": "CHECK_USE",
                     "closed": "CHECK_BLOB_CLOSED"
@@ -5531,6 +7254,14 @@ class APSW(unittest.TestCase):
                 },
                 "order": ("use", "closed")
             },
+            "ConnectionPool": {
+                "skip": ("dealloc", "init", "close", "release", "stats", "remove_entry", "find_entry", "wake_waiter",
+                         "remove_waiter", "make_available", "discard_entry", "open", "available", "acquire_internal",
+                         "release_internal", "tp_str", "tp_traverse", "tp_clear"),
+                "req": {
+                    "closed": "CHECK_POOL_CLOSED"
+                },
+            },
             "apswvfs": {
                 "req": {
                     "preamble": "VFSPREAMBLE",
@@ -5566,11 +7297,65 @@ class APSW(unittest.TestCase):
                 },
                 "order": ("check", "notimpl"),
             },
+            "apswvfsfilepy_xMmap": {
+                "req": {
+                    "check": "CHECKVFSFILEPY",
+                },
+            },
+            "apswvfsfilepy_xReadBatch": {
+                "req": {
+                    "check": "CHECKVFSFILEPY",
+                    "notimpl": "VFSFILENOTIMPLEMENTED(xRead,"
+                },
+                "order": ("check", "notimpl"),
+            },
+            "apswvfsfilepy_xReadInto": {
+                "req": {
+                    "check": "CHECKVFSFILEPY",
+                    "notimpl": "VFSFILENOTIMPLEMENTED(xRead,"
+                },
+                "order": ("check", "notimpl"),
+            },
             "SqliteIndexInfo": {
                 "req": {
                     "check": "CHECK_INDEX",
                 },
             },
+            "APSWSession": {
+                "skip": ("new", "dealloc", "init", "close", "close_internal", "generate", "generate_stream", "tp_str",
+                         "tp_traverse", "tp_clear"),
+                "req": {
+                    "use": "CHECK_USE",
+                    "closed": "CHECK_SESSION_CLOSED"
+                },
+                "order": ("use", "closed")
+            },
+            "APSWChangeset": {
+                "skip": ("new", "dealloc", "init", "concat_internal", "tp_traverse", "tp_clear"),
+                "req": {
+                    "init": "CHECK_CHANGESET_INIT"
+                },
+            },
+            "APSWChangesetIterator": {
+                "skip": ("dealloc", "finish", "tp_traverse", "tp_clear"),
+                "req": {
+                    "use": "CHECK_USE"
+                },
+            },
+            "APSWTableChange": {
+                "skip": ("tp_str", ),
+                "req": {
+                    "check": "CHECK_TABLE_CHANGE"
+                },
+            },
+            "APSWChangesetBuilder": {
+                "skip": ("new", "dealloc", "close", "close_internal"),
+                "req": {
+                    "use": "CHECK_USE",
+                    "closed": "CHECK_BUILDER_CLOSED"
+                },
+                "order": ("use", "closed")
+            },
             "apswfcntl": {
                 "req": {}
             },
@@ -5715,8 +7500,30 @@ class APSW(unittest.TestCase):
             self.assertRaises(TypeError, apsw.config, apsw.SQLITE_CONFIG_MEMDB_MAXSIZE, 3, "3")
             self.assertRaises(OverflowError, apsw.config, apsw.SQLITE_CONFIG_MEMDB_MAXSIZE, 2**65)
             apsw.config(apsw.SQLITE_CONFIG_MEMDB_MAXSIZE, 2**63 - 1)
+            self.assertRaises(TypeError, apsw.config, apsw.SQLITE_CONFIG_LOOKASIDE, 1200)
+            self.assertRaises(TypeError, apsw.config, apsw.SQLITE_CONFIG_PAGECACHE, 4096)
+
+            def page_overflow():
+                apsw.initialize()
+                apsw.status(apsw.SQLITE_STATUS_PAGECACHE_OVERFLOW, True)
+                db = apsw.Connection("")
+                db.execute("create table foo(x); insert into foo values(zeroblob(100000))")
+                self.assertGreater(db.status(apsw.SQLITE_DBSTATUS_LOOKASIDE_HIT)[1], 0)
+                db.close()
+                res = apsw.status(apsw.SQLITE_STATUS_PAGECACHE_OVERFLOW)[1]
+                apsw.shutdown()
+                return res
+
+            general = page_overflow()
+            apsw.config(apsw.SQLITE_CONFIG_LOOKASIDE, 1200, 200)
+            apsw.config(apsw.SQLITE_CONFIG_PAGECACHE, 4096 + apsw.config(apsw.SQLITE_CONFIG_PCACHE_HDRSZ), 100)
+            self.assertLess(page_overflow(), general)
+            # defaults
+            apsw.config(apsw.SQLITE_CONFIG_LOOKASIDE, 1200, 100)
+            apsw.config(apsw.SQLITE_CONFIG_PAGECACHE, 0, 0)
         finally:
             # put back to normal
+            apsw.shutdown()
             apsw.config(apsw.SQLITE_CONFIG_SERIALIZED)
             apsw.config(apsw.SQLITE_CONFIG_MEMSTATUS, True)
             apsw.initialize()
@@ -6163,6 +7970,132 @@ class APSW(unittest.TestCase):
             klass, value = sys.exc_info()[:2]
             self.assertTrue(klass is apsw.AbortError)
 
+    def testBlobCopy(self):
+        "Blob copy_to, copy_from, and reopen_each"
+        import io, socket
+        fn = TESTFILEPREFIX + "testfile"
+        data = [b"", b"0123456789", os.urandom(3 * 1024 * 1024 + 7), os.urandom(70000)]
+        self.db.execute("create table media(content)")
+        self.db.executemany("insert into media(rowid, content) values(?,?)", enumerate(data, 1))
+
+        blob = self.db.blob_open("main", "media", "content", 1, False)
+        self.assertRaises(TypeError, blob.copy_to)
+        self.assertRaises(TypeError, blob.copy_to, io.BytesIO(), "3")
+        self.assertRaises(ValueError, blob.copy_to, -3)
+        self.assertRaises(ValueError, blob.copy_to, io.BytesIO(), chunk_size=0)
+        self.assertRaises(TypeError, blob.reopen_each, 3)
+        self.assertEqual(blob.copy_to(io.BytesIO()), 0)
+
+        # objects and descriptors, in various chunk sizes
+        seen = []
+        for rowid in blob.reopen_each(iter([1, 2, 3, 4])):
+            seen.append(rowid)
+            expected = data[rowid - 1]
+            self.assertEqual(blob.tell(), 0)
+            for chunk_size in (1, 1000, 1024 * 1024):
+                if chunk_size == 1 and len(expected) > 100:
+                    continue
+                blob.seek(0)
+                out = io.BytesIO()
+                self.assertEqual(blob.copy_to(out, chunk_size=chunk_size), len(expected))
+                self.assertEqual(out.getvalue(), expected)
+                self.assertEqual(blob.tell(), len(expected))
+            start = min(3, len(expected))
+            blob.seek(start)
+            with open(fn, "wb") as f:
+                self.assertEqual(blob.copy_to(f.fileno(), 5), len(expected[start:start + 5]))
+                self.assertEqual(blob.copy_to(f.fileno()), len(expected[start + 5:]))
+            with open(fn, "rb") as f:
+                self.assertEqual(f.read(), expected[start:])
+        self.assertEqual(seen, [1, 2, 3, 4])
+        self.assertRaises(TypeError, list, blob.reopen_each([2, "three"]))
+        self.assertRaises(apsw.SQLError, list, blob.reopen_each([2, 99]))
+        # a rowid generator referring back to the iterator is collected
+        class Marker:
+            pass
+
+        def rowids(refs):
+            yield from [1, 2]
+
+        holder = [Marker()]
+        holder.append(blob.reopen_each(rowids(holder)))
+        marker = weakref.ref(holder[0])
+        del holder
+        gc.collect()
+        self.assertIsNone(marker())
+        blob.close()
+
+        # the memoryview is only valid during the call
+        class Keeper:
+            def write(self, data):
+                self.data = data
+
+        blob = self.db.blob_open("main", "media", "content", 2, False)
+        keeper = Keeper()
+        blob.copy_to(keeper)
+        self.assertRaises(ValueError, bytes, keeper.data)
+
+        class Closer:
+            def write(self, data):
+                blob.close()
+
+        blob.seek(0)
+        self.assertRaises(ValueError, blob.copy_to, Closer(), chunk_size=2)
+        self.assertRaises(ValueError, blob.copy_to, io.BytesIO())
+
+        # a socket
+        if hasattr(socket, "socketpair") and sys.platform != "win32":
+            a, b = socket.socketpair()
+            with a, b:
+                blob = self.db.blob_open("main", "media", "content", 4, False)
+                self.assertEqual(blob.copy_to(a.fileno()), len(data[3]))
+                received = b""
+                while len(received) < len(data[3]):
+                    received += b.recv(65536)
+                self.assertEqual(received, data[3])
+                blob.close()
+
+        # copy_from
+        self.db.execute("create table upload(content)")
+        self.db.execute("insert into upload values(zeroblob(100000))")
+        blob = self.db.blob_open("main", "upload", "content", 1, True)
+        self.assertRaises(TypeError, blob.copy_from, io.BytesIO(), "3")
+        self.assertRaises(ValueError, blob.copy_from, -3)
+        self.assertRaises(ValueError, blob.copy_from, io.BytesIO(), chunk_size=-1)
+        self.assertRaises(AttributeError, blob.copy_from, b"abc")
+        source = io.BytesIO(data[1] * 20000)
+        self.assertEqual(blob.copy_from(source, chunk_size=999), 100000)
+        self.assertEqual(source.tell(), 100000)
+        self.assertEqual(blob.copy_from(source), 0)
+        blob.seek(5)
+        self.assertEqual(blob.copy_from(io.BytesIO(b"abc")), 3)
+        self.assertEqual(blob.tell(), 8)
+        with open(fn, "wb") as f:
+            f.write(data[3])
+        with open(fn, "rb") as f:
+            blob.seek(0)
+            self.assertEqual(blob.copy_from(f.fileno(), 1000), 1000)
+            self.assertEqual(blob.copy_from(f.fileno(), chunk_size=4096), 69000)
+        self.assertEqual(blob.tell(), 70000)
+        blob.seek(0)
+        self.assertEqual(blob.read(), data[3] + (data[1] * 20000)[70000:100000])
+
+        class BadReader:
+            def __init__(self, result):
+                self.result = result
+
+            def readinto(self, buffer):
+                buffer[0] = 1
+                return self.result
+
+        blob.seek(0)
+        for result, exc in ((None, ValueError), (-1, ValueError), (2**20, ValueError), ("1", ValueError)):
+            self.assertRaises(exc, blob.copy_from, BadReader(result))
+        blob.close()
+        blob = self.db.blob_open("main", "media", "content", 4, False)
+        self.assertRaises(apsw.ReadOnlyError, blob.copy_from, io.BytesIO(b"abc"))
+        blob.close(True)
+
     def testAutovacuumPages(self):
         self.assertRaises(TypeError, self.db.autovacuum_pages)
         self.assertRaises(TypeError, self.db.autovacuum_pages, 3)
@@ -6324,6 +8257,292 @@ class APSW(unittest.TestCase):
                           flags=apsw.SQLITE_OPEN_READWRITE | apsw.SQLITE_OPEN_CREATE | apsw.SQLITE_OPEN_URI,
                           vfs="uritest")
 
+    def testVFSReadInto(self):
+        "Verify VFS files reading into and writing from SQLite buffers"
+        calls = []
+        kept = []
+
+        class ViewFile(apsw.VFSFile):
+
+            def xReadInto(self, buffer, offset):
+                calls.append(("read", type(buffer), buffer.readonly))
+                return super().xReadInto(buffer, offset)
+
+            def xWrite(self, data, offset):
+                calls.append(("write", type(data), data.readonly))
+                kept.append(data)
+                super().xWrite(data, offset)
+
+        class PlainFile(apsw.VFSFile):
+
+            def xRead(self, amount, offset):
+                calls.append(("read", int, True))
+                return super().xRead(amount, offset)
+
+        class TVFS(apsw.VFS):
+
+            def __init__(self):
+                self.file_class = ViewFile
+                apsw.VFS.__init__(self, "readinto", "")
+
+            def xOpen(self, name, flags):
+                return self.file_class("", name, flags)
+
+        vfs = TVFS()
+        db = apsw.Connection(TESTFILEPREFIX + "testdb2", vfs="readinto")
+        db.execute("create table foo(x); insert into foo values(zeroblob(10000))")
+        db.close()
+        self.assertIn(("read", memoryview, False), calls)
+        self.assertIn(("write", memoryview, True), calls)
+        self.assertEqual({c for c in calls if c[1] is not memoryview}, set())
+        # views are not usable after the call
+        self.assertRaises(ValueError, bytes, kept[0])
+
+        calls.clear()
+        vfs.file_class = PlainFile
+        db = apsw.Connection(TESTFILEPREFIX + "testdb2", vfs="readinto")
+        self.assertEqual(db.execute("select length(x) from foo").get, 10000)
+        db.close()
+        self.assertTrue(calls)
+        self.assertEqual({c for c in calls if c[1] is not int}, set())
+
+        # direct use with short read
+        f = apsw.VFSFile("", TESTFILEPREFIX + "testdb2", [apsw.SQLITE_OPEN_MAIN_DB | apsw.SQLITE_OPEN_READONLY, 0])
+        size = f.xFileSize()
+        buf = bytearray(100)
+        self.assertEqual(f.xReadInto(buf, 0), 100)
+        self.assertEqual(bytes(buf), f.xRead(100, 0))
+        self.assertLess(f.xReadInto(buf, size - 10), 11)
+        self.assertRaises(BufferError, f.xReadInto, b"readonly", 0)
+        f.xClose()
+        self.assertRaises(apsw.VFSFileClosedError, f.xReadInto, buf, 0)
+
+        # bad return values
+        class BadFile(apsw.VFSFile):
+            result = 0
+
+            def xReadInto(self, buffer, offset):
+                super().xReadInto(buffer, offset)
+                return BadFile.result
+
+        vfs.file_class = BadFile
+        for bad in (-1, 10**6, "seven"):
+            BadFile.result = bad
+            self.assertRaises((ValueError, TypeError),
+                              lambda: apsw.Connection(TESTFILEPREFIX + "testdb2", vfs="readinto").execute("select * from foo"))
+
+    def testVFSReadAhead(self):
+        "Verify VFS block cache and read-ahead"
+        batches = []
+        reads = []
+
+        class BatchFile(apsw.VFSFile):
+
+            def xReadBatch(self, items):
+                batches.append(items)
+                return super().xReadBatch(items)
+
+        class PlainFile(apsw.VFSFile):
+
+            def xRead(self, amount, offset):
+                reads.append((amount, offset))
+                return super().xRead(amount, offset)
+
+        class TVFS(apsw.VFS):
+
+            def __init__(self):
+                self.file_class = BatchFile
+                apsw.VFS.__init__(self, "readahead", "")
+
+            def xOpen(self, name, flags):
+                return self.file_class("", name, flags)
+
+        vfs = TVFS()
+
+        dbname = TESTFILEPREFIX + "testdb2"
+        self.db.close()
+        db = apsw.Connection(dbname)
+        db.execute("create table foo(x); with recursive c(n) as (select 1 union all select n+1 from c where n < 400) "
+                   "insert into foo select randomblob(1000) from c")
+        expected = db.execute("select sum(length(x)), sum(unicode(x)) from foo").get
+        pages = db.pragma("page_count")
+        db.close()
+
+        def connect(params="apsw_cache=1000"):
+            return apsw.Connection(f"file:{dbname}?{params}",
+                                   flags=apsw.SQLITE_OPEN_READWRITE | apsw.SQLITE_OPEN_URI,
+                                   vfs="readahead")
+
+        query = "select sum(length(x)), sum(unicode(x)) from foo"
+
+        db = connect()
+        self.assertEqual(db.execute(query).get, expected)
+        read = sum(len(b) for b in batches)
+        self.assertGreater(read, 0)
+        # coalesced and read ahead
+        self.assertLess(read, pages / 4)
+        self.assertTrue(any(amount > 4096 for b in batches for amount, offset in b))
+        # cleared at the start of the next transaction
+        batches.clear()
+        self.assertEqual(db.execute(query).get, expected)
+        self.assertTrue(batches)
+        db.close()
+
+        # kept for immutable
+        batches.clear()
+        db = connect("apsw_cache=1000&immutable=1")
+        self.assertEqual(db.execute(query).get, expected)
+        self.assertTrue(batches)
+        batches.clear()
+        self.assertEqual(db.execute(query).get, expected)
+        self.assertEqual(batches, [])
+        db.close()
+
+        # writes, truncation, and changes from another connection
+        for journal in ("delete", "wal"):
+            db = connect("apsw_cache=50&apsw_cache_block=1024&apsw_readahead=7")
+            db.pragma("journal_mode", journal)
+            other = apsw.Connection(dbname)
+            for i in range(4):
+                self.assertEqual(db.execute(query).get, other.execute(query).get)
+                with db:
+                    db.execute("update foo set x=randomblob(800) where rowid % 4 = ?", (i, ))
+                self.assertEqual(db.execute(query).get, other.execute(query).get)
+                other.execute("delete from foo where rowid % 10 = ?; vacuum", (i, ))
+                self.assertEqual(db.execute(query).get, other.execute(query).get)
+                db.execute("with recursive c(n) as (select 1 union all select n+1 from c where n < 30) "
+                           "insert into foo select randomblob(1200) from c")
+                db.pragma("wal_checkpoint(truncate)")
+                self.assertEqual(db.execute(query).get, other.execute(query).get)
+            self.assertEqual(db.pragma("integrity_check"), "ok")
+            other.close()
+            db.pragma("journal_mode", "delete")
+            db.close()
+
+        # without xReadBatch
+        vfs.file_class = PlainFile
+        db = connect("apsw_cache=1000&immutable=1")
+        expected = apsw.Connection(dbname).execute(query).get
+        self.assertEqual(db.execute(query).get, expected)
+        self.assertTrue(any(amount > 4096 for amount, offset in reads))
+        db.close()
+
+        for params in ("apsw_cache=10&apsw_cache_block=1000", "apsw_cache=10&apsw_cache_block=128",
+                       "apsw_cache=10&apsw_readahead=-1"):
+            self.assertRaises(ValueError, connect, params)
+
+        # direct use
+        f = apsw.VFSFile("", dbname, [apsw.SQLITE_OPEN_MAIN_DB | apsw.SQLITE_OPEN_READONLY, 0])
+        size = f.xFileSize()
+        res = f.xReadBatch([(100, 0), (100, size - 10), (10, size + 10)])
+        self.assertEqual(res, [f.xRead(100, 0), f.xRead(100, size - 10), b""])
+        self.assertEqual(len(res[1]), 10)
+        self.assertRaises(TypeError, f.xReadBatch, [3])
+        self.assertRaises(TypeError, f.xReadBatch, 3)
+        self.assertRaises(ValueError, f.xReadBatch, [(-1, 0)])
+        f.xClose()
+        self.assertRaises(apsw.VFSFileClosedError, f.xReadBatch, [])
+
+    def testVFSMmap(self):
+        "Verify VFS files providing memory for xFetch"
+        import mmap
+        reads = []
+        maps = []
+        closed = []
+
+        class MmapFile(apsw.VFSFile):
+
+            def __init__(self, filename, flags):
+                super().__init__("", filename, flags)
+                self.main = flags[0] & apsw.SQLITE_OPEN_MAIN_DB
+                self.name = filename.filename() if self.main else None
+                self.mmaps = []
+
+            def xRead(self, amount, offset):
+                if self.main:
+                    reads.append(offset)
+                return super().xRead(amount, offset)
+
+            def xMmap(self):
+                size = self.xFileSize()
+                maps.append(size)
+                if not size:
+                    return None
+                with open(self.name, "r+b") as f:
+                    self.mmaps.append(mmap.mmap(f.fileno(), size))
+                    return self.mmaps[-1]
+
+            def xClose(self):
+                # the mapping must have been released by now else
+                # this raises BufferError
+                for m in self.mmaps:
+                    m.close()
+                if self.main:
+                    closed.append(self.name)
+                return super().xClose()
+
+        class TVFS(apsw.VFS):
+
+            def __init__(self):
+                apsw.VFS.__init__(self, "mmaptest", "")
+
+            def xOpen(self, name, flags):
+                return MmapFile(name, flags)
+
+        vfs = TVFS()
+        dbname = TESTFILEPREFIX + "testdb2"
+        db = apsw.Connection(dbname, vfs="mmaptest")
+        other = apsw.Connection(dbname)
+        db.execute("pragma mmap_size=100000000")
+        db.execute("create table foo(x); insert into foo values(zeroblob(100000))")
+
+        query = "select sum(length(x)), count(*) from foo"
+        sizes = set()
+        for i in range(5):
+            # changes from the other connection mean SQLite has to read
+            # every page again, and the file grows
+            other.execute("insert into foo values(randomblob(50000))")
+            maps.clear()
+            reads.clear()
+            self.assertEqual(db.execute(query).get, other.execute(query).get)
+            # mapped so minimal reads
+            self.assertLess(len(reads), 3)
+            sizes.update(maps)
+            with db:
+                db.execute("insert into foo values(randomblob(?))", (10000 * i, ))
+                db.execute("delete from foo where rowid % 3 = ?", (i, ))
+            self.assertEqual(db.execute(query).get, other.execute(query).get)
+
+        self.assertEqual(db.pragma("integrity_check"), "ok")
+        # remapped as the file changed size
+        self.assertGreater(len(sizes), 2)
+
+        # disabled
+        db.execute("pragma mmap_size=0")
+        maps.clear()
+        reads.clear()
+        self.assertEqual(db.execute(query).get, other.execute(query).get)
+        self.assertEqual(maps, [])
+        self.assertTrue(reads)
+        db.close()
+        other.close()
+        self.assertEqual(len(closed), 1)
+
+        # closed while mapped
+        db = apsw.Connection(dbname, vfs="mmaptest")
+        db.execute("pragma mmap_size=100000000")
+        maps.clear()
+        db.execute(query).get
+        self.assertTrue(maps)
+        db.close()
+        self.assertEqual(len(closed), 2)
+
+        # the default
+        f = apsw.VFSFile("", dbname, [apsw.SQLITE_OPEN_MAIN_DB | apsw.SQLITE_OPEN_READONLY, 0])
+        self.assertIsNone(f.xMmap())
+        f.xClose()
+        self.assertRaises(apsw.VFSFileClosedError, f.xMmap)
+
     def testVFSWithWAL(self):
         "Verify VFS using WAL"
         apsw.connection_hooks.append(
@@ -7765,6 +9984,187 @@ class APSW(unittest.TestCase):
                 list(c2.execute("select * from [%s] order by _ROWID_" % (table, ))),
             )
 
+    def testConnectionPool(self):
+        "Verify connection pool"
+        self.assertRaises(ValueError, apsw.ConnectionPool, TESTFILEPREFIX + "testdb", size=0)
+        self.assertRaises(TypeError, apsw.ConnectionPool, TESTFILEPREFIX + "testdb", setup=3)
+        self.assertRaises(TypeError, apsw.ConnectionPool)
+
+        setups = []
+
+        def setup(con):
+            setups.append(con)
+            con.execute("pragma cache_size=1234")
+
+        pool = apsw.ConnectionPool(TESTFILEPREFIX + "testdb", size=2, setup=setup)
+        self.assertIn("ConnectionPool", str(pool))
+        db = pool.acquire()
+        self.assertIsInstance(db, apsw.Connection)
+        self.assertEqual(setups, [db])
+        self.assertEqual(db.execute("pragma cache_size").get, 1234)
+        db.execute("create table if not exists pool(x)")
+        pool.release(db)
+        self.assertRaises(ValueError, pool.release, db)
+        self.assertRaises(ValueError, pool.release, self.db)
+
+        # same thread gets the same connection back with a warm cache
+        db2 = pool.acquire()
+        self.assertIs(db2, db)
+        hits = db2.cache_stats()["hits"]
+        db2.execute("pragma cache_size").get
+        self.assertEqual(db2.cache_stats()["hits"], hits + 1)
+        stats = pool.stats()
+        self.assertEqual(stats["affinity_hits"], 1)
+        self.assertEqual(stats["checkouts"], 2)
+        self.assertEqual(stats["opened"], 1)
+        self.assertEqual(stats["idle"], 0)
+
+        # transactions are rolled back
+        db2.execute("begin; insert into pool values(1)")
+        pool.release(db2)
+        self.assertTrue(db2.get_autocommit())
+        self.assertEqual(self.db.execute("select count(*) from pool").get, 0)
+
+        # exhaustion and timeouts
+        dba, dbb = pool.acquire(), pool.acquire()
+        self.assertIsNot(dba, dbb)
+        self.assertEqual(len(setups), 2)
+        self.assertRaises(TimeoutError, pool.acquire, timeout=0)
+        b4 = time.monotonic()
+        self.assertRaises(TimeoutError, pool.acquire, timeout=50)
+        self.assertGreaterEqual(time.monotonic() - b4, 0.04)
+        stats = pool.stats()
+        self.assertEqual(stats["timeouts"], 2)
+        self.assertEqual(stats["waits"], 1)
+        self.assertEqual(stats["open"], 2)
+
+        # waiting thread is handed a released connection
+        t = ThreadRunner(pool.acquire, timeout=10000)
+        t.start()
+        while pool.stats()["waiting"] == 0:
+            time.sleep(0.01)
+        pool.release(dba)
+        got = t.go()
+        self.assertIs(got, dba)
+        self.assertGreater(pool.stats()["wait_time"], 0)
+
+        # closed connections are discarded and a waiter can open a replacement
+        t = ThreadRunner(pool.acquire, timeout=10000)
+        t.start()
+        while pool.stats()["waiting"] == 0:
+            time.sleep(0.01)
+        dbb.close()
+        pool.release(dbb)
+        got2 = t.go()
+        self.assertIsNot(got2, dbb)
+        self.assertEqual(len(setups), 3)
+        pool.release(got)
+        pool.release(got2)
+
+        self.assertEqual(pool.release_idle(), 2)
+        self.assertEqual(pool.release_idle(min_idle=100000), 0)
+
+        # setup failing
+        def badsetup(con):
+            1 / 0
+
+        pool2 = apsw.ConnectionPool(":memory:", setup=badsetup)
+        self.assertRaises(ZeroDivisionError, pool2.acquire)
+        self.assertEqual(pool2.stats()["open"], 0)
+        pool2.close()
+
+        # closing
+        db = pool.acquire()
+        t = ThreadRunner(pool.acquire, timeout=10000)
+        pool.acquire()
+        t.start()
+        while pool.stats()["waiting"] == 0:
+            time.sleep(0.01)
+        pool.close()
+        self.assertRaises(apsw.ConnectionClosedError, t.go)
+        self.assertRaises(apsw.ConnectionClosedError, pool.acquire)
+        self.assertRaises(apsw.ConnectionClosedError, pool.release_idle)
+        pool.release(db)
+        self.assertRaises(apsw.ConnectionClosedError, db.execute, "select 3")
+        pool.close()
+
+        # reference cycles through setup are collected, along with pooled connections
+        def cycle_setup(con, box=[]):
+            con.execute("pragma cache_size=1234")
+
+        pool3 = apsw.ConnectionPool(":memory:", setup=cycle_setup)
+        cycle_setup.__defaults__[0].append(pool3)
+        db = pool3.acquire()
+        pool3.release(db)
+        poolref, dbref = weakref.ref(pool3), weakref.ref(db)
+        del pool3, db, cycle_setup
+        gc.collect()
+        self.assertIsNone(poolref())
+        self.assertIsNone(dbref())
+
+    def testParallelExecute(self):
+        "Verify running queries in parallel across a pool"
+        self.db.pragma("journal_mode", "wal")
+        self.db.execute("create table par(x, y); begin")
+        self.db.executemany("insert into par values(?, ?)", ((i, "t" * (i % 50) + str(i)) for i in range(2000)))
+        self.db.execute("insert into par values(null, x'aabbcc'); commit")
+
+        def setup(con):
+            con.create_scalar_function("double", lambda x: x * 2 if x is not None else None)
+
+        setup(self.db)
+        pool = apsw.ConnectionPool(TESTFILEPREFIX + "testdb", size=4, setup=setup)
+        self.assertEqual(pool.parallel_execute([]), [])
+
+        queries = [
+            "select * from par order by x",
+            ("select count(*) from par where x < ?", (100, )),
+            ("select double(x) from par where x = :x", {"x": 7}),
+            ("select y from par where x is null", None),
+            "select 1 where 0",
+            "-- nothing",
+        ] * 3
+        expected = [self.db.execute(*((q, ) if isinstance(q, str) else q)).fetchall() for q in queries]
+        self.assertEqual(pool.parallel_execute(queries), expected)
+        self.assertEqual(pool.stats()["open"], 4)
+        self.assertEqual(pool.stats()["idle"], 4)
+        self.assertEqual(expected[3], [(b"\xaa\xbb\xcc", )])
+
+        # uses those available
+        held = [pool.acquire() for _ in range(3)]
+        self.assertEqual(pool.parallel_execute(queries), expected)
+        held.append(pool.acquire())
+        self.assertRaises(TimeoutError, pool.parallel_execute, queries, timeout=0)
+        for db in held:
+            pool.release(db)
+
+        # row tracers
+        db = pool.acquire()
+        db.row_trace = lambda cur, row: None if row[0] % 2 else row[0]
+        pool.release(db)
+        res = pool.parallel_execute(["select x from par where x < 10"] * 4)
+        self.assertIn([0, 2, 4, 6, 8], res)
+        self.assertIn([(i, ) for i in range(10)], res)
+        db = pool.acquire()
+        db.row_trace = None
+        pool.release(db)
+
+        # errors
+        self.assertRaises(TypeError, pool.parallel_execute, 3)
+        self.assertRaises(TypeError, pool.parallel_execute, [3])
+        self.assertRaises(TypeError, pool.parallel_execute, [("select 3", )])
+        self.assertRaises(ValueError, pool.parallel_execute, ["select 3; select 4"])
+        self.assertRaises(ValueError, pool.parallel_execute, ["insert into par values(1, 2)"])
+        self.assertRaises(apsw.SQLError, pool.parallel_execute, ["select * from nosuchtable"])
+        self.assertRaises(apsw.BindingsError, pool.parallel_execute, [("select ?", (1, 2))])
+        with self.assertRaises(apsw.SQLError):
+            pool.parallel_execute(["select 1", "select abs(-9223372036854775808)"] * 2)
+        self.assertEqual(pool.stats()["idle"], pool.stats()["open"])
+        self.assertEqual(self.db.execute("select count(*) from par").get, 2001)
+
+        pool.close()
+        self.assertRaises(apsw.ConnectionClosedError, pool.parallel_execute, queries)
+
     def testBackup(self):
         "Verify hot backup functionality"
         # bad calls
@@ -7900,6 +10300,219 @@ class APSW(unittest.TestCase):
         self.assertRaises(apsw.BusyError, b.__exit__, None, None, None)
         b.__exit__(None, None, None)
 
+    def testBackupRun(self):
+        "Verify backup in a background thread"
+        self.db.execute("create table foo(x); insert into foo values(zeroblob(2000))")
+        self.db.execute(
+            "with recursive c(x) as (values(1) union all select x+1 from c where x<200) insert into foo select randomblob(2000) from c"
+        )
+        expected = self.db.execute("select sum(length(x)), count(*) from foo").get
+
+        db2 = apsw.Connection(":memory:")
+        b = db2.backup("main", self.db, "main")
+        self.assertRaises(ValueError, b.run, 0)
+        self.assertRaises(ValueError, b.run, sleep_ms=-1)
+        self.assertRaises(ValueError, b.run, progress_interval_ms=-1)
+        self.assertRaises(ValueError, b.run, busy_timeout_ms=-1)
+        self.assertRaises(TypeError, b.run, progress=3)
+
+        calls = []
+        fut = b.run(7, 0, lambda *args: calls.append(args), progress_interval_ms=0)
+        # the backup can't be used meanwhile, but the thread may already be done
+        try:
+            b.step()
+        except apsw.ThreadingViolationError:
+            pass
+        pages = fut.result(timeout=60)
+        self.assertTrue(b.done)
+        self.assertEqual(pages, b.page_count)
+        self.assertTrue(len(calls) >= (pages // 7))
+        self.assertEqual(calls[-1], (0, pages))
+        for remaining, page_count in calls:
+            self.assertEqual(page_count, pages)
+        self.assertEqual(sorted(calls, reverse=True), calls)
+        b.finish()
+        self.assertEqual(expected, db2.execute("select sum(length(x)), count(*) from foo").get)
+
+        # progress raising
+        db2 = apsw.Connection(":memory:")
+        b = db2.backup("main", self.db, "main")
+
+        def progress(remaining, page_count):
+            1 / 0
+
+        fut = b.run(progress=progress, progress_interval_ms=0)
+        self.assertRaises(ZeroDivisionError, fut.result, 60)
+        self.assertFalse(b.done)
+        b.finish()
+
+        # sqlite errors keep their message
+        fn = TESTFILEPREFIX + "testdb2"
+        apsw.Connection(fn).execute("create table x(y)")
+        db2 = apsw.Connection(fn, flags=apsw.SQLITE_OPEN_READONLY)
+        b = db2.backup("main", self.db, "main")
+        self.assertRaisesRegex(apsw.ReadOnlyError, "readonly database", b.run().result, 60)
+        b.close(True)
+
+        # the source staying locked eventually gives up
+        locker = apsw.Connection(self.db.filename)
+        locker.execute("begin exclusive")
+        db2 = apsw.Connection(":memory:")
+        b = db2.backup("main", self.db, "main")
+        start = time.monotonic()
+        self.assertRaises(apsw.BusyError, b.run(busy_timeout_ms=200).result, 60)
+        self.assertTrue(0.2 <= time.monotonic() - start < 30)
+        self.assertFalse(b.done)
+        locker.execute("rollback")
+        self.assertEqual(b.run(busy_timeout_ms=0).result(60), pages)
+        b.finish()
+        locker.close()
+
+        # asyncio
+        import asyncio
+
+        db2 = apsw.Connection(":memory:")
+
+        async def amain():
+            with db2.backup("main", self.db, "main") as b:
+                return await asyncio.wrap_future(b.run(pages_per_step=-1))
+
+        self.assertEqual(asyncio.run(amain()), pages)
+        self.assertEqual(expected, db2.execute("select sum(length(x)), count(*) from foo").get)
+
+    def testAio(self):
+        "Verify asyncio wrappers"
+        import asyncio
+        import apsw.aio
+
+        self.db.execute("create table foo(x,y); insert into foo values(1, 'one')")
+        self.db.close()
+
+        async def amain():
+            with self.assertRaises(ValueError):
+                await apsw.aio.connect(":memory:", batch_size=0)
+            with self.assertRaises(apsw.CantOpenError):
+                await apsw.aio.connect(TESTFILEPREFIX + "no/such/directory/db")
+            db = await apsw.aio.connect(TESTFILEPREFIX + "testdb", batch_size=3)
+            worker = db._worker.thread
+            self.assertNotEqual(worker, threading.current_thread())
+
+            # work is done on the worker thread
+            self.assertEqual(await db.run(lambda con, x: (threading.current_thread(), x), 7), (worker, 7))
+
+            # iteration in batches
+            await db.executemany("insert into foo values(?,?)", ((i, str(i)) for i in range(2, 11)))
+            calls = []
+            orig = db._call
+
+            async def counted(*args, **kwargs):
+                calls.append(args)
+                return await orig(*args, **kwargs)
+
+            db._call = counted
+            rows = [row async for row in await db.execute("select x from foo order by x")]
+            self.assertEqual(rows, [(i,) for i in range(1, 11)])
+            # first batch with execute, then 3 rows at a time (3, 3, 1)
+            self.assertEqual(len(calls), 4)
+            db._call = orig
+
+            cursor = await db.execute("select x, y from foo where x<? order by x", (6,))
+            self.assertEqual(await cursor.fetchone(), (1, "one"))
+            self.assertEqual(await cursor.fetchall(), [(i, str(i)) for i in range(2, 6)])
+            self.assertIsNone(await cursor.fetchone())
+            self.assertEqual(await cursor.fetchall(), [])
+            self.assertEqual(await db.pragma("user_version"), 0)
+            cursor = await db.execute("select ?", (7,), can_cache=False)
+            self.assertEqual(await cursor.fetchall(), [(7,)])
+            await db.executemany("insert into foo values(?, ?)", [(99, 99)], can_cache=False)
+            await db.execute("delete from foo where x=99")
+
+            # errors are delivered
+            with self.assertRaises(apsw.SQLError):
+                await db.execute("select * from nosuchtable")
+
+            # transactions
+            with self.assertRaises(ZeroDivisionError):
+                async with db:
+                    await db.execute("delete from foo")
+                    1 / 0
+            self.assertEqual((await (await db.execute("select count(*) from foo")).fetchone())[0], 10)
+
+            # the loop keeps running while a query is in progress
+            ticks = 0
+
+            async def ticker():
+                nonlocal ticks
+                while True:
+                    ticks += 1
+                    await asyncio.sleep(0)
+
+            ticktask = asyncio.create_task(ticker())
+            stmt = "with recursive c(x) as (values(1) union all select x+1 from c where x<2000000) select sum(x) from c"
+            self.assertEqual((await (await db.execute(stmt)).fetchone())[0], 2000000 * 2000001 // 2)
+            self.assertGreater(ticks, 1)
+
+            # cancellation interrupts the running query
+            stmt = "with recursive c(x) as (values(1) union all select x+1 from c) select sum(x) from c"
+            task = asyncio.create_task(db.execute(stmt))
+            await asyncio.sleep(0.1)
+            task.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await task
+            ticktask.cancel()
+            self.assertEqual((await (await db.execute("select 3")).fetchone())[0], 3)
+
+            # cancelled calls still in the queue are not run
+            ran = []
+            task = asyncio.create_task(db.execute(stmt))
+            queued = asyncio.create_task(db.run(lambda con: ran.append(con)))
+            await asyncio.sleep(0.1)
+            queued.cancel()
+            task.cancel()
+            for t in (queued, task):
+                with self.assertRaises(asyncio.CancelledError):
+                    await t
+            self.assertEqual((await (await db.execute("select 4")).fetchone())[0], 4)
+            self.assertEqual(ran, [])
+
+            # but not when that would also stop another cursor part way through
+            other = await db.execute("select x from foo order by x")
+            task = asyncio.create_task(db.execute(stmt.replace("from c)", "from c where x<3000000)")))
+            await asyncio.sleep(0.1)
+            task.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await task
+            self.assertEqual([row async for row in other], [(i,) for i in range(1, 11)])
+            self.assertEqual(len(db._active), 0)
+
+            # using the underlying cursor from the loop while the worker
+            # is busy is caught
+            db.batch_size = 1
+            stmt = "select 1 union all select * from (with recursive c(x) as (values(1) union all select x+1 from c where x<5000000) select sum(x) from c)"
+            cursor = await db.execute(stmt)
+            self.assertEqual(await cursor.fetchone(), (1,))
+            task = asyncio.create_task(cursor.fetchall())
+            await asyncio.sleep(0.1)
+            self.assertRaises(apsw.ThreadingViolationError, next, cursor.cursor)
+            self.assertEqual(await task, [(5000000 * 5000001 // 2,)])
+
+            await db.close()
+            await db.close()
+            worker.join(5)
+            self.assertFalse(worker.is_alive())
+            with self.assertRaises(apsw.ConnectionClosedError):
+                await db.execute("select 3")
+
+            # the worker stops if the connection is never closed
+            db = await apsw.aio.connect(":memory:")
+            worker = db._worker.thread
+            del db
+            gc.collect()
+            worker.join(5)
+            self.assertFalse(worker.is_alive())
+
+        asyncio.run(amain())
+
     def testLog(self):
         "Verifies logging functions"
         self.assertRaises(TypeError, apsw.log)
@@ -9031,6 +11644,83 @@ insert into xxblah values(3);
         s.cmdloop()
         isempty(fh[1])
         isempty(fh[2])
+        # tables of a database file are exported in parallel, giving
+        # the same dump
+        reset()
+        s = shellclass(args=[TESTFILEPREFIX + "testdump"], **kwargs)
+        cmd("pragma journal_mode=wal; create table one(x, y); create table [two 2](z);"
+            "with recursive c(i) as (values(1) union all select i+1 from c where i<20000) "
+            "insert into one select i, 'x' || i from c;"
+            "insert into [two 2] values(x'aabb'), (3.25), (null);")
+        s.cmdloop()
+        isempty(fh[2])
+        dumps = []
+        for cpus in (1, 4):
+            reset()
+            cmd(".dump")
+            orig = os.cpu_count
+            try:
+                os.cpu_count = lambda: cpus
+                s.cmdloop()
+            finally:
+                os.cpu_count = orig
+            isempty(fh[2])
+            dumps.append(re.sub("-- Date:.*", "", get(fh[1])))
+        self.assertEqual(dumps[0], dumps[1])
+        self.assertIn("INSERT INTO \"two 2\" VALUES(X'AABB');", dumps[0])
+        reset()
+        s = shellclass(args=[":memory:"], **kwargs)
+        cmd(dumps[0])
+        s.cmdloop()
+        isempty(fh[2])
+        self.assertEqual(s.db.execute("select count(*), sum(x) from one").get, (20000, 200010000))
+        self.assertEqual(s.db.execute("select * from [two 2]").fetchall(), [(b"\xaa\xbb", ), (3.25, ), (None, )])
+        # output without a file descriptor
+        reset()
+        s = shellclass(args=[TESTFILEPREFIX + "testdump"], **kwargs)
+        for cpus in (1, 4):
+            out = io.StringIO()
+            s.stdout = out
+            orig = os.cpu_count
+            try:
+                os.cpu_count = lambda: cpus
+                s.process_command(".dump")
+            finally:
+                os.cpu_count = orig
+            self.assertEqual(re.sub("-- Date:.*", "", out.getvalue()), dumps[0])
+        s.stdout = fh[1]
+        # parallel exports only run as many tables ahead as there are workers
+        for i in range(6):
+            s.db.execute(f"create table more{ i }(x); insert into more{ i } values({ i })")
+        events = []
+        import concurrent.futures
+        orig_submit, orig_write = concurrent.futures.ThreadPoolExecutor.submit, s.write
+
+        def submit(executor, *args):
+            events.append("submit")
+            return orig_submit(executor, *args)
+
+        def write(dest, text):
+            if text.startswith("DROP TABLE"):
+                events.append("table")
+            return orig_write(dest, text)
+
+        orig = os.cpu_count
+        try:
+            os.cpu_count = lambda: 2
+            concurrent.futures.ThreadPoolExecutor.submit = submit
+            s.write = write
+            s.process_command(".dump")
+        finally:
+            os.cpu_count = orig
+            concurrent.futures.ThreadPoolExecutor.submit = orig_submit
+            del s.write
+        self.assertEqual(events.count("submit"), 8)
+        self.assertEqual(events.count("table"), 8)
+        for i, event in enumerate(events):
+            if event == "table":
+                self.assertLessEqual(events[:i].count("submit"), 2 + events[:i].count("table"))
+        reset()
 
         ###
         ### Command - echo
@@ -530,7 +530,7 @@ class apsw_build_ext(beparent):
         if self.enable_all_extensions:
             exts = [
                 "fts4", "fts3", "fts3_parenthesis", "rtree", "stat4", "fts5", "rbu", "geopoly",
-                "math_functions"
+                "math_functions", "session", "preupdate_hook"
             ]
             if not self.omit or "icu" not in self.omit.split(","):
                 if get_icu_config():
@@ -624,7 +624,7 @@ class apsw_build_ext(beparent):
                        "memsys" not in e.lower() and \
                        e.lower() not in ("fts4", "fts3", "rtree", "icu", "iotrace",
                                          "stat2", "stat3", "stat4", "dbstat_vtab",
-                                         "fts5", "json1", "rbu", "geopoly"):
+                                         "fts5", "json1", "rbu", "geopoly", "session"):
                     write("Unknown enable " + e, sys.stderr)
                     raise ValueError("Bad enable " + e)
 
@@ -108,6 +108,8 @@ API Reference
 #include <stdarg.h>
 #ifdef _MSC_VER
 #include <malloc.h>
+/* dup and close */
+#include <io.h>
 #endif
 
 /* Get the version number */
@@ -205,6 +207,15 @@ static void apsw_write_unraisable(PyObject *hookobject);
 /* The statement cache */
 #include "statementcache.c"
 
+/* Connection.import_file */
+#include "dataimport.c"
+
+/* Connection.export_query */
+#include "dataexport.c"
+
+/* default for Connection.whole_row_fetch */
+static int whole_row_fetch_default = 0;
+
 /* connections */
 #include "connection.c"
 
@@ -219,6 +230,12 @@ static int allow_missing_dict_bindings = 0;
 /* cursors */
 #include "cursor.c"
 
+/* connection pool */
+#include "pool.c"
+
+/* session extension */
+#include "session.c"
+
 /* virtual tables */
 #include "vtable.c"
 
@@ -425,6 +442,11 @@ sqliteshutdown(void)
   Some operations don't make sense from a Python program.  All the
   remaining are supported.
 
+  Memory for `SQLITE_CONFIG_PAGECACHE
+  <https://sqlite.org/c3ref/c_config_chunkalloc.html#sqliteconfigpagecache>`__
+  is allocated by SQLite, so only the size and count are given.  See
+  :ref:`memory` for suggested settings.
+
   -* sqlite3_config
 */
 
@@ -517,7 +539,6 @@ config(PyObject *Py_UNUSED(self), PyObject *args)
   case SQLITE_CONFIG_PMASZ:
   case SQLITE_CONFIG_STMTJRNL_SPILL:
   case SQLITE_CONFIG_SORTERREF_SIZE:
-  case SQLITE_CONFIG_LOOKASIDE:
   case SQLITE_CONFIG_SMALL_MALLOC:
   {
     int intval;
@@ -528,6 +549,27 @@ config(PyObject *Py_UNUSED(self), PyObject *args)
     break;
   }
 
+  case SQLITE_CONFIG_LOOKASIDE:
+  {
+    int size, count;
+    if (!PyArg_ParseTuple(args, "iii", &optdup, &size, &count))
+      return NULL;
+    assert(opt == optdup);
+    res = sqlite3_config(opt, size, count);
+    break;
+  }
+
+  case SQLITE_CONFIG_PAGECACHE:
+  {
+    /* a NULL buffer has each connection allocate its own in one go */
+    int size, count;
+    if (!PyArg_ParseTuple(args, "iii", &optdup, &size, &count))
+      return NULL;
+    assert(opt == optdup);
+    res = sqlite3_config(opt, NULL, size, count);
+    break;
+  }
+
   case SQLITE_CONFIG_LOG:
   {
     PyObject *logger;
@@ -1770,6 +1812,31 @@ apsw_allow_missing_dict_bindings(PyObject *Py_UNUSED(module), PyObject *const *f
   Py_RETURN_FALSE;
 }
 
+/** .. method:: whole_row_fetch(value: bool) -> bool
+
+  Sets the default for :attr:`Connection.whole_row_fetch` used by
+  connections opened after this call.  Existing connections are not
+  changed.
+
+  The previous value is returned.
+*/
+static PyObject *
+apsw_whole_row_fetch(PyObject *Py_UNUSED(module), PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  int curval = whole_row_fetch_default;
+  int value;
+  {
+    Apsw_whole_row_fetch_CHECK;
+    ARG_PROLOG(1, Apsw_whole_row_fetch_KWNAMES);
+    ARG_MANDATORY ARG_bool(value);
+    ARG_EPILOG(NULL, Apsw_whole_row_fetch_USAGE, );
+  }
+  whole_row_fetch_default = value;
+  if (curval)
+    Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+}
+
 static PyObject *
 apsw_getattr(PyObject *Py_UNUSED(module), PyObject *name)
 {
@@ -1840,6 +1907,7 @@ static PyMethodDef module_methods[] = {
     {"set_default_vfs", (PyCFunction)apsw_set_default_vfs, METH_FASTCALL | METH_KEYWORDS, Apsw_set_default_vfs_DOC},
     {"unregister_vfs", (PyCFunction)apsw_unregister_vfs, METH_FASTCALL | METH_KEYWORDS, Apsw_unregister_vfs_DOC},
     {"allow_missing_dict_bindings", (PyCFunction)apsw_allow_missing_dict_bindings, METH_FASTCALL | METH_KEYWORDS, Apsw_allow_missing_dict_bindings_DOC},
+    {"whole_row_fetch", (PyCFunction)apsw_whole_row_fetch, METH_FASTCALL | METH_KEYWORDS, Apsw_whole_row_fetch_DOC},
 #ifdef APSW_TESTFIXTURES
     {"_fini", (PyCFunction)apsw_fini, METH_NOARGS,
      "Frees all caches and recycle lists"},
@@ -1901,9 +1969,14 @@ PyInit_apsw(void)
     goto fail;
   }
 
-  if (PyType_Ready(&ConnectionType) < 0 || PyType_Ready(&APSWCursorType) < 0 || PyType_Ready(&ZeroBlobBindType) < 0 || PyType_Ready(&APSWBlobType) < 0 || PyType_Ready(&APSWVFSType) < 0 || PyType_Ready(&APSWVFSFileType) < 0 || PyType_Ready(&apswfcntl_pragma_Type) < 0 || PyType_Ready(&APSWURIFilenameType) < 0 || PyType_Ready(&FunctionCBInfoType) < 0 || PyType_Ready(&APSWBackupType) < 0 || PyType_Ready(&SqliteIndexInfoType) < 0 || PyType_Ready(&apsw_no_change_object) < 0)
+  if (PyType_Ready(&ConnectionType) < 0 || PyType_Ready(&APSWCursorType) < 0 || PyType_Ready(&APSWBlobViewType) < 0 || PyType_Ready(&APSWRowType) < 0 || PyType_Ready(&ZeroBlobBindType) < 0 || PyType_Ready(&APSWBlobType) < 0 || PyType_Ready(&APSWBlobReopenIteratorType) < 0 || PyType_Ready(&APSWVFSType) < 0 || PyType_Ready(&APSWVFSFileType) < 0 || PyType_Ready(&apswfcntl_pragma_Type) < 0 || PyType_Ready(&APSWURIFilenameType) < 0 || PyType_Ready(&FunctionCBInfoType) < 0 || PyType_Ready(&APSWBackupType) < 0 || PyType_Ready(&ConnectionPoolType) < 0 || PyType_Ready(&SqliteIndexInfoType) < 0 || PyType_Ready(&apsw_no_change_object) < 0)
     goto fail;
 
+#ifdef SQLITE_ENABLE_SESSION
+  if (PyType_Ready(&APSWSessionType) < 0 || PyType_Ready(&APSWChangesetType) < 0 || PyType_Ready(&APSWChangesetIteratorType) < 0 || PyType_Ready(&APSWTableChangeType) < 0 || PyType_Ready(&APSWChangesetBuilderType) < 0)
+    goto fail;
+#endif
+
   /* PyStructSequence_NewType is broken in some Pythons
       https://github.com/python/cpython/issues/72895
     You also can't call InitType2 more than once otherwise
@@ -1944,14 +2017,23 @@ PyInit_apsw(void)
 
   ADD(Connection, ConnectionType);
   ADD(Cursor, APSWCursorType);
+  ADD(BlobView, APSWBlobViewType);
+  ADD(Row, APSWRowType);
   ADD(Blob, APSWBlobType);
   ADD(Backup, APSWBackupType);
+  ADD(ConnectionPool, ConnectionPoolType);
   ADD(zeroblob, ZeroBlobBindType);
   ADD(VFS, APSWVFSType);
   ADD(VFSFile, APSWVFSFileType);
   ADD(VFSFcntlPragma, apswfcntl_pragma_Type);
   ADD(URIFilename, APSWURIFilenameType);
   ADD(IndexInfo, SqliteIndexInfoType);
+#ifdef SQLITE_ENABLE_SESSION
+  ADD(Session, APSWSessionType);
+  ADD(Changeset, APSWChangesetType);
+  ADD(TableChange, APSWTableChangeType);
+  ADD(ChangesetBuilder, APSWChangesetBuilderType);
+#endif
 
 #undef ADD
 
@@ -2059,6 +2141,11 @@ modules etc. For example::
   if (add_apsw_constants(m))
     goto fail;
 
+#ifdef SQLITE_ENABLE_SESSION
+  if (add_session_constants(m))
+    goto fail;
+#endif
+
   PyModule_AddObject(m, "compile_options", get_compile_options());
   PyModule_AddObject(m, "keywords", get_keywords());
 
@@ -2072,6 +2159,16 @@ modules etc. For example::
     }
   }
 
+  if (!PyErr_Occurred())
+  {
+    PyObject *mod = PyImport_ImportModule("array");
+    if (mod)
+    {
+      array_array = PyObject_GetAttr(mod, apst.array);
+      Py_DECREF(mod);
+    }
+  }
+
   if (!PyErr_Occurred())
   {
     return m;
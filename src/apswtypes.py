@@ -3,6 +3,8 @@ import sys
 from typing import Optional, Callable, Any, Iterator, Iterable, Sequence, Literal, final, Protocol, TypeAlias
 from collections.abc import Mapping
 import array
+import concurrent.futures
+import mmap
 import types
 
 SQLiteValue = None | int | float | bytes | str
@@ -31,6 +33,18 @@ class AggregateClass(Protocol):
         ...
 
 
+class AggregateBatchClass(Protocol):
+    "Represents a running aggregate function registered with a batch_size"
+
+    def step_batch(self, columns: tuple[array.array | list[SQLiteValue], ...]) -> None:
+        "Called with each argument's values from a batch of matching rows"
+        ...
+
+    def final(self) -> SQLiteValue:
+        "Called after all matching rows have been processed to get the final value"
+        ...
+
+
 # Neither TypeVar nor ParamSpec work, when either should
 AggregateT = Any
 "An object provided as first parameter of step and final aggregate functions"
@@ -50,7 +64,7 @@ AggregateStep = (
 AggregateFinal = Callable[[AggregateT], SQLiteValue]
 "Final is called after all matching rows have been processed by step, and returns a SQLiteValue"
 
-AggregateFactory = Callable[[], AggregateClass | tuple[AggregateT, AggregateStep, AggregateFinal]]
+AggregateFactory = Callable[[], AggregateClass | AggregateBatchClass | tuple[AggregateT, AggregateStep, AggregateFinal]]
 """Called each time for the start of a new calculation using an aggregate function,
 returning an object, a step function and a final function"""
 
@@ -141,3 +155,31 @@ on the operatation.  Return SQLITE_OK, SQLITE_DENY, or SQLITE_IGNORE"""
 CommitHook = Callable[[], bool]
 """Commit hook is called with no arguments and should return True to abort the commit and False
 to let it continue"""
+
+UpdateHook = Callable[[int, str, str, int], None] | Callable[[list[tuple[int, str, str, int]]], None]
+"""Update hook is called with the operation, database name, table name, and rowid.  When batching
+it is instead called with a list of those as tuples"""
+
+
+class BlobSink(Protocol):
+    "Where :meth:`Blob.copy_to` writes, such as a file opened in binary mode"
+
+    def write(self, data: memoryview, /) -> Any:
+        "Called with each chunk of the blob, and must write all of it"
+        ...
+
+
+class BlobSource(Protocol):
+    "What :meth:`Blob.copy_from` reads, such as a file opened in binary mode"
+
+    def readinto(self, buffer: memoryview, /) -> int:
+        "Fills the buffer returning how many bytes were filled, with zero meaning there is no more"
+        ...
+
+
+ChangesetInput = bytes | Callable[[int], bytes]
+"""A changeset as bytes (or anything supporting the buffer protocol), or a function called with the
+maximum number of bytes wanted, returning at most that many and empty bytes at the end"""
+
+SessionStreamOutput = Callable[[memoryview], None]
+"""Called with each chunk of streamed session output.  The memoryview is only valid during the call"""
@@ -16,7 +16,8 @@ Backup
 A backup object encapsulates copying one database to another.  You
 call :meth:`Connection.backup` on the destination database to get the
 Backup object.  Call :meth:`~Backup.step` to copy some pages
-repeatedly dealing with errors as appropriate.  Finally
+repeatedly dealing with errors as appropriate, or :meth:`~Backup.run`
+to do all the steps in a background thread.  Finally
 :meth:`~Backup.finish` cleans up committing or rolling back and
 releasing locks.
 
@@ -67,9 +68,11 @@ typedef struct APSWBackup APSWBackup;
 static void
 APSWBackup_init(APSWBackup *self, Connection *dest, Connection *source, sqlite3_backup *backup)
 {
-  assert(dest->inuse == 0);
-  dest->inuse = 1;
-  assert(source->inuse == 1); /* set by caller */
+  int acquired = INUSE_ACQUIRE(dest);
+
+  assert(acquired);
+  (void)acquired;
+  assert(INUSE_GET(source) == 1); /* set by caller */
 
   self->dest = dest;
   self->source = source;
@@ -85,7 +88,7 @@ APSWBackup_close_internal(APSWBackup *self, int force)
 {
   int res, setexc = 0;
 
-  assert(!self->inuse);
+  assert(!INUSE_GET(self));
 
   if (!self->backup)
     return 0;
@@ -116,8 +119,8 @@ APSWBackup_close_internal(APSWBackup *self, int force)
 
   self->backup = 0;
 
-  assert(self->dest->inuse);
-  self->dest->inuse = 0;
+  assert(INUSE_GET(self->dest));
+  INUSE_RELEASE(self->dest);
 
   Connection_remove_dependent(self->dest, (PyObject *)self);
   Connection_remove_dependent(self->source, (PyObject *)self);
@@ -198,6 +201,279 @@ APSWBackup_step(APSWBackup *self, PyObject *const *fast_args, Py_ssize_t fast_na
   return Py_NewRef(self->done);
 }
 
+/* State for run in the background thread */
+typedef struct
+{
+  APSWBackup *backup;
+  PyObject *future;
+  PyObject *progress;
+  int pages_per_step;
+  int sleep_ms;
+  long long progress_interval_ns;
+  long long busy_timeout_ns;
+  /* result of the last step */
+  int res;
+  int remaining;
+  int page_count;
+  char *errmsg;
+} BackupRun;
+
+/* the longest busy backoff */
+#define BACKUP_RUN_MAX_BUSY_MS 1000
+
+/* Does one step.  Called with the GIL released */
+static void
+backup_run_step(BackupRun *run)
+{
+  sqlite3 *db = run->backup->dest->db;
+
+  sqlite3_mutex_enter(sqlite3_db_mutex(db));
+  run->res = sqlite3_backup_step(run->backup->backup, run->pages_per_step);
+  run->remaining = sqlite3_backup_remaining(run->backup->backup);
+  run->page_count = sqlite3_backup_pagecount(run->backup->backup);
+  /* step errors are only recorded on the destination by finish */
+  if (run->res != SQLITE_OK && run->res != SQLITE_DONE && !run->errmsg)
+    run->errmsg = sqlite3_mprintf("%s", sqlite3_errstr(run->res));
+  sqlite3_mutex_leave(sqlite3_db_mutex(db));
+}
+
+/* Calls progress returning -1 if it raised an exception.  The GIL must be held */
+static int
+backup_run_progress(BackupRun *run)
+{
+  PyObject *vargs[] = {NULL, PyLong_FromLong(run->remaining), PyLong_FromLong(run->page_count)};
+  PyObject *res = NULL;
+
+  if (vargs[1] && vargs[2])
+    res = PyObject_Vectorcall(run->progress, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  if (!res)
+    AddTraceBackHere(__FILE__, __LINE__, "Backup.run.progress", "{s: i, s: i}", "remaining", run->remaining, "page_count", run->page_count);
+  Py_XDECREF(vargs[1]);
+  Py_XDECREF(vargs[2]);
+  Py_XDECREF(res);
+  return res ? 0 : -1;
+}
+
+static void
+backup_run_thread(void *arg)
+{
+  BackupRun *run = (BackupRun *)arg;
+  PyGILState_STATE gilstate;
+  long long last_progress = apsw_perf_counter_ns(), busy_since = 0;
+  int busy_ms = 0, failed = 0;
+  PyObject *res;
+
+  for (;;)
+  {
+    backup_run_step(run);
+
+    if (run->res == SQLITE_BUSY || run->res == SQLITE_LOCKED)
+    {
+      long long now = apsw_perf_counter_ns();
+      if (!busy_ms)
+        busy_since = now;
+      /* give up, with the busy or locked error */
+      if (now - busy_since >= run->busy_timeout_ns)
+        break;
+      /* back off, doubling each time */
+      busy_ms = busy_ms ? Py_MIN(busy_ms * 2, BACKUP_RUN_MAX_BUSY_MS) : Py_MAX(run->sleep_ms, 1);
+      sqlite3_free(run->errmsg);
+      run->errmsg = NULL;
+      sqlite3_sleep(busy_ms);
+      continue;
+    }
+    busy_ms = 0;
+
+    if (run->res != SQLITE_OK)
+      break;
+
+    if (run->progress && apsw_perf_counter_ns() - last_progress >= run->progress_interval_ns)
+    {
+      gilstate = PyGILState_Ensure();
+      failed = backup_run_progress(run);
+      /* keep the GIL since releasing it would discard the thread state
+         holding the exception */
+      if (failed)
+        break;
+      PyGILState_Release(gilstate);
+      last_progress = apsw_perf_counter_ns();
+    }
+
+    if (run->sleep_ms)
+      sqlite3_sleep(run->sleep_ms);
+  }
+
+  if (!failed)
+    gilstate = PyGILState_Ensure();
+
+  if (!failed && run->res == SQLITE_DONE)
+  {
+    if (!Py_IsTrue(run->backup->done))
+    {
+      Py_CLEAR(run->backup->done);
+      run->backup->done = Py_NewRef(Py_True);
+    }
+    if (run->progress)
+      failed = backup_run_progress(run);
+  }
+
+  /* this would happen if there were errors deep in the vfs */
+  MakeExistingException();
+
+  if (!PyErr_Occurred() && run->res != SQLITE_DONE)
+  {
+    apsw_set_errmsg(run->errmsg ? run->errmsg : "error");
+    SET_EXC(run->res, run->backup->dest->db);
+  }
+
+  INUSE_RELEASE(run->backup);
+
+  if (PyErr_Occurred())
+  {
+    PY_ERR_FETCH(exc);
+    PY_ERR_NORMALIZE(exc);
+#if PY_VERSION_HEX < 0x030c0000
+    if (exctraceback)
+      PyException_SetTraceback(exc, exctraceback);
+#endif
+    res = PyObject_CallMethod(run->future, "set_exception", "(O)", exc);
+    PY_ERR_CLEAR(exc);
+  }
+  else
+    res = PyObject_CallMethod(run->future, "set_result", "(i)", run->page_count);
+  if (!res)
+    apsw_write_unraisable(NULL);
+  Py_XDECREF(res);
+
+  sqlite3_free(run->errmsg);
+  Py_DECREF(run->backup);
+  Py_DECREF(run->future);
+  Py_XDECREF(run->progress);
+  PyMem_Free(run);
+
+  PyGILState_Release(gilstate);
+}
+
+/** .. method:: run(pages_per_step: int = 100, sleep_ms: int = 10, progress: Optional[Callable[[int, int], None]] = None, *, progress_interval_ms: int = 100, busy_timeout_ms: int = 60000) -> concurrent.futures.Future[int]
+
+  Copies all the pages in a background thread, returning a
+  :class:`concurrent.futures.Future` that completes with the
+  number of pages copied, or the exception.  The GIL is only
+  acquired to call *progress*, so the copy does not hold up Python
+  or your other threads.
+
+  The backup is not used from Python until the future completes.
+  Calling methods on it meanwhile gives a
+  :exc:`ThreadingViolationError`.  You still need to call
+  :meth:`finish` afterwards so that the copy takes effect.
+
+  .. code-block:: python
+
+    with destination.backup("main", source, "main") as backup:
+        # in asyncio use: await asyncio.wrap_future(backup.run())
+        backup.run(progress=lambda remaining, total: print(remaining, total)).result()
+
+  :param pages_per_step: How many pages to copy in each
+     :meth:`step`.  The source database is only locked during each
+     step.
+  :param sleep_ms: How long to sleep between steps so that other
+     connections can use the source database.
+  :param progress: Called with the :attr:`remaining` and
+     :attr:`page_count`.  It is called at most once every
+     *progress_interval_ms* milliseconds, and once more when the
+     copy is complete.   If it raises an exception then the copy
+     stops, and the future has the exception.
+  :param progress_interval_ms: The minimum time between calls to
+     *progress*
+  :param busy_timeout_ms: How long to keep retrying while the source
+     database is busy or locked, after which the future has the
+     :exc:`BusyError` or :exc:`LockedError`
+
+  If the source database is busy or locked then the step is retried
+  after sleeping, doubling the sleep each consecutive time up to a
+  second.  The future can't be cancelled once the copy has started,
+  so *busy_timeout_ms* is what stops it waiting forever for another
+  connection to release its lock.
+
+  -* sqlite3_backup_step sqlite3_backup_remaining sqlite3_backup_pagecount
+*/
+static PyObject *
+APSWBackup_run(APSWBackup *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  int pages_per_step = 100, sleep_ms = 10, progress_interval_ms = 100, busy_timeout_ms = 60000;
+  PyObject *progress = NULL, *module = NULL, *future = NULL, *res = NULL;
+  BackupRun *run = NULL;
+
+  CHECK_USE(NULL);
+  CHECK_BACKUP_CLOSED(NULL);
+
+  {
+    Backup_run_CHECK;
+    ARG_PROLOG(3, Backup_run_KWNAMES);
+    ARG_OPTIONAL ARG_int(pages_per_step);
+    ARG_OPTIONAL ARG_int(sleep_ms);
+    ARG_OPTIONAL ARG_optional_Callable(progress);
+    ARG_OPTIONAL ARG_int(progress_interval_ms);
+    ARG_OPTIONAL ARG_int(busy_timeout_ms);
+    ARG_EPILOG(NULL, Backup_run_USAGE, );
+  }
+
+  if (pages_per_step == 0 || sleep_ms < 0 || progress_interval_ms < 0 || busy_timeout_ms < 0)
+    return PyErr_Format(PyExc_ValueError, "pages_per_step must be non-zero, and sleep_ms, progress_interval_ms and busy_timeout_ms must not be negative");
+
+  module = PyImport_ImportModule("concurrent.futures");
+  if (!module)
+    goto error;
+  future = PyObject_CallMethod(module, "Future", NULL);
+  if (!future)
+    goto error;
+  res = PyObject_CallMethod(future, "set_running_or_notify_cancel", NULL);
+  if (!res)
+    goto error;
+
+  run = PyMem_Calloc(1, sizeof(BackupRun));
+  if (!run)
+  {
+    PyErr_NoMemory();
+    goto error;
+  }
+
+  if (!INUSE_ACQUIRE(self))
+  {
+    PyErr_Format(ExcThreadingViolation, INUSE_VIOLATION_MESSAGE);
+    goto error;
+  }
+
+  run->backup = (APSWBackup *)Py_NewRef((PyObject *)self);
+  run->future = Py_NewRef(future);
+  run->progress = Py_XNewRef(progress);
+  run->pages_per_step = pages_per_step;
+  run->sleep_ms = sleep_ms;
+  run->progress_interval_ns = progress_interval_ms * 1000000LL;
+  run->busy_timeout_ns = busy_timeout_ms * 1000000LL;
+
+  if (PyThread_start_new_thread(backup_run_thread, run) == PYTHREAD_INVALID_THREAD_ID)
+  {
+    INUSE_RELEASE(self);
+    Py_DECREF(run->backup);
+    Py_DECREF(run->future);
+    Py_XDECREF(run->progress);
+    PyErr_Format(PyExc_RuntimeError, "Unable to start backup thread");
+    goto error;
+  }
+
+  Py_DECREF(module);
+  Py_DECREF(res);
+  return future;
+
+error:
+  PyMem_Free(run);
+  Py_XDECREF(module);
+  Py_XDECREF(future);
+  Py_XDECREF(res);
+  return NULL;
+}
+
 /** .. method:: finish() -> None
 
   Completes the copy process.  If all pages have been copied then the
@@ -381,6 +657,8 @@ static PyMethodDef backup_methods[] = {
      Backup_exit_DOC},
     {"step", (PyCFunction)APSWBackup_step, METH_FASTCALL | METH_KEYWORDS,
      Backup_step_DOC},
+    {"run", (PyCFunction)APSWBackup_run, METH_FASTCALL | METH_KEYWORDS,
+     Backup_run_DOC},
     {"finish", (PyCFunction)APSWBackup_finish, METH_NOARGS,
      Backup_finish_DOC},
     {"close", (PyCFunction)APSWBackup_close, METH_FASTCALL | METH_KEYWORDS,
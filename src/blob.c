@@ -123,7 +123,7 @@ struct APSWBlob
   PyObject_HEAD
       Connection *connection;
   sqlite3_blob *pBlob;
-  unsigned inuse;        /* track if we are in use preventing concurrent thread mangling */
+  int inuse;             /* track if we are in use preventing concurrent thread mangling */
   int curoffset;         /* SQLite only supports 32 bit signed int offsets */
   PyObject *weakreflist; /* weak reference tracking */
 };
@@ -632,6 +632,30 @@ APSWBlob_exit(APSWBlob *self, PyObject *Py_UNUSED(args))
   Py_RETURN_FALSE;
 }
 
+/* Does the work of reopen.  Returns -1 with an exception on error */
+static int
+APSWBlob_reopen_internal(APSWBlob *self, long long rowid)
+{
+  int res;
+
+  /* no matter what happens we always reset current offset */
+  self->curoffset = 0;
+
+  PYSQLITE_BLOB_CALL(res = sqlite3_blob_reopen(self->pBlob, rowid));
+
+  MakeExistingException(); /* a vfs error could cause this */
+
+  if (PyErr_Occurred())
+    return -1;
+
+  if (res != SQLITE_OK)
+  {
+    SET_EXC(res, self->connection->db);
+    return -1;
+  }
+  return 0;
+}
+
 /** .. method:: reopen(rowid: int) -> None
 
   Change this blob object to point to a different row.  It can be
@@ -643,7 +667,6 @@ APSWBlob_exit(APSWBlob *self, PyObject *Py_UNUSED(args))
 static PyObject *
 APSWBlob_reopen(APSWBlob *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
 {
-  int res;
   long long rowid;
 
   CHECK_USE(NULL);
@@ -655,22 +678,471 @@ APSWBlob_reopen(APSWBlob *self, PyObject *const *fast_args, Py_ssize_t fast_narg
     ARG_MANDATORY ARG_int64(rowid);
     ARG_EPILOG(NULL, Blob_reopen_USAGE, );
   }
-  /* no matter what happens we always reset current offset */
-  self->curoffset = 0;
+  if (APSWBlob_reopen_internal(self, rowid))
+    return NULL;
+  Py_RETURN_NONE;
+}
 
-  PYSQLITE_BLOB_CALL(res = sqlite3_blob_reopen(self->pBlob, rowid));
+/* Iterator returned by reopen_each */
+typedef struct
+{
+  PyObject_HEAD
+      APSWBlob *blob;
+  PyObject *rowids; /* iterator over the rowids */
+} APSWBlobReopenIterator;
 
-  MakeExistingException(); /* a vfs error could cause this */
+static int
+APSWBlobReopenIterator_tp_traverse(APSWBlobReopenIterator *self, visitproc visit, void *arg)
+{
+  Py_VISIT(self->blob);
+  Py_VISIT(self->rowids);
+  return 0;
+}
+
+static int
+APSWBlobReopenIterator_tp_clear(APSWBlobReopenIterator *self)
+{
+  Py_CLEAR(self->blob);
+  Py_CLEAR(self->rowids);
+  return 0;
+}
+
+static void
+APSWBlobReopenIterator_dealloc(APSWBlobReopenIterator *self)
+{
+  PyObject_GC_UnTrack(self);
+  Py_XDECREF(self->blob);
+  Py_XDECREF(self->rowids);
+  Py_TpFree((PyObject *)self);
+}
+
+static PyObject *
+APSWBlobReopenIterator_next(APSWBlobReopenIterator *it)
+{
+  APSWBlob *self = it->blob;
+  PyObject *rowid;
+  long long value = 0;
+
+  CHECK_USE(NULL);
+  CHECK_BLOB_CLOSED;
+
+  rowid = PyIter_Next(it->rowids);
+  if (!rowid)
+    return NULL;
+  if (PyLong_Check(rowid))
+    value = PyLong_AsLongLong(rowid);
+  else
+    PyErr_Format(PyExc_TypeError, "rowids should be int, not %s", Py_TypeName(rowid));
+  if (PyErr_Occurred() || APSWBlob_reopen_internal(self, value))
+  {
+    Py_DECREF(rowid);
+    return NULL;
+  }
+  return rowid;
+}
+
+static PyTypeObject APSWBlobReopenIteratorType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "apsw.BlobReopenIterator",
+    .tp_basicsize = sizeof(APSWBlobReopenIterator),
+    .tp_dealloc = (destructor)APSWBlobReopenIterator_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_traverse = (traverseproc)APSWBlobReopenIterator_tp_traverse,
+    .tp_clear = (inquiry)APSWBlobReopenIterator_tp_clear,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc)APSWBlobReopenIterator_next,
+};
+
+/** .. method:: reopen_each(rowids: Iterable[int]) -> Iterator[int]
+
+  Returns an iterator that :meth:`reopens <reopen>` this blob on each
+  rowid from *rowids* in turn, returning the rowid.  One blob can then
+  work through many rows, such as serving stored files.
+
+  .. code-block:: python
+
+    with connection.blob_open("main", "media", "content", first, False) as blob:
+        for rowid in blob.reopen_each(rowids):
+            blob.copy_to(sock.fileno())
+
+  -* sqlite3_blob_reopen
+*/
+
+static PyObject *
+APSWBlob_reopen_each(APSWBlob *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *rowids = NULL;
+  APSWBlobReopenIterator *it;
+
+  CHECK_USE(NULL);
+  CHECK_BLOB_CLOSED;
+
+  {
+    Blob_reopen_each_CHECK;
+    ARG_PROLOG(1, Blob_reopen_each_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(rowids);
+    ARG_EPILOG(NULL, Blob_reopen_each_USAGE, );
+  }
+
+  rowids = PyObject_GetIter(rowids);
+  if (!rowids)
+    return NULL;
+  it = PyObject_GC_New(APSWBlobReopenIterator, &APSWBlobReopenIteratorType);
+  if (!it)
+  {
+    Py_DECREF(rowids);
+    return NULL;
+  }
+  it->blob = (APSWBlob *)Py_NewRef((PyObject *)self);
+  it->rowids = rowids;
+  PyObject_GC_Track(it);
+  return (PyObject *)it;
+}
+
+/* How much copy_to and copy_from do at a time by default */
+#define BLOB_COPY_CHUNK_SIZE (1024 * 1024)
+
+/* Copies amount bytes of the blob from offset to the file descriptor.
+   Called with the GIL released, taking the database mutex for each
+   chunk read.  Returns SQLITE_OK, an error code from SQLite, or
+   SQLITE_IOERR with *io_errno set if writing failed. */
+static int
+blob_copy_to_fd(sqlite3 *db, sqlite3_blob *blob, int offset, int amount, char *buffer, int chunk_size, int fd,
+                int *copied, int *io_errno)
+{
+  int res = SQLITE_OK;
+
+  while (amount > 0)
+  {
+    int n = (amount < chunk_size) ? amount : chunk_size;
+    char *pos = buffer;
+
+    sqlite3_mutex_enter(sqlite3_db_mutex(db));
+    res = sqlite3_blob_read(blob, buffer, n, offset);
+    if (res != SQLITE_OK)
+      apsw_set_errmsg(sqlite3_errmsg(db));
+    sqlite3_mutex_leave(sqlite3_db_mutex(db));
+    if (res != SQLITE_OK)
+      return res;
+
+    while (pos < buffer + n)
+    {
+      int written = (int)write(fd, pos, (unsigned)(buffer + n - pos));
+      if (written < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        *io_errno = errno;
+        return SQLITE_IOERR;
+      }
+      pos += written;
+      *copied += written;
+    }
+    offset += n;
+    amount -= n;
+  }
+  return res;
+}
+
+/* Copies up to amount bytes from the file descriptor into the blob at
+   offset, stopping early at end of file.  Called with the GIL released,
+   taking the database mutex for each chunk written.  Returns the same
+   as blob_copy_to_fd */
+static int
+blob_copy_from_fd(sqlite3 *db, sqlite3_blob *blob, int offset, int amount, char *buffer, int chunk_size, int fd,
+                  int *copied, int *io_errno)
+{
+  int res = SQLITE_OK;
+
+  while (amount > 0)
+  {
+    int n = (int)read(fd, buffer, (unsigned)((amount < chunk_size) ? amount : chunk_size));
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      *io_errno = errno;
+      return SQLITE_IOERR;
+    }
+    if (n == 0)
+      break;
+
+    sqlite3_mutex_enter(sqlite3_db_mutex(db));
+    res = sqlite3_blob_write(blob, buffer, n, offset);
+    if (res != SQLITE_OK)
+      apsw_set_errmsg(sqlite3_errmsg(db));
+    sqlite3_mutex_leave(sqlite3_db_mutex(db));
+    if (res != SQLITE_OK)
+      return res;
+
+    *copied += n;
+    offset += n;
+    amount -= n;
+  }
+  return res;
+}
+
+/* Works out the file descriptor if destination/source is an int,
+   leaving it -1 otherwise.  Returns -1 with an exception on error */
+static int
+blob_copy_fd(PyObject *obj, int *fd)
+{
+  if (!PyLong_Check(obj))
+    return 0;
+  *fd = PyLong_AsInt(obj);
+  if (*fd == -1 && PyErr_Occurred())
+    return -1;
+  if (*fd < 0)
+  {
+    PyErr_Format(PyExc_ValueError, "file descriptor must be zero or positive, not %d", *fd);
+    return -1;
+  }
+  return 0;
+}
+
+/** .. method:: copy_to(destination: int | BlobSink, length: int = -1, chunk_size: int = 1048576) -> int
+
+  Copies the blob from the current position to *destination*,
+  advancing the position, and returns how many bytes were copied.
+  This is much faster than calling :meth:`read` in a loop.
+
+  :param destination: An open file descriptor, which is written with
+      the GIL released.  On platforms other than Windows this can be a
+      socket.  Otherwise an object whose ``write`` method is called with
+      a :class:`memoryview` of each chunk, which is only valid during
+      the call.  Flush any Python buffering around a descriptor first.
+  :param length: How many bytes to copy, with negative numbers meaning
+      all remaining data.  It is limited to the end of the blob.
+  :param chunk_size: How many bytes are read from the blob and then
+      written at a time.
+
+  Writing to a descriptor continues until all of each chunk has been
+  written.  A ``write`` method must write all the data it is given, as
+  buffered files do.  If an exception occurs the position is after
+  what was copied.
+
+  -* sqlite3_blob_read
+*/
+static PyObject *
+APSWBlob_copy_to(APSWBlob *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *destination = NULL;
+  int length = -1, chunk_size = BLOB_COPY_CHUNK_SIZE;
+  int res = SQLITE_OK, fd = -1, copied = 0, io_errno = 0;
+  char *buffer = NULL;
+
+  CHECK_USE(NULL);
+  CHECK_BLOB_CLOSED;
+
+  {
+    Blob_copy_to_CHECK;
+    ARG_PROLOG(3, Blob_copy_to_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(destination);
+    ARG_OPTIONAL ARG_int(length);
+    ARG_OPTIONAL ARG_int(chunk_size);
+    ARG_EPILOG(NULL, Blob_copy_to_USAGE, );
+  }
+
+  if (chunk_size < 1)
+    return PyErr_Format(PyExc_ValueError, "chunk_size must be at least one, not %d", chunk_size);
+  if (blob_copy_fd(destination, &fd))
+    return NULL;
+
+  if (length < 0 || length > sqlite3_blob_bytes(self->pBlob) - self->curoffset)
+    length = sqlite3_blob_bytes(self->pBlob) - self->curoffset;
+  if (chunk_size > length)
+    chunk_size = length;
+  if (!length)
+    return PyLong_FromLong(0);
+
+  buffer = PyMem_Malloc(chunk_size);
+  if (!buffer)
+    return PyErr_NoMemory();
+
+  if (fd >= 0)
+  {
+    INUSE_CALL_ELSE(_PYSQLITE_CALL_V(res = blob_copy_to_fd(self->connection->db, self->pBlob, self->curoffset,
+                                                           length, buffer, chunk_size, fd, &copied, &io_errno)),
+                    res = SQLITE_MISUSE);
+    self->curoffset += copied;
+  }
+  else
+  {
+    while (copied < length)
+    {
+      int n = (length - copied < chunk_size) ? length - copied : chunk_size;
+      PyObject *view, *written;
+
+      /* the write method could have closed us */
+      if (!self->pBlob)
+      {
+        PyErr_Format(PyExc_ValueError, "I/O operation on closed blob");
+        break;
+      }
+      PYSQLITE_BLOB_CALL(res = sqlite3_blob_read(self->pBlob, buffer, n, self->curoffset));
+      MakeExistingException();
+      if (PyErr_Occurred() || res != SQLITE_OK)
+        break;
+
+      view = PyMemoryView_FromMemory(buffer, n, PyBUF_READ);
+      if (!view)
+        break;
+      PyObject *vargs[] = {NULL, destination, view};
+      written = PyObject_VectorcallMethod(apst.write, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+      if (0 != memoryview_release(view))
+        Py_CLEAR(written);
+      Py_DECREF(view);
+      if (!written)
+        break;
+      Py_DECREF(written);
+      self->curoffset += n;
+      copied += n;
+    }
+  }
 
+  PyMem_Free(buffer);
+
+  MakeExistingException(); /* vfs errors could cause this */
+  if (!PyErr_Occurred())
+  {
+    if (io_errno)
+    {
+      errno = io_errno;
+      PyErr_SetFromErrno(PyExc_OSError);
+    }
+    else if (res != SQLITE_OK)
+      SET_EXC(res, self->connection->db);
+  }
   if (PyErr_Occurred())
     return NULL;
+  return PyLong_FromLong(copied);
+}
+
+/** .. method:: copy_from(source: int | BlobSource, length: int = -1, chunk_size: int = 1048576) -> int
+
+  Copies data from *source* into the blob at the current position
+  until the source has no more, advancing the position, and returns
+  how many bytes were copied.  This is much faster than calling
+  :meth:`write` in a loop.
+
+  :param source: An open file descriptor, which is read with the GIL
+      released.  On platforms other than Windows this can be a socket.
+      Otherwise an object whose ``readinto`` method is called with a
+      :class:`memoryview` to fill, which is only valid during the call.
+      It returns how many bytes it filled, with zero meaning there is
+      no more.
+  :param length: The most bytes to copy, with negative numbers meaning
+      up to the end of the blob.  It is limited to the end of the blob.
+  :param chunk_size: How many bytes are read and then written to the
+      blob at a time.
+
+  No more than *length* bytes are read from *source*, so anything
+  after remains to be read.  If an exception occurs the position is
+  after what was copied.
+
+  -* sqlite3_blob_write
+*/
+static PyObject *
+APSWBlob_copy_from(APSWBlob *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *source = NULL;
+  int length = -1, chunk_size = BLOB_COPY_CHUNK_SIZE;
+  int res = SQLITE_OK, fd = -1, copied = 0, io_errno = 0;
+  char *buffer = NULL;
+
+  CHECK_USE(NULL);
+  CHECK_BLOB_CLOSED;
 
-  if (res != SQLITE_OK)
   {
-    SET_EXC(res, self->connection->db);
+    Blob_copy_from_CHECK;
+    ARG_PROLOG(3, Blob_copy_from_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(source);
+    ARG_OPTIONAL ARG_int(length);
+    ARG_OPTIONAL ARG_int(chunk_size);
+    ARG_EPILOG(NULL, Blob_copy_from_USAGE, );
+  }
+
+  if (chunk_size < 1)
+    return PyErr_Format(PyExc_ValueError, "chunk_size must be at least one, not %d", chunk_size);
+  if (blob_copy_fd(source, &fd))
     return NULL;
+
+  if (length < 0 || length > sqlite3_blob_bytes(self->pBlob) - self->curoffset)
+    length = sqlite3_blob_bytes(self->pBlob) - self->curoffset;
+  if (chunk_size > length)
+    chunk_size = length;
+  if (!length)
+    return PyLong_FromLong(0);
+
+  buffer = PyMem_Malloc(chunk_size);
+  if (!buffer)
+    return PyErr_NoMemory();
+
+  if (fd >= 0)
+  {
+    INUSE_CALL_ELSE(_PYSQLITE_CALL_V(res = blob_copy_from_fd(self->connection->db, self->pBlob, self->curoffset,
+                                                             length, buffer, chunk_size, fd, &copied, &io_errno)),
+                    res = SQLITE_MISUSE);
+    self->curoffset += copied;
   }
-  Py_RETURN_NONE;
+  else
+  {
+    while (copied < length)
+    {
+      int n = (length - copied < chunk_size) ? length - copied : chunk_size;
+      long long count = -1;
+      PyObject *view, *got;
+
+      view = PyMemoryView_FromMemory(buffer, n, PyBUF_WRITE);
+      if (!view)
+        break;
+      PyObject *vargs[] = {NULL, source, view};
+      got = PyObject_VectorcallMethod(apst.readinto, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+      if (0 != memoryview_release(view))
+        Py_CLEAR(got);
+      Py_DECREF(view);
+      if (!got)
+        break;
+      if (PyLong_Check(got))
+        count = PyLong_AsLongLong(got);
+      if (!PyErr_Occurred() && (count < 0 || count > n))
+        PyErr_Format(PyExc_ValueError, "readinto should return the number of bytes read between 0 and %d, not %R", n,
+                     got);
+      Py_DECREF(got);
+      if (PyErr_Occurred() || count == 0)
+        break;
+
+      /* the readinto method could have closed us */
+      if (!self->pBlob)
+      {
+        PyErr_Format(PyExc_ValueError, "I/O operation on closed blob");
+        break;
+      }
+      PYSQLITE_BLOB_CALL(res = sqlite3_blob_write(self->pBlob, buffer, (int)count, self->curoffset));
+      MakeExistingException();
+      if (PyErr_Occurred() || res != SQLITE_OK)
+        break;
+      self->curoffset += (int)count;
+      copied += (int)count;
+    }
+  }
+
+  PyMem_Free(buffer);
+
+  MakeExistingException(); /* vfs errors could cause this */
+  if (!PyErr_Occurred())
+  {
+    if (io_errno)
+    {
+      errno = io_errno;
+      PyErr_SetFromErrno(PyExc_OSError);
+    }
+    else if (res != SQLITE_OK)
+      SET_EXC(res, self->connection->db);
+  }
+  if (PyErr_Occurred())
+    return NULL;
+  return PyLong_FromLong(copied);
 }
 
 static PyObject *
@@ -696,6 +1168,12 @@ static PyMethodDef APSWBlob_methods[] = {
      Blob_write_DOC},
     {"reopen", (PyCFunction)APSWBlob_reopen, METH_FASTCALL | METH_KEYWORDS,
      Blob_reopen_DOC},
+    {"reopen_each", (PyCFunction)APSWBlob_reopen_each, METH_FASTCALL | METH_KEYWORDS,
+     Blob_reopen_each_DOC},
+    {"copy_to", (PyCFunction)APSWBlob_copy_to, METH_FASTCALL | METH_KEYWORDS,
+     Blob_copy_to_DOC},
+    {"copy_from", (PyCFunction)APSWBlob_copy_from, METH_FASTCALL | METH_KEYWORDS,
+     Blob_copy_from_DOC},
     {"close", (PyCFunction)APSWBlob_close, METH_FASTCALL | METH_KEYWORDS,
      Blob_close_DOC},
     {"__enter__", (PyCFunction)APSWBlob_enter, METH_NOARGS,
@@ -27,8 +27,20 @@ typedef struct
   PyObject *scalarfunc;           /* the function to call for stepping */
   PyObject *aggregatefactory;     /* factory for aggregate functions */
   PyObject *windowfactory;        /* factory for window functions */
+  char *arg_types;                /* declared argument types of typed functions, else NULL */
+  int num_arg_types;
+  char return_type;               /* declared return type of typed scalar functions, else 0 */
+  int batch_size;                 /* rows per aggregate step_batch call, else 0 */
 } FunctionCBInfo;
 
+/* arguments buffered for an aggregate function registered with batch_size */
+typedef struct
+{
+  int rows;      /* how many rows are buffered */
+  int columns;   /* how many arguments each row has */
+  void **values; /* per column batch_size int64 or double for arguments declared int or float, else PyObject * */
+} aggregatebatch;
+
 /* a particular aggregate function instance used as sqlite3_aggregate_context */
 typedef struct
 {
@@ -38,9 +50,10 @@ typedef struct
     afcUNINIT = 0,
     afcERROR = -1
   } state;
-  PyObject *aggvalue;  /* the aggregation value passed as first parameter */
-  PyObject *stepfunc;  /* step function */
-  PyObject *finalfunc; /* final function */
+  PyObject *aggvalue;     /* the aggregation value passed as first parameter */
+  PyObject *stepfunc;     /* step function (step_batch when batched) */
+  PyObject *finalfunc;    /* final function */
+  aggregatebatch *batch;  /* buffered arguments when batched */
 } aggregatefunctioncontext;
 
 /* a particular window function instance used as sqlite3_aggregate_context */
@@ -59,13 +72,42 @@ typedef struct
   PyObject *inversefunc; /* inverse function */
 } windowfunctioncontext;
 
+/* a row change held by a batched update hook */
+typedef struct
+{
+  int op;
+  int table; /* index into update_batch_tables */
+  sqlite3_int64 rowid;
+} UpdateBatchRow;
+
+/* rows taken from a connection when its update hook is changed */
+typedef struct
+{
+  UpdateBatchRow *rows;
+  int count;
+  char **tables;
+  int tables_count;
+} UpdateBatchHeld;
+
+/* a database's schema version, used to notice schema changes for
+   the metadata cache */
+typedef struct
+{
+  sqlite3_stmt *stmt;    /* pragma "name".schema_version */
+  char *name;            /* database name */
+  char *filename;        /* database filename, empty for temp and memory */
+  sqlite3_int64 version; /* value when the metadata cache was filled */
+  int reprepares;        /* SQLITE_STMTSTATUS_REPREPARE of stmt, which changes
+                            when databases are detached and attached */
+} SchemaVersion;
+
 /* CONNECTION TYPE */
 
 struct Connection
 {
   PyObject_HEAD
       sqlite3 *db; /* the actual database connection */
-  unsigned inuse;  /* track if we are in use preventing concurrent thread mangling */
+  int inuse;       /* track if we are in use preventing concurrent thread mangling */
 
   struct StatementCache *stmtcache; /* prepared statement cache */
 
@@ -88,12 +130,51 @@ struct Connection
   PyObject *tracehook;
   int tracemask;
 
+  /* batched update hook - rows are held until commit or update_batch
+     of them, and discarded on rollback.  update_batch is zero when not
+     batching */
+  int update_batch;
+  int update_batch_count;
+  UpdateBatchRow *update_batch_rows;
+  char **update_batch_tables; /* database name NUL table name NUL */
+  int update_batch_tables_count;
+  int update_batch_last_table;
+  /* rows delivered or discarded before the current batch, and that
+     plus update_batch_count at each __enter__ level so rows can be
+     discarded when the with block is rolled back */
+  long long update_batch_base;
+  long long *update_batch_marks;
+  long update_batch_marks_size;
+
   /* if we are using one of our VFS since sqlite doesn't reference count them */
   PyObject *vfs;
 
   /* used for nested with (contextmanager) statements */
   long savepointlevel;
 
+  /* read whole rows in one GIL release */
+  int whole_row_fetch;
+
+  /* bind text and blobs without SQLite making a copy */
+  int zero_copy_bindings;
+
+  /* measure time and rows per statement */
+  int profile_statements;
+
+  /* return result rows as apsw.Row instead of tuple */
+  int named_rows;
+
+  /* type conversion registered on the connection, NULL when empty */
+  PyObject *adapters;          /* dict of type to callable making a SQLite value */
+  PyObject *converters;        /* dict of declared column type to callable */
+  unsigned converters_version; /* changes whenever converters does */
+
+  /* schema dependent results, discarded when any of schema_versions
+     change */
+  PyObject *metadata_cache;        /* dict, NULL until first used */
+  SchemaVersion *schema_versions; /* one per attached database */
+  int schema_versions_count;
+
   /* informational attributes */
   PyObject *open_flags;
   PyObject *open_vfs;
@@ -120,6 +201,7 @@ typedef struct _vtableinfo
                              Connection* */
   int bestindex_object;   /* 0: tuples are passed to xBestIndex, 1: object is */
   int use_no_change;
+  int cache_best_index;
   struct sqlite3_module *sqlite3_module_def;
 } vtableinfo;
 
@@ -149,6 +231,8 @@ FunctionCBInfo_dealloc(FunctionCBInfo *self)
   Py_CLEAR(self->scalarfunc);
   Py_CLEAR(self->aggregatefactory);
   Py_CLEAR(self->windowfactory);
+  PyMem_Free(self->arg_types);
+  self->arg_types = NULL;
   Py_TpFree((PyObject *)self);
 }
 
@@ -161,9 +245,50 @@ FunctionCBInfo_dealloc(FunctionCBInfo *self)
 
 /* CONNECTION CODE */
 
+static void
+Connection_update_batch_free(Connection *self)
+{
+  int i;
+
+  for (i = 0; i < self->update_batch_tables_count; i++)
+    PyMem_RawFree(self->update_batch_tables[i]);
+  PyMem_RawFree(self->update_batch_tables);
+  PyMem_RawFree(self->update_batch_rows);
+  self->update_batch = 0;
+  self->update_batch_base += self->update_batch_count;
+  self->update_batch_count = 0;
+  self->update_batch_rows = 0;
+  self->update_batch_tables = 0;
+  self->update_batch_tables_count = 0;
+  self->update_batch_last_table = 0;
+}
+
+static void Connection_update_batch_replace(Connection *self, int batch, UpdateBatchRow *rows, int hook,
+                                           UpdateBatchHeld *held);
+
+static void
+Connection_schema_versions_free(Connection *self)
+{
+  int i;
+
+  for (i = 0; i < self->schema_versions_count; i++)
+  {
+    sqlite3_finalize(self->schema_versions[i].stmt);
+    sqlite3_free(self->schema_versions[i].name);
+    sqlite3_free(self->schema_versions[i].filename);
+  }
+  sqlite3_free(self->schema_versions);
+  self->schema_versions = 0;
+  self->schema_versions_count = 0;
+}
+
 static void
 Connection_internal_cleanup(Connection *self)
 {
+  Connection_update_batch_free(self);
+  PyMem_Free(self->update_batch_marks);
+  self->update_batch_marks = 0;
+  self->update_batch_marks_size = 0;
   Py_CLEAR(self->cursor_factory);
   Py_CLEAR(self->busyhandler);
   Py_CLEAR(self->rollbackhook);
@@ -177,9 +302,12 @@ Connection_internal_cleanup(Connection *self)
   Py_CLEAR(self->exectrace);
   Py_CLEAR(self->rowtrace);
   Py_CLEAR(self->tracehook);
+  Py_CLEAR(self->adapters);
+  Py_CLEAR(self->converters);
   Py_CLEAR(self->vfs);
   Py_CLEAR(self->open_flags);
   Py_CLEAR(self->open_vfs);
+  Py_CLEAR(self->metadata_cache);
 }
 
 static void
@@ -253,6 +381,11 @@ Connection_close_internal(Connection *self, int force)
     statementcache_free(self->stmtcache);
   self->stmtcache = 0;
 
+  PYSQLITE_VOID_CALL(Connection_schema_versions_free(self));
+
+  if (self->db)
+    PYSQLITE_VOID_CALL(Connection_update_batch_replace(self, 0, NULL, 0, NULL));
+
   apsw_connection_remove(self);
 
   PYSQLITE_VOID_CALL(res = sqlite3_close(self->db));
@@ -377,8 +510,24 @@ Connection_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSE
     self->rowtrace = 0;
     self->tracehook = 0;
     self->tracemask = 0;
+    self->update_batch = 0;
+    self->update_batch_count = 0;
+    self->update_batch_rows = 0;
+    self->update_batch_tables = 0;
+    self->update_batch_tables_count = 0;
+    self->update_batch_last_table = 0;
+    self->update_batch_base = 0;
+    self->update_batch_marks = 0;
+    self->update_batch_marks_size = 0;
     self->vfs = 0;
     self->savepointlevel = 0;
+    self->whole_row_fetch = whole_row_fetch_default;
+    self->zero_copy_bindings = 0;
+    self->profile_statements = 0;
+    self->named_rows = 0;
+    self->adapters = 0;
+    self->converters = 0;
+    self->converters_version = 0;
     self->open_flags = 0;
     self->open_vfs = 0;
     self->weakreflist = 0;
@@ -401,7 +550,7 @@ Connection_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSE
 
   :param statementcachesize: Use zero to disable the statement cache,
     or a number larger than the total distinct SQL statements you
-    execute frequently.
+    execute frequently.  The maximum is 4,096.
 
   -* sqlite3_open_v2
 
@@ -442,8 +591,8 @@ Connection_init(Connection *self, PyObject *args, PyObject *kwargs)
   /* clamp cache size */
   if (statementcachesize < 0)
     statementcachesize = 0;
-  if (statementcachesize > 512)
-    statementcachesize = 512;
+  if (statementcachesize > 4096)
+    statementcachesize = 4096;
 
   /* Technically there is a race condition as a vfs of the same name
      could be registered between our find and the open starting.
@@ -673,19 +822,17 @@ Connection_backup(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_
     goto finally;
   }
 
-  if (sourceconnection->inuse)
+  if (sourceconnection->db == self->db)
   {
-    PyErr_Format(ExcThreadingViolation, "source connection is in concurrent use in another thread");
+    PyErr_Format(PyExc_ValueError, "source and destination are the same which sqlite3_backup doesn't allow");
     goto finally;
   }
 
-  if (sourceconnection->db == self->db)
+  if (!INUSE_ACQUIRE(sourceconnection))
   {
-    PyErr_Format(PyExc_ValueError, "source and destination are the same which sqlite3_backup doesn't allow");
+    PyErr_Format(ExcThreadingViolation, "source connection is in concurrent use in another thread");
     goto finally;
   }
-
-  sourceconnection->inuse = 1;
   isetsourceinuse = 1;
 
   PYSQLITE_CON_CALL(backup = sqlite3_backup_init(self->db, databasename, sourceconnection->db, sourcedatabasename));
@@ -737,10 +884,10 @@ finally:
   Py_XDECREF(weakref);
 
   /* if inuse is set then we must be returning result */
-  assert((self->inuse) ? (!!result) : (result == NULL));
-  assert(result ? (self->inuse) : (!self->inuse));
+  assert((INUSE_GET(self)) ? (!!result) : (result == NULL));
+  assert(result ? (INUSE_GET(self)) : (!INUSE_GET(self)));
   if (isetsourceinuse)
-    sourceconnection->inuse = 0;
+    INUSE_RELEASE(sourceconnection);
   return result;
 }
 
@@ -1023,6 +1170,128 @@ Connection_limit(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_n
   return PyLong_FromLong(res);
 }
 
+/* Adds a row to the batch.  Called with the GIL released, so only
+   the raw allocator is used.  Returns -1 if out of memory */
+static int
+Connection_update_batch_add(Connection *self, int updatetype, const char *databasename, const char *tablename,
+                            sqlite3_int64 rowid)
+{
+  int table = self->update_batch_last_table;
+  char *name;
+
+  /* the same table as last time is by far the most common case */
+  if (table >= self->update_batch_tables_count
+      || strcmp(self->update_batch_tables[table], databasename)
+      || strcmp(self->update_batch_tables[table] + strlen(databasename) + 1, tablename))
+  {
+    for (table = 0; table < self->update_batch_tables_count; table++)
+    {
+      name = self->update_batch_tables[table];
+      if (0 == strcmp(name, databasename) && 0 == strcmp(name + strlen(name) + 1, tablename))
+        break;
+    }
+    if (table == self->update_batch_tables_count)
+    {
+      size_t dblen = strlen(databasename), tablelen = strlen(tablename);
+      char **tables
+          = PyMem_RawRealloc(self->update_batch_tables, sizeof(char *) * (self->update_batch_tables_count + 1));
+      if (!tables)
+        return -1;
+      self->update_batch_tables = tables;
+      name = PyMem_RawMalloc(dblen + tablelen + 2);
+      if (!name)
+        return -1;
+      memcpy(name, databasename, dblen + 1);
+      memcpy(name + dblen + 1, tablename, tablelen + 1);
+      self->update_batch_tables[self->update_batch_tables_count++] = name;
+    }
+    self->update_batch_last_table = table;
+  }
+
+  self->update_batch_rows[self->update_batch_count].op = updatetype;
+  self->update_batch_rows[self->update_batch_count].table = table;
+  self->update_batch_rows[self->update_batch_count].rowid = rowid;
+  self->update_batch_count++;
+  return 0;
+}
+
+/* Calls callable with a list of the rows.  Needs the GIL.  Returns -1
+   with an exception on failure */
+static int
+Connection_update_batch_call(PyObject *callable, const UpdateBatchRow *batch_rows, int count, char *const *tables,
+                             int tables_count)
+{
+  PyObject *names = NULL, *rows = NULL, *retval = NULL;
+  int i;
+
+  /* each database and table name is only made once */
+  names = PyTuple_New(2 * tables_count);
+  rows = PyList_New(count);
+  if (!names || !rows)
+    goto finally;
+
+  for (i = 0; i < count; i++)
+  {
+    const UpdateBatchRow *row = batch_rows + i;
+    PyObject *item;
+
+    if (!PyTuple_GET_ITEM(names, 2 * row->table))
+    {
+      const char *name = tables[row->table];
+      PyObject *dbname = PyUnicode_FromString(name);
+      if (!dbname)
+        goto finally;
+      PyTuple_SET_ITEM(names, 2 * row->table, dbname);
+      PyObject *tablename = PyUnicode_FromString(name + strlen(name) + 1);
+      if (!tablename)
+        goto finally;
+      PyTuple_SET_ITEM(names, 2 * row->table + 1, tablename);
+    }
+    item = PyTuple_New(4);
+    if (!item)
+      goto finally;
+    PyList_SET_ITEM(rows, i, item);
+    PyObject *op = PyLong_FromLong(row->op);
+    if (!op)
+      goto finally;
+    PyTuple_SET_ITEM(item, 0, op);
+    PyTuple_SET_ITEM(item, 1, Py_NewRef(PyTuple_GET_ITEM(names, 2 * row->table)));
+    PyTuple_SET_ITEM(item, 2, Py_NewRef(PyTuple_GET_ITEM(names, 2 * row->table + 1)));
+    PyObject *rowid = PyLong_FromLongLong(row->rowid);
+    if (!rowid)
+      goto finally;
+    PyTuple_SET_ITEM(item, 3, rowid);
+  }
+
+  PyObject *vargs[] = {NULL, rows};
+  retval = PyObject_Vectorcall(callable, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+
+finally:
+  if (PyErr_Occurred())
+    AddTraceBackHere(__FILE__, __LINE__, "Connection.update_hook", "{s: O, s: i}", "callable", callable, "count",
+                     count);
+  Py_XDECREF(names);
+  Py_XDECREF(rows);
+  Py_XDECREF(retval);
+  return PyErr_Occurred() ? -1 : 0;
+}
+
+/* Calls the update hook with a list of the held rows, emptying the
+   batch.  Needs the GIL and to be inside a SQLite callback (holding
+   the database mutex).  Returns -1 with an exception on failure */
+static int
+Connection_update_batch_deliver(Connection *self)
+{
+  int count = self->update_batch_count;
+
+  if (!count)
+    return 0;
+  self->update_batch_base += count;
+  self->update_batch_count = 0;
+  return Connection_update_batch_call(self->updatehook, self->update_batch_rows, count, self->update_batch_tables,
+                                      self->update_batch_tables_count);
+}
+
 static void
 updatecb(void *context, int updatetype, char const *databasename, char const *tablename, sqlite3_int64 rowid)
 {
@@ -1032,11 +1301,20 @@ updatecb(void *context, int updatetype, char const *databasename, char const *ta
   PyGILState_STATE gilstate;
   PyObject *retval = NULL;
   Connection *self = (Connection *)context;
+  int added = 0;
 
   assert(self);
   assert(self->updatehook);
   assert(!Py_IsNone(self->updatehook));
 
+  /* batched rows don't need the GIL until the batch is full */
+  if (self->update_batch)
+  {
+    added = (0 == Connection_update_batch_add(self, updatetype, databasename, tablename, rowid));
+    if (added && self->update_batch_count < self->update_batch)
+      return;
+  }
+
   gilstate = PyGILState_Ensure();
 
   MakeExistingException();
@@ -1044,6 +1322,15 @@ updatecb(void *context, int updatetype, char const *databasename, char const *ta
   if (PyErr_Occurred())
     goto finally; /* abort hook due to outstanding exception */
 
+  if (self->update_batch)
+  {
+    if (!added)
+      PyErr_NoMemory();
+    else
+      Connection_update_batch_deliver(self);
+    goto finally;
+  }
+
   PyObject *vargs[] = {NULL, PyLong_FromLong(updatetype), PyUnicode_FromString(databasename), PyUnicode_FromString(tablename), PyLong_FromLongLong(rowid)};
   if (vargs[1] && vargs[2] && vargs[3] && vargs[4])
     retval = PyObject_Vectorcall(self->updatehook, vargs + 1, 4 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
@@ -1056,7 +1343,45 @@ finally:
   PyGILState_Release(gilstate);
 }
 
-/** .. method:: set_update_hook(callable: Optional[Callable[[int, str, str, int], None]]) -> None
+/* Installs the new batch and update hook.  The held rows are moved to
+   held if supplied, else freed.  updatecb on another thread adds rows
+   holding only the database mutex so this holds it too.  Call without
+   the GIL. */
+static void
+Connection_update_batch_replace(Connection *self, int batch, UpdateBatchRow *rows, int hook, UpdateBatchHeld *held)
+{
+  sqlite3_mutex_enter(sqlite3_db_mutex(self->db));
+  if (held)
+  {
+    held->rows = self->update_batch_rows;
+    held->count = self->update_batch_count;
+    held->tables = self->update_batch_tables;
+    held->tables_count = self->update_batch_tables_count;
+    self->update_batch_rows = 0;
+    self->update_batch_tables = 0;
+    self->update_batch_tables_count = 0;
+  }
+  Connection_update_batch_free(self);
+  self->update_batch = batch;
+  self->update_batch_rows = rows;
+  sqlite3_update_hook(self->db, hook ? updatecb : NULL, hook ? self : NULL);
+  sqlite3_mutex_leave(sqlite3_db_mutex(self->db));
+}
+
+static int commithookcb(void *context);
+static void rollbackhookcb(void *context);
+
+/* batched update hooks also need the commit and rollback hooks */
+static void
+Connection_set_transaction_hooks(Connection *self)
+{
+  int commit = self->commithook || self->update_batch, rollback = self->rollbackhook || self->update_batch;
+
+  PYSQLITE_VOID_CALL(sqlite3_commit_hook(self->db, commit ? commithookcb : NULL, commit ? self : NULL));
+  PYSQLITE_VOID_CALL(sqlite3_rollback_hook(self->db, rollback ? rollbackhookcb : NULL, rollback ? self : NULL));
+}
+
+/** .. method:: set_update_hook(callable: Optional[UpdateHook], *, batch: int = 0) -> None
 
   Calls *callable* whenever a row is updated, deleted or inserted.  If
   *callable* is *None* then any existing update hook is
@@ -1075,6 +1400,26 @@ finally:
     rowid (int)
       The affected row
 
+  If *batch* is non-zero then the rows are held without calling Python,
+  and *callable* is called with one parameter - a list of tuples of
+  the 4 values above.  That happens when the transaction commits, and
+  when *batch* rows have been held in which case it is before the
+  outcome of the transaction is known.  Held rows are discarded if the
+  transaction rolls back.  An exception in *callable* at commit turns
+  the commit into a rollback.  This is considerably faster when many
+  rows change.  Rows are also discarded when the connection is
+  closed.  Rows held when the update hook is changed are given to the
+  existing *callable* after the new one is installed, with any
+  exception it raises coming from this method.
+
+  .. note::
+
+    Changes undone by a `ROLLBACK TO <https://sqlite.org/lang_savepoint.html>`__
+    or a single failed statement inside a transaction are not seen
+    by the rollback hook, so their rows are still delivered.  The
+    exception is a :meth:`with <__exit__>` block that rolls back,
+    which discards rows held since the block started.
+
   .. seealso::
 
       * :ref:`Example <example_update_hook>`
@@ -1086,6 +1431,8 @@ Connection_set_update_hook(Connection *self, PyObject *const *fast_args, Py_ssiz
 {
   /* sqlite3_update_hook doesn't return an error code */
   PyObject *callable;
+  int batch = 0;
+  UpdateBatchRow *rows = NULL;
   CHECK_USE(NULL);
   CHECK_CLOSED(self, NULL);
 
@@ -1093,21 +1440,40 @@ Connection_set_update_hook(Connection *self, PyObject *const *fast_args, Py_ssiz
     Connection_set_update_hook_CHECK;
     ARG_PROLOG(1, Connection_set_update_hook_KWNAMES);
     ARG_MANDATORY ARG_optional_Callable(callable);
+    ARG_OPTIONAL ARG_int(batch);
     ARG_EPILOG(NULL, Connection_set_update_hook_USAGE, );
   }
+
+  if (batch < 0)
+    return PyErr_Format(PyExc_ValueError, "batch must be zero or positive not %d", batch);
   if (!callable)
+    batch = 0;
+  if (batch)
   {
-    PYSQLITE_VOID_CALL(sqlite3_update_hook(self->db, NULL, NULL));
-  }
-  else
-  {
-    PYSQLITE_VOID_CALL(sqlite3_update_hook(self->db, updatecb, self));
-    Py_INCREF(callable);
+    rows = PyMem_RawMalloc(sizeof(UpdateBatchRow) * (size_t)batch);
+    if (!rows)
+      return PyErr_NoMemory();
   }
 
-  Py_XDECREF(self->updatehook);
-  self->updatehook = callable;
+  PyObject *old = self->updatehook;
+  UpdateBatchHeld held = {0};
+  int failed = 0, i;
+
+  self->updatehook = Py_XNewRef(callable);
+  PYSQLITE_VOID_CALL(Connection_update_batch_replace(self, batch, rows, !!callable, &held));
 
+  Connection_set_transaction_hooks(self);
+
+  if (held.count)
+    failed = Connection_update_batch_call(old, held.rows, held.count, held.tables, held.tables_count);
+  for (i = 0; i < held.tables_count; i++)
+    PyMem_RawFree(held.tables[i]);
+  PyMem_RawFree(held.tables);
+  PyMem_RawFree(held.rows);
+  Py_XDECREF(old);
+
+  if (failed)
+    return NULL;
   Py_RETURN_NONE;
 }
 
@@ -1122,8 +1488,14 @@ rollbackhookcb(void *context)
   Connection *self = (Connection *)context;
 
   assert(self);
-  assert(self->rollbackhook);
-  assert(!Py_IsNone(self->rollbackhook));
+  assert(self->rollbackhook || self->update_batch);
+
+  /* batched update hook rows were never committed */
+  self->update_batch_base += self->update_batch_count;
+  self->update_batch_count = 0;
+
+  if (!self->rollbackhook)
+    return;
 
   gilstate = PyGILState_Ensure();
 
@@ -1165,19 +1537,12 @@ Connection_set_rollback_hook(Connection *self, PyObject *const *fast_args, Py_ss
     ARG_EPILOG(NULL, Connection_set_rollback_hook_USAGE, );
   }
 
-  if (!callable)
-  {
-    PYSQLITE_VOID_CALL(sqlite3_rollback_hook(self->db, NULL, NULL));
-  }
-  else
-  {
-    PYSQLITE_VOID_CALL(sqlite3_rollback_hook(self->db, rollbackhookcb, self));
-    Py_INCREF(callable);
-  }
-
+  Py_XINCREF(callable);
   Py_XDECREF(self->rollbackhook);
   self->rollbackhook = callable;
 
+  Connection_set_transaction_hooks(self);
+
   Py_RETURN_NONE;
 }
 
@@ -1442,8 +1807,11 @@ commithookcb(void *context)
   Connection *self = (Connection *)context;
 
   assert(self);
-  assert(self->commithook);
-  assert(!Py_IsNone(self->commithook));
+  assert(self->commithook || self->update_batch);
+
+  /* only batched update hook, with nothing to deliver */
+  if (!self->commithook && !self->update_batch_count)
+    return 0;
 
   gilstate = PyGILState_Ensure();
 
@@ -1452,20 +1820,29 @@ commithookcb(void *context)
   if (PyErr_Occurred())
     goto finally; /* abort hook due to outstanding exception */
 
-  PyObject *vargs[] = {NULL};
-  retval = PyObject_Vectorcall(self->commithook, vargs + 1, 0 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  if (self->commithook)
+  {
+    PyObject *vargs[] = {NULL};
+    retval = PyObject_Vectorcall(self->commithook, vargs + 1, 0 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
 
-  if (!retval)
-    goto finally; /* abort hook due to exception */
+    if (!retval)
+      goto finally; /* abort hook due to exception */
 
-  ok = PyObject_IsTrueStrict(retval);
-  assert(ok == -1 || ok == 0 || ok == 1);
-  if (ok == -1)
-  {
-    ok = 1;
-    assert(PyErr_Occurred());
-    goto finally; /* abort due to exception in return value */
+    ok = PyObject_IsTrueStrict(retval);
+    assert(ok == -1 || ok == 0 || ok == 1);
+    if (ok == -1)
+    {
+      ok = 1;
+      assert(PyErr_Occurred());
+      goto finally; /* abort due to exception in return value */
+    }
   }
+  else
+    ok = 0;
+
+  /* batched update hook rows are delivered once the commit is going ahead */
+  if (!ok && self->update_batch && Connection_update_batch_deliver(self))
+    ok = 1; /* abort due to exception in update hook */
 
 finally:
   Py_XDECREF(retval);
@@ -1502,21 +1879,12 @@ Connection_set_commit_hook(Connection *self, PyObject *const *fast_args, Py_ssiz
     ARG_MANDATORY ARG_optional_Callable(callable);
     ARG_EPILOG(NULL, Connection_set_commit_hook_USAGE, );
   }
-  if (!callable)
-  {
-    PYSQLITE_VOID_CALL(sqlite3_commit_hook(self->db, NULL, NULL));
-    goto finally;
-  }
-
-  PYSQLITE_VOID_CALL(sqlite3_commit_hook(self->db, commithookcb, self));
-
-  Py_INCREF(callable);
-
-finally:
-
+  Py_XINCREF(callable);
   Py_XDECREF(self->commithook);
   self->commithook = callable;
 
+  Connection_set_transaction_hooks(self);
+
   Py_RETURN_NONE;
 }
 
@@ -2354,6 +2722,10 @@ allocfunccbinfo(const char *name)
     res->scalarfunc = 0;
     res->aggregatefactory = 0;
     res->windowfactory = 0;
+    res->arg_types = 0;
+    res->num_arg_types = 0;
+    res->return_type = 0;
+    res->batch_size = 0;
     if (!res->name)
     {
       FunctionCBInfo_dealloc(res);
@@ -2373,7 +2745,7 @@ set_context_result(sqlite3_context *context, PyObject *obj)
   assert(obj);
 
   /* DUPLICATE(ish) code: this is substantially similar to the code in
-     APSWCursor_dobinding.  If you fix anything here then do it there as
+     APSWCursor_dobinding_value.  If you fix anything here then do it there as
      well. */
 
   if (Py_IsNone(obj))
@@ -2517,6 +2889,160 @@ finalfinally:
   PyGILState_Release(gilstate);
 }
 
+/* Converts an argument of a typed function using SQLite's
+   conversion rules instead of probing the value type.  Returns a new
+   reference */
+static PyObject *
+convert_value_as_type(sqlite3_value *value, char type)
+{
+  const void *data;
+
+  switch (type)
+  {
+  case 'i':
+    return PyLong_FromLongLong(sqlite3_value_int64(value));
+  case 'f':
+    return PyFloat_FromDouble(sqlite3_value_double(value));
+  case 's':
+    data = sqlite3_value_text(value);
+    return PyUnicode_FromStringAndSize(data ? (const char *)data : "", data ? sqlite3_value_bytes(value) : 0);
+  case 'b':
+    data = sqlite3_value_blob(value);
+    return PyBytes_FromStringAndSize(data ? (const char *)data : "", data ? sqlite3_value_bytes(value) : 0);
+  default:
+    return convert_value_to_pyobject(value, 0, 0);
+  }
+}
+
+/* getfunctionargs for functions with declared arg_types.  Returns 0 on
+   success, non-zero on failure */
+static int
+gettypedfunctionargs(PyObject *vargs[], sqlite3_context *context, int argc, sqlite3_value **argv, const char *arg_types)
+{
+  int i;
+
+  /* numargs is the same as the number of arg_types so argc always matches */
+  for (i = 0; i < argc; i++)
+  {
+    vargs[i] = convert_value_as_type(argv[i], arg_types ? arg_types[i] : 0);
+    if (!vargs[i])
+    {
+      Py_DECREF_ARRAY(vargs, i);
+      sqlite3_result_error(context, "convert_value_to_pyobject failed", -1);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* sets the result for a typed scalar function, going straight to the
+   declared type when the value is exactly that type.  Returns zero on
+   failure, non-zero on success */
+static int
+set_context_result_as_type(sqlite3_context *context, PyObject *obj, char type)
+{
+  const char *strdata;
+  Py_ssize_t strbytes;
+
+  switch (type)
+  {
+  case 'i':
+    if (PyLong_CheckExact(obj))
+    {
+      long long v = PyLong_AsLongLong(obj);
+      if (v == -1 && PyErr_Occurred())
+      {
+        sqlite3_result_error(context, "python integer overflow", -1);
+        return 0;
+      }
+      sqlite3_result_int64(context, v);
+      return 1;
+    }
+    break;
+  case 'f':
+    if (PyFloat_CheckExact(obj))
+    {
+      sqlite3_result_double(context, PyFloat_AS_DOUBLE(obj));
+      return 1;
+    }
+    break;
+  case 's':
+    if (PyUnicode_CheckExact(obj))
+    {
+      strdata = PyUnicode_AsUTF8AndSize(obj, &strbytes);
+      if (!strdata)
+      {
+        sqlite3_result_error(context, "Unicode conversions failed", -1);
+        return 0;
+      }
+      sqlite3_result_text64(context, strdata, strbytes, SQLITE_TRANSIENT, SQLITE_UTF8);
+      return 1;
+    }
+    break;
+  case 'b':
+    if (PyBytes_CheckExact(obj))
+    {
+      sqlite3_result_blob64(context, PyBytes_AS_STRING(obj), PyBytes_GET_SIZE(obj), SQLITE_TRANSIENT);
+      return 1;
+    }
+    break;
+  }
+  return set_context_result(context, obj);
+}
+
+/* dispatches scalar function registered with arg_types or return_type */
+static void
+cbdispatch_func_typed(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  PyGILState_STATE gilstate;
+  PyObject *retval = NULL;
+  FunctionCBInfo *cbinfo = (FunctionCBInfo *)sqlite3_user_data(context);
+  assert(cbinfo);
+
+  VLA_PYO(vargs, 1 + argc);
+
+  gilstate = PyGILState_Ensure();
+
+  assert(cbinfo->scalarfunc);
+
+  MakeExistingException();
+
+  if (PyErr_Occurred())
+  {
+    sqlite3_result_error_code(context, MakeSqliteMsgFromPyException(NULL));
+    sqlite3_result_error(context, "Prior Python Error", -1);
+    goto finalfinally;
+  }
+
+  assert(!cbinfo->arg_types || argc == cbinfo->num_arg_types);
+  if (gettypedfunctionargs(vargs + 1, context, argc, argv, cbinfo->arg_types))
+    goto finally;
+
+  retval = PyObject_Vectorcall(cbinfo->scalarfunc, vargs + 1, argc | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  Py_DECREF_ARRAY(vargs + 1, argc);
+  if (retval)
+    set_context_result_as_type(context, retval, cbinfo->return_type);
+
+finally:
+  if (PyErr_Occurred())
+  {
+    char *errmsg = NULL;
+    char *funname = NULL;
+    CHAIN_EXC(
+        funname = sqlite3_mprintf("user-defined-scalar-%s", cbinfo->name);
+        if (!funname) PyErr_NoMemory(););
+    sqlite3_result_error_code(context, MakeSqliteMsgFromPyException(&errmsg));
+    sqlite3_result_error(context, errmsg, -1);
+    AddTraceBackHere(__FILE__, __LINE__, funname ? funname : "sqlite3_mprintf ran out of memory", "{s: i, s: s}", "NumberOfArguments", argc, "message", errmsg);
+    sqlite3_free(funname);
+    sqlite3_free(errmsg);
+  }
+finalfinally:
+  Py_XDECREF(retval);
+
+  PyGILState_Release(gilstate);
+}
+
 static aggregatefunctioncontext *
 getaggregatefunctioncontext(sqlite3_context *context)
 {
@@ -2551,7 +3077,7 @@ getaggregatefunctioncontext(sqlite3_context *context)
   if (!PyTuple_Check(retval))
   {
     aggfc->aggvalue = NULL;
-    aggfc->stepfunc = PyObject_GetAttr(retval, apst.step);
+    aggfc->stepfunc = PyObject_GetAttr(retval, cbinfo->batch_size ? apst.step_batch : apst.step);
     if (!aggfc->stepfunc)
       goto finally;
     if (!PyCallable_Check(aggfc->stepfunc))
@@ -2611,6 +3137,145 @@ finally:
   return aggfc;
 }
 
+static void
+aggregatebatch_free(aggregatebatch *batch, const char *arg_types)
+{
+  int col, row;
+
+  if (!batch)
+    return;
+  for (col = 0; col < batch->columns; col++)
+  {
+    if (!batch->values[col])
+      continue;
+    if (!arg_types || (arg_types[col] != 'i' && arg_types[col] != 'f'))
+      for (row = 0; row < batch->rows; row++)
+        Py_DECREF(((PyObject **)batch->values[col])[row]);
+    PyMem_Free(batch->values[col]);
+  }
+  PyMem_Free(batch->values);
+  PyMem_Free(batch);
+}
+
+static aggregatebatch *
+aggregatebatch_new(int columns, int batch_size)
+{
+  aggregatebatch *batch = PyMem_Calloc(1, sizeof(aggregatebatch));
+  int col;
+
+  if (!batch)
+    return (void *)PyErr_NoMemory();
+  batch->values = PyMem_Calloc(Py_MAX(columns, 1), sizeof(void *));
+  if (!batch->values)
+    goto error;
+  batch->columns = columns;
+  /* int64, double, and pointers are all 8 bytes or less */
+  for (col = 0; col < columns; col++)
+  {
+    batch->values[col] = PyMem_Calloc(batch_size, Py_MAX(sizeof(sqlite3_int64), sizeof(PyObject *)));
+    if (!batch->values[col])
+      goto error;
+  }
+  return batch;
+error:
+  aggregatebatch_free(batch, NULL);
+  return (void *)PyErr_NoMemory();
+}
+
+/* adds a row of arguments.  Returns 0 on success, -1 on failure */
+static int
+aggregatebatch_add(aggregatebatch *batch, const char *arg_types, sqlite3_value **argv)
+{
+  int col;
+  PyObject *value;
+
+  for (col = 0; col < batch->columns; col++)
+  {
+    switch (arg_types ? arg_types[col] : 0)
+    {
+    case 'i':
+      ((sqlite3_int64 *)batch->values[col])[batch->rows] = sqlite3_value_int64(argv[col]);
+      break;
+    case 'f':
+      ((double *)batch->values[col])[batch->rows] = sqlite3_value_double(argv[col]);
+      break;
+    default:
+      value = convert_value_as_type(argv[col], arg_types ? arg_types[col] : 0);
+      if (!value)
+        goto error;
+      ((PyObject **)batch->values[col])[batch->rows] = value;
+    }
+  }
+  batch->rows++;
+  return 0;
+
+error:
+  /* discard the partial row */
+  while (col--)
+    if (!arg_types || (arg_types[col] != 'i' && arg_types[col] != 'f'))
+      Py_DECREF(((PyObject **)batch->values[col])[batch->rows]);
+  return -1;
+}
+
+/* calls step_batch with the buffered rows as a tuple of columns, and
+   empties the batch.  Returns 0 on success, -1 on failure */
+static int
+aggregatebatch_flush(aggregatefunctioncontext *aggfc, const char *arg_types)
+{
+  aggregatebatch *batch = aggfc->batch;
+  PyObject *columns = NULL, *column, *retval = NULL;
+  int col, row;
+
+  columns = PyTuple_New(batch->columns);
+  if (!columns)
+    goto finally;
+
+  for (col = 0; col < batch->columns; col++)
+  {
+    switch (arg_types ? arg_types[col] : 0)
+    {
+    case 'i':
+      column = array_from_memory("q", batch->values[col], batch->rows * sizeof(sqlite3_int64));
+      break;
+    case 'f':
+      column = array_from_memory("d", batch->values[col], batch->rows * sizeof(double));
+      break;
+    default:
+      column = PyList_New(batch->rows);
+      if (column)
+      {
+        for (row = 0; row < batch->rows; row++)
+          PyList_SET_ITEM(column, row, ((PyObject **)batch->values[col])[row]);
+        /* the list now owns the values */
+        memset(batch->values[col], 0, batch->rows * sizeof(PyObject *));
+      }
+    }
+    if (!column)
+      goto finally;
+    PyTuple_SET_ITEM(columns, col, column);
+  }
+
+  {
+    int offset = (aggfc->aggvalue) ? 1 : 0;
+    PyObject *vargs[] = {NULL, aggfc->aggvalue ? aggfc->aggvalue : columns, columns};
+    retval = PyObject_Vectorcall(aggfc->stepfunc, vargs + 1, (1 + offset) | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  }
+
+finally:
+  if (!columns || PyErr_Occurred())
+  {
+    /* release any values not yet owned by a list */
+    for (col = 0; col < batch->columns; col++)
+      if (!arg_types || (arg_types[col] != 'i' && arg_types[col] != 'f'))
+        for (row = 0; row < batch->rows; row++)
+          Py_CLEAR(((PyObject **)batch->values[col])[row]);
+  }
+  batch->rows = 0;
+  Py_XDECREF(columns);
+  Py_XDECREF(retval);
+  return PyErr_Occurred() ? -1 : 0;
+}
+
 /*
   Note that we can't call sqlite3_result_error in the step function as
   SQLite doesn't want to you to do that (and core dumps!)
@@ -2639,9 +3304,25 @@ cbdispatch_step(sqlite3_context *context, int argc, sqlite3_value **argv)
   if (!aggfc || PyErr_Occurred())
     goto finally;
 
+  FunctionCBInfo *cbinfo = (FunctionCBInfo *)sqlite3_user_data(context);
+  if (cbinfo->batch_size)
+  {
+    if (!aggfc->batch)
+    {
+      aggfc->batch = aggregatebatch_new(argc, cbinfo->batch_size);
+      if (!aggfc->batch)
+        goto finally;
+    }
+    assert(aggfc->batch->columns == argc);
+    if (0 == aggregatebatch_add(aggfc->batch, cbinfo->arg_types, argv) && aggfc->batch->rows == cbinfo->batch_size)
+      aggregatebatch_flush(aggfc, cbinfo->arg_types);
+    goto finally;
+  }
+
   int offset = (aggfc->aggvalue) ? 1 : 0;
   vargs[1] = aggfc->aggvalue;
-  if (getfunctionargs(vargs + 1 + offset, context, argc, argv))
+  if (cbinfo->arg_types ? gettypedfunctionargs(vargs + 1 + offset, context, argc, argv, cbinfo->arg_types)
+                        : getfunctionargs(vargs + 1 + offset, context, argc, argv))
     goto finally;
 
   assert(!PyErr_Occurred());
@@ -2697,6 +3378,16 @@ cbdispatch_final(sqlite3_context *context)
     goto finally;
   }
 
+  if (aggfc->batch && aggfc->batch->rows)
+  {
+    FunctionCBInfo *cbinfo = (FunctionCBInfo *)sqlite3_user_data(context);
+    if (aggregatebatch_flush(aggfc, cbinfo->arg_types))
+    {
+      sqlite3_result_error(context, "Python Error in step_batch function", -1);
+      goto finally;
+    }
+  }
+
   int offset = (aggfc->aggvalue) ? 1 : 0;
   PyObject *vargs[] = {NULL, aggfc->aggvalue};
   retval = PyObject_Vectorcall(aggfc->finalfunc, vargs + 1, offset | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
@@ -2715,6 +3406,8 @@ finally:
     Py_CLEAR(aggfc->aggvalue);
     Py_CLEAR(aggfc->stepfunc);
     Py_CLEAR(aggfc->finalfunc);
+    aggregatebatch_free(aggfc->batch, ((FunctionCBInfo *)sqlite3_user_data(context))->arg_types);
+    aggfc->batch = NULL;
   }
 
   if (PyErr_Occurred() && PY_ERR_NOT_NULL(exc_save))
@@ -3125,7 +3818,124 @@ finally:
   Py_RETURN_NONE;
 }
 
-/** .. method:: create_scalar_function(name: str, callable: Optional[ScalarProtocol], numargs: int = -1, *, deterministic: bool = False, flags: int = 0) -> None
+/* returns the typed function code for int, float, str, or bytes,
+   0 for None meaning any type, or -1 with an exception set */
+static int
+scalar_type_code(PyObject *type, const char *what)
+{
+  if (Py_IsNone(type))
+    return 0;
+  if (type == (PyObject *)&PyLong_Type)
+    return 'i';
+  if (type == (PyObject *)&PyFloat_Type)
+    return 'f';
+  if (type == (PyObject *)&PyUnicode_Type)
+    return 's';
+  if (type == (PyObject *)&PyBytes_Type)
+    return 'b';
+  PyErr_Format(PyExc_TypeError, "%s should be one of int, float, str, bytes, or None not %R", what, type);
+  return -1;
+}
+
+/* sets the arg_types of cbinfo from a sequence, with numargs defaulting
+   to the length.  Returns -1 with an exception set on error */
+static int
+funccbinfo_set_arg_types(FunctionCBInfo *cbinfo, PyObject *arg_types, int *numargs)
+{
+  PyObject *arg_types_fast = NULL;
+  Py_ssize_t i;
+  int code;
+
+  arg_types_fast = PySequence_Fast(arg_types, "arg_types should be a sequence");
+  if (!arg_types_fast)
+    goto error;
+  if (*numargs < 0)
+  {
+    if (PySequence_Fast_GET_SIZE(arg_types_fast) > INT_MAX)
+    {
+      PyErr_Format(PyExc_ValueError, "arg_types is too long");
+      goto error;
+    }
+    *numargs = (int)PySequence_Fast_GET_SIZE(arg_types_fast);
+  }
+  else if (*numargs != PySequence_Fast_GET_SIZE(arg_types_fast))
+  {
+    PyErr_Format(PyExc_ValueError, "numargs %d must match the %zd items in arg_types", *numargs, PySequence_Fast_GET_SIZE(arg_types_fast));
+    goto error;
+  }
+  cbinfo->arg_types = PyMem_Calloc(*numargs + 1, 1);
+  if (!cbinfo->arg_types)
+  {
+    PyErr_NoMemory();
+    goto error;
+  }
+  cbinfo->num_arg_types = *numargs;
+  for (i = 0; i < *numargs; i++)
+  {
+    code = scalar_type_code(PySequence_Fast_GET_ITEM(arg_types_fast, i), "arg_types items");
+    if (code < 0)
+      goto error;
+    cbinfo->arg_types[i] = (char)code;
+  }
+  Py_DECREF(arg_types_fast);
+  return 0;
+
+error:
+  Py_XDECREF(arg_types_fast);
+  return -1;
+}
+
+/* Is callable a builtin known to always return the same result for the
+   same arguments?  Returns -1 with an exception set on error */
+static int
+scalar_is_known_deterministic(PyObject *callable)
+{
+  static const char *const builtin_names[] = {"abs", "bin", "chr", "divmod", "hex", "len", "max", "min", "oct", "ord", "pow", "round", NULL};
+  PyObject *module = NULL, *name = NULL;
+  const char *modulestr, *namestr;
+  int res = 0, i;
+
+  if (PyObject_TypeCheck(callable, &PyMethodDescr_Type))
+  {
+    PyTypeObject *type = PyDescr_TYPE(callable);
+    return type == &PyUnicode_Type || type == &PyBytes_Type || type == &PyLong_Type || type == &PyFloat_Type;
+  }
+
+  if (!PyCFunction_Check(callable))
+    return 0;
+
+  module = PyObject_GetAttrString(callable, "__module__");
+  if (!module)
+    goto error;
+  name = PyObject_GetAttrString(callable, "__name__");
+  if (!name)
+    goto error;
+  if (!PyUnicode_Check(module) || !PyUnicode_Check(name))
+    goto finally;
+  modulestr = PyUnicode_AsUTF8(module);
+  if (!modulestr)
+    goto error;
+  namestr = PyUnicode_AsUTF8(name);
+  if (!namestr)
+    goto error;
+
+  if (0 == strcmp(modulestr, "math") || 0 == strcmp(modulestr, "_operator"))
+    res = 1;
+  else if (0 == strcmp(modulestr, "builtins"))
+    for (i = 0; builtin_names[i]; i++)
+      if (0 == strcmp(namestr, builtin_names[i]))
+        res = 1;
+  goto finally;
+
+error:
+  res = -1;
+finally:
+  Py_XDECREF(module);
+  Py_XDECREF(name);
+  return res;
+}
+
+/** .. method:: create_scalar_function(name: str, callable: Optional[ScalarProtocol], numargs: int = -1, *, deterministic: bool = False, flags: int = 0, arg_types: Optional[Sequence[type[int] | type[float] | type[str] | type[bytes] | None]] = None, return_type: Optional[type[int] | type[float] | type[str] | type[bytes]] = None) -> None
 
   Registers a scalar function.  Scalar functions operate on one set of parameters once.
 
@@ -3139,6 +3949,27 @@ finally:
            function is not deterministic while one that returns the
            length of a string is.
   :param flags: Additional `function flags <https://www.sqlite.org/c3ref/c_deterministic.html>`__
+  :param arg_types: Declares the type of each argument as :class:`int`,
+           :class:`float`, :class:`str`, or :class:`bytes`, with None
+           meaning any type.  *numargs* defaults to, and must match,
+           the length.  Arguments are converted by SQLite to the
+           declared type without checking their actual type, using
+           `SQLite's rules <https://www.sqlite.org/c3ref/value_blob.html>`__,
+           so for example a NULL declared as :class:`int` becomes
+           ``0``.
+  :param return_type: Declares the type your function usually returns.
+           Matching values are given straight to SQLite, while other
+           values still work and take the normal path.
+
+  Using *arg_types* or *return_type* makes each call quicker, which
+  matters for functions called on millions of rows.  When you use them
+  and *callable* is a builtin known to always return the same result
+  for the same arguments, such as :func:`math.sqrt`, :func:`len`, or
+  :meth:`str.upper`, the function is also registered as deterministic.
+
+  .. code-block:: python
+
+    connection.create_scalar_function("name_length", len, arg_types=[str], return_type=int)
 
   .. note::
 
@@ -3168,8 +3999,9 @@ Connection_create_scalar_function(Connection *self, PyObject *const *fast_args,
   PyObject *callable = NULL;
   int deterministic = 0, flags = 0;
   const char *name = 0;
-  FunctionCBInfo *cbinfo;
-  int res;
+  PyObject *arg_types = NULL, *return_type = NULL;
+  FunctionCBInfo *cbinfo = NULL;
+  int res, typed = 0, code;
 
   CHECK_USE(NULL);
   CHECK_CLOSED(self, NULL);
@@ -3182,11 +4014,20 @@ Connection_create_scalar_function(Connection *self, PyObject *const *fast_args,
     ARG_OPTIONAL ARG_int(numargs);
     ARG_OPTIONAL ARG_bool(deterministic);
     ARG_OPTIONAL ARG_int(flags);
+    ARG_OPTIONAL ARG_pyobject(arg_types);
+    ARG_OPTIONAL ARG_pyobject(return_type);
     ARG_EPILOG(NULL, Connection_create_scalar_function_USAGE, );
   }
+  if (arg_types && Py_IsNone(arg_types))
+    arg_types = NULL;
+  if (return_type && Py_IsNone(return_type))
+    return_type = NULL;
+  typed = arg_types || return_type;
+
   if (!callable)
   {
-    cbinfo = 0;
+    if (typed)
+      return PyErr_Format(PyExc_ValueError, "arg_types and return_type can't be used when unregistering a function");
   }
   else
   {
@@ -3196,6 +4037,24 @@ Connection_create_scalar_function(Connection *self, PyObject *const *fast_args,
     cbinfo->scalarfunc = Py_NewRef(callable);
   }
 
+  if (arg_types && funccbinfo_set_arg_types(cbinfo, arg_types, &numargs))
+    goto finally;
+
+  if (return_type)
+  {
+    code = scalar_type_code(return_type, "return_type");
+    if (code < 0)
+      goto finally;
+    cbinfo->return_type = (char)code;
+  }
+
+  if (typed && !deterministic)
+  {
+    deterministic = scalar_is_known_deterministic(callable);
+    if (deterministic < 0)
+      goto finally;
+  }
+
   flags |= (deterministic ? SQLITE_DETERMINISTIC : 0);
 
   PYSQLITE_CON_CALL(
@@ -3204,24 +4063,26 @@ Connection_create_scalar_function(Connection *self, PyObject *const *fast_args,
                                        numargs,
                                        SQLITE_UTF8 | flags,
                                        cbinfo,
-                                       cbinfo ? cbdispatch_func : NULL,
+                                       cbinfo ? (typed ? cbdispatch_func_typed : cbdispatch_func) : NULL,
                                        NULL,
                                        NULL,
                                        apsw_free_func));
+  /* ownership passed to SQLite, which calls the destructor (apsw_free_func) even on error */
+  cbinfo = NULL;
   if (res)
   {
-    /* Note: On error sqlite3_create_function_v2 calls the destructor (apsw_free_func)! */
     SET_EXC(res, self->db);
     goto finally;
   }
 
 finally:
+  Py_XDECREF((PyObject *)cbinfo);
   if (PyErr_Occurred())
     return NULL;
   Py_RETURN_NONE;
 }
 
-/** .. method:: create_aggregate_function(name: str, factory: Optional[AggregateFactory], numargs: int = -1, *, flags: int = 0) -> None
+/** .. method:: create_aggregate_function(name: str, factory: Optional[AggregateFactory], numargs: int = -1, *, flags: int = 0, batch_size: int = 0, arg_types: Optional[Sequence[type[int] | type[float] | type[str] | type[bytes] | None]] = None) -> None
 
   Registers an aggregate function.  Aggregate functions operate on all
   the relevant rows such as counting how many there are.
@@ -3230,6 +4091,10 @@ finally:
   :param factory: The function that will be called.  Use None to delete the function.
   :param numargs: How many arguments the function takes, with -1 meaning any number
   :param flags: `Function flags <https://www.sqlite.org/c3ref/c_deterministic.html>`__
+  :param batch_size: When non-zero the rows are given to the step
+     function in batches of this many.  See below.
+  :param arg_types: Declares the type of each argument, with the same
+     meaning as in :meth:`create_scalar_function`.
 
   When a query starts, the *factory* will be called.  It can return an object
   with a *step* function called for each matching row, and a *final* function
@@ -3252,6 +4117,31 @@ finally:
        exception was raised by the step function. This allows you to
        ensure any resources are cleaned up.
 
+  With *batch_size* the arguments are buffered, and *step_batch* (the
+  second tuple item for the non-class approach) is called with up to
+  *batch_size* rows at a time, and before *final* with any remaining
+  rows.  It is given a tuple with one item per argument, each containing
+  that argument for every row.  Arguments declared as :class:`int` or
+  :class:`float` in *arg_types* are :class:`array.array` of typecode
+  ``q`` or ``d``, which libraries like numpy can use without copying,
+  while other arguments are a :class:`list`.
+
+  .. code-block:: python
+
+    class Mean:
+        def __init__(self):
+            self.total, self.count = 0.0, 0
+
+        def step_batch(self, columns):
+            values = numpy.frombuffer(columns[0], dtype=numpy.float64)
+            self.total += values.sum()
+            self.count += len(values)
+
+        def final(self):
+            return self.total / self.count if self.count else None
+
+    connection.create_aggregate_function("mean", Mean, batch_size=4096, arg_types=[float])
+
   .. note::
 
     You can register the same named function but with different
@@ -3271,11 +4161,11 @@ static PyObject *
 Connection_create_aggregate_function(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
 {
   int numargs = -1;
-  PyObject *factory;
+  PyObject *factory, *arg_types = NULL;
   const char *name = 0;
-  FunctionCBInfo *cbinfo;
+  FunctionCBInfo *cbinfo = NULL;
   int res;
-  int flags = 0;
+  int flags = 0, batch_size = 0;
 
   CHECK_USE(NULL);
   CHECK_CLOSED(self, NULL);
@@ -3287,11 +4177,21 @@ Connection_create_aggregate_function(Connection *self, PyObject *const *fast_arg
     ARG_MANDATORY ARG_optional_Callable(factory);
     ARG_OPTIONAL ARG_int(numargs);
     ARG_OPTIONAL ARG_int(flags);
+    ARG_OPTIONAL ARG_int(batch_size);
+    ARG_OPTIONAL ARG_pyobject(arg_types);
     ARG_EPILOG(NULL, Connection_create_aggregate_function_USAGE, );
   }
+  if (arg_types && Py_IsNone(arg_types))
+    arg_types = NULL;
+
+  if (batch_size < 0)
+    return PyErr_Format(PyExc_ValueError, "batch_size must not be negative");
 
   if (!factory)
-    cbinfo = 0;
+  {
+    if (batch_size || arg_types)
+      return PyErr_Format(PyExc_ValueError, "batch_size and arg_types can't be used when unregistering a function");
+  }
   else
   {
     cbinfo = allocfunccbinfo(name);
@@ -3299,6 +4199,9 @@ Connection_create_aggregate_function(Connection *self, PyObject *const *fast_arg
       goto finally;
 
     cbinfo->aggregatefactory = Py_NewRef(factory);
+    cbinfo->batch_size = batch_size;
+    if (arg_types && funccbinfo_set_arg_types(cbinfo, arg_types, &numargs))
+      goto finally;
   }
 
   PYSQLITE_CON_CALL(
@@ -3311,16 +4214,17 @@ Connection_create_aggregate_function(Connection *self, PyObject *const *fast_arg
                                        cbinfo ? cbdispatch_step : NULL,
                                        cbinfo ? cbdispatch_final : NULL,
                                        apsw_free_func));
+  /* ownership passed to SQLite, which calls the destructor (apsw_free_func) even on error */
+  cbinfo = NULL;
 
   if (res)
   {
-    /* Note: On error sqlite3_create_function_v2 calls the
-   destructor (apsw_free_func)! */
     SET_EXC(res, self->db);
     goto finally;
   }
 
 finally:
+  Py_XDECREF((PyObject *)cbinfo);
   if (PyErr_Occurred())
     return NULL;
   Py_RETURN_NONE;
@@ -3694,7 +4598,7 @@ Connection_wal_checkpoint(Connection *self, PyObject *const *fast_args, Py_ssize
 static void apswvtabFree(void *context);
 static struct sqlite3_module *apswvtabSetupModuleDef(PyObject *datasource, int iVersion, int eponymous, int eponymous_only, int read_only);
 
-/** .. method:: create_module(name: str, datasource: Optional[VTModule], *, use_bestindex_object: bool = False, use_no_change: bool = False, iVersion: int = 1, eponymous: bool=False, eponymous_only: bool = False, read_only: bool = False) -> None
+/** .. method:: create_module(name: str, datasource: Optional[VTModule], *, use_bestindex_object: bool = False, use_no_change: bool = False, iVersion: int = 1, eponymous: bool=False, eponymous_only: bool = False, read_only: bool = False, cache_best_index: bool = False) -> None
 
     Registers a virtual table, or drops it if *datasource* is *None*.
     See :ref:`virtualtables` for details.
@@ -3707,6 +4611,14 @@ static struct sqlite3_module *apswvtabSetupModuleDef(PyObject *datasource, int i
     :param eponymous: Configures module to be `eponymous <https://www.sqlite.org/vtab.html#eponymous_virtual_tables>`__
     :param eponymous_only: Configures module to be `eponymous only <https://www.sqlite.org/vtab.html#eponymous_only_virtual_tables>`__
     :param read_only: Leaves `sqlite3_module <https://www.sqlite.org/c3ref/module.html>`__ methods that involve writing and transactions as NULL
+    :param cache_best_index: Each table remembers the results of :meth:`~VTTable.BestIndex`
+        (or :meth:`~VTTable.BestIndexObject`) for the last 16 different sets of
+        constraints, order bys and columns used, and reuses them without calling your
+        method again.  Only use this if your results don't depend on anything else.
+        Results are not remembered if you looked at a
+        :meth:`constraint value <IndexInfo.get_aConstraint_rhs>`, a
+        :meth:`collation <IndexInfo.get_aConstraint_collation>`, or used
+        :meth:`IndexInfo.set_aConstraintUsage_in`.
 
     .. seealso::
 
@@ -3723,7 +4635,7 @@ Connection_create_module(Connection *self, PyObject *const *fast_args, Py_ssize_
   int res;
   int use_bestindex_object = 0, use_no_change = 0;
 
-  int iVersion = 1, eponymous = 0, eponymous_only = 0, read_only = 0;
+  int iVersion = 1, eponymous = 0, eponymous_only = 0, read_only = 0, cache_best_index = 0;
 
   CHECK_USE(NULL);
   CHECK_CLOSED(self, NULL);
@@ -3739,6 +4651,7 @@ Connection_create_module(Connection *self, PyObject *const *fast_args, Py_ssize_
     ARG_OPTIONAL ARG_bool(eponymous);
     ARG_OPTIONAL ARG_bool(eponymous_only);
     ARG_OPTIONAL ARG_bool(read_only);
+    ARG_OPTIONAL ARG_bool(cache_best_index);
     ARG_EPILOG(NULL, Connection_create_module_USAGE, );
   }
 
@@ -3755,6 +4668,7 @@ Connection_create_module(Connection *self, PyObject *const *fast_args, Py_ssize_
     vti->datasource = datasource;
     vti->bestindex_object = use_bestindex_object;
     vti->use_no_change = use_no_change;
+    vti->cache_best_index = cache_best_index;
   }
 
   /* SQLite is really finnicky.  Note that it calls the destructor on
@@ -3923,6 +4837,127 @@ Connection_set_row_trace(Connection *self, PyObject *const *fast_args, Py_ssize_
   Py_RETURN_NONE;
 }
 
+/* Sets or removes key in the dict at *where, which is made on first
+   use and freed when it becomes empty */
+static int
+Connection_update_registry(PyObject **where, PyObject *key, PyObject *callable)
+{
+  if (callable)
+  {
+    if (!*where)
+    {
+      *where = PyDict_New();
+      if (!*where)
+        return -1;
+    }
+    return PyDict_SetItem(*where, key, callable);
+  }
+  if (*where)
+  {
+    if (PyDict_DelItem(*where, key) && !PyErr_ExceptionMatches(PyExc_KeyError))
+      return -1;
+    PyErr_Clear();
+    if (PyDict_GET_SIZE(*where) == 0)
+      Py_CLEAR(*where);
+  }
+  return 0;
+}
+
+/** .. method:: register_adapter(klass: type, callable: Optional[Callable[[Any], SQLiteValue]]) -> None
+
+  Registers a callable that converts values of type *klass* into one of
+  the :ref:`types SQLite supports <types>` when they are used as
+  bindings in this connection.  The lookup is by the
+  exact type, so subclasses need their own registration.  :class:`int`,
+  :class:`float`, :class:`str`, :class:`bytes`, and *None* are always
+  bound directly, with no lookup.  Use *None* as *callable* to remove
+  the registration.
+
+  The adapter can return any supported value, but that isn't adapted
+  again.
+
+  .. code-block:: python
+
+    connection.register_adapter(datetime.date, datetime.date.isoformat)
+
+  This is done in C without wrapping cursors or bindings, so is
+  considerably faster than
+  :class:`apsw.ext.TypesConverterCursorFactory`.
+
+  .. seealso::
+
+    * :meth:`register_converter`
+*/
+static PyObject *
+Connection_register_adapter(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *klass, *callable;
+
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  {
+    Connection_register_adapter_CHECK;
+    ARG_PROLOG(2, Connection_register_adapter_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(klass);
+    ARG_MANDATORY ARG_optional_Callable(callable);
+    ARG_EPILOG(NULL, Connection_register_adapter_USAGE, );
+  }
+
+  if (!PyType_Check(klass))
+    return PyErr_Format(PyExc_TypeError, "Expected a type, not %s", Py_TypeName(klass));
+
+  if (Connection_update_registry(&self->adapters, klass, callable))
+    return NULL;
+
+  Py_RETURN_NONE;
+}
+
+/** .. method:: register_converter(decltype: str, callable: Optional[Callable[[SQLiteValue], Any]]) -> None
+
+  Registers a callable that converts result values from columns
+  declared as *decltype* in the schema.  For example a table created
+  with ``CREATE TABLE events(happened DATE)`` has a declared type of
+  ``DATE`` for the ``happened`` column.  The match is exact, including
+  case, against `sqlite3_column_decltype
+  <https://sqlite.org/c3ref/column_decltype.html>`__, which is worked out
+  once per prepared statement.  The converter is not called for null
+  values.  Use *None* as *callable* to remove the registration.
+
+  .. code-block:: python
+
+    connection.register_converter("DATE", datetime.date.fromisoformat)
+
+  Only values from columns with a converter pay any cost.  Conversion
+  happens before any :attr:`row tracer <row_trace>` is called.
+
+  .. seealso::
+
+    * :meth:`register_adapter`
+*/
+static PyObject *
+Connection_register_converter(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *decltype, *callable;
+
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  {
+    Connection_register_converter_CHECK;
+    ARG_PROLOG(2, Connection_register_converter_KWNAMES);
+    ARG_MANDATORY ARG_PyUnicode(decltype);
+    ARG_MANDATORY ARG_optional_Callable(callable);
+    ARG_EPILOG(NULL, Connection_register_converter_USAGE, );
+  }
+
+  if (Connection_update_registry(&self->converters, decltype, callable))
+    return NULL;
+  self->converters_version++;
+
+  Py_RETURN_NONE;
+}
+
 /** .. method:: get_exec_trace() -> Optional[ExecTracer]
 
   Returns the currently installed :attr:`execution tracer
@@ -3990,6 +5025,15 @@ Connection_enter(Connection *self)
   CHECK_USE(NULL);
   CHECK_CLOSED(self, NULL);
 
+  if (self->savepointlevel >= self->update_batch_marks_size)
+  {
+    long long *marks = PyMem_Realloc(self->update_batch_marks, sizeof(long long) * (self->savepointlevel + 8));
+    if (!marks)
+      return PyErr_NoMemory();
+    self->update_batch_marks = marks;
+    self->update_batch_marks_size = self->savepointlevel + 8;
+  }
+
   sql = sqlite3_mprintf("SAVEPOINT \"_apsw-%ld\"", self->savepointlevel);
   if (!sql)
     return PyErr_NoMemory();
@@ -4026,6 +5070,7 @@ Connection_enter(Connection *self)
   if (res)
     return NULL;
 
+  self->update_batch_marks[self->savepointlevel] = self->update_batch_base + self->update_batch_count;
   self->savepointlevel++;
   return Py_NewRef((PyObject *)self);
 
@@ -4090,6 +5135,26 @@ static int connection_trace_and_exec(Connection *self, int release, int sp, int
   return PyErr_Occurred() ? 0 : (res == SQLITE_OK);
 }
 
+/* ROLLBACK TO doesn't call the rollback hook, so batched update rows
+   held since the savepoint was made are discarded here.  Rows that were
+   already delivered because the batch filled up can't be taken back.
+   Call without the GIL. */
+static void
+Connection_update_batch_rollback_to(Connection *self, long sp)
+{
+  long long keep;
+
+  if (sp >= self->update_batch_marks_size)
+    return;
+  sqlite3_mutex_enter(sqlite3_db_mutex(self->db));
+  keep = self->update_batch_marks[sp] - self->update_batch_base;
+  if (keep < 0)
+    keep = 0;
+  if (keep < self->update_batch_count)
+    self->update_batch_count = (int)keep;
+  sqlite3_mutex_leave(sqlite3_db_mutex(self->db));
+}
+
 static PyObject *
 Connection_exit(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
 {
@@ -4138,6 +5203,8 @@ Connection_exit(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_na
   res = connection_trace_and_exec(self, 0, sp, 1);
   if (res == -1)
     return NULL;
+  if (res == 1)
+    PYSQLITE_VOID_CALL(Connection_update_batch_rollback_to(self, sp));
   return_null = return_null || res == 0;
   /* we have rolled back, but still need to release the savepoint */
   res = connection_trace_and_exec(self, 1, sp, 1);
@@ -4165,6 +5232,13 @@ Connection_exit(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_na
     A parameter of zero would turn it off, 1 turns on, and negative
     leaves unaltered.  The effective value is always returned.
 
+    `SQLITE_DBCONFIG_LOOKASIDE
+    <https://sqlite.org/c3ref/c_dbconfig_defensive.html#sqlitedbconfiglookaside>`__
+    takes the slot size and count, with SQLite allocating the memory,
+    and returns zero.  It raises :exc:`BusyError` if lookaside memory
+    is in use, so it is best done straight after opening.  See
+    :ref:`memory`.
+
     -* sqlite3_db_config
 */
 static PyObject *
@@ -4216,6 +5290,24 @@ Connection_config(Connection *self, PyObject *args)
     }
     return PyLong_FromLong(current);
   }
+
+  case SQLITE_DBCONFIG_LOOKASIDE:
+  {
+    /* SQLite allocates the memory as one block for this connection */
+    int opdup, size, count;
+    if (!PyArg_ParseTuple(args, "iii", &opdup, &size, &count))
+      return NULL;
+
+    PYSQLITE_CON_CALL(res = sqlite3_db_config(self->db, opdup, NULL, size, count));
+
+    if (res != SQLITE_OK)
+    {
+      SET_EXC(res, self->db);
+      return NULL;
+    }
+    return PyLong_FromLong(0);
+  }
+
   default:
     return PyErr_Format(PyExc_ValueError, "Unknown config operation %d", (int)opt);
   }
@@ -4429,31 +5521,525 @@ fail:
 }
 
 static PyObject *formatsqlvalue(PyObject *Py_UNUSED(self), PyObject *value);
-/** .. method:: pragma(name: str, value: Optional[SQLiteValue] = None, *, schema: Optional[str] = None) -> Any
-
-  Issues the pragma (with the value if supplied) and returns the result with
-  :attr:`the least amount of structure <Cursor.get>`.  For example
-  :code:`pragma("user_version")` will return just the number, while
-  :code:`pragma("journal_mode", "WAL")` will return the journal mode
-  now in effect.
-
-  Pragmas do not support bindings, so this method is a convenient
-  alternative to composing SQL text.  Pragmas are often executed
-  while being prepared, instead of when run like regular SQL.  They
-  may also contain encryption keys.  This method ensures they are
-  not cached to avoid problems.
-
-  Use the `schema` parameter to run the pragma against a different
-  attached database (eg ``temp``).
-
-  * :ref:`Example <example_pragma>`
+/** .. method:: import_file(filename: str, table: str, *, format: str = "csv", separator: str = ",", quoting: bool = True, header: bool = False, commit_every: int = 0) -> int
+
+  Imports rows from a file into an existing *table*, returning how
+  many rows were inserted.  This is considerably faster than parsing
+  the file in Python and using :meth:`executemany`, and is usually
+  limited by how fast the file can be read.  A background thread reads
+  the file in large chunks while this thread parses the previous chunk
+  and inserts its rows with a single prepared statement, all without
+  holding the GIL.
+
+  :param filename: The file to read, which must be UTF-8.  A leading
+      byte order mark is skipped.
+  :param table: The table to insert into, which must already exist.
+  :param format: ``csv`` for each line being values separated by
+      *separator*, or ``jsonl`` for `JSON lines <https://jsonlines.org/>`__
+      where each line is an array of values in column order, or an
+      object keyed by column name.
+  :param separator: The single character between values in ``csv``.
+      For example use ``"\t"`` for tab separated values.
+  :param quoting: If True then ``csv`` values can be in double quotes,
+      which allows them to contain separators, newlines, and double
+      quotes written twice.  Use False when quotes have no special
+      meaning.
+  :param header: If True the first row is column names, and is not
+      imported.
+  :param commit_every: If non-zero the transaction is committed after
+      this many rows, and another started.  That keeps the journal
+      small for very large files, but if there is an error then the
+      rows already committed remain.  The default of zero imports
+      everything in one transaction, so nothing is imported if there
+      is an error.
+
+  All ``csv`` values are inserted as text, so use declared column
+  types for `type affinity <https://www.sqlite.org/datatype3.html#type_affinity>`__
+  to store numbers.  Blank lines are ignored.  :exc:`ValueError` is
+  raised if a row has the wrong number of values.
+
+  If a transaction is already in progress then a savepoint is used
+  instead and *commit_every* is ignored.
+
+  The :ref:`shell <shell>` ``.import`` command uses this.
 */
 static PyObject *
-Connection_pragma(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+Connection_import_file(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
 {
-  const char *name = NULL;
-  PyObject *value = NULL;
-  const char *schema = NULL;
+  const char *filename = NULL, *table = NULL, *format = "csv", *separator = ",";
+  int quoting = 1, header = 0, commit_every = 0;
+  int res = SQLITE_OK, started = 0;
+  DataImport imp;
+
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  {
+    Connection_import_file_CHECK;
+    ARG_PROLOG(2, Connection_import_file_KWNAMES);
+    ARG_MANDATORY ARG_str(filename);
+    ARG_MANDATORY ARG_str(table);
+    ARG_OPTIONAL ARG_str(format);
+    ARG_OPTIONAL ARG_str(separator);
+    ARG_OPTIONAL ARG_bool(quoting);
+    ARG_OPTIONAL ARG_bool(header);
+    ARG_OPTIONAL ARG_int(commit_every);
+    ARG_EPILOG(NULL, Connection_import_file_USAGE, );
+  }
+
+  memset(&imp, 0, sizeof(imp));
+
+  if (0 == strcmp(format, "csv"))
+    imp.format = DATAIMPORT_CSV;
+  else if (0 == strcmp(format, "jsonl"))
+    imp.format = DATAIMPORT_JSONL;
+  else
+    return PyErr_Format(PyExc_ValueError, "format should be 'csv' or 'jsonl', not '%s'", format);
+  if (strlen(separator) != 1 || separator[0] == '"' || separator[0] == '\n' || separator[0] == '\r'
+      || (unsigned char)separator[0] > 127)
+    return PyErr_Format(PyExc_ValueError,
+                        "separator must be one ASCII character other than double quote or newline, not '%s'", separator);
+  if (commit_every < 0)
+    return PyErr_Format(PyExc_ValueError, "commit_every must be zero or positive, not %d", commit_every);
+
+  imp.db = self->db;
+  imp.table = table;
+  imp.separator = separator[0];
+  imp.quoting = quoting;
+  imp.header = header;
+  imp.commit_every = commit_every;
+
+  imp.chunks[0] = PyMem_Malloc(DATAIMPORT_CHUNK_SIZE);
+  imp.chunks[1] = PyMem_Malloc(DATAIMPORT_CHUNK_SIZE);
+  imp.want = PyThread_allocate_lock();
+  imp.ready = PyThread_allocate_lock();
+  imp.done = PyThread_allocate_lock();
+  if (!imp.chunks[0] || !imp.chunks[1] || !imp.want || !imp.ready || !imp.done)
+  {
+    PyErr_NoMemory();
+    goto finally;
+  }
+  /* the locks are used as signals, so they start acquired */
+  PyThread_acquire_lock(imp.want, WAIT_LOCK);
+  PyThread_acquire_lock(imp.ready, WAIT_LOCK);
+  PyThread_acquire_lock(imp.done, WAIT_LOCK);
+
+  imp.file = fopen(filename, "rb");
+  if (!imp.file)
+  {
+    PyErr_SetFromErrnoWithFilename(PyExc_OSError, filename);
+    goto finally;
+  }
+
+  if (PyThread_start_new_thread(dataimport_reader_thread, &imp) == PYTHREAD_INVALID_THREAD_ID)
+  {
+    PyErr_Format(PyExc_RuntimeError, "Unable to start the file reader thread");
+    goto finally;
+  }
+  started = 1;
+
+  res = SQLITE_MISUSE;
+  PYSQLITE_CON_CALL(res = dataimport_run(&imp));
+
+  if (!imp.eof && !imp.stop)
+  {
+    /* dataimport_run didn't get to run */
+    imp.stop = 1;
+    PyThread_release_lock(imp.want);
+  }
+
+  if (!PyErr_Occurred())
+  {
+    if (imp.read_errno)
+    {
+      errno = imp.read_errno;
+      PyErr_SetFromErrnoWithFilename(PyExc_OSError, filename);
+    }
+    else if (imp.message[0])
+      PyErr_Format(PyExc_ValueError, "%s", imp.message);
+    else if (res != SQLITE_OK)
+    {
+      /* the rollback replaced the SQLite error message */
+      if (imp.errmsg)
+        apsw_set_errmsg(imp.errmsg);
+      SET_EXC(res, self->db);
+    }
+  }
+  if (PyErr_Occurred())
+    AddTraceBackHere(__FILE__, __LINE__, "Connection.import_file", "{s: s, s: s, s: L}", "filename", filename,
+                     "table", table, "record", imp.record);
+
+finally:
+  if (started)
+  {
+    Py_BEGIN_ALLOW_THREADS PyThread_acquire_lock(imp.done, WAIT_LOCK);
+    Py_END_ALLOW_THREADS;
+  }
+  if (imp.file)
+    fclose(imp.file);
+  PyMem_Free(imp.chunks[0]);
+  PyMem_Free(imp.chunks[1]);
+  dataimport_free_lock(imp.want);
+  dataimport_free_lock(imp.ready);
+  dataimport_free_lock(imp.done);
+  sqlite3_free(imp.work);
+  sqlite3_free(imp.fields);
+  sqlite3_free(imp.errmsg);
+
+  if (PyErr_Occurred())
+    return NULL;
+  return PyLong_FromLongLong(imp.rows);
+}
+
+/** .. method:: export_query(destination: int | str, query: str, *, format: str = "sql", table: str = "table", separator: str = ",", quoting: bool = True, header: bool = False) -> int
+
+  Writes the rows from *query* to *destination*, returning how many
+  rows were written.  Each value is formatted directly from SQLite
+  without making Python objects, and a background thread writes out
+  the previous block of output while the next is formatted, all
+  without holding the GIL.  This is considerably faster than
+  formatting rows in Python.
+
+  :param destination: A file name, which is created or truncated, or
+      an open file descriptor which is written at its current position
+      and left open.  Flush any Python buffering around a descriptor
+      first.
+  :param query: A single SQL statement that returns rows.  It does
+      not take bindings.
+  :param format: ``sql`` for each row as an ``INSERT`` statement in
+      the same syntax as :meth:`apsw.format_sql_value`, ``csv`` for
+      values separated by *separator*, or ``jsonl`` for `JSON lines
+      <https://jsonlines.org/>`__ where each row is an object keyed
+      by column name.
+  :param table: The table name used in ``sql`` format, quoted if
+      necessary.
+  :param separator: The single character between values in ``csv``.
+  :param quoting: If True then ``csv`` values containing *separator*,
+      double quotes, or newlines are in double quotes with double
+      quotes written twice.
+  :param header: If True then ``csv`` starts with a row of column
+      names.
+
+  All output is UTF-8 and each row ends with a newline.  ``csv`` writes
+  null as an empty value.  Blobs are base64 encoded in ``csv`` and
+  ``jsonl``.  Infinity is ``1e999`` in ``sql`` and ``jsonl``.
+
+  The output can be read back with :meth:`import_file`.  The
+  :ref:`shell <shell>` ``.dump`` command uses this.
+*/
+static PyObject *
+Connection_export_query(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *destination = NULL;
+  const char *query = NULL, *format = "sql", *table = "table", *separator = ",";
+  int quoting = 1, header = 0;
+  int res = SQLITE_OK, started = 0, fd = -1;
+  const char *filename = NULL;
+  DataExport exp;
+
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  {
+    Connection_export_query_CHECK;
+    ARG_PROLOG(2, Connection_export_query_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(destination);
+    ARG_MANDATORY ARG_str(query);
+    ARG_OPTIONAL ARG_str(format);
+    ARG_OPTIONAL ARG_str(table);
+    ARG_OPTIONAL ARG_str(separator);
+    ARG_OPTIONAL ARG_bool(quoting);
+    ARG_OPTIONAL ARG_bool(header);
+    ARG_EPILOG(NULL, Connection_export_query_USAGE, );
+  }
+
+  memset(&exp, 0, sizeof(exp));
+
+  if (PyLong_Check(destination))
+  {
+    fd = PyLong_AsInt(destination);
+    if (fd == -1 && PyErr_Occurred())
+      return NULL;
+    if (fd < 0)
+      return PyErr_Format(PyExc_ValueError, "file descriptor must be zero or positive, not %d", fd);
+  }
+  else if (PyUnicode_Check(destination))
+  {
+    filename = PyUnicode_AsUTF8(destination);
+    if (!filename)
+      return NULL;
+  }
+  else
+    return PyErr_Format(PyExc_TypeError, "destination should be a file name or descriptor, not %s",
+                        Py_TypeName(destination));
+
+  if (0 == strcmp(format, "sql"))
+    exp.format = DATAEXPORT_SQL;
+  else if (0 == strcmp(format, "csv"))
+    exp.format = DATAEXPORT_CSV;
+  else if (0 == strcmp(format, "jsonl"))
+    exp.format = DATAEXPORT_JSONL;
+  else
+    return PyErr_Format(PyExc_ValueError, "format should be 'sql', 'csv', or 'jsonl', not '%s'", format);
+  if (strlen(separator) != 1 || separator[0] == '"' || separator[0] == '\n' || separator[0] == '\r'
+      || (unsigned char)separator[0] > 127)
+    return PyErr_Format(PyExc_ValueError,
+                        "separator must be one ASCII character other than double quote or newline, not '%s'", separator);
+
+  exp.db = self->db;
+  exp.query = query;
+  exp.table = table;
+  exp.separator = separator[0];
+  exp.quoting = quoting;
+  exp.header = header;
+
+  exp.full = PyThread_allocate_lock();
+  exp.idle = PyThread_allocate_lock();
+  exp.done = PyThread_allocate_lock();
+  if (!exp.full || !exp.idle || !exp.done)
+  {
+    PyErr_NoMemory();
+    goto finally;
+  }
+  /* the writer starts idle */
+  PyThread_acquire_lock(exp.full, WAIT_LOCK);
+  PyThread_acquire_lock(exp.done, WAIT_LOCK);
+
+  if (filename)
+    exp.file = fopen(filename, "wb");
+  else
+  {
+    /* a duplicate so closing it leaves the caller's descriptor open */
+    int dupfd = dup(fd);
+    if (dupfd >= 0)
+    {
+      exp.file = fdopen(dupfd, "wb");
+      if (!exp.file)
+        close(dupfd);
+    }
+  }
+  if (!exp.file)
+  {
+    if (filename)
+      PyErr_SetFromErrnoWithFilename(PyExc_OSError, filename);
+    else
+      PyErr_SetFromErrno(PyExc_OSError);
+    goto finally;
+  }
+
+  if (PyThread_start_new_thread(dataexport_writer_thread, &exp) == PYTHREAD_INVALID_THREAD_ID)
+  {
+    PyErr_Format(PyExc_RuntimeError, "Unable to start the file writer thread");
+    goto finally;
+  }
+  started = 1;
+
+  res = SQLITE_MISUSE;
+  PYSQLITE_CON_CALL(res = dataexport_run(&exp));
+
+  if (!exp.stop)
+  {
+    /* dataexport_run didn't get to run */
+    exp.stop = 1;
+    PyThread_release_lock(exp.full);
+  }
+
+  if (!PyErr_Occurred())
+  {
+    if (exp.write_errno)
+    {
+      errno = exp.write_errno;
+      if (filename)
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, filename);
+      else
+        PyErr_SetFromErrno(PyExc_OSError);
+    }
+    else if (exp.message[0])
+      PyErr_Format(PyExc_ValueError, "%s", exp.message);
+    else if (res != SQLITE_OK)
+    {
+      if (exp.errmsg)
+        apsw_set_errmsg(exp.errmsg);
+      SET_EXC(res, self->db);
+    }
+  }
+
+finally:
+  if (started)
+  {
+    Py_BEGIN_ALLOW_THREADS PyThread_acquire_lock(exp.done, WAIT_LOCK);
+    Py_END_ALLOW_THREADS;
+  }
+  if (exp.file && fclose(exp.file) != 0 && !PyErr_Occurred())
+  {
+    if (filename)
+      PyErr_SetFromErrnoWithFilename(PyExc_OSError, filename);
+    else
+      PyErr_SetFromErrno(PyExc_OSError);
+  }
+  if (PyErr_Occurred())
+    AddTraceBackHere(__FILE__, __LINE__, "Connection.export_query", "{s: O, s: s, s: L}", "destination", destination,
+                     "query", query, "rows", exp.rows);
+  dataimport_free_lock(exp.full);
+  dataimport_free_lock(exp.idle);
+  dataimport_free_lock(exp.done);
+  sqlite3_free(exp.buffers[0].data);
+  sqlite3_free(exp.buffers[1].data);
+  sqlite3_free(exp.prefix.data);
+  sqlite3_free(exp.key_offsets);
+  sqlite3_free(exp.errmsg);
+
+  if (PyErr_Occurred())
+    return NULL;
+  return PyLong_FromLongLong(exp.rows);
+}
+
+/* Brings schema_versions up to date, setting *changed if the attached
+   databases or any of their schema versions are different.  Called
+   with the database mutex held. */
+static int
+Connection_schema_versions_update(Connection *self, int *changed)
+{
+  int res = SQLITE_OK, count = 0, same, i;
+
+  while (sqlite3_db_name(self->db, count))
+    count++;
+
+  same = (count == self->schema_versions_count);
+  for (i = 0; same && i < count; i++)
+  {
+    const char *filename = sqlite3_db_filename(self->db, sqlite3_db_name(self->db, i));
+    same = 0 == strcmp(self->schema_versions[i].name, sqlite3_db_name(self->db, i))
+           && 0 == strcmp(self->schema_versions[i].filename, filename ? filename : "");
+  }
+
+  if (!same)
+  {
+    Connection_schema_versions_free(self);
+    *changed = 1;
+    self->schema_versions = sqlite3_malloc64(sizeof(SchemaVersion) * count);
+    if (!self->schema_versions)
+      return SQLITE_NOMEM;
+    memset(self->schema_versions, 0, sizeof(SchemaVersion) * count);
+    self->schema_versions_count = count;
+    for (i = 0; i < count; i++)
+    {
+      SchemaVersion *sv = &self->schema_versions[i];
+      const char *filename = sqlite3_db_filename(self->db, sqlite3_db_name(self->db, i));
+      char *sql;
+
+      sv->name = sqlite3_mprintf("%s", sqlite3_db_name(self->db, i));
+      sv->filename = sqlite3_mprintf("%s", filename ? filename : "");
+      sql = sqlite3_mprintf("pragma \"%w\".schema_version", sqlite3_db_name(self->db, i));
+      if (!sv->name || !sv->filename || !sql)
+        res = SQLITE_NOMEM;
+      else
+        res = sqlite3_prepare_v3(self->db, sql, -1, 0, &sv->stmt, NULL);
+      sqlite3_free(sql);
+      if (res != SQLITE_OK)
+        return res;
+    }
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    SchemaVersion *sv = &self->schema_versions[i];
+    sqlite3_int64 version = 0;
+
+    res = sqlite3_step(sv->stmt);
+    if (res == SQLITE_ROW)
+      version = sqlite3_column_int64(sv->stmt, 0);
+    if (res == SQLITE_ROW || res == SQLITE_DONE)
+      res = sqlite3_reset(sv->stmt);
+    else
+      sqlite3_reset(sv->stmt);
+    if (res != SQLITE_OK)
+      return res;
+    if (version != sv->version || sqlite3_stmt_status(sv->stmt, SQLITE_STMTSTATUS_REPREPARE, 0) != sv->reprepares)
+    {
+      sv->version = version;
+      sv->reprepares = sqlite3_stmt_status(sv->stmt, SQLITE_STMTSTATUS_REPREPARE, 0);
+      *changed = 1;
+    }
+  }
+  return SQLITE_OK;
+}
+
+/* Discards the metadata cache if the schema has changed.  Returns 1 if
+   new results can be added (no transaction is open so the schema
+   versions are committed ones that can't be reused by a rollback), 0
+   if not, and -1 with an exception set on error. */
+static int
+Connection_metadata_cache_validate(Connection *self)
+{
+  int res, changed = 0, storable = sqlite3_get_autocommit(self->db);
+
+  PYSQLITE_CON_CALL(res = Connection_schema_versions_update(self, &changed));
+  if (res != SQLITE_OK)
+  {
+    SET_EXC(res, self->db);
+    PYSQLITE_VOID_CALL(Connection_schema_versions_free(self));
+    Py_CLEAR(self->metadata_cache);
+    return -1;
+  }
+  if (changed)
+    Py_CLEAR(self->metadata_cache);
+  if (!self->metadata_cache)
+  {
+    self->metadata_cache = PyDict_New();
+    if (!self->metadata_cache)
+      return -1;
+  }
+  return storable ? 1 : 0;
+}
+
+/* what is returned for a cached value - mutable containers are copied
+   so callers can't alter the cache */
+static PyObject *
+Connection_metadata_cache_result(PyObject *value)
+{
+  if (PyList_CheckExact(value))
+    return PyList_GetSlice(value, 0, PyList_GET_SIZE(value));
+  if (PyDict_CheckExact(value))
+    return PyDict_Copy(value);
+  return Py_NewRef(value);
+}
+
+/** .. method:: pragma(name: str, value: Optional[SQLiteValue] = None, *, schema: Optional[str] = None, cache: bool = False) -> Any
+
+  Issues the pragma (with the value if supplied) and returns the result with
+  :attr:`the least amount of structure <Cursor.get>`.  For example
+  :code:`pragma("user_version")` will return just the number, while
+  :code:`pragma("journal_mode", "WAL")` will return the journal mode
+  now in effect.
+
+  Pragmas do not support bindings, so this method is a convenient
+  alternative to composing SQL text.  Pragmas are often executed
+  while being prepared, instead of when run like regular SQL.  They
+  may also contain encryption keys.  This method ensures they are
+  not cached to avoid problems.
+
+  Use the `schema` parameter to run the pragma against a different
+  attached database (eg ``temp``).
+
+  If `cache` is True then the result is kept and returned again
+  until the `schema version
+  <https://sqlite.org/pragma.html#pragma_schema_version>`__ of any
+  attached database changes.  This is only correct for pragmas whose
+  result depends solely on the schema such as ``table_info``,
+  ``table_xinfo``, ``index_list``, ``index_xinfo``, and
+  ``foreign_key_list``.  Results are not added to the cache while a
+  transaction is open.  See :meth:`metadata_cache_clear`.
+
+  * :ref:`Example <example_pragma>`
+*/
+static PyObject *
+Connection_pragma(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  const char *name = NULL;
+  PyObject *value = NULL;
+  const char *schema = NULL;
+  int cache = 0;
 
   CHECK_USE(NULL);
   CHECK_CLOSED(self, NULL);
@@ -4464,12 +6050,14 @@ Connection_pragma(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_
     ARG_MANDATORY ARG_str(name);
     ARG_OPTIONAL ARG_pyobject(value);
     ARG_OPTIONAL ARG_optional_str(schema);
+    ARG_OPTIONAL ARG_bool(cache);
     ARG_EPILOG(NULL, Connection_pragma_USAGE, );
   }
 
   PyObject *value_format = NULL, *res = NULL, *cursor = NULL, *query_py = NULL;
   const char *value_str = NULL;
   char *query = NULL;
+  int storable = 0;
 
   if (value)
   {
@@ -4508,6 +6096,21 @@ Connection_pragma(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_
   if (!query_py)
     goto error;
 
+  if (cache)
+  {
+    storable = Connection_metadata_cache_validate(self);
+    if (storable < 0)
+      goto error;
+    res = PyDict_GetItemWithError(self->metadata_cache, query_py);
+    if (res)
+    {
+      res = Connection_metadata_cache_result(res);
+      goto error;
+    }
+    if (PyErr_Occurred())
+      goto error;
+  }
+
   PyObject *vargs[] = {NULL, query_py, Py_False};
   PyObject *kwnames = PyTuple_Pack(1, apst.can_cache);
   if (kwnames)
@@ -4517,6 +6120,14 @@ Connection_pragma(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_
     goto error;
 
   res = PyObject_GetAttr(cursor, apst.get);
+  if (res && storable)
+  {
+    PyObject *cached = res;
+    res = NULL;
+    if (0 == PyDict_SetItem(self->metadata_cache, query_py, cached))
+      res = Connection_metadata_cache_result(cached);
+    Py_DECREF(cached);
+  }
 
 error:
   Py_XDECREF(value_format);
@@ -4566,6 +6177,13 @@ The returned dictionary has the following information.
       in the misses count.
   * - max_cacheable_bytes
     - Maximum size of query (in bytes of utf8) that will be considered for caching
+  * - prepare_time
+    - Total seconds spent preparing statements, whether cached or not
+  * - recycle_hits
+    - Statement bookkeeping memory reused from the connection's
+      recycle bin
+  * - recycle_misses
+    - Statement bookkeeping memory that had to be allocated
   * - entries
     - (Only present if `include_entries` is True) A list of the cache entries
 
@@ -4587,10 +6205,46 @@ If `entries` is present, then each list entry is a dict with the following infor
       if >= 0
   * - uses
     - How many times this entry has been (re)used
+  * - prepare_time
+    - Seconds it took to prepare this entry
+  * - priority
+    - Eviction priority.  The entry with the lowest value is discarded
+      next when space is needed
   * - has_more
     - Boolean indicating if there was more query text than
       the first statement
-
+  * - fullscan_steps
+    - How many times SQLite stepped forward in a table as part of a full table scan
+  * - sorts
+    - How many sort operations have occurred
+  * - autoindexes
+    - How many rows were inserted into transient indices that were
+      automatically created to help joins run faster
+  * - vm_steps
+    - How many virtual machine operations were run
+  * - reprepares
+    - How many times the statement was automatically regenerated due to
+      schema changes
+  * - runs
+    - How many times the statement has been run
+  * - memory_used
+    - Approximate bytes of heap memory used to store the statement
+  * - rows
+    - Result rows returned while :attr:`profile_statements` is on
+  * - step_time
+    - Seconds spent in SQLite evaluating the statement while
+      :attr:`profile_statements` is on
+  * - convert_time
+    - Seconds spent converting result values into Python objects
+      while :attr:`profile_statements` is on
+
+The counters from `sqlite3_stmt_status
+<https://sqlite.org/c3ref/stmt_status.html>`__ (fullscan_steps through
+memory_used) are always gathered by SQLite, and cover every use of the
+cache entry.  Statements that are currently executing are not in the
+cache and so are not included.
+
+-* sqlite3_stmt_status
 */
 static PyObject *
 Connection_cache_stats(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
@@ -4691,6 +6345,140 @@ Connection_column_metadata(Connection *self, PyObject *const *fast_args, Py_ssiz
   return Py_BuildValue("(ssOOO)", datatype, collseq, notnull ? Py_True : Py_False, primarykey ? Py_True : Py_False, autoinc ? Py_True : Py_False);
 }
 
+/** .. method:: table_metadata(dbname: Optional[str], table_name: str) -> dict[str, tuple[str, str, bool, bool, bool]]
+
+  Returns :meth:`column_metadata` for every column of the table in one
+  call, as a dict keyed by column name in table order.
+
+  `dbname` is `main`, `temp`, the name in `ATTACH <https://sqlite.org/lang_attach.html>`__, or None to search
+  all databases.
+
+  The result is cached until the schema changes, the same as
+  :meth:`pragma` with *cache*.
+
+  -* sqlite3_table_column_metadata
+*/
+static PyObject *
+Connection_table_metadata(Connection *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  const char *dbname = NULL, *table_name = NULL;
+  int res, storable, i;
+  PyObject *key = NULL, *result = NULL, *item = NULL;
+  sqlite3_stmt *stmt = NULL;
+  char *sql = NULL;
+
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  {
+    Connection_table_metadata_CHECK;
+    ARG_PROLOG(2, Connection_table_metadata_KWNAMES);
+    ARG_MANDATORY ARG_optional_str(dbname);
+    ARG_MANDATORY ARG_str(table_name);
+    ARG_EPILOG(NULL, Connection_table_metadata_USAGE, );
+  }
+
+  storable = Connection_metadata_cache_validate(self);
+  if (storable < 0)
+    return NULL;
+
+  key = Py_BuildValue("(zs)", dbname, table_name);
+  if (!key)
+    return NULL;
+  result = PyDict_GetItemWithError(self->metadata_cache, key);
+  if (result)
+  {
+    Py_DECREF(key);
+    return Connection_metadata_cache_result(result);
+  }
+  if (PyErr_Occurred())
+    goto error;
+
+  /* the statement provides the column names.  It is stepped first
+     because preparing uses this connection's copy of the schema, which
+     is only checked against the database (and reloaded if another
+     connection changed it) when a statement runs */
+  if (dbname)
+    sql = sqlite3_mprintf("select * from \"%w\".\"%w\" limit 0", dbname, table_name);
+  else
+    sql = sqlite3_mprintf("select * from \"%w\" limit 0", table_name);
+  if (!sql)
+  {
+    PyErr_NoMemory();
+    goto error;
+  }
+  PYSQLITE_CON_CALL(res = sqlite3_prepare_v3(self->db, sql, -1, 0, &stmt, NULL));
+  if (res == SQLITE_OK)
+    PYSQLITE_CON_CALL(res = sqlite3_step(stmt));
+  if (res != SQLITE_DONE)
+  {
+    SET_EXC(res, self->db);
+    goto error;
+  }
+
+  result = PyDict_New();
+  if (!result)
+    goto error;
+
+  for (i = 0; i < sqlite3_column_count(stmt); i++)
+  {
+    const char *column_name = sqlite3_column_name(stmt, i);
+    const char *datatype = NULL, *collseq = NULL;
+    int notnull = 0, primarykey = 0, autoinc = 0;
+
+    PYSQLITE_CON_CALL(res = sqlite3_table_column_metadata(self->db, dbname, table_name, column_name, &datatype, &collseq, &notnull, &primarykey, &autoinc));
+    if (res != SQLITE_OK)
+    {
+      SET_EXC(res, self->db);
+      goto error;
+    }
+    item = Py_BuildValue("(ssOOO)", datatype, collseq, notnull ? Py_True : Py_False, primarykey ? Py_True : Py_False, autoinc ? Py_True : Py_False);
+    if (!item || PyDict_SetItemString(result, column_name, item))
+      goto error;
+    Py_CLEAR(item);
+  }
+
+  if (storable && PyDict_SetItem(self->metadata_cache, key, result))
+    goto error;
+
+  PYSQLITE_VOID_CALL(sqlite3_finalize(stmt));
+  sqlite3_free(sql);
+  Py_DECREF(key);
+  item = Connection_metadata_cache_result(result);
+  Py_DECREF(result);
+  return item;
+
+error:
+  PYSQLITE_VOID_CALL(sqlite3_finalize(stmt));
+  sqlite3_free(sql);
+  Py_XDECREF(key);
+  Py_XDECREF(result);
+  Py_XDECREF(item);
+  return NULL;
+}
+
+/** .. method:: metadata_cache_clear() -> None
+
+  Discards results cached by :meth:`pragma` and :meth:`table_metadata`.
+
+  The cache is discarded automatically when the schema version of any
+  attached database changes, or databases are attached or detached.
+  You only need this if a pragma result depends on more than the
+  schema, or the schema version was changed with the `schema_version
+  pragma <https://sqlite.org/pragma.html#pragma_schema_version>`__.
+*/
+static PyObject *
+Connection_metadata_cache_clear(Connection *self)
+{
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  Py_CLEAR(self->metadata_cache);
+  PYSQLITE_VOID_CALL(Connection_schema_versions_free(self));
+
+  Py_RETURN_NONE;
+}
+
 /** .. method:: cache_flush() -> None
 
   Flushes caches to disk mid-transaction.
@@ -5193,6 +6981,158 @@ Connection_is_interrupted(Connection *self)
   return Py_NewRef(sqlite3_is_interrupted(self->db) ? Py_True : Py_False);
 }
 
+/** .. attribute:: whole_row_fetch
+  :type: bool
+
+  Controls how result rows are read from SQLite.  The default (False)
+  releases the Python Global Interpreter Lock (GIL) around reading
+  each value from SQLite.  When True the GIL is released once to read
+  all the values of a row, and then held while converting them to
+  Python objects.  That is considerably faster in multi-threaded
+  programs where the GIL is contended.
+
+  The initial value comes from :func:`apsw.whole_row_fetch`.
+*/
+static PyObject *
+Connection_get_whole_row_fetch(Connection *self)
+{
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  return Py_NewRef(self->whole_row_fetch ? Py_True : Py_False);
+}
+
+static int
+Connection_set_whole_row_fetch(Connection *self, PyObject *value)
+{
+  CHECK_USE(-1);
+  CHECK_CLOSED(self, -1);
+
+  if (!PyBool_Check(value))
+  {
+    PyErr_Format(PyExc_TypeError, "Expected a bool, not %s", Py_TypeName(value));
+    return -1;
+  }
+  self->whole_row_fetch = Py_IsTrue(value);
+  return 0;
+}
+
+/** .. attribute:: profile_statements
+  :type: bool
+
+  When True each statement records the number of result rows, the
+  time spent in SQLite evaluating it, and the time spent converting its
+  result values into Python objects.  The totals are kept with each
+  :meth:`statement cache <cache_stats>` entry, so you can find the most
+  expensive queries without a :meth:`profile <set_profile>` callback.
+  The default is False, and the overhead when True is measuring the
+  time around each step.
+*/
+static PyObject *
+Connection_get_profile_statements(Connection *self)
+{
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  return Py_NewRef(self->profile_statements ? Py_True : Py_False);
+}
+
+static int
+Connection_set_profile_statements(Connection *self, PyObject *value)
+{
+  CHECK_USE(-1);
+  CHECK_CLOSED(self, -1);
+
+  if (!PyBool_Check(value))
+  {
+    PyErr_Format(PyExc_TypeError, "Expected a bool, not %s", Py_TypeName(value));
+    return -1;
+  }
+  self->profile_statements = Py_IsTrue(value);
+  return 0;
+}
+
+/** .. attribute:: named_rows
+  :type: bool
+
+  When True result rows are returned as :class:`Row`, which can also
+  be accessed by column name as an attribute or key, instead of
+  :class:`tuple`.  The column names are worked out once per prepared
+  statement, so this is considerably faster than using a
+  :attr:`row tracer <row_trace>` such as
+  :class:`apsw.ext.DataClassRowFactory`.  The default is False.
+*/
+static PyObject *
+Connection_get_named_rows(Connection *self)
+{
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  return Py_NewRef(self->named_rows ? Py_True : Py_False);
+}
+
+static int
+Connection_set_named_rows(Connection *self, PyObject *value)
+{
+  CHECK_USE(-1);
+  CHECK_CLOSED(self, -1);
+
+  if (!PyBool_Check(value))
+  {
+    PyErr_Format(PyExc_TypeError, "Expected a bool, not %s", Py_TypeName(value));
+    return -1;
+  }
+  self->named_rows = Py_IsTrue(value);
+  return 0;
+}
+
+/** .. attribute:: zero_copy_bindings
+  :type: bool
+
+  Controls how :class:`str`, :class:`bytes`, and other buffer values
+  are bound to queries.  The default (False) has SQLite make its own
+  copy of each value.  When True SQLite uses the memory of the Python
+  object directly, which avoids doubling memory for large values.
+
+  SQLite can read a bound value at any point until the statement it
+  is bound to finishes.  That is when the cursor moves on to the next
+  statement in the query, to the next set of bindings in
+  :meth:`Cursor.executemany`, or when the cursor is reset because the
+  results were exhausted, an error occurred, another query was
+  executed, or the cursor was closed.  The cursor keeps a reference to
+  each bound object (and holds the buffer export for buffers) until
+  then, so you don't have to keep them alive yourself.
+
+  .. note::
+
+    Buffers such as :class:`bytearray` can't be resized during that
+    time, but their contents can be changed and SQLite would then see
+    the new contents.  Don't modify them until the statement finishes.
+*/
+static PyObject *
+Connection_get_zero_copy_bindings(Connection *self)
+{
+  CHECK_USE(NULL);
+  CHECK_CLOSED(self, NULL);
+
+  return Py_NewRef(self->zero_copy_bindings ? Py_True : Py_False);
+}
+
+static int
+Connection_set_zero_copy_bindings(Connection *self, PyObject *value)
+{
+  CHECK_USE(-1);
+  CHECK_CLOSED(self, -1);
+
+  if (!PyBool_Check(value))
+  {
+    PyErr_Format(PyExc_TypeError, "Expected a bool, not %s", Py_TypeName(value));
+    return -1;
+  }
+  self->zero_copy_bindings = Py_IsTrue(value);
+  return 0;
+}
+
 static PyGetSetDef Connection_getseters[] = {
     /* name getter setter doc closure */
     {"filename",
@@ -5209,6 +7149,10 @@ static PyGetSetDef Connection_getseters[] = {
     {"authorizer", (getter)Connection_get_authorizer_attr, (setter)Connection_set_authorizer_attr, Connection_authorizer_DOC},
     {"system_errno", (getter)Connection_get_system_errno, NULL, Connection_system_errno_DOC},
     {"is_interrupted", (getter)Connection_is_interrupted, NULL, Connection_is_interrupted_DOC},
+    {"whole_row_fetch", (getter)Connection_get_whole_row_fetch, (setter)Connection_set_whole_row_fetch, Connection_whole_row_fetch_DOC},
+    {"profile_statements", (getter)Connection_get_profile_statements, (setter)Connection_set_profile_statements, Connection_profile_statements_DOC},
+    {"named_rows", (getter)Connection_get_named_rows, (setter)Connection_set_named_rows, Connection_named_rows_DOC},
+    {"zero_copy_bindings", (getter)Connection_get_zero_copy_bindings, (setter)Connection_set_zero_copy_bindings, Connection_zero_copy_bindings_DOC},
 #ifndef APSW_OMIT_OLD_NAMES
     {Connection_exec_trace_OLDNAME, (getter)Connection_get_exec_trace_attr, (setter)Connection_set_exec_trace_attr, Connection_exec_trace_OLDDOC},
     {Connection_row_trace_OLDNAME, (getter)Connection_get_row_trace_attr, (setter)Connection_set_row_trace_attr, Connection_row_trace_OLDDOC},
@@ -5244,6 +7188,8 @@ Connection_tp_traverse(Connection *self, visitproc visit, void *arg)
   Py_VISIT(self->exectrace);
   Py_VISIT(self->rowtrace);
   Py_VISIT(self->tracehook);
+  Py_VISIT(self->adapters);
+  Py_VISIT(self->converters);
   Py_VISIT(self->vfs);
   Py_VISIT(self->dependents);
   Py_VISIT(self->cursor_factory);
@@ -5335,6 +7281,10 @@ static PyMethodDef Connection_methods[] = {
      Connection_set_exec_trace_DOC},
     {"set_row_trace", (PyCFunction)Connection_set_row_trace, METH_FASTCALL | METH_KEYWORDS,
      Connection_set_row_trace_DOC},
+    {"register_adapter", (PyCFunction)Connection_register_adapter, METH_FASTCALL | METH_KEYWORDS,
+     Connection_register_adapter_DOC},
+    {"register_converter", (PyCFunction)Connection_register_converter, METH_FASTCALL | METH_KEYWORDS,
+     Connection_register_converter_DOC},
     {"get_exec_trace", (PyCFunction)Connection_get_exec_trace, METH_NOARGS,
      Connection_get_exec_trace_DOC},
     {"get_row_trace", (PyCFunction)Connection_get_row_trace, METH_NOARGS,
@@ -5372,6 +7322,8 @@ static PyMethodDef Connection_methods[] = {
     {"cache_stats", (PyCFunction)Connection_cache_stats, METH_FASTCALL | METH_KEYWORDS, Connection_cache_stats_DOC},
     {"table_exists", (PyCFunction)Connection_table_exists, METH_FASTCALL | METH_KEYWORDS, Connection_table_exists_DOC},
     {"column_metadata", (PyCFunction)Connection_column_metadata, METH_FASTCALL | METH_KEYWORDS, Connection_column_metadata_DOC},
+    {"table_metadata", (PyCFunction)Connection_table_metadata, METH_FASTCALL | METH_KEYWORDS, Connection_table_metadata_DOC},
+    {"metadata_cache_clear", (PyCFunction)Connection_metadata_cache_clear, METH_NOARGS, Connection_metadata_cache_clear_DOC},
     {"trace_v2", (PyCFunction)Connection_trace_v2, METH_FASTCALL | METH_KEYWORDS, Connection_trace_v2_DOC},
     {"cache_flush", (PyCFunction)Connection_cache_flush, METH_NOARGS, Connection_cache_flush_DOC},
     {"release_memory", (PyCFunction)Connection_release_memory, METH_FASTCALL | METH_KEYWORDS, Connection_release_memory_DOC},
@@ -5381,6 +7333,9 @@ static PyMethodDef Connection_methods[] = {
     {"vtab_config", (PyCFunction)Connection_vtab_config, METH_FASTCALL | METH_KEYWORDS, Connection_vtab_config_DOC},
     {"vtab_on_conflict", (PyCFunction)Connection_vtab_on_conflict, METH_NOARGS, Connection_vtab_on_conflict_DOC},
     {"pragma", (PyCFunction)Connection_pragma, METH_FASTCALL | METH_KEYWORDS, Connection_pragma_DOC},
+    {"import_file", (PyCFunction)Connection_import_file, METH_FASTCALL | METH_KEYWORDS, Connection_import_file_DOC},
+    {"export_query", (PyCFunction)Connection_export_query, METH_FASTCALL | METH_KEYWORDS,
+     Connection_export_query_DOC},
     {"read", (PyCFunction)Connection_read, METH_FASTCALL | METH_KEYWORDS, Connection_read_DOC},
 #ifndef APSW_OMIT_OLD_NAMES
     {Connection_set_busy_timeout_OLDNAME, (PyCFunction)Connection_set_busy_timeout, METH_FASTCALL | METH_KEYWORDS,
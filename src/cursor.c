@@ -60,7 +60,7 @@ struct APSWCursor
   PyObject_HEAD
       Connection *connection; /* pointer to parent connection */
 
-  unsigned inuse;                  /* track if we are in use preventing concurrent thread mangling */
+  int inuse;                       /* track if we are in use preventing concurrent thread mangling */
   struct APSWStatement *statement; /* statement we are currently using */
 
   /* what state we are in */
@@ -74,6 +74,7 @@ struct APSWCursor
   /* bindings for query */
   PyObject *bindings;        /* dict or sequence */
   Py_ssize_t bindingsoffset; /* for sequence tracks how far along we are when dealing with multiple statements */
+  PyObject *pinned;          /* list of objects whose memory is bound with SQLITE_STATIC */
 
   /* iterator for executemany, original query string, prepare options */
   PyObject *emiter;
@@ -89,12 +90,38 @@ struct APSWCursor
 
   PyObject *description_cache[3];
 
+  /* blobs returned as BlobView */
+  int blob_views;
+  unsigned blob_view_generation; /* changes when the views of the current row become stale */
+  Py_ssize_t blob_view_exports;  /* buffer exports of views of the current row */
+
   int init_was_called;
 };
 
 typedef struct APSWCursor APSWCursor;
 static PyTypeObject APSWCursorType;
 
+typedef struct APSWBlobView
+{
+  PyObject_HEAD
+      APSWCursor *cursor;
+  unsigned generation; /* cursor blob_view_generation when made */
+  const void *data;    /* SQLite's memory for the value */
+  Py_ssize_t length;
+  Py_ssize_t exports; /* outstanding buffer exports */
+} APSWBlobView;
+
+static PyTypeObject APSWBlobViewType;
+
+typedef struct APSWRow
+{
+  PyObject_VAR_HEAD
+      PyObject *fields; /* statement row_fields - tuple of (names tuple, dict of name to index) */
+  PyObject *values[1];
+} APSWRow;
+
+static PyTypeObject APSWRowType;
+
 static PyObject *collections_abc_Mapping;
 
 /* CURSOR CODE */
@@ -105,6 +132,51 @@ static PyObject *collections_abc_Mapping;
 
 #define EXECTRACE (self->exectrace ? self->exectrace : self->connection->exectrace)
 
+/* Values bound with SQLITE_STATIC point into the memory of the objects
+   in pinned, so SQLite has to stop using them (by clearing the
+   bindings) before the objects are released */
+static void
+APSWCursor_unpin_bindings(APSWCursor *self)
+{
+  if (!self->pinned)
+    return;
+  if (self->statement && self->statement->vdbestatement)
+    PYSQLITE_VOID_CALL(sqlite3_clear_bindings(self->statement->vdbestatement));
+  Py_CLEAR(self->pinned);
+}
+
+/* keeps obj alive until APSWCursor_unpin_bindings.  Returns 0 on success */
+static int
+APSWCursor_pin_binding(APSWCursor *self, PyObject *obj)
+{
+  if (!self->pinned)
+  {
+    self->pinned = PyList_New(0);
+    if (!self->pinned)
+      return -1;
+  }
+  return PyList_Append(self->pinned, obj);
+}
+
+/* The BlobViews of the current row become stale because SQLite will
+   reuse their memory.  Returns 0 on success, or -1 with BufferError if
+   any are still exported.  That applies even when forcing because the
+   exported buffers point directly at SQLite's memory, and there is no
+   way of revoking them. */
+static int
+APSWCursor_invalidate_blob_views(APSWCursor *self)
+{
+  if (self->blob_view_exports)
+  {
+    PyErr_Format(PyExc_BufferError, "There are %zd exported buffers of BlobView from the current row.  They must be released first",
+                 self->blob_view_exports);
+    return -1;
+  }
+  self->blob_view_generation++;
+  self->blob_view_exports = 0;
+  return 0;
+}
+
 /* Do finalization and free resources.  Returns the SQLITE error code.  If force is 2 then don't raise any exceptions */
 static int
 resetcursor(APSWCursor *self, int force)
@@ -112,15 +184,20 @@ resetcursor(APSWCursor *self, int force)
   int res = SQLITE_OK;
   int hasmore = statementcache_hasmore(self->statement);
 
+  if (APSWCursor_invalidate_blob_views(self))
+    return SQLITE_ERROR;
+
   Py_CLEAR(self->description_cache[0]);
   Py_CLEAR(self->description_cache[1]);
   Py_CLEAR(self->description_cache[2]);
 
   PY_ERR_FETCH_IF(force, exc_save);
 
+  APSWCursor_unpin_bindings(self);
+
   if (self->statement)
   {
-    INUSE_CALL(res = statementcache_finalize(self->connection->stmtcache, self->statement));
+    INUSE_CALL_ELSE(res = statementcache_finalize(self->connection->stmtcache, self->statement), res = SQLITE_MISUSE);
     if (res == SQLITE_OK && PyErr_Occurred())
       res = SQLITE_ERROR;
     if (res)
@@ -152,7 +229,7 @@ resetcursor(APSWCursor *self, int force)
   if (!force && self->status != C_DONE && self->emiter)
   {
     PyObject *next;
-    INUSE_CALL(next = PyIter_Next(self->emiter));
+    INUSE_CALL_ELSE(next = PyIter_Next(self->emiter), next = NULL);
     if (next)
     {
       Py_DECREF(next);
@@ -253,6 +330,7 @@ APSWCursor_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSE
     self->status = C_DONE;
     self->bindings = 0;
     self->bindingsoffset = 0;
+    self->pinned = 0;
     self->emiter = 0;
     self->emoriginalquery = 0;
     self->exectrace = 0;
@@ -262,6 +340,9 @@ APSWCursor_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSE
     self->description_cache[0] = 0;
     self->description_cache[1] = 0;
     self->description_cache[2] = 0;
+    self->blob_views = 0;
+    self->blob_view_generation = 0;
+    self->blob_view_exports = 0;
     self->init_was_called = 0;
   }
 
@@ -471,7 +552,7 @@ APSWCursor_is_dict_binding(PyObject *obj)
 
 /* internal function - returns SQLite error code (ie SQLITE_OK if all is well) */
 static int
-APSWCursor_dobinding(APSWCursor *self, int arg, PyObject *obj)
+APSWCursor_dobinding_value(APSWCursor *self, int arg, PyObject *obj)
 {
 
   /* DUPLICATE(ish) code: this is substantially similar to the code in
@@ -479,6 +560,8 @@ APSWCursor_dobinding(APSWCursor *self, int arg, PyObject *obj)
      well. */
 
   int res = SQLITE_OK;
+  int zero_copy = self->connection->zero_copy_bindings;
+  sqlite3_destructor_type destructor = zero_copy ? SQLITE_STATIC : SQLITE_TRANSIENT;
 
   assert(!PyErr_Occurred());
 
@@ -502,7 +585,9 @@ APSWCursor_dobinding(APSWCursor *self, int arg, PyObject *obj)
     strdata = PyUnicode_AsUTF8AndSize(obj, &strbytes);
     if (strdata)
     {
-      PYSQLITE_CUR_CALL(res = sqlite3_bind_text64(self->statement->vdbestatement, arg, strdata, strbytes, SQLITE_TRANSIENT, SQLITE_UTF8));
+      if (zero_copy && APSWCursor_pin_binding(self, obj))
+        return -1;
+      PYSQLITE_CUR_CALL(res = sqlite3_bind_text64(self->statement->vdbestatement, arg, strdata, strbytes, destructor, SQLITE_UTF8));
     }
     else
     {
@@ -510,6 +595,29 @@ APSWCursor_dobinding(APSWCursor *self, int arg, PyObject *obj)
       return -1;
     }
   }
+  else if (PyObject_CheckBuffer(obj) && zero_copy)
+  {
+    /* the memoryview holds the buffer export until it is unpinned */
+    PyObject *view = PyMemoryView_FromObject(obj);
+    Py_buffer *viewbuffer;
+
+    if (!view)
+      return -1;
+    viewbuffer = PyMemoryView_GET_BUFFER(view);
+    if (!PyBuffer_IsContiguous(viewbuffer, 'C'))
+    {
+      Py_DECREF(view);
+      PyErr_Format(PyExc_TypeError, "Expected a contiguous buffer");
+      return -1;
+    }
+    if (APSWCursor_pin_binding(self, view))
+    {
+      Py_DECREF(view);
+      return -1;
+    }
+    Py_DECREF(view);
+    PYSQLITE_CUR_CALL(res = sqlite3_bind_blob64(self->statement->vdbestatement, arg, viewbuffer->buf, viewbuffer->len, SQLITE_STATIC));
+  }
   else if (PyObject_CheckBuffer(obj))
   {
     int asrb;
@@ -541,6 +649,34 @@ APSWCursor_dobinding(APSWCursor *self, int arg, PyObject *obj)
   return 0;
 }
 
+/* internal function - applies any Connection.register_adapter for the
+   exact type of obj, then binds it */
+static int
+APSWCursor_dobinding(APSWCursor *self, int arg, PyObject *obj)
+{
+  PyObject *adapter, *adapted;
+  int res;
+
+  if (!self->connection->adapters || Py_IsNone(obj) || PyLong_CheckExact(obj) || PyFloat_CheckExact(obj)
+      || PyUnicode_CheckExact(obj) || PyBytes_CheckExact(obj))
+    return APSWCursor_dobinding_value(self, arg, obj);
+
+  adapter = PyDict_GetItemWithError(self->connection->adapters, (PyObject *)Py_TYPE(obj));
+  if (!adapter)
+    return PyErr_Occurred() ? -1 : APSWCursor_dobinding_value(self, arg, obj);
+
+  adapted = PyObject_CallOneArg(adapter, obj);
+  if (!adapted)
+  {
+    AddTraceBackHere(__FILE__, __LINE__, "Cursor.dobinding", "{s: i, s: O, s: O}", "number", arg + self->bindingsoffset,
+                     "value", obj, "adapter", adapter);
+    return -1;
+  }
+  res = APSWCursor_dobinding_value(self, arg, adapted);
+  Py_DECREF(adapted);
+  return res;
+}
+
 /* internal function */
 static int
 APSWCursor_dobindings(APSWCursor *self)
@@ -734,17 +870,36 @@ APSWCursor_do_row_trace(APSWCursor *self, PyObject *retval)
   return PyObject_Vectorcall(rowtrace, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
 }
 
-/* Returns a borrowed reference to self if all is ok, else NULL on error */
+/* Returns a borrowed reference to self if all is ok, else NULL on error.
+   stepped is the result of a sqlite3_step of the current statement
+   already made by the caller, or -1 to make the call here. */
 static PyObject *
-APSWCursor_step(APSWCursor *self)
+APSWCursor_step_from(APSWCursor *self, int stepped)
 {
   int res;
   int savedbindingsoffset = 0; /* initialised to stop stupid compiler from whining */
 
+  if (APSWCursor_invalidate_blob_views(self))
+    return NULL;
+
   for (;;)
   {
     assert(!PyErr_Occurred());
-    PYSQLITE_CUR_CALL(res = (self->statement->vdbestatement) ? (sqlite3_step(self->statement->vdbestatement)) : (SQLITE_DONE));
+    if (stepped >= 0)
+    {
+      res = stepped;
+      stepped = -1;
+    }
+    else if (self->connection->profile_statements && self->statement->vdbestatement)
+    {
+      long long start;
+      PYSQLITE_CUR_CALL((start = apsw_perf_counter_ns(), res = sqlite3_step(self->statement->vdbestatement),
+                         self->statement->step_ns += apsw_perf_counter_ns() - start));
+      if (res == SQLITE_ROW)
+        self->statement->rows++;
+    }
+    else
+      PYSQLITE_CUR_CALL(res = (self->statement->vdbestatement) ? (sqlite3_step(self->statement->vdbestatement)) : (SQLITE_DONE));
 
     switch (res & 0xff)
     {
@@ -793,7 +948,7 @@ APSWCursor_step(APSWCursor *self)
       }
 
       /* we are in executemany mode */
-      INUSE_CALL(next = PyIter_Next(self->emiter));
+      INUSE_CALL_ELSE(next = PyIter_Next(self->emiter), next = NULL);
       if (PyErr_Occurred())
       {
         assert(!next);
@@ -808,6 +963,7 @@ APSWCursor_step(APSWCursor *self)
       }
 
       /* we need to clear just completed and restart original executemany statement */
+      APSWCursor_unpin_bindings(self);
       INUSE_CALL(statementcache_finalize(self->connection->stmtcache, self->statement));
       self->statement = NULL;
       /* don't need bindings from last round if emiter.next() */
@@ -832,13 +988,14 @@ APSWCursor_step(APSWCursor *self)
     {
       /* we are going again in executemany mode */
       assert(self->emiter);
-      INUSE_CALL(self->statement = statementcache_prepare(self->connection->stmtcache, self->emoriginalquery, &self->emoptions));
+      INUSE_CALL_ELSE(self->statement = statementcache_prepare(self->connection->stmtcache, self->emoriginalquery, &self->emoptions), self->statement = NULL);
       res = (self->statement) ? SQLITE_OK : SQLITE_ERROR;
     }
     else
     {
       /* next sql statement */
-      INUSE_CALL(res = statementcache_next(self->connection->stmtcache, &self->statement));
+      APSWCursor_unpin_bindings(self);
+      INUSE_CALL_ELSE(res = statementcache_next(self->connection->stmtcache, &self->statement), res = SQLITE_MISUSE);
       SET_EXC(res, self->connection->db);
     }
 
@@ -882,6 +1039,275 @@ APSWCursor_step(APSWCursor *self)
   return NULL;
 }
 
+static PyObject *
+APSWCursor_step(APSWCursor *self)
+{
+  return APSWCursor_step_from(self, -1);
+}
+
+/* Converts the sequence bindings for one executemany row into values
+   using the plan (Python type per binding) from earlier rows.  The
+   SQLite type for each planned binding is kept in values.  Returns 1 if
+   the row was converted, 0 if the row has to be bound the normal way, and
+   -1 on error */
+static int
+executemany_plan_row(PyObject *bindings, int nargs, PyTypeObject **plan, APSWColumnValue *values)
+{
+  int i;
+
+  if (PySequence_Fast_GET_SIZE(bindings) != nargs)
+    return 0;
+
+  for (i = 0; i < nargs; i++)
+  {
+    PyObject *obj = PySequence_Fast_GET_ITEM(bindings, i);
+
+    if (Py_TYPE(obj) != plan[i])
+    {
+      /* only exact types are planned - everything else such as
+         subclasses, buffers, and zeroblob is bound the normal way */
+      if (Py_IsNone(obj))
+        values[i].type = SQLITE_NULL;
+      else if (PyLong_CheckExact(obj))
+        values[i].type = SQLITE_INTEGER;
+      else if (PyFloat_CheckExact(obj))
+        values[i].type = SQLITE_FLOAT;
+      else if (PyUnicode_CheckExact(obj))
+        values[i].type = SQLITE_TEXT;
+      else if (PyBytes_CheckExact(obj))
+        values[i].type = SQLITE_BLOB;
+      else
+        return 0;
+      plan[i] = Py_TYPE(obj);
+    }
+
+    switch (values[i].type)
+    {
+    case SQLITE_INTEGER:
+      values[i].u.i = PyLong_AsLongLong(obj);
+      if (values[i].u.i == -1 && PyErr_Occurred())
+        return -1;
+      break;
+    case SQLITE_FLOAT:
+      values[i].u.d = PyFloat_AS_DOUBLE(obj);
+      break;
+    case SQLITE_TEXT:
+      values[i].u.p = PyUnicode_AsUTF8AndSize(obj, &values[i].len);
+      if (!values[i].u.p)
+        return -1;
+      break;
+    case SQLITE_BLOB:
+      values[i].u.p = PyBytes_AS_STRING(obj);
+      values[i].len = PyBytes_GET_SIZE(obj);
+      break;
+    }
+  }
+  return 1;
+}
+
+/* Binds the values (if any), then steps the statement to completion,
+   resetting it and clearing the bindings ready for the next row.  Text
+   and blob values use destructor which can be SQLITE_STATIC because the
+   bindings are cleared before returning.  This must be called with the
+   GIL released. */
+static int
+executemany_bind_step(sqlite3_stmt *stmt, int nargs, const APSWColumnValue *values, sqlite3_destructor_type destructor)
+{
+  int i, res = SQLITE_OK;
+
+  for (i = 0; i < nargs && res == SQLITE_OK; i++)
+  {
+    switch (values[i].type)
+    {
+    case SQLITE_NULL:
+      res = sqlite3_bind_null(stmt, i + 1);
+      break;
+    case SQLITE_INTEGER:
+      res = sqlite3_bind_int64(stmt, i + 1, values[i].u.i);
+      break;
+    case SQLITE_FLOAT:
+      res = sqlite3_bind_double(stmt, i + 1, values[i].u.d);
+      break;
+    case SQLITE_TEXT:
+      res = sqlite3_bind_text64(stmt, i + 1, values[i].u.p, values[i].len, destructor, SQLITE_UTF8);
+      break;
+    case SQLITE_BLOB:
+      res = sqlite3_bind_blob64(stmt, i + 1, values[i].u.p, values[i].len, destructor);
+      break;
+    }
+  }
+  if (res != SQLITE_OK)
+    return res;
+
+  /* the statement has no result columns so there is nothing to return */
+  do
+    res = sqlite3_step(stmt);
+  while (res == SQLITE_ROW);
+  if (res != SQLITE_DONE)
+    return res;
+
+  res = sqlite3_reset(stmt);
+  if (res == SQLITE_OK)
+    res = sqlite3_clear_bindings(stmt);
+  return res;
+}
+
+/* executemany of a single statement that returns no rows, with the
+   current bindings being a sequence.  Instead of going back through the
+   statement cache for each row, the statement is reset and reused.  Rows
+   matching the binding plan are bound and stepped in one release of the
+   GIL.  Other rows (dicts, types not in the plan, when there is an exec
+   tracer) are bound the normal way.  Returns a borrowed reference to self
+   if all is ok, else NULL on error */
+static PyObject *
+APSWCursor_executemany_bulk(APSWCursor *self)
+{
+  int res = SQLITE_OK, nargs, converted;
+  long long step_start;
+  PyTypeObject **plan = NULL;
+  APSWColumnValue *values = NULL;
+  PyObject *next = NULL;
+
+  nargs = sqlite3_bind_parameter_count(self->statement->vdbestatement);
+  if (nargs)
+  {
+    plan = PyMem_Calloc(nargs, sizeof(PyTypeObject *));
+    values = PyMem_Calloc(nargs, sizeof(APSWColumnValue));
+    if (!plan || !values)
+    {
+      PyErr_NoMemory();
+      goto error;
+    }
+  }
+
+  for (;;)
+  {
+    assert(self->bindings);
+    assert(!PyErr_Occurred());
+
+    converted = 0;
+    if (!EXECTRACE && !APSWCursor_is_dict_binding(self->bindings))
+      converted = executemany_plan_row(self->bindings, nargs, plan, values);
+    if (converted < 0)
+      goto error;
+
+    step_start = self->connection->profile_statements ? apsw_perf_counter_ns() : 0;
+    if (converted)
+    {
+      sqlite3_destructor_type destructor = self->connection->zero_copy_bindings ? SQLITE_STATIC : SQLITE_TRANSIENT;
+      PYSQLITE_CUR_CALL(res = executemany_bind_step(self->statement->vdbestatement, nargs, values, destructor));
+    }
+    else
+    {
+      self->bindingsoffset = 0;
+      if (APSWCursor_dobindings(self))
+        goto error;
+      if (EXECTRACE && APSWCursor_do_exec_trace(self, 0))
+        goto error;
+      PYSQLITE_CUR_CALL(res = executemany_bind_step(self->statement->vdbestatement, 0, NULL, SQLITE_TRANSIENT));
+    }
+    if (step_start)
+      self->statement->step_ns += apsw_perf_counter_ns() - step_start;
+    if (res != SQLITE_OK || PyErr_Occurred())
+    {
+      SET_EXC(res, self->connection->db);
+      goto error;
+    }
+    /* the bindings were cleared so none are pinned */
+    Py_CLEAR(self->pinned);
+
+    INUSE_CALL_ELSE(next = PyIter_Next(self->emiter), next = NULL);
+    if (!next)
+    {
+      if (PyErr_Occurred())
+        goto error;
+      break;
+    }
+    /* counts as a reuse, the same as going back through the cache */
+    self->statement->uses++;
+
+    Py_CLEAR(self->bindings);
+    if (APSWCursor_is_dict_binding(next))
+      self->bindings = next;
+    else
+    {
+      self->bindings = PySequence_Fast(next, "You must supply a dict or a sequence for bindings");
+      Py_DECREF(next);
+      if (!self->bindings)
+        goto error;
+    }
+  }
+
+  PyMem_Free(plan);
+  PyMem_Free(values);
+  self->status = C_DONE;
+  res = resetcursor(self, 0);
+  return (res == SQLITE_OK) ? (PyObject *)self : NULL;
+
+error:
+  assert(PyErr_Occurred());
+  PyMem_Free(plan);
+  PyMem_Free(values);
+  /* the row may have been bound with SQLITE_STATIC and not cleared */
+  PYSQLITE_VOID_CALL(sqlite3_clear_bindings(self->statement->vdbestatement));
+  self->status = C_DONE;
+  resetcursor(self, 1);
+  return NULL;
+}
+
+/* Prepares statements and binds bindings (borrowed) ready for the
+   first step, running the exec tracer.  Returns non-zero with an
+   exception set on error. */
+static int
+APSWCursor_prepare_execute(APSWCursor *self, PyObject *statements, PyObject *bindings, APSWStatementOptions *options)
+{
+  self->bindings = bindings;
+
+  if (self->bindings)
+  {
+    if (APSWCursor_is_dict_binding(self->bindings) || Py_Is(self->bindings, apsw_cursor_null_bindings))
+      Py_INCREF(self->bindings);
+    else
+    {
+      self->bindings = PySequence_Fast(self->bindings, "You must supply a dict or a sequence for execute");
+      if (!self->bindings)
+        return -1;
+    }
+  }
+
+  assert(!self->statement);
+  assert(!PyErr_Occurred());
+  INUSE_CALL_ELSE(self->statement = statementcache_prepare(self->connection->stmtcache, statements, options), self->statement = NULL);
+  if (!self->statement)
+  {
+    AddTraceBackHere(__FILE__, __LINE__, "APSWCursor_execute.sqlite3_prepare_v3", "{s: O, s: O}",
+                     "Connection", self->connection,
+                     "statement", OBJ(statements));
+    return -1;
+  }
+  assert(!PyErr_Occurred());
+
+  self->bindingsoffset = 0;
+
+  if (APSWCursor_dobindings(self))
+  {
+    assert(PyErr_Occurred());
+    return -1;
+  }
+
+  if (EXECTRACE)
+  {
+    if (APSWCursor_do_exec_trace(self, 0))
+    {
+      assert(PyErr_Occurred());
+      return -1;
+    }
+  }
+
+  self->status = C_BEGIN;
+  return 0;
+}
+
 /** .. method:: execute(statements: str, bindings: Optional[Bindings] = None, *, can_cache: bool = True, prepare_flags: int = 0, explain: int = -1) -> Cursor
 
     Executes the statements using the supplied bindings.  Execution
@@ -915,7 +1341,6 @@ static PyObject *
 APSWCursor_execute(APSWCursor *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
 {
   int res;
-  int savedbindingsoffset = -1;
   int prepare_flags = 0;
   int can_cache = 1;
   int explain = -1;
@@ -944,55 +1369,13 @@ APSWCursor_execute(APSWCursor *self, PyObject *const *fast_args, Py_ssize_t fast
     ARG_OPTIONAL ARG_int(explain);
     ARG_EPILOG(NULL, Cursor_execute_USAGE, );
   }
-  self->bindings = bindings;
 
   options.can_cache = can_cache;
   options.prepare_flags = prepare_flags;
   options.explain = explain;
 
-  if (self->bindings)
-  {
-    if (APSWCursor_is_dict_binding(self->bindings) || Py_Is(self->bindings, apsw_cursor_null_bindings))
-      Py_INCREF(self->bindings);
-    else
-    {
-      self->bindings = PySequence_Fast(self->bindings, "You must supply a dict or a sequence for execute");
-      if (!self->bindings)
-        return NULL;
-    }
-  }
-
-  assert(!self->statement);
-  assert(!PyErr_Occurred());
-  INUSE_CALL(self->statement = statementcache_prepare(self->connection->stmtcache, statements, &options));
-  if (!self->statement)
-  {
-    AddTraceBackHere(__FILE__, __LINE__, "APSWCursor_execute.sqlite3_prepare_v3", "{s: O, s: O}",
-                     "Connection", self->connection,
-                     "statement", OBJ(statements));
-    return NULL;
-  }
-  assert(!PyErr_Occurred());
-
-  self->bindingsoffset = 0;
-  savedbindingsoffset = 0;
-
-  if (APSWCursor_dobindings(self))
-  {
-    assert(PyErr_Occurred());
+  if (APSWCursor_prepare_execute(self, statements, bindings, &options))
     return NULL;
-  }
-
-  if (EXECTRACE)
-  {
-    if (APSWCursor_do_exec_trace(self, savedbindingsoffset))
-    {
-      assert(PyErr_Occurred());
-      return NULL;
-    }
-  }
-
-  self->status = C_BEGIN;
 
   retval = APSWCursor_step(self);
   if (!retval)
@@ -1015,6 +1398,14 @@ APSWCursor_execute(APSWCursor *self, PyObject *const *fast_args, Py_ssize_t fast
   statements can return data.  See :meth:`~Cursor.execute` for more
   information, and the :ref:`example <example_executemany>`.
 
+  When the statements are a single statement that doesn't return data
+  (for example an ``INSERT`` without ``RETURNING``), the statement is
+  prepared once and reused for all the bindings.  The types of the
+  values in each sequence of bindings are tracked, and when they are
+  the same exact types (:class:`int`, :class:`float`, :class:`str`,
+  :class:`bytes`, or None) as previous rows then binding and execution
+  of the row are done with a single release of the GIL.
+
 */
 
 static PyObject *
@@ -1061,7 +1452,7 @@ APSWCursor_executemany(APSWCursor *self, PyObject *const *fast_args, Py_ssize_t
     return NULL;
   }
 
-  INUSE_CALL(next = PyIter_Next(self->emiter));
+  INUSE_CALL_ELSE(next = PyIter_Next(self->emiter), next = NULL);
   if (!next && PyErr_Occurred())
     return NULL;
   if (!next)
@@ -1087,7 +1478,7 @@ APSWCursor_executemany(APSWCursor *self, PyObject *const *fast_args, Py_ssize_t
   assert(!self->statement);
   assert(!PyErr_Occurred());
   assert(!self->statement);
-  INUSE_CALL(self->statement = statementcache_prepare(self->connection->stmtcache, statements, &self->emoptions));
+  INUSE_CALL_ELSE(self->statement = statementcache_prepare(self->connection->stmtcache, statements, &self->emoptions), self->statement = NULL);
   if (!self->statement)
   {
     AddTraceBackHere(__FILE__, __LINE__, "APSWCursor_executemany.sqlite3_prepare_v3", "{s: O, s: O}",
@@ -1099,12 +1490,23 @@ APSWCursor_executemany(APSWCursor *self, PyObject *const *fast_args, Py_ssize_t
 
   self->emoriginalquery = Py_NewRef(statements);
 
-  self->bindingsoffset = 0;
-  savedbindingsoffset = 0;
-
-  if (APSWCursor_dobindings(self))
+  if (self->statement->vdbestatement && !statementcache_hasmore(self->statement) && !EXECTRACE && !APSWCursor_is_dict_binding(self->bindings) && 0 == sqlite3_column_count(self->statement->vdbestatement))
   {
-    assert(PyErr_Occurred());
+    retval = APSWCursor_executemany_bulk(self);
+    if (!retval)
+    {
+      assert(PyErr_Occurred());
+      return NULL;
+    }
+    return Py_NewRef(retval);
+  }
+
+  self->bindingsoffset = 0;
+  savedbindingsoffset = 0;
+
+  if (APSWCursor_dobindings(self))
+  {
+    assert(PyErr_Occurred());
     return NULL;
   }
 
@@ -1171,6 +1573,208 @@ APSWCursor_close(APSWCursor *self, PyObject *const *fast_args, Py_ssize_t fast_n
   Py_RETURN_NONE;
 }
 
+/* Returns a new BlobView if the column is a blob, else NULL without an
+   exception set */
+static PyObject *
+APSWCursor_blob_view(APSWCursor *self, int col)
+{
+  APSWBlobView *view;
+  int coltype;
+  const void *data;
+  Py_ssize_t length;
+
+  PYSQLITE_VOID_CALL(coltype = sqlite3_column_type(self->statement->vdbestatement, col));
+  if (coltype != SQLITE_BLOB)
+    return NULL;
+  PYSQLITE_VOID_CALL((data = sqlite3_column_blob(self->statement->vdbestatement, col), length = sqlite3_column_bytes(self->statement->vdbestatement, col)));
+
+  view = (APSWBlobView *)_PyObject_New(&APSWBlobViewType);
+  if (!view)
+    return NULL;
+  view->cursor = (APSWCursor *)Py_NewRef((PyObject *)self);
+  view->generation = self->blob_view_generation;
+  /* zero length blobs are NULL */
+  view->data = data ? data : "";
+  view->length = length;
+  view->exports = 0;
+  return (PyObject *)view;
+}
+
+/* Returns a borrowed reference to the apsw.Row fields of the current
+   statement, making them if this is the first row or the statement
+   has since been reprepared */
+static PyObject *
+APSWCursor_row_fields(APSWCursor *self, int numcols)
+{
+  APSWStatement *statement = self->statement;
+  PyObject *names = NULL, *index = NULL, *name = NULL, *position = NULL;
+  int reprepares = sqlite3_stmt_status(statement->vdbestatement, SQLITE_STMTSTATUS_REPREPARE, 0);
+  int i;
+
+  if (statement->row_fields && statement->row_fields_reprepares == reprepares
+      && PyTuple_GET_SIZE(PyTuple_GET_ITEM(statement->row_fields, 0)) == numcols)
+    return statement->row_fields;
+
+  Py_CLEAR(statement->row_fields);
+
+  names = PyTuple_New(numcols);
+  index = PyDict_New();
+  if (!names || !index)
+    goto error;
+
+  for (i = 0; i < numcols; i++)
+  {
+    const char *column_name = sqlite3_column_name(statement->vdbestatement, i);
+    if (!column_name)
+    {
+      PyErr_Format(PyExc_MemoryError, "SQLite call sqlite3_column_name ran out of memory");
+      goto error;
+    }
+    name = PyUnicode_FromString(column_name);
+    position = PyLong_FromLong(i);
+    if (!name || !position)
+      goto error;
+    /* the first column with a name wins */
+    if (!PyDict_SetDefault(index, name, position))
+      goto error;
+    PyTuple_SET_ITEM(names, i, name);
+    name = NULL;
+    Py_CLEAR(position);
+  }
+
+  statement->row_fields = PyTuple_Pack(2, names, index);
+  if (!statement->row_fields)
+    goto error;
+  statement->row_fields_reprepares = reprepares;
+  Py_DECREF(names);
+  Py_DECREF(index);
+  return statement->row_fields;
+
+error:
+  Py_XDECREF(names);
+  Py_XDECREF(index);
+  Py_XDECREF(name);
+  Py_XDECREF(position);
+  return NULL;
+}
+
+/* Makes an apsw.Row with values not yet filled in */
+static APSWRow *
+APSWCursor_new_row(APSWCursor *self, int numcols)
+{
+  APSWRow *row;
+  PyObject *fields = APSWCursor_row_fields(self, numcols);
+  if (!fields)
+    return NULL;
+
+  row = PyObject_GC_NewVar(APSWRow, &APSWRowType, numcols);
+  if (!row)
+    return NULL;
+  row->fields = Py_NewRef(fields);
+  memset(row->values, 0, sizeof(PyObject *) * numcols);
+  PyObject_GC_Track(row);
+  return row;
+}
+
+/* Returns a borrowed reference to the Connection.register_converter
+   callables for each column of the current statement, or None if no
+   column has one.  They are worked out again if the statement is
+   reprepared or the converters change. */
+static PyObject *
+APSWCursor_column_converters(APSWCursor *self, int numcols)
+{
+  APSWStatement *statement = self->statement;
+  PyObject *converters = NULL, *key;
+  int reprepares = sqlite3_stmt_status(statement->vdbestatement, SQLITE_STMTSTATUS_REPREPARE, 0);
+  int i, found = 0;
+
+  if (statement->column_converters && statement->column_converters_version == self->connection->converters_version
+      && statement->column_converters_reprepares == reprepares
+      && (Py_IsNone(statement->column_converters) || PyTuple_GET_SIZE(statement->column_converters) == numcols))
+    return statement->column_converters;
+
+  Py_CLEAR(statement->column_converters);
+
+  converters = PyTuple_New(numcols);
+  if (!converters)
+    return NULL;
+
+  for (i = 0; i < numcols; i++)
+  {
+    PyObject *converter = NULL;
+    const char *decltype = sqlite3_column_decltype(statement->vdbestatement, i);
+    if (decltype)
+    {
+      key = PyUnicode_FromString(decltype);
+      if (!key)
+        goto error;
+      converter = PyDict_GetItemWithError(self->connection->converters, key);
+      Py_DECREF(key);
+      if (!converter && PyErr_Occurred())
+        goto error;
+      if (converter)
+        found = 1;
+    }
+    PyTuple_SET_ITEM(converters, i, Py_NewRef(converter ? converter : Py_None));
+  }
+
+  if (!found)
+    Py_SETREF(converters, Py_NewRef(Py_None));
+
+  statement->column_converters = converters;
+  statement->column_converters_version = self->connection->converters_version;
+  statement->column_converters_reprepares = reprepares;
+  return converters;
+
+error:
+  Py_XDECREF(converters);
+  return NULL;
+}
+
+/* Applies Connection.register_converter callables to the values of a
+   row in place.  Returns 0 on success. */
+static int
+APSWCursor_convert_values(APSWCursor *self, PyObject **values, int numcols)
+{
+  PyObject *converters = APSWCursor_column_converters(self, numcols);
+  int i;
+
+  if (!converters)
+    return -1;
+  if (Py_IsNone(converters))
+    return 0;
+
+  for (i = 0; i < numcols; i++)
+  {
+    PyObject *converter = PyTuple_GET_ITEM(converters, i), *converted;
+    if (Py_IsNone(converter) || Py_IsNone(values[i]))
+      continue;
+    converted = PyObject_CallOneArg(converter, values[i]);
+    if (!converted)
+    {
+      AddTraceBackHere(__FILE__, __LINE__, "Cursor.convert_values", "{s: i, s: O, s: O}", "column", i, "value",
+                       values[i], "converter", converter);
+      return -1;
+    }
+    Py_SETREF(values[i], converted);
+  }
+  return 0;
+}
+
+#define ROW_VALUES(row) (PyTuple_CheckExact(row) ? PySequence_Fast_ITEMS(row) : ((APSWRow *)(row))->values)
+
+/* Reads the whole current row in one GIL release, straight into a
+   tuple or apsw.Row */
+static PyObject *
+APSWCursor_whole_row(APSWCursor *self, int numcols)
+{
+  PyObject *row = self->connection->named_rows ? (PyObject *)APSWCursor_new_row(self, numcols) : PyTuple_New(numcols);
+  if (row)
+    INUSE_CALL_ELSE(row = convert_row_to_pyobject(self->statement->vdbestatement, numcols, row, ROW_VALUES(row)),
+                    Py_CLEAR(row));
+  return row;
+}
+
 /** .. method:: __next__(self: Cursor) -> Any
 
     Cursors are iterators
@@ -1182,6 +1786,7 @@ APSWCursor_next(APSWCursor *self)
   PyObject *item;
   int numcols = -1;
   int i;
+  long long convert_start = 0;
 
   CHECK_USE(NULL);
   CHECK_CURSOR_CLOSED(NULL);
@@ -1200,19 +1805,53 @@ again:
 
   self->status = C_BEGIN;
 
+  if (self->connection->profile_statements)
+    convert_start = apsw_perf_counter_ns();
+
   /* return the row of data */
   numcols = sqlite3_data_count(self->statement->vdbestatement);
-  retval = PyTuple_New(numcols);
-  if (!retval)
-    goto error;
-
-  for (i = 0; i < numcols; i++)
+  if (self->connection->whole_row_fetch && !self->blob_views)
   {
-    INUSE_CALL(item = convert_column_to_pyobject(self->statement->vdbestatement, i));
-    if (!item)
+    retval = APSWCursor_whole_row(self, numcols);
+    if (!retval)
       goto error;
-    PyTuple_SET_ITEM(retval, i, item);
   }
+  else
+  {
+    APSWRow *row = NULL;
+    if (self->connection->named_rows)
+    {
+      row = APSWCursor_new_row(self, numcols);
+      retval = (PyObject *)row;
+    }
+    else
+      retval = PyTuple_New(numcols);
+    if (!retval)
+      goto error;
+
+    for (i = 0; i < numcols; i++)
+    {
+      item = NULL;
+      if (self->blob_views)
+      {
+        item = APSWCursor_blob_view(self, i);
+        if (!item && PyErr_Occurred())
+          goto error;
+      }
+      if (!item)
+        INUSE_CALL_ELSE(item = convert_column_to_pyobject(self->statement->vdbestatement, i), item = NULL);
+      if (!item)
+        goto error;
+      if (row)
+        row->values[i] = item;
+      else
+        PyTuple_SET_ITEM(retval, i, item);
+    }
+  }
+  if (self->connection->converters && APSWCursor_convert_values(self, ROW_VALUES(retval), numcols))
+    goto error;
+  if (convert_start)
+    self->statement->convert_ns += apsw_perf_counter_ns() - convert_start;
   if (ROWTRACE)
   {
     PyObject *r2 = APSWCursor_do_row_trace(self, retval);
@@ -1360,10 +1999,18 @@ APSWCursor_get_connection(APSWCursor *self)
 static PyObject *
 APSWCursor_fetchall(APSWCursor *self)
 {
+  PyObject *res;
+  int blob_views;
+
   CHECK_USE(NULL);
   CHECK_CURSOR_CLOSED(NULL);
 
-  return PySequence_List((PyObject *)self);
+  /* views would all be stale by the time we return */
+  blob_views = self->blob_views;
+  self->blob_views = 0;
+  res = PySequence_List((PyObject *)self);
+  self->blob_views = blob_views;
+  return res;
 }
 
 /** .. method:: fetchone() -> Optional[Any]
@@ -1676,6 +2323,7 @@ APSWCursor_get(APSWCursor *self)
   PyObject *the_list = NULL, *the_row = NULL;
   PyObject *step, *item;
   int numcols, i;
+  long long convert_start = 0;
 
   CHECK_USE(NULL);
   CHECK_CURSOR_CLOSED(NULL);
@@ -1696,26 +2344,49 @@ APSWCursor_get(APSWCursor *self)
         goto error;
       Py_CLEAR(the_row);
     }
+    if (self->connection->profile_statements)
+      convert_start = apsw_perf_counter_ns();
     numcols = sqlite3_data_count(self->statement->vdbestatement);
     if (numcols == 1)
     {
-      INUSE_CALL(the_row = convert_column_to_pyobject(self->statement->vdbestatement, 0));
+      INUSE_CALL_ELSE(the_row = convert_column_to_pyobject(self->statement->vdbestatement, 0), the_row = NULL);
+      if (!the_row)
+        goto error;
+    }
+    else if (self->connection->whole_row_fetch)
+    {
+      the_row = APSWCursor_whole_row(self, numcols);
       if (!the_row)
         goto error;
     }
     else
     {
-      the_row = PyTuple_New(numcols);
+      APSWRow *row = NULL;
+      if (self->connection->named_rows)
+      {
+        row = APSWCursor_new_row(self, numcols);
+        the_row = (PyObject *)row;
+      }
+      else
+        the_row = PyTuple_New(numcols);
       if (!the_row)
         goto error;
       for (i = 0; i < numcols; i++)
       {
-        INUSE_CALL(item = convert_column_to_pyobject(self->statement->vdbestatement, i));
+        INUSE_CALL_ELSE(item = convert_column_to_pyobject(self->statement->vdbestatement, i), item = NULL);
         if (!item)
           goto error;
-        PyTuple_SET_ITEM(the_row, i, item);
+        if (row)
+          row->values[i] = item;
+        else
+          PyTuple_SET_ITEM(the_row, i, item);
       }
     }
+    if (self->connection->converters
+        && APSWCursor_convert_values(self, (numcols == 1) ? &the_row : ROW_VALUES(the_row), numcols))
+      goto error;
+    if (convert_start)
+      self->statement->convert_ns += apsw_perf_counter_ns() - convert_start;
     if (the_list)
     {
       if (0 != PyList_Append(the_list, the_row))
@@ -1739,6 +2410,455 @@ error:
   return NULL;
 }
 
+/* Accumulates one result column for fetchmany_columns.  Values are
+   kept in native form while a batch is gathered without the GIL, and
+   turned into the Python result afterwards.  A column whose values
+   are all the same type (ignoring nulls) is returned as buffers,
+   otherwise as a list of Python objects. */
+
+typedef struct ColumnBatch
+{
+  int types_seen;         /* bitmask of 1 << SQLite type for each non-null value */
+  unsigned char *types;   /* SQLite type of each row */
+  size_t types_alloc;     /* bytes allocated for types */
+  char *fixed;            /* int64/double of each row (zero for other types), once one is seen */
+  size_t fixed_alloc;     /* bytes allocated for fixed */
+  char *var;              /* concatenated text/blob bytes */
+  size_t var_len;         /* bytes used in var */
+  size_t var_alloc;       /* bytes allocated for var */
+  sqlite3_int64 *offsets; /* text/blob start of each row in var with rows + 1 entries, once one is seen */
+  size_t offsets_alloc;   /* bytes allocated for offsets */
+  unsigned char *valid;   /* bitmap with bit set for each non-null row */
+  size_t valid_alloc;     /* bytes allocated for valid */
+  Py_ssize_t null_count;  /* how many rows were null */
+} ColumnBatch;
+
+/* ensures at least needed bytes are available, zero filling new
+   memory.  Does not need the GIL, returning -1 on out of memory */
+static int
+columnbatch_reserve(void **buffer, size_t *allocated, size_t needed)
+{
+  size_t newsize;
+  void *newbuffer;
+
+  if (needed <= *allocated)
+    return 0;
+
+  newsize = Py_MAX(needed, Py_MAX(*allocated * 2, 256));
+  newbuffer = PyMem_RawRealloc(*buffer, newsize);
+  if (!newbuffer)
+    return -1;
+  memset((char *)newbuffer + *allocated, 0, newsize - *allocated);
+  *buffer = newbuffer;
+  *allocated = newsize;
+  return 0;
+}
+
+static void
+columnbatch_free(ColumnBatch *cb)
+{
+  PyMem_RawFree(cb->types);
+  PyMem_RawFree(cb->fixed);
+  PyMem_RawFree(cb->var);
+  PyMem_RawFree(cb->offsets);
+  PyMem_RawFree(cb->valid);
+}
+
+/* adds the value of column col in the current row of stmt as row
+   number row.  Called without the GIL, returning -1 on out of memory */
+static int
+columnbatch_add(ColumnBatch *cb, Py_ssize_t row, sqlite3_stmt *stmt, int col)
+{
+  int coltype = sqlite3_column_type(stmt, col);
+
+  if (columnbatch_reserve((void **)&cb->valid, &cb->valid_alloc, row / 8 + 1)
+      || columnbatch_reserve((void **)&cb->types, &cb->types_alloc, row + 1))
+    return -1;
+
+  if (coltype == SQLITE_INTEGER || coltype == SQLITE_FLOAT || cb->fixed)
+    if (columnbatch_reserve((void **)&cb->fixed, &cb->fixed_alloc, (row + 1) * 8))
+      return -1;
+  if (coltype == SQLITE_TEXT || coltype == SQLITE_BLOB || cb->offsets)
+    if (columnbatch_reserve((void **)&cb->offsets, &cb->offsets_alloc, (row + 2) * sizeof(sqlite3_int64)))
+      return -1;
+
+  cb->types[row] = (unsigned char)coltype;
+  if (coltype == SQLITE_NULL)
+    cb->null_count++;
+  else
+  {
+    cb->valid[row / 8] |= 1 << (row % 8);
+    cb->types_seen |= 1 << coltype;
+  }
+
+  switch (coltype)
+  {
+  case SQLITE_INTEGER:
+  {
+    sqlite3_int64 ival = sqlite3_column_int64(stmt, col);
+    memcpy(cb->fixed + row * 8, &ival, 8);
+    break;
+  }
+  case SQLITE_FLOAT:
+  {
+    double dval = sqlite3_column_double(stmt, col);
+    memcpy(cb->fixed + row * 8, &dval, 8);
+    break;
+  }
+  case SQLITE_TEXT:
+  case SQLITE_BLOB:
+  {
+    const void *ptr = (coltype == SQLITE_TEXT) ? (const void *)sqlite3_column_text(stmt, col) : sqlite3_column_blob(stmt, col);
+    size_t len = sqlite3_column_bytes(stmt, col);
+    if (columnbatch_reserve((void **)&cb->var, &cb->var_alloc, cb->var_len + len))
+      return -1;
+    if (len)
+      memcpy(cb->var + cb->var_len, ptr, len);
+    cb->var_len += len;
+    break;
+  }
+  }
+
+  if (cb->offsets)
+    cb->offsets[row + 1] = cb->var_len;
+  return 0;
+}
+
+/* Gathers rows into columns starting with the current row, stepping
+   between them, until size rows are held or a step doesn't return a
+   row.  Called with the database mutex held and the GIL released.
+   Returns SQLITE_ROW when size was reached leaving the statement on
+   the last row gathered, else what sqlite3_step returned.  *nomem is
+   set if memory could not be allocated. */
+static int
+columnbatch_collect(ColumnBatch *columns, int ncols, Py_ssize_t *rows, Py_ssize_t size, APSWStatement *statement,
+                    int profile, int *nomem)
+{
+  sqlite3_stmt *stmt = statement->vdbestatement;
+  int i, res;
+
+  for (;;)
+  {
+    for (i = 0; i < ncols; i++)
+      if (columnbatch_add(&columns[i], *rows, stmt, i))
+      {
+        *nomem = 1;
+        return SQLITE_ROW;
+      }
+    (*rows)++;
+    if (*rows == size)
+      return SQLITE_ROW;
+
+    if (profile)
+    {
+      long long start = apsw_perf_counter_ns();
+      res = sqlite3_step(stmt);
+      statement->step_ns += apsw_perf_counter_ns() - start;
+      if (res == SQLITE_ROW)
+        statement->rows++;
+    }
+    else
+      res = sqlite3_step(stmt);
+    if (res != SQLITE_ROW)
+      return res;
+  }
+}
+
+/* the values of a column that has more than one type as a list */
+static PyObject *
+columnbatch_objects(ColumnBatch *cb, Py_ssize_t rows)
+{
+  Py_ssize_t i;
+  PyObject *list, *item;
+
+  list = PyList_New(rows);
+  if (!list)
+    return NULL;
+
+  for (i = 0; i < rows; i++)
+  {
+    switch (cb->types[i])
+    {
+    case SQLITE_INTEGER:
+      item = PyLong_FromLongLong(((sqlite3_int64 *)cb->fixed)[i]);
+      break;
+    case SQLITE_FLOAT:
+      item = PyFloat_FromDouble(((double *)cb->fixed)[i]);
+      break;
+    case SQLITE_TEXT:
+      item = PyUnicode_FromStringAndSize(cb->var + cb->offsets[i], cb->offsets[i + 1] - cb->offsets[i]);
+      break;
+    case SQLITE_BLOB:
+      item = PyBytes_FromStringAndSize(cb->var + cb->offsets[i], cb->offsets[i + 1] - cb->offsets[i]);
+      break;
+    default:
+      item = Py_NewRef(Py_None);
+    }
+    if (!item)
+    {
+      Py_DECREF(list);
+      return NULL;
+    }
+    PyList_SET_ITEM(list, i, item);
+  }
+  return list;
+}
+
+static PyObject *
+columnbatch_result(ColumnBatch *cb, PyObject *name, Py_ssize_t rows)
+{
+  const char *typename;
+  PyObject *values = NULL, *offsets = NULL, *valid = NULL, *res = NULL;
+
+  switch (cb->types_seen)
+  {
+  case 0:
+    typename = "null";
+    values = Py_NewRef(Py_None);
+    break;
+  case 1 << SQLITE_INTEGER:
+    typename = "int";
+    values = array_from_memory("q", cb->fixed, rows * 8);
+    break;
+  case 1 << SQLITE_FLOAT:
+    typename = "float";
+    values = array_from_memory("d", cb->fixed, rows * 8);
+    break;
+  case 1 << SQLITE_TEXT:
+  case 1 << SQLITE_BLOB:
+    typename = (cb->types_seen == 1 << SQLITE_TEXT) ? "str" : "bytes";
+    values = PyBytes_FromStringAndSize(cb->var, cb->var_len);
+    if (values)
+      offsets = array_from_memory("q", cb->offsets, (rows + 1) * sizeof(sqlite3_int64));
+    break;
+  default:
+    typename = "object";
+    values = columnbatch_objects(cb, rows);
+    break;
+  }
+  if (!values || (!offsets && PyErr_Occurred()))
+    goto finally;
+
+  valid = PyBytes_FromStringAndSize((const char *)cb->valid, (rows + 7) / 8);
+  if (!valid)
+    goto finally;
+
+  res = Py_BuildValue("{s: O, s: s, s: n, s: n, s: O, s: O, s: O}",
+                      "name", name,
+                      "type", typename,
+                      "rows", rows,
+                      "null_count", cb->null_count,
+                      "valid", valid,
+                      "values", values,
+                      "offsets", offsets ? offsets : Py_None);
+finally:
+  Py_XDECREF(values);
+  Py_XDECREF(offsets);
+  Py_XDECREF(valid);
+  return res;
+}
+
+/** .. method:: fetchmany_columns(size: int = 1024) -> tuple[dict[str, Any], ...] | None
+
+  Returns up to *size* result rows laid out by column instead of by
+  row, or None if there are no more rows.  No per row tuples are
+  created, and integers and floats are not converted into Python
+  objects, making this considerably faster for large result sets.
+  The rows of each statement are gathered in one release of the GIL
+  into native memory, which is then copied once into the returned
+  buffers.  The buffers are in the layout used by `Apache Arrow
+  <https://arrow.apache.org/docs/format/Columnar.html>`__ so
+  libraries like numpy and pyarrow can use them without further
+  copying.
+
+  Rows are gathered until *size* is reached, the results are
+  exhausted, or the next row has a different number of columns
+  (such as the next of multiple statements) which is left for the
+  next call.
+
+  A tuple is returned with a dict for each column containing:
+
+  .. list-table::
+    :header-rows: 1
+    :widths: auto
+
+    * - Key
+      - Value
+    * - name
+      - Column name
+    * - type
+      - ``int``, ``float``, ``str``, ``bytes``, ``null`` if every row
+        is null, or ``object`` if rows have values of different types
+    * - rows
+      - Number of rows
+    * - null_count
+      - How many rows are null
+    * - valid
+      - :class:`bytes` bitmap with the bit set (least significant bit
+        first) for each row that is not null
+    * - values
+      - ``int`` and ``float`` are :class:`array.array` of typecode
+        ``q`` and ``d`` with zero for null rows.  ``str`` and
+        ``bytes`` are :class:`bytes` of the concatenated values, with
+        text in UTF-8.  ``object`` is a :class:`list` of the values.
+        ``null`` is None.
+    * - offsets
+      - For ``str`` and ``bytes`` an :class:`array.array` of typecode
+        ``q`` with rows + 1 entries.  A row's value is
+        ``values[offsets[row]:offsets[row+1]]``.  None for other types.
+
+  Row tracers are not called when using this method.
+
+  -* sqlite3_column_type sqlite3_column_int64 sqlite3_column_double sqlite3_column_text sqlite3_column_blob sqlite3_column_bytes
+*/
+static PyObject *
+APSWCursor_fetchmany_columns(APSWCursor *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  int size = 1024;
+  int ncols = 0, i;
+  Py_ssize_t rows = 0;
+  ColumnBatch *columns = NULL;
+  PyObject *names = NULL, *res = NULL;
+
+  CHECK_USE(NULL);
+  CHECK_CURSOR_CLOSED(NULL);
+
+  {
+    Cursor_fetchmany_columns_CHECK;
+    ARG_PROLOG(1, Cursor_fetchmany_columns_KWNAMES);
+    ARG_OPTIONAL ARG_int(size);
+    ARG_EPILOG(NULL, Cursor_fetchmany_columns_USAGE, );
+  }
+
+  if (size < 1)
+    return PyErr_Format(PyExc_ValueError, "size must be at least 1, not %d", size);
+
+  if (self->status == C_BEGIN)
+    if (!APSWCursor_step(self))
+    {
+      assert(PyErr_Occurred());
+      return NULL;
+    }
+  if (self->status == C_DONE)
+    Py_RETURN_NONE;
+
+  assert(self->status == C_ROW);
+
+  ncols = sqlite3_data_count(self->statement->vdbestatement);
+  names = PyTuple_New(ncols);
+  if (!names)
+    goto error;
+  for (i = 0; i < ncols; i++)
+  {
+    const char *column_name = sqlite3_column_name(self->statement->vdbestatement, i);
+    if (!column_name)
+    {
+      PyErr_Format(PyExc_MemoryError, "SQLite call sqlite3_column_name ran out of memory");
+      goto error;
+    }
+    PyObject *name = PyUnicode_FromString(column_name);
+    if (!name)
+      goto error;
+    PyTuple_SET_ITEM(names, i, name);
+  }
+
+  columns = PyMem_Calloc(Py_MAX(ncols, 1), sizeof(ColumnBatch));
+  if (!columns)
+  {
+    PyErr_NoMemory();
+    goto error;
+  }
+  /* each statement's rows are gathered in one release of the GIL */
+  for (;;)
+  {
+    int res = SQLITE_ROW, nomem = 0;
+
+    if (APSWCursor_invalidate_blob_views(self))
+      goto error;
+    PYSQLITE_CUR_CALL(res = columnbatch_collect(columns, ncols, &rows, size, self->statement,
+                                                self->connection->profile_statements, &nomem));
+    if (PyErr_Occurred())
+      goto error;
+    if (nomem)
+    {
+      PyErr_NoMemory();
+      goto error;
+    }
+    self->status = C_BEGIN;
+
+    if (res == SQLITE_ROW)
+      break;
+    if (!APSWCursor_step_from(self, res))
+      goto error;
+    if (self->status != C_ROW || sqlite3_data_count(self->statement->vdbestatement) != ncols)
+      break;
+  }
+
+  res = PyTuple_New(ncols);
+  if (!res)
+    goto error;
+  for (i = 0; i < ncols; i++)
+  {
+    PyObject *column = columnbatch_result(&columns[i], PyTuple_GET_ITEM(names, i), rows);
+    if (!column)
+      goto error;
+    PyTuple_SET_ITEM(res, i, column);
+  }
+
+  goto finally;
+
+error:
+  assert(PyErr_Occurred());
+  Py_CLEAR(res);
+
+finally:
+  if (columns)
+  {
+    for (i = 0; i < ncols; i++)
+      columnbatch_free(&columns[i]);
+    PyMem_Free(columns);
+  }
+  Py_XDECREF(names);
+  return res;
+}
+
+/** .. attribute:: blob_views
+  :type: bool
+
+  When True, blob values in rows are returned as :class:`BlobView`
+  which points directly at SQLite's memory for the value instead of
+  copying it into :class:`bytes`.  The views of a row become invalid
+  when the cursor moves on to the next row, so this is for iterating
+  over the cursor.  :meth:`fetchall` and :attr:`get` still return
+  :class:`bytes`.
+
+  This is useful when handing large blobs to code such as hashing and
+  compression that accepts a buffer.
+*/
+static PyObject *
+APSWCursor_get_blob_views(APSWCursor *self)
+{
+  CHECK_USE(NULL);
+  CHECK_CURSOR_CLOSED(NULL);
+
+  return Py_NewRef(self->blob_views ? Py_True : Py_False);
+}
+
+static int
+APSWCursor_set_blob_views(APSWCursor *self, PyObject *value)
+{
+  CHECK_USE(-1);
+  CHECK_CURSOR_CLOSED(-1);
+
+  if (!PyBool_Check(value))
+  {
+    PyErr_Format(PyExc_TypeError, "Expected a bool, not %s", Py_TypeName(value));
+    return -1;
+  }
+  self->blob_views = Py_IsTrue(value);
+  return 0;
+}
+
 static PyObject *
 APSWCursor_tp_str(APSWCursor *self)
 {
@@ -1770,6 +2890,8 @@ static PyMethodDef APSWCursor_methods[] = {
      Cursor_fetchall_DOC},
     {"fetchone", (PyCFunction)APSWCursor_fetchone, METH_NOARGS,
      Cursor_fetchone_DOC},
+    {"fetchmany_columns", (PyCFunction)APSWCursor_fetchmany_columns, METH_FASTCALL | METH_KEYWORDS,
+     Cursor_fetchmany_columns_DOC},
 #ifndef APSW_OMIT_OLD_NAMES
     {Cursor_set_exec_trace_OLDNAME, (PyCFunction)APSWCursor_set_exec_trace, METH_FASTCALL | METH_KEYWORDS,
      Cursor_set_exec_trace_OLDDOC},
@@ -1804,6 +2926,7 @@ static PyGetSetDef APSWCursor_getset[] = {
     {Cursor_row_trace_OLDNAME, (getter)APSWCursor_get_row_trace_attr, (setter)APSWCursor_set_row_trace_attr, Cursor_row_trace_OLDDOC},
     {"connection", (getter)APSWCursor_get_connection_attr, NULL, Cursor_connection_DOC},
     {"get", (getter)APSWCursor_get, NULL, Cursor_get_DOC},
+    {"blob_views", (getter)APSWCursor_get_blob_views, (setter)APSWCursor_set_blob_views, Cursor_blob_views_DOC},
     {NULL, NULL, NULL, NULL, NULL}};
 
 static PyTypeObject APSWCursorType = {
@@ -1823,3 +2946,418 @@ static PyTypeObject APSWCursorType = {
     .tp_new = APSWCursor_new,
     .tp_str = (reprfunc)APSWCursor_tp_str,
 };
+
+/** .. class:: BlobView
+
+  A read only view of a blob value in the current row of a
+  :class:`Cursor`, returned instead of :class:`bytes` when
+  :attr:`Cursor.blob_views` is True.  It supports the buffer protocol
+  so it can be passed to :class:`memoryview`, :mod:`hashlib`,
+  :mod:`zlib`, file writes etc without any copying.
+
+  The memory belongs to SQLite and is only valid until the cursor
+  moves to another row.  After that any access raises
+  :exc:`ValueError`.  The cursor won't move or be closed while there
+  are exported buffers (for example a :class:`memoryview` that hasn't
+  been released) and raises :exc:`BufferError`.  That includes closing
+  with force, and :meth:`Connection.close` with force which closes
+  the cursor.
+*/
+
+#define CHECK_BLOB_VIEW(e)                                                                     \
+  do                                                                                           \
+  {                                                                                            \
+    if (!APSWBlobView_is_current(self))                                                        \
+    {                                                                                          \
+      PyErr_Format(PyExc_ValueError, "BlobView is out of scope (the cursor has moved on)");    \
+      return e;                                                                                \
+    }                                                                                          \
+  } while (0)
+
+static int
+APSWBlobView_is_current(APSWBlobView *self)
+{
+  return self->generation == self->cursor->blob_view_generation;
+}
+
+static void
+APSWBlobView_dealloc(APSWBlobView *self)
+{
+  assert(self->exports == 0);
+  Py_CLEAR(self->cursor);
+  Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static int
+APSWBlobView_getbuffer(APSWBlobView *self, Py_buffer *view, int flags)
+{
+  CHECK_BLOB_VIEW(-1);
+
+  if (PyBuffer_FillInfo(view, (PyObject *)self, (void *)self->data, self->length, 1, flags))
+    return -1;
+  self->exports++;
+  self->cursor->blob_view_exports++;
+  return 0;
+}
+
+static void
+APSWBlobView_releasebuffer(APSWBlobView *self, Py_buffer *Py_UNUSED(view))
+{
+  assert(self->exports > 0);
+  self->exports--;
+  if (APSWBlobView_is_current(self))
+    self->cursor->blob_view_exports--;
+}
+
+/** .. method:: __len__() -> int
+
+  Size of the blob in bytes
+*/
+static Py_ssize_t
+APSWBlobView_len(APSWBlobView *self)
+{
+  return self->length;
+}
+
+/** .. method:: tobytes() -> bytes
+
+  Returns a copy of the value
+*/
+static PyObject *
+APSWBlobView_tobytes(APSWBlobView *self)
+{
+  CHECK_BLOB_VIEW(NULL);
+
+  return PyBytes_FromStringAndSize(self->data, self->length);
+}
+
+/** .. attribute:: valid
+  :type: bool
+
+  False once the cursor has moved on from the row this value
+  was in.
+*/
+static PyObject *
+APSWBlobView_valid(APSWBlobView *self)
+{
+  return Py_NewRef(APSWBlobView_is_current(self) ? Py_True : Py_False);
+}
+
+static PyObject *
+APSWBlobView_tp_str(APSWBlobView *self)
+{
+  return PyUnicode_FromFormat("<apsw.BlobView %zd bytes%s at %p>", self->length,
+                              APSWBlobView_is_current(self) ? "" : " (out of scope)", self);
+}
+
+static PyBufferProcs APSWBlobView_as_buffer = {
+    .bf_getbuffer = (getbufferproc)APSWBlobView_getbuffer,
+    .bf_releasebuffer = (releasebufferproc)APSWBlobView_releasebuffer,
+};
+
+static PySequenceMethods APSWBlobView_as_sequence = {
+    .sq_length = (lenfunc)APSWBlobView_len,
+};
+
+static PyMethodDef APSWBlobView_methods[] = {
+    {"tobytes", (PyCFunction)APSWBlobView_tobytes, METH_NOARGS, BlobView_tobytes_DOC},
+    {0, 0, 0, 0}};
+
+static PyGetSetDef APSWBlobView_getset[] = {
+    {"valid", (getter)APSWBlobView_valid, NULL, BlobView_valid_DOC, NULL},
+    {NULL, NULL, NULL, NULL, NULL}};
+
+static PyTypeObject APSWBlobViewType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "apsw.BlobView",
+    .tp_basicsize = sizeof(APSWBlobView),
+    .tp_dealloc = (destructor)APSWBlobView_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = BlobView_class_DOC,
+    .tp_as_buffer = &APSWBlobView_as_buffer,
+    .tp_as_sequence = &APSWBlobView_as_sequence,
+    .tp_methods = APSWBlobView_methods,
+    .tp_getset = APSWBlobView_getset,
+    .tp_str = (reprfunc)APSWBlobView_tp_str,
+};
+
+/** .. class:: Row
+
+  A result row returned instead of :class:`tuple` when
+  :attr:`Connection.named_rows` is True.  It behaves like a tuple of
+  the values (indexing, slicing, iteration, length, comparison with
+  tuples, hashing) and values can also be accessed by column name,
+  either as an attribute ``row.name`` or a key ``row["name"]``.  If
+  more than one column has the same name then the first is used.
+
+  The column names come from `sqlite3_column_name
+  <https://sqlite.org/c3ref/column_name.html>`__ and are worked out
+  once per prepared statement, shared by all its rows.  Column names
+  take precedence over the attributes and methods below, which
+  follow :func:`collections.namedtuple` naming.
+
+  .. code-block:: python
+
+    connection.named_rows = True
+    for row in connection.execute("select id, title from items"):
+        print(row.id, row["title"], row[1])
+*/
+
+#define ROW_NAMES(self) PyTuple_GET_ITEM((self)->fields, 0)
+#define ROW_INDEX(self) PyTuple_GET_ITEM((self)->fields, 1)
+
+static void
+APSWRow_dealloc(APSWRow *self)
+{
+  Py_ssize_t i;
+  PyObject_GC_UnTrack(self);
+  for (i = 0; i < Py_SIZE(self); i++)
+    Py_XDECREF(self->values[i]);
+  Py_XDECREF(self->fields);
+  Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+/* converters can return any object, so values can be part of cycles */
+static int
+APSWRow_tp_traverse(APSWRow *self, visitproc visit, void *arg)
+{
+  Py_ssize_t i;
+  for (i = 0; i < Py_SIZE(self); i++)
+    Py_VISIT(self->values[i]);
+  Py_VISIT(self->fields);
+  return 0;
+}
+
+/* values become None rather than NULL so the row stays usable.  fields
+   only holds names and indices so it can't be part of a cycle */
+static int
+APSWRow_tp_clear(APSWRow *self)
+{
+  Py_ssize_t i;
+  for (i = 0; i < Py_SIZE(self); i++)
+    if (self->values[i])
+      Py_SETREF(self->values[i], Py_NewRef(Py_None));
+  return 0;
+}
+
+static PyObject *
+APSWRow_as_tuple(APSWRow *self)
+{
+  Py_ssize_t i;
+  PyObject *tuple = PyTuple_New(Py_SIZE(self));
+  if (tuple)
+    for (i = 0; i < Py_SIZE(self); i++)
+      PyTuple_SET_ITEM(tuple, i, Py_NewRef(self->values[i]));
+  return tuple;
+}
+
+/** .. method:: __len__() -> int
+
+  Number of columns
+*/
+static Py_ssize_t
+APSWRow_len(APSWRow *self)
+{
+  return Py_SIZE(self);
+}
+
+static PyObject *
+APSWRow_item(APSWRow *self, Py_ssize_t i)
+{
+  if (i < 0 || i >= Py_SIZE(self))
+  {
+    PyErr_Format(PyExc_IndexError, "Row index out of range");
+    return NULL;
+  }
+  return Py_NewRef(self->values[i]);
+}
+
+/** .. method:: __getitem__(key: int | slice | str) -> SQLiteValue | tuple[SQLiteValue, ...]
+
+  Returns the value at an index, a :class:`tuple` of values for a
+  slice, or the value for a column name.  Unknown column names raise
+  :exc:`KeyError`.
+*/
+static PyObject *
+APSWRow_getitem(APSWRow *self, PyObject *key)
+{
+  if (PyUnicode_Check(key))
+  {
+    PyObject *position = PyDict_GetItemWithError(ROW_INDEX(self), key);
+    if (!position)
+    {
+      if (!PyErr_Occurred())
+        PyErr_SetObject(PyExc_KeyError, key);
+      return NULL;
+    }
+    return Py_NewRef(self->values[PyLong_AsSsize_t(position)]);
+  }
+  if (PySlice_Check(key))
+  {
+    PyObject *tuple = APSWRow_as_tuple(self), *res;
+    if (!tuple)
+      return NULL;
+    res = PyObject_GetItem(tuple, key);
+    Py_DECREF(tuple);
+    return res;
+  }
+  if (PyIndex_Check(key))
+  {
+    Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+    if (i == -1 && PyErr_Occurred())
+      return NULL;
+    if (i < 0)
+      i += Py_SIZE(self);
+    return APSWRow_item(self, i);
+  }
+  PyErr_Format(PyExc_TypeError, "Row indices must be integers, slices, or str, not %s", Py_TypeName(key));
+  return NULL;
+}
+
+/** .. method:: __getattr__(name: str) -> SQLiteValue
+
+  Returns the value for a column name
+*/
+static PyObject *
+APSWRow_getattro(APSWRow *self, PyObject *name)
+{
+  if (PyUnicode_Check(name))
+  {
+    PyObject *position = PyDict_GetItemWithError(ROW_INDEX(self), name);
+    if (position)
+      return Py_NewRef(self->values[PyLong_AsSsize_t(position)]);
+    if (PyErr_Occurred())
+      return NULL;
+  }
+  return PyObject_GenericGetAttr((PyObject *)self, name);
+}
+
+/** .. method:: _asdict() -> dict[str, SQLiteValue]
+
+  Returns a new :class:`dict` of column names to values
+*/
+static PyObject *
+APSWRow_asdict(APSWRow *self)
+{
+  Py_ssize_t i;
+  PyObject *names = ROW_NAMES(self);
+  PyObject *dict = PyDict_New();
+  if (!dict)
+    return NULL;
+  for (i = 0; i < Py_SIZE(self); i++)
+    if (!PyDict_SetDefault(dict, PyTuple_GET_ITEM(names, i), self->values[i]))
+    {
+      Py_DECREF(dict);
+      return NULL;
+    }
+  return dict;
+}
+
+/** .. attribute:: _fields
+  :type: tuple[str, ...]
+
+  The column names
+*/
+static PyObject *
+APSWRow_fields(APSWRow *self)
+{
+  return Py_NewRef(ROW_NAMES(self));
+}
+
+static PyObject *
+APSWRow_richcompare(APSWRow *self, PyObject *other, int op)
+{
+  PyObject *left = NULL, *right = NULL, *res = NULL;
+
+  if (!PyTuple_Check(other) && !PyObject_TypeCheck(other, &APSWRowType))
+    Py_RETURN_NOTIMPLEMENTED;
+
+  left = APSWRow_as_tuple(self);
+  right = PyTuple_Check(other) ? Py_NewRef(other) : APSWRow_as_tuple((APSWRow *)other);
+  if (left && right)
+    res = PyObject_RichCompare(left, right, op);
+  Py_XDECREF(left);
+  Py_XDECREF(right);
+  return res;
+}
+
+static Py_hash_t
+APSWRow_hash(APSWRow *self)
+{
+  Py_hash_t res;
+  PyObject *tuple = APSWRow_as_tuple(self);
+  if (!tuple)
+    return -1;
+  res = PyObject_Hash(tuple);
+  Py_DECREF(tuple);
+  return res;
+}
+
+static PyObject *
+APSWRow_tp_repr(APSWRow *self)
+{
+  Py_ssize_t i;
+  PyObject *names = ROW_NAMES(self);
+  PyObject *items = NULL, *sep = NULL, *joined = NULL, *res = NULL;
+
+  items = PyList_New(Py_SIZE(self));
+  if (!items)
+    goto finally;
+  for (i = 0; i < Py_SIZE(self); i++)
+  {
+    PyObject *item = PyUnicode_FromFormat("%U=%R", PyTuple_GET_ITEM(names, i), self->values[i]);
+    if (!item)
+      goto finally;
+    PyList_SET_ITEM(items, i, item);
+  }
+  sep = PyUnicode_FromString(", ");
+  if (!sep)
+    goto finally;
+  joined = PyUnicode_Join(sep, items);
+  if (joined)
+    res = PyUnicode_FromFormat("Row(%U)", joined);
+
+finally:
+  Py_XDECREF(items);
+  Py_XDECREF(sep);
+  Py_XDECREF(joined);
+  return res;
+}
+
+static PySequenceMethods APSWRow_as_sequence = {
+    .sq_length = (lenfunc)APSWRow_len,
+    .sq_item = (ssizeargfunc)APSWRow_item,
+};
+
+static PyMappingMethods APSWRow_as_mapping = {
+    .mp_length = (lenfunc)APSWRow_len,
+    .mp_subscript = (binaryfunc)APSWRow_getitem,
+};
+
+static PyMethodDef APSWRow_methods[] = {
+    {"_asdict", (PyCFunction)APSWRow_asdict, METH_NOARGS, Row_asdict_DOC},
+    {0, 0, 0, 0}};
+
+static PyGetSetDef APSWRow_getset[] = {
+    {"_fields", (getter)APSWRow_fields, NULL, Row_fields_DOC, NULL},
+    {NULL, NULL, NULL, NULL, NULL}};
+
+static PyTypeObject APSWRowType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "apsw.Row",
+    .tp_basicsize = offsetof(APSWRow, values),
+    .tp_itemsize = sizeof(PyObject *),
+    .tp_dealloc = (destructor)APSWRow_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_doc = Row_class_DOC,
+    .tp_traverse = (traverseproc)APSWRow_tp_traverse,
+    .tp_clear = (inquiry)APSWRow_tp_clear,
+    .tp_as_sequence = &APSWRow_as_sequence,
+    .tp_as_mapping = &APSWRow_as_mapping,
+    .tp_getattro = (getattrofunc)APSWRow_getattro,
+    .tp_richcompare = (richcmpfunc)APSWRow_richcompare,
+    .tp_hash = (hashfunc)APSWRow_hash,
+    .tp_methods = APSWRow_methods,
+    .tp_getset = APSWRow_getset,
+    .tp_repr = (reprfunc)APSWRow_tp_repr,
+};
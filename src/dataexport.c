@@ -0,0 +1,557 @@
+/*
+  Writing query results as SQL, CSV, or JSON lines, behind
+  Connection.export_query.
+
+  The calling thread steps the query and formats each row straight
+  from the SQLite column values into one of two buffers, while a
+  writer thread writes out the other.  Neither holds the GIL.
+*/
+
+#define DATAEXPORT_CHUNK_SIZE (1024 * 1024)
+
+typedef enum
+{
+  DATAEXPORT_SQL,
+  DATAEXPORT_CSV,
+  DATAEXPORT_JSONL
+} DataExportFormat;
+
+typedef struct DataExportBuffer
+{
+  char *data;
+  size_t length;
+  size_t size;
+} DataExportBuffer;
+
+typedef struct DataExport
+{
+  /* configuration */
+  sqlite3 *db;
+  FILE *file;
+  const char *query;
+  const char *table;
+  DataExportFormat format;
+  char separator;
+  int quoting;
+  int header;
+
+  /* writer thread, which writes out the buffer that isn't current */
+  DataExportBuffer buffers[2];
+  int current;
+  int pending;               /* which buffer the writer should write */
+  int write_errno;           /* non-zero if writing failed */
+  int stop;                  /* set to make the writer exit */
+  PyThread_type_lock full;   /* released to give the writer a buffer */
+  PyThread_type_lock idle;   /* released by the writer when it has written a buffer */
+  PyThread_type_lock done;   /* released by the writer when it exits */
+
+  sqlite3_stmt *stmt;
+  int ncols;
+  /* the text before each row (sql), or each column name already
+     formatted as a JSON key (jsonl) */
+  DataExportBuffer prefix;
+  size_t *key_offsets;
+  sqlite3_int64 rows;
+
+  /* errors */
+  char *errmsg;      /* SQLite error message from sqlite3_mprintf */
+  char message[256]; /* problem with the query, empty if none */
+} DataExport;
+
+static void
+dataexport_writer_thread(void *arg)
+{
+  DataExport *exp = (DataExport *)arg;
+
+  for (;;)
+  {
+    PyThread_acquire_lock(exp->full, WAIT_LOCK);
+    if (exp->stop)
+      break;
+    if (!exp->write_errno)
+    {
+      DataExportBuffer *buffer = &exp->buffers[exp->pending];
+      if (fwrite(buffer->data, 1, buffer->length, exp->file) != buffer->length)
+        exp->write_errno = errno ? errno : EIO;
+    }
+    PyThread_release_lock(exp->idle);
+  }
+  PyThread_release_lock(exp->done);
+}
+
+/* Records the SQLite error message, returning res */
+static int
+dataexport_error(DataExport *exp, int res)
+{
+  if (!exp->errmsg)
+    exp->errmsg = sqlite3_mprintf("%s", sqlite3_errmsg(exp->db));
+  return res;
+}
+
+/* Makes room for at least amount more bytes, returning where they go */
+static char *
+dataexport_reserve(DataExportBuffer *buffer, size_t amount)
+{
+  if (buffer->length + amount > buffer->size)
+  {
+    size_t size = buffer->length + amount + DATAEXPORT_CHUNK_SIZE;
+    char *data = sqlite3_realloc64(buffer->data, size);
+    if (!data)
+      return NULL;
+    buffer->data = data;
+    buffer->size = size;
+  }
+  return buffer->data + buffer->length;
+}
+
+/* Waits for the writer to finish the previous buffer, and hands it
+   the current one */
+static int
+dataexport_submit(DataExport *exp)
+{
+  PyThread_acquire_lock(exp->idle, WAIT_LOCK);
+  if (exp->write_errno)
+  {
+    PyThread_release_lock(exp->idle);
+    return SQLITE_IOERR;
+  }
+  exp->pending = exp->current;
+  exp->current = !exp->current;
+  exp->buffers[exp->current].length = 0;
+  PyThread_release_lock(exp->full);
+  return SQLITE_OK;
+}
+
+/* Formats a double so it reads back the same, in SQL/JSON syntax.
+   out must have room for 40 bytes */
+static size_t
+dataexport_format_double(char *out, double d)
+{
+  int digits;
+
+  if (isinf(d))
+    strcpy(out, (d < 0) ? "-1e999" : "1e999");
+  else if (d == 0)
+    strcpy(out, "0.0");
+  else
+  {
+    /* the shortest that round trips */
+    for (digits = 15; digits < 17; digits++)
+    {
+      sqlite3_snprintf(40, out, "%!.*g", digits, d);
+      if (strtod(out, NULL) == d)
+        break;
+    }
+    if (digits == 17)
+      sqlite3_snprintf(40, out, "%!.17g", d);
+  }
+  return strlen(out);
+}
+
+static const char dataexport_hex[] = "0123456789ABCDEF";
+static const char dataexport_base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static char *
+dataexport_format_base64(char *out, const unsigned char *data, size_t length)
+{
+  for (; length >= 3; length -= 3, data += 3)
+  {
+    *out++ = dataexport_base64[data[0] >> 2];
+    *out++ = dataexport_base64[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+    *out++ = dataexport_base64[((data[1] & 0x0f) << 2) | (data[2] >> 6)];
+    *out++ = dataexport_base64[data[2] & 0x3f];
+  }
+  if (length)
+  {
+    *out++ = dataexport_base64[data[0] >> 2];
+    if (length == 1)
+    {
+      *out++ = dataexport_base64[(data[0] & 0x03) << 4];
+      *out++ = '=';
+    }
+    else
+    {
+      *out++ = dataexport_base64[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+      *out++ = dataexport_base64[(data[1] & 0x0f) << 2];
+    }
+    *out++ = '=';
+  }
+  return out;
+}
+
+/* Appends text as a JSON string */
+static int
+dataexport_json_string(DataExportBuffer *buffer, const unsigned char *text, size_t length)
+{
+  char *out = dataexport_reserve(buffer, 6 * length + 2);
+  size_t i;
+
+  if (!out)
+    return SQLITE_NOMEM;
+  *out++ = '"';
+  for (i = 0; i < length; i++)
+  {
+    unsigned char c = text[i];
+    switch (c)
+    {
+    case '"':
+    case '\\':
+      *out++ = '\\';
+      *out++ = c;
+      break;
+    case '\n':
+      *out++ = '\\';
+      *out++ = 'n';
+      break;
+    case '\r':
+      *out++ = '\\';
+      *out++ = 'r';
+      break;
+    case '\t':
+      *out++ = '\\';
+      *out++ = 't';
+      break;
+    default:
+      if (c < 0x20)
+      {
+        memcpy(out, "\\u00", 4);
+        out[4] = dataexport_hex[c >> 4];
+        out[5] = dataexport_hex[c & 0x0f];
+        out += 6;
+      }
+      else
+        *out++ = c;
+    }
+  }
+  *out++ = '"';
+  buffer->length = out - buffer->data;
+  return SQLITE_OK;
+}
+
+/* Appends text as a CSV value, quoted if needed */
+static int
+dataexport_csv_string(DataExport *exp, DataExportBuffer *buffer, const unsigned char *text, size_t length)
+{
+  char *out = dataexport_reserve(buffer, 2 * length + 2);
+  size_t i;
+  int quote = 0;
+
+  if (!out)
+    return SQLITE_NOMEM;
+  for (i = 0; exp->quoting && !quote && i < length; i++)
+    quote = text[i] == exp->separator || text[i] == '"' || text[i] == '\n' || text[i] == '\r';
+  if (!quote)
+  {
+    memcpy(out, text, length);
+    buffer->length += length;
+    return SQLITE_OK;
+  }
+  *out++ = '"';
+  for (i = 0; i < length; i++)
+  {
+    if (text[i] == '"')
+      *out++ = '"';
+    *out++ = text[i];
+  }
+  *out++ = '"';
+  buffer->length = out - buffer->data;
+  return SQLITE_OK;
+}
+
+/* Appends one column value of the current row */
+static int
+dataexport_value(DataExport *exp, DataExportBuffer *buffer, int col)
+{
+  char *out;
+
+  switch (sqlite3_column_type(exp->stmt, col))
+  {
+  case SQLITE_NULL:
+    if (exp->format == DATAEXPORT_CSV)
+      return SQLITE_OK;
+    out = dataexport_reserve(buffer, 4);
+    if (!out)
+      return SQLITE_NOMEM;
+    memcpy(out, (exp->format == DATAEXPORT_SQL) ? "NULL" : "null", 4);
+    buffer->length += 4;
+    return SQLITE_OK;
+
+  case SQLITE_INTEGER:
+    out = dataexport_reserve(buffer, 40);
+    if (!out)
+      return SQLITE_NOMEM;
+    sqlite3_snprintf(40, out, "%lld", sqlite3_column_int64(exp->stmt, col));
+    buffer->length += strlen(out);
+    return SQLITE_OK;
+
+  case SQLITE_FLOAT:
+    out = dataexport_reserve(buffer, 40);
+    if (!out)
+      return SQLITE_NOMEM;
+    buffer->length += dataexport_format_double(out, sqlite3_column_double(exp->stmt, col));
+    return SQLITE_OK;
+
+  case SQLITE_TEXT:
+  {
+    const unsigned char *text = sqlite3_column_text(exp->stmt, col);
+    size_t length = sqlite3_column_bytes(exp->stmt, col), i;
+
+    if (!text)
+      return SQLITE_NOMEM;
+    if (exp->format == DATAEXPORT_CSV)
+      return dataexport_csv_string(exp, buffer, text, length);
+    if (exp->format == DATAEXPORT_JSONL)
+      return dataexport_json_string(buffer, text, length);
+
+    /* the same as apsw.format_sql_value */
+    out = dataexport_reserve(buffer, 11 * length + 2);
+    if (!out)
+      return SQLITE_NOMEM;
+    *out++ = '\'';
+    for (i = 0; i < length; i++)
+    {
+      if (text[i] == 0)
+      {
+        memcpy(out, "'||X'00'||'", 11);
+        out += 11;
+        continue;
+      }
+      if (text[i] == '\'')
+        *out++ = '\'';
+      *out++ = text[i];
+    }
+    *out++ = '\'';
+    buffer->length = out - buffer->data;
+    return SQLITE_OK;
+  }
+
+  default: /* SQLITE_BLOB */
+  {
+    const unsigned char *data = sqlite3_column_blob(exp->stmt, col);
+    size_t length = sqlite3_column_bytes(exp->stmt, col), i;
+
+    if (!data && length)
+      return SQLITE_NOMEM;
+    out = dataexport_reserve(buffer, 2 * length + 3);
+    if (!out)
+      return SQLITE_NOMEM;
+    if (exp->format == DATAEXPORT_SQL)
+    {
+      *out++ = 'X';
+      *out++ = '\'';
+      for (i = 0; i < length; i++)
+      {
+        *out++ = dataexport_hex[data[i] >> 4];
+        *out++ = dataexport_hex[data[i] & 0x0f];
+      }
+      *out++ = '\'';
+    }
+    else
+    {
+      if (exp->format == DATAEXPORT_JSONL)
+        *out++ = '"';
+      out = dataexport_format_base64(out, data, length);
+      if (exp->format == DATAEXPORT_JSONL)
+        *out++ = '"';
+    }
+    buffer->length = out - buffer->data;
+    return SQLITE_OK;
+  }
+  }
+}
+
+/* Appends a single character */
+static int
+dataexport_char(DataExportBuffer *buffer, char c)
+{
+  char *out = dataexport_reserve(buffer, 1);
+  if (!out)
+    return SQLITE_NOMEM;
+  *out = c;
+  buffer->length++;
+  return SQLITE_OK;
+}
+
+static int
+dataexport_bytes(DataExportBuffer *buffer, const char *data, size_t length)
+{
+  char *out = dataexport_reserve(buffer, length);
+  if (!out)
+    return SQLITE_NOMEM;
+  memcpy(out, data, length);
+  buffer->length += length;
+  return SQLITE_OK;
+}
+
+/* Appends the current row */
+static int
+dataexport_row(DataExport *exp)
+{
+  DataExportBuffer *buffer = &exp->buffers[exp->current];
+  int res = SQLITE_OK, i;
+
+  if (exp->format == DATAEXPORT_SQL)
+    res = dataexport_bytes(buffer, exp->prefix.data, exp->prefix.length);
+  else if (exp->format == DATAEXPORT_JSONL)
+    res = dataexport_char(buffer, '{');
+
+  for (i = 0; i < exp->ncols && res == SQLITE_OK; i++)
+  {
+    if (exp->format == DATAEXPORT_JSONL)
+    {
+      if (i)
+        res = dataexport_char(buffer, ',');
+      if (res == SQLITE_OK)
+        res = dataexport_bytes(buffer, exp->prefix.data + exp->key_offsets[i],
+                               exp->key_offsets[i + 1] - exp->key_offsets[i]);
+    }
+    else if (i)
+      res = dataexport_char(buffer, (exp->format == DATAEXPORT_SQL) ? ',' : exp->separator);
+    if (res == SQLITE_OK)
+      res = dataexport_value(exp, buffer, i);
+  }
+
+  if (res == SQLITE_OK)
+  {
+    if (exp->format == DATAEXPORT_SQL)
+      res = dataexport_bytes(buffer, ");\n", 3);
+    else
+      res = (exp->format == DATAEXPORT_JSONL) ? dataexport_bytes(buffer, "}\n", 2) : dataexport_char(buffer, '\n');
+  }
+  return res;
+}
+
+/* Prepares the query, and the text that goes with each row */
+static int
+dataexport_prepare(DataExport *exp)
+{
+  const char *tail = NULL;
+  sqlite3_stmt *next = NULL;
+  int res, i;
+
+  res = sqlite3_prepare_v3(exp->db, exp->query, -1, 0, &exp->stmt, &tail);
+  if (res != SQLITE_OK)
+    return dataexport_error(exp, res);
+  if (!exp->stmt)
+  {
+    sqlite3_snprintf(sizeof(exp->message), exp->message, "query is empty");
+    return SQLITE_ERROR;
+  }
+  /* anything after the first statement had better be comments */
+  res = sqlite3_prepare_v3(exp->db, tail, -1, 0, &next, NULL);
+  if (res != SQLITE_OK)
+    return dataexport_error(exp, res);
+  if (next)
+  {
+    sqlite3_finalize(next);
+    sqlite3_snprintf(sizeof(exp->message), exp->message, "query must be exactly one statement");
+    return SQLITE_ERROR;
+  }
+  if (sqlite3_bind_parameter_count(exp->stmt))
+  {
+    sqlite3_snprintf(sizeof(exp->message), exp->message, "query can't have bindings");
+    return SQLITE_ERROR;
+  }
+  exp->ncols = sqlite3_column_count(exp->stmt);
+  if (!exp->ncols)
+  {
+    sqlite3_snprintf(sizeof(exp->message), exp->message, "query does not return any columns");
+    return SQLITE_ERROR;
+  }
+
+  if (exp->format == DATAEXPORT_SQL)
+  {
+    /* quote the table name only if needed, like the shell */
+    const char *name = exp->table;
+    int bare = (name[0] && !Py_ISDIGIT(name[0]) && !sqlite3_keyword_check(name, (int)strlen(name)));
+    char *prefix;
+
+    for (i = 0; bare && name[i]; i++)
+      bare = Py_ISALNUM(name[i]) || name[i] == '_';
+    prefix = sqlite3_mprintf(bare ? "INSERT INTO %s VALUES(" : "INSERT INTO \"%w\" VALUES(", name);
+    if (!prefix)
+      return SQLITE_NOMEM;
+    res = dataexport_bytes(&exp->prefix, prefix, strlen(prefix));
+    sqlite3_free(prefix);
+    return res;
+  }
+
+  /* the csv header */
+  if (exp->format == DATAEXPORT_CSV)
+  {
+    for (i = 0; i < exp->ncols && exp->header && res == SQLITE_OK; i++)
+    {
+      const char *name = sqlite3_column_name(exp->stmt, i);
+      if (!name)
+        return SQLITE_NOMEM;
+      if (i)
+        res = dataexport_char(&exp->buffers[exp->current], exp->separator);
+      if (res == SQLITE_OK)
+        res = dataexport_csv_string(exp, &exp->buffers[exp->current], (const unsigned char *)name, strlen(name));
+    }
+    if (exp->header && res == SQLITE_OK)
+      res = dataexport_char(&exp->buffers[exp->current], '\n');
+    return res;
+  }
+
+  /* jsonl keys */
+  exp->key_offsets = sqlite3_malloc64(sizeof(size_t) * (exp->ncols + 1));
+  if (!exp->key_offsets)
+    return SQLITE_NOMEM;
+  for (i = 0; i < exp->ncols && res == SQLITE_OK; i++)
+  {
+    const char *name = sqlite3_column_name(exp->stmt, i);
+    if (!name)
+      return SQLITE_NOMEM;
+    exp->key_offsets[i] = exp->prefix.length;
+    res = dataexport_json_string(&exp->prefix, (const unsigned char *)name, strlen(name));
+    if (res == SQLITE_OK)
+      res = dataexport_char(&exp->prefix, ':');
+  }
+  exp->key_offsets[exp->ncols] = exp->prefix.length;
+  return res;
+}
+
+/* Does the export with the writer thread already started.  Called with
+   the GIL released and the database mutex held.  The writer has been
+   stopped on return. */
+static int
+dataexport_run(DataExport *exp)
+{
+  int res = dataexport_prepare(exp);
+
+  while (res == SQLITE_OK)
+  {
+    res = sqlite3_step(exp->stmt);
+    if (res != SQLITE_ROW)
+    {
+      if (res == SQLITE_DONE)
+        res = SQLITE_OK;
+      else
+        dataexport_error(exp, res);
+      break;
+    }
+    res = dataexport_row(exp);
+    if (res == SQLITE_OK)
+    {
+      exp->rows++;
+      if (exp->buffers[exp->current].length >= DATAEXPORT_CHUNK_SIZE)
+        res = dataexport_submit(exp);
+    }
+  }
+
+  if (res == SQLITE_OK && exp->buffers[exp->current].length)
+    res = dataexport_submit(exp);
+
+  /* stop the writer once it has finished */
+  PyThread_acquire_lock(exp->idle, WAIT_LOCK);
+  exp->stop = 1;
+  PyThread_release_lock(exp->full);
+
+  if (exp->stmt)
+  {
+    sqlite3_finalize(exp->stmt);
+    exp->stmt = NULL;
+  }
+  return res;
+}
@@ -0,0 +1,428 @@
+/*
+  Importing CSV and JSON lines files into a table, behind
+  Connection.import_file.
+
+  A reader thread reads the file in large chunks while the calling
+  thread parses the previous chunk and inserts its rows.  Neither
+  holds the GIL.  Each value is bound directly from the chunk memory
+  into a single prepared INSERT, and the rows are committed in large
+  transactions.
+*/
+
+#define DATAIMPORT_CHUNK_SIZE (4 * 1024 * 1024)
+
+typedef enum
+{
+  DATAIMPORT_CSV,
+  DATAIMPORT_JSONL
+} DataImportFormat;
+
+typedef struct DataImportField
+{
+  const char *data;
+  int length;
+} DataImportField;
+
+typedef struct DataImport
+{
+  /* configuration */
+  sqlite3 *db;
+  FILE *file;
+  const char *table;
+  DataImportFormat format;
+  char separator;
+  int quoting;
+  int header;
+  int commit_every;
+
+  /* reader thread, which alternates between the two chunks */
+  char *chunks[2];
+  size_t chunk_lengths[2];
+  int read_errno;           /* non-zero if reading failed */
+  int eof;                  /* the last chunk has been read */
+  int stop;                 /* set to make the reader exit early */
+  PyThread_type_lock want;  /* released to ask the reader for the next chunk */
+  PyThread_type_lock ready; /* released by the reader when a chunk has been read */
+  PyThread_type_lock done;  /* released by the reader when it exits */
+
+  /* data not yet parsed, which carries partial records between chunks */
+  char *work;
+  size_t work_length;
+  size_t work_size;
+
+  sqlite3_stmt *stmt;
+  int ncols;
+  DataImportField *fields;
+  int autocommit;         /* we started the transaction, rather than using a savepoint */
+  sqlite3_int64 record;   /* current record number in the file */
+  sqlite3_int64 rows;     /* rows inserted */
+  sqlite3_int64 uncommitted;
+
+  /* errors */
+  char *errmsg;      /* SQLite error message from sqlite3_mprintf */
+  char message[256]; /* problem with the file contents, empty if none */
+} DataImport;
+
+static void
+dataimport_reader_thread(void *arg)
+{
+  DataImport *imp = (DataImport *)arg;
+  int which = 0;
+
+  for (;;)
+  {
+    PyThread_acquire_lock(imp->want, WAIT_LOCK);
+    if (imp->stop)
+      break;
+    imp->chunk_lengths[which] = fread(imp->chunks[which], 1, DATAIMPORT_CHUNK_SIZE, imp->file);
+    if (imp->chunk_lengths[which] < DATAIMPORT_CHUNK_SIZE)
+    {
+      if (ferror(imp->file))
+        imp->read_errno = errno ? errno : EIO;
+      imp->eof = 1;
+    }
+    which = !which;
+    PyThread_release_lock(imp->ready);
+    if (imp->eof)
+      break;
+  }
+  PyThread_release_lock(imp->done);
+}
+
+static void
+dataimport_free_lock(PyThread_type_lock lock)
+{
+  if (lock)
+  {
+    /* make sure it is acquired so the release is balanced */
+    PyThread_acquire_lock(lock, NOWAIT_LOCK);
+    PyThread_release_lock(lock);
+    PyThread_free_lock(lock);
+  }
+}
+
+/* Records the SQLite error message, returning res */
+static int
+dataimport_error(DataImport *imp, int res)
+{
+  if (!imp->errmsg)
+    imp->errmsg = sqlite3_mprintf("%s", sqlite3_errmsg(imp->db));
+  return res;
+}
+
+static int
+dataimport_exec(DataImport *imp, const char *sql)
+{
+  int res = sqlite3_exec(imp->db, sql, NULL, NULL, NULL);
+  return (res == SQLITE_OK) ? res : dataimport_error(imp, res);
+}
+
+/* Prepares the INSERT.  The number of columns comes from preparing a
+   select of the table */
+static int
+dataimport_prepare(DataImport *imp)
+{
+  sqlite3_stmt *stmt = NULL;
+  sqlite3_str *sql;
+  char *query = NULL;
+  int res, i;
+
+  query = sqlite3_mprintf("SELECT * FROM \"%w\"", imp->table);
+  if (!query)
+    return SQLITE_NOMEM;
+  res = sqlite3_prepare_v3(imp->db, query, -1, 0, &stmt, NULL);
+  sqlite3_free(query);
+  if (res != SQLITE_OK)
+    return dataimport_error(imp, res);
+  imp->ncols = sqlite3_column_count(stmt);
+
+  sql = sqlite3_str_new(imp->db);
+  sqlite3_str_appendf(sql, "INSERT INTO \"%w\" VALUES(", imp->table);
+  for (i = 0; i < imp->ncols; i++)
+  {
+    if (i)
+      sqlite3_str_appendchar(sql, 1, ',');
+    if (imp->format == DATAIMPORT_CSV)
+      sqlite3_str_appendchar(sql, 1, '?');
+    else
+      /* arrays by position, else objects by column name */
+      sqlite3_str_appendf(sql, "iif(json_type(?1)='array', ?1->>%d, ?1->>('$.' || json_quote(%Q)))", i,
+                          sqlite3_column_name(stmt, i));
+  }
+  sqlite3_str_appendchar(sql, 1, ')');
+  sqlite3_finalize(stmt);
+
+  query = sqlite3_str_finish(sql);
+  if (!query)
+    return SQLITE_NOMEM;
+  res = sqlite3_prepare_v3(imp->db, query, -1, SQLITE_PREPARE_PERSISTENT, &imp->stmt, NULL);
+  sqlite3_free(query);
+  if (res != SQLITE_OK)
+    return dataimport_error(imp, res);
+
+  imp->fields = sqlite3_malloc64(sizeof(DataImportField) * (imp->ncols ? imp->ncols : 1));
+  return imp->fields ? SQLITE_OK : SQLITE_NOMEM;
+}
+
+/* Returns the newline ending the record starting at p, or NULL if the
+   record isn't complete.  This follows the same rules as
+   dataimport_csv_fields so newlines inside quoted values don't end the
+   record. */
+static char *
+dataimport_record_end(DataImport *imp, char *p, char *end)
+{
+  int quoted = 0, closed = 0, field_start = 1;
+
+  if (imp->format == DATAIMPORT_JSONL || !imp->quoting)
+    return memchr(p, '\n', end - p);
+
+  for (; p < end; p++)
+  {
+    char c = *p;
+    if (quoted)
+    {
+      if (c == '"')
+      {
+        quoted = 0;
+        closed = 1;
+      }
+      continue;
+    }
+    /* quotes start a value, or are doubled inside one */
+    if (c == '"' && (field_start || closed))
+    {
+      quoted = 1;
+      closed = field_start = 0;
+      continue;
+    }
+    if (c == '\n')
+      return p;
+    closed = 0;
+    field_start = (c == imp->separator);
+  }
+  return NULL;
+}
+
+/* Splits a CSV record into imp->fields, unquoting values in place.
+   Returns how many fields there were. */
+static int
+dataimport_csv_fields(DataImport *imp, char *p, char *end)
+{
+  int nfields = 0;
+
+  for (;;)
+  {
+    char *start = p, *out;
+    if (imp->quoting && p < end && *p == '"')
+    {
+      /* values are written back over the quotes, so out is never after p */
+      out = start;
+      p++;
+      while (p < end)
+      {
+        if (*p == '"')
+        {
+          if (p + 1 < end && p[1] == '"')
+          {
+            *out++ = '"';
+            p += 2;
+            continue;
+          }
+          p++;
+          break;
+        }
+        *out++ = *p++;
+      }
+      /* anything after the closing quote is kept */
+      while (p < end && *p != imp->separator)
+        *out++ = *p++;
+    }
+    else
+    {
+      while (p < end && *p != imp->separator)
+        p++;
+      out = p;
+    }
+    if (nfields < imp->ncols)
+    {
+      imp->fields[nfields].data = start;
+      imp->fields[nfields].length = (int)(out - start);
+    }
+    nfields++;
+    if (p == end)
+      return nfields;
+    /* skip separator */
+    p++;
+  }
+}
+
+/* Binds and inserts one record */
+static int
+dataimport_record(DataImport *imp, char *p, char *end)
+{
+  int res = SQLITE_OK, i;
+
+  if (end > p && end[-1] == '\r')
+    end--;
+  /* blank lines are ignored */
+  if (end == p)
+    return SQLITE_OK;
+
+  imp->record++;
+  if (imp->header && imp->record == 1)
+    return SQLITE_OK;
+
+  if (imp->format == DATAIMPORT_JSONL)
+    res = sqlite3_bind_text64(imp->stmt, 1, p, end - p, SQLITE_STATIC, SQLITE_UTF8);
+  else
+  {
+    int nfields = dataimport_csv_fields(imp, p, end);
+    if (nfields != imp->ncols)
+    {
+      sqlite3_snprintf(sizeof(imp->message), imp->message, "row %lld has %d columns but should have %d", imp->record,
+                       nfields, imp->ncols);
+      return SQLITE_ERROR;
+    }
+    for (i = 0; i < imp->ncols && res == SQLITE_OK; i++)
+      res = sqlite3_bind_text(imp->stmt, i + 1, imp->fields[i].data, imp->fields[i].length, SQLITE_STATIC);
+  }
+  if (res == SQLITE_OK)
+  {
+    res = sqlite3_step(imp->stmt);
+    if (res == SQLITE_DONE)
+      res = SQLITE_OK;
+  }
+  if (res != SQLITE_OK)
+  {
+    dataimport_error(imp, res);
+    sqlite3_reset(imp->stmt);
+    return res;
+  }
+  res = sqlite3_reset(imp->stmt);
+  if (res != SQLITE_OK)
+    return dataimport_error(imp, res);
+
+  imp->rows++;
+  if (imp->commit_every && imp->autocommit && ++imp->uncommitted >= imp->commit_every)
+  {
+    imp->uncommitted = 0;
+    res = dataimport_exec(imp, "COMMIT; BEGIN IMMEDIATE");
+  }
+  return res;
+}
+
+/* Adds a chunk to the work buffer and inserts all the complete records */
+static int
+dataimport_chunk(DataImport *imp, const char *chunk, size_t length, int final)
+{
+  char *p, *end, *record_end;
+  int res = SQLITE_OK;
+
+  if (imp->work_length + length > imp->work_size)
+  {
+    size_t size = imp->work_length + length + DATAIMPORT_CHUNK_SIZE;
+    char *work = sqlite3_realloc64(imp->work, size);
+    if (!work)
+      return SQLITE_NOMEM;
+    imp->work = work;
+    imp->work_size = size;
+  }
+  memcpy(imp->work + imp->work_length, chunk, length);
+  imp->work_length += length;
+
+  p = imp->work;
+  end = imp->work + imp->work_length;
+
+  /* UTF-8 byte order mark */
+  if (imp->record == 0 && end - p >= 3 && 0 == memcmp(p, "\xef\xbb\xbf", 3))
+    p += 3;
+
+  while (p < end && res == SQLITE_OK)
+  {
+    record_end = dataimport_record_end(imp, p, end);
+    if (!record_end)
+    {
+      if (!final)
+        break;
+      record_end = end;
+    }
+    res = dataimport_record(imp, p, record_end);
+    p = (record_end == end) ? end : record_end + 1;
+  }
+
+  imp->work_length = end - p;
+  memmove(imp->work, p, imp->work_length);
+  return res;
+}
+
+/* Does the import with the reader thread already started.  Called with
+   the GIL released and the database mutex held.  The transaction is
+   rolled back on any error. */
+static int
+dataimport_run(DataImport *imp)
+{
+  int res, which = 0, outstanding = 0;
+
+  imp->autocommit = sqlite3_get_autocommit(imp->db);
+  res = dataimport_exec(imp, imp->autocommit ? "BEGIN IMMEDIATE" : "SAVEPOINT \"apsw-import\"");
+  if (res == SQLITE_OK)
+    res = dataimport_prepare(imp);
+
+  if (res == SQLITE_OK)
+  {
+    PyThread_release_lock(imp->want);
+    outstanding = 1;
+  }
+
+  while (res == SQLITE_OK)
+  {
+    int eof;
+
+    PyThread_acquire_lock(imp->ready, WAIT_LOCK);
+    outstanding = 0;
+    eof = imp->eof;
+    if (imp->read_errno)
+      break;
+    /* read the next chunk while this one is parsed */
+    if (!eof)
+    {
+      PyThread_release_lock(imp->want);
+      outstanding = 1;
+    }
+    res = dataimport_chunk(imp, imp->chunks[which], imp->chunk_lengths[which], eof);
+    which = !which;
+    if (eof)
+      break;
+  }
+
+  /* stop the reader */
+  if (outstanding)
+    PyThread_acquire_lock(imp->ready, WAIT_LOCK);
+  if (!imp->eof)
+  {
+    imp->stop = 1;
+    PyThread_release_lock(imp->want);
+  }
+
+  if (imp->stmt)
+  {
+    sqlite3_finalize(imp->stmt);
+    imp->stmt = NULL;
+  }
+
+  if (res == SQLITE_OK && !imp->read_errno)
+  {
+    res = dataimport_exec(imp, imp->autocommit ? "COMMIT" : "RELEASE \"apsw-import\"");
+    if (res == SQLITE_OK)
+      return res;
+  }
+
+  if (imp->autocommit)
+  {
+    if (!sqlite3_get_autocommit(imp->db))
+      sqlite3_exec(imp->db, "ROLLBACK", NULL, NULL, NULL);
+  }
+  else
+    sqlite3_exec(imp->db, "ROLLBACK TO \"apsw-import\"; RELEASE \"apsw-import\"", NULL, NULL, NULL);
+  return res;
+}
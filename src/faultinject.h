@@ -88,6 +88,7 @@ APSW_FaultInjectControl(const char *faultfunction, const char *filename, const c
 #undef apsw_strdup
 #undef connection_trace_and_exec
 #undef convert_column_to_pyobject
+#undef convert_row_to_pyobject
 #undef convert_value_to_pyobject
 #undef convertutf8string
 #undef get_window_function_context
@@ -1316,6 +1317,21 @@ APSW_FaultInjectControl(const char *faultfunction, const char *filename, const c
     }                                                                                                                                                                              \
     _res_convert_column_to_pyobject;                                                                                                                                               \
 })
+#define convert_row_to_pyobject(...) \
+({                                                                                                                                                                        \
+    __auto_type _res_convert_row_to_pyobject = 0 ? convert_row_to_pyobject(__VA_ARGS__) : 0;                                                                              \
+                                                                                                                                                                          \
+    _res_convert_row_to_pyobject = (typeof (_res_convert_row_to_pyobject))APSW_FaultInjectControl("convert_row_to_pyobject", __FILE__, __func__, __LINE__, #__VA_ARGS__); \
+                                                                                                                                                                          \
+    if ((typeof (_res_convert_row_to_pyobject))0x1FACADE == _res_convert_row_to_pyobject)                                                                                 \
+       _res_convert_row_to_pyobject = convert_row_to_pyobject(__VA_ARGS__);                                                                                               \
+    else if ((typeof(_res_convert_row_to_pyobject))0x2FACADE == _res_convert_row_to_pyobject)                                                                             \
+    {                                                                                                                                                                     \
+        convert_row_to_pyobject(__VA_ARGS__);                                                                                                                             \
+        _res_convert_row_to_pyobject = (typeof (_res_convert_row_to_pyobject))18;                                                                                         \
+    }                                                                                                                                                                     \
+    _res_convert_row_to_pyobject;                                                                                                                                         \
+})
 #define convert_value_to_pyobject(...) \
 ({                                                                                                                                                                              \
     __auto_type _res_convert_value_to_pyobject = 0 ? convert_value_to_pyobject(__VA_ARGS__) : 0;                                                                                \
@@ -0,0 +1,1242 @@
+/*
+  Another Python Sqlite Wrapper
+
+  A pool of connections to the same database
+
+  See the accompanying LICENSE file.
+*/
+
+/**
+
+.. _pool:
+
+Connection Pool
+***************
+
+A :class:`ConnectionPool` keeps open :class:`Connections
+<Connection>` to the same database for reuse, so that each piece of
+work doesn't have to open a connection and prepare its queries again.
+A connection that is released back to the pool keeps its
+:ref:`statement cache <statementcache>`, page cache, registered
+functions and other state.
+
+.. code-block:: python
+
+  pool = apsw.ConnectionPool("database.db", size=4)
+
+  db = pool.acquire()
+  try:
+      db.execute("...")
+  finally:
+      pool.release(db)
+
+Important details
+=================
+
+Each connection is only given to one caller at a time.  You must
+:meth:`~ConnectionPool.release` a connection once done with it,
+otherwise the pool will consider it still in use.
+
+The thread releasing a connection is remembered.  When that thread
+next calls :meth:`~ConnectionPool.acquire` it is preferentially given
+the same connection back, which will already have its caches warmed
+for the queries that thread runs.
+
+When all connections are in use and the pool is at its maximum size,
+:meth:`~ConnectionPool.acquire` waits (with the GIL released) for a
+connection to be released.  Waiters are served in the order they
+arrived.
+
+If a connection is released while a transaction is still open, the
+transaction is rolled back.  Connections you close yourself are
+discarded from the pool, and a replacement opened when needed.
+
+*/
+
+/** .. class:: ConnectionPool
+
+  Provides :class:`Connection` from a pool, opening new ones as needed
+  up to a maximum size.
+*/
+
+/* a thread waiting in acquire */
+typedef struct PoolWaiter
+{
+  PyThread_type_lock lock; /* released to wake the waiter */
+  Connection *handed;      /* connection handed over to the waiter */
+  int woken;               /* lock was released */
+  unsigned long thread_id; /* waiting thread */
+  struct PoolWaiter *next;
+} PoolWaiter;
+
+typedef struct PoolEntry
+{
+  Connection *connection;     /* NULL while being opened */
+  unsigned long thread_id;    /* thread that last acquired it */
+  long long idle_since;       /* when it was released */
+  int checked_out;            /* currently given to a caller */
+  unsigned long long open_id; /* identifies the entry while being opened */
+} PoolEntry;
+
+typedef struct ConnectionPool
+{
+  PyObject_HEAD
+  int init_was_called;
+  int closed;
+  PyObject *open_args; /* tuple of arguments to Connection */
+  PyObject *setup;     /* called with each new connection */
+  PoolEntry *entries;
+  unsigned size;  /* maximum number of entries */
+  unsigned count; /* entries in use */
+  PoolWaiter *waiters;
+  unsigned waiting;                /* how many waiters */
+  unsigned long long next_open_id; /* for PoolEntry.open_id */
+
+  /* stats */
+  unsigned long long checkouts;     /* successful acquires */
+  unsigned long long affinity_hits; /* got the connection this thread used last */
+  unsigned long long opened;        /* connections opened */
+  unsigned long long waits;         /* acquires that had to wait */
+  unsigned long long timeouts;      /* acquires that timed out */
+  long long checkout_ns;            /* total time in successful acquire */
+  long long max_checkout_ns;        /* longest successful acquire */
+  long long wait_ns;                /* total time waiting */
+  long long max_wait_ns;            /* longest wait */
+
+  PyObject *weakreflist;
+} ConnectionPool;
+
+#define CHECK_POOL_CLOSED(e)                                             \
+  do                                                                     \
+  {                                                                      \
+    if (self->closed)                                                    \
+    {                                                                    \
+      PyErr_Format(ExcConnectionClosed, "The pool has been closed");     \
+      return e;                                                          \
+    }                                                                    \
+  } while (0)
+
+static PyObject *
+ConnectionPool_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSED(kwds))
+{
+  ConnectionPool *self;
+
+  self = (ConnectionPool *)type->tp_alloc(type, 0);
+  if (self)
+  {
+    self->init_was_called = 0;
+    self->closed = 1;
+    self->open_args = NULL;
+    self->setup = NULL;
+    self->entries = NULL;
+    self->size = 0;
+    self->count = 0;
+    self->waiters = NULL;
+    self->waiting = 0;
+    self->next_open_id = 0;
+    self->checkouts = 0;
+    self->affinity_hits = 0;
+    self->opened = 0;
+    self->waits = 0;
+    self->timeouts = 0;
+    self->checkout_ns = 0;
+    self->max_checkout_ns = 0;
+    self->wait_ns = 0;
+    self->max_wait_ns = 0;
+    self->weakreflist = NULL;
+  }
+  return (PyObject *)self;
+}
+
+/** .. method:: __init__(filename: str, flags: int = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, vfs: Optional[str] = None, statementcachesize: int = 100, size: int = 8, setup: Optional[Callable[[Connection], None]] = None)
+
+  The first four parameters are passed to :class:`Connection` when
+  opening each connection.
+
+  :param size: Maximum number of connections open at once
+  :param setup: Called with each newly opened connection, for example
+     to set pragmas or register functions.  If it raises an exception
+     then the connection is closed and the exception is raised by
+     :meth:`~ConnectionPool.acquire`.
+*/
+static int
+ConnectionPool_init(ConnectionPool *self, PyObject *args, PyObject *kwargs)
+{
+  const char *filename = NULL;
+  int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+  const char *vfs = NULL;
+  int statementcachesize = 100;
+  int size = 8;
+  PyObject *setup = NULL;
+
+  {
+    ConnectionPool_init_CHECK;
+    PREVENT_INIT_MULTIPLE_CALLS;
+    ARG_CONVERT_VARARGS_TO_FASTCALL;
+    ARG_PROLOG(6, ConnectionPool_init_KWNAMES);
+    ARG_MANDATORY ARG_str(filename);
+    ARG_OPTIONAL ARG_int(flags);
+    ARG_OPTIONAL ARG_optional_str(vfs);
+    ARG_OPTIONAL ARG_int(statementcachesize);
+    ARG_OPTIONAL ARG_int(size);
+    ARG_OPTIONAL ARG_optional_Callable(setup);
+    ARG_EPILOG(-1, ConnectionPool_init_USAGE, Py_XDECREF(fast_kwnames));
+  }
+
+  if (size < 1)
+  {
+    PyErr_Format(PyExc_ValueError, "size must be at least 1, not %d", size);
+    return -1;
+  }
+
+  self->open_args = Py_BuildValue("(siNi)", filename, flags, vfs ? PyUnicode_FromString(vfs) : Py_NewRef(Py_None), statementcachesize);
+  if (!self->open_args)
+    return -1;
+  self->entries = PyMem_Calloc(size, sizeof(PoolEntry));
+  if (!self->entries)
+  {
+    PyErr_NoMemory();
+    return -1;
+  }
+  self->setup = Py_XNewRef(setup);
+  self->size = size;
+  self->closed = 0;
+  return 0;
+}
+
+static void
+ConnectionPool_remove_entry(ConnectionPool *self, unsigned i)
+{
+  assert(i < self->count);
+  Py_XDECREF((PyObject *)self->entries[i].connection);
+  self->count--;
+  self->entries[i] = self->entries[self->count];
+}
+
+static int
+ConnectionPool_find_entry(ConnectionPool *self, Connection *connection)
+{
+  unsigned i;
+
+  for (i = 0; i < self->count; i++)
+    if (self->entries[i].connection == connection)
+      return (int)i;
+  return -1;
+}
+
+/* wakes the first waiter, handing over connection if not NULL */
+static void
+ConnectionPool_wake_waiter(ConnectionPool *self, Connection *connection)
+{
+  PoolWaiter *waiter = self->waiters;
+
+  assert(waiter);
+  self->waiters = waiter->next;
+  self->waiting--;
+  waiter->next = NULL;
+  waiter->handed = connection ? (Connection *)Py_NewRef((PyObject *)connection) : NULL;
+  waiter->woken = 1;
+  PyThread_release_lock(waiter->lock);
+}
+
+static void
+ConnectionPool_remove_waiter(ConnectionPool *self, PoolWaiter *waiter)
+{
+  PoolWaiter **pos;
+
+  for (pos = &self->waiters; *pos; pos = &(*pos)->next)
+    if (*pos == waiter)
+    {
+      *pos = waiter->next;
+      self->waiting--;
+      return;
+    }
+}
+
+/* makes entry i available, handing it to a waiter if there is one */
+static void
+ConnectionPool_make_available(ConnectionPool *self, unsigned i)
+{
+  PoolEntry *entry = &self->entries[i];
+
+  assert(entry->checked_out && entry->connection);
+  if (self->waiters)
+  {
+    entry->thread_id = self->waiters->thread_id;
+    ConnectionPool_wake_waiter(self, entry->connection);
+  }
+  else
+  {
+    entry->checked_out = 0;
+    entry->idle_since = apsw_perf_counter_ns();
+  }
+}
+
+/* removes entry i, waking a waiter so it can open a replacement */
+static void
+ConnectionPool_discard_entry(ConnectionPool *self, unsigned i)
+{
+  ConnectionPool_remove_entry(self, i);
+  if (self->waiters)
+    ConnectionPool_wake_waiter(self, NULL);
+}
+
+/* returns new reference to an opened connection occupying entry i,
+   or NULL with the entry discarded */
+static Connection *
+ConnectionPool_open(ConnectionPool *self, unsigned i)
+{
+  PyObject *connection = NULL, *res = NULL;
+  unsigned long long open_id = self->entries[i].open_id;
+  int entry;
+
+  assert(!self->entries[i].connection && self->entries[i].checked_out);
+
+  /* other threads can run while the connection is opened so the entry
+     can be moved by them */
+  connection = PyObject_Call((PyObject *)&ConnectionType, self->open_args, NULL);
+  if (connection && self->setup)
+  {
+    PyObject *vargs[] = {NULL, connection};
+    res = PyObject_Vectorcall(self->setup, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    if (!res)
+      AddTraceBackHere(__FILE__, __LINE__, "ConnectionPool.setup", "{s: O}", "connection", connection);
+    Py_XDECREF(res);
+  }
+
+  for (entry = 0; entry < (int)self->count; entry++)
+    if (!self->entries[entry].connection && self->entries[entry].open_id == open_id)
+      break;
+  assert(entry < (int)self->count);
+
+  if (!connection || !res || self->closed)
+  {
+    if (connection)
+    {
+      Connection_close_internal((Connection *)connection, 2);
+      Py_DECREF(connection);
+    }
+    ConnectionPool_discard_entry(self, entry);
+    if (!PyErr_Occurred())
+      PyErr_Format(ExcConnectionClosed, "The pool has been closed");
+    return NULL;
+  }
+
+  self->opened++;
+  self->entries[entry].connection = (Connection *)Py_NewRef(connection);
+  return (Connection *)connection;
+}
+
+/* can acquire succeed without waiting */
+static int
+ConnectionPool_available(ConnectionPool *self)
+{
+  unsigned i;
+
+  if (self->count < self->size)
+    return 1;
+  for (i = 0; i < self->count; i++)
+    if (!self->entries[i].checked_out)
+      return 1;
+  return 0;
+}
+
+/* returns a new reference to a connection, or NULL with an exception */
+static Connection *
+ConnectionPool_acquire_internal(ConnectionPool *self, int timeout)
+{
+  unsigned long thread_id = PyThread_get_thread_ident();
+  long long start, elapsed;
+  Connection *connection = NULL;
+
+  start = apsw_perf_counter_ns();
+
+  while (!connection)
+  {
+    unsigned i;
+    int best = -1;
+
+    CHECK_POOL_CLOSED(NULL);
+
+    /* idle connection? */
+    for (i = 0; i < self->count; i++)
+    {
+      PoolEntry *entry = &self->entries[i];
+      if (entry->checked_out)
+        continue;
+      if (entry->thread_id == thread_id)
+      {
+        best = (int)i;
+        self->affinity_hits++;
+        break;
+      }
+      /* most recently released has the warmest caches */
+      if (best < 0 || entry->idle_since > self->entries[best].idle_since)
+        best = (int)i;
+    }
+    if (best >= 0)
+    {
+      self->entries[best].checked_out = 1;
+      self->entries[best].thread_id = thread_id;
+      connection = (Connection *)Py_NewRef((PyObject *)self->entries[best].connection);
+      break;
+    }
+
+    /* room for another? */
+    if (self->count < self->size)
+    {
+      PoolEntry *entry = &self->entries[self->count++];
+      entry->connection = NULL;
+      entry->checked_out = 1;
+      entry->thread_id = thread_id;
+      entry->open_id = self->next_open_id++;
+      connection = ConnectionPool_open(self, self->count - 1);
+      if (!connection)
+        return NULL;
+      break;
+    }
+
+    /* wait */
+    elapsed = apsw_perf_counter_ns() - start;
+    if (timeout >= 0 && elapsed >= timeout * 1000000LL)
+    {
+      self->timeouts++;
+      PyErr_Format(PyExc_TimeoutError, "No connection became available within %d milliseconds", timeout);
+      return NULL;
+    }
+
+    {
+      PoolWaiter waiter = {.handed = NULL, .woken = 0, .thread_id = thread_id, .next = NULL};
+      PoolWaiter **tail;
+      PyLockStatus status = PY_LOCK_FAILURE;
+      long long wait_start = apsw_perf_counter_ns(), waited;
+
+      waiter.lock = PyThread_allocate_lock();
+      if (!waiter.lock)
+      {
+        PyErr_NoMemory();
+        return NULL;
+      }
+      PyThread_acquire_lock(waiter.lock, WAIT_LOCK);
+
+      for (tail = &self->waiters; *tail; tail = &(*tail)->next)
+        ;
+      *tail = &waiter;
+      self->waiting++;
+      self->waits++;
+
+      while (!waiter.woken)
+      {
+        PY_TIMEOUT_T microseconds = -1;
+
+        if (timeout >= 0)
+        {
+          long long remaining = timeout * 1000000LL - (apsw_perf_counter_ns() - start);
+          if (remaining <= 0)
+            break;
+          microseconds = (PY_TIMEOUT_T)Py_MIN(remaining / 1000 + 1, PY_TIMEOUT_MAX);
+        }
+
+        Py_BEGIN_ALLOW_THREADS
+            status = PyThread_acquire_lock_timed(waiter.lock, microseconds, 1);
+        Py_END_ALLOW_THREADS;
+
+        if (status == PY_LOCK_INTR && PyErr_CheckSignals())
+          break;
+        if (status == PY_LOCK_FAILURE)
+          break;
+      }
+
+      if (!waiter.woken)
+        ConnectionPool_remove_waiter(self, &waiter);
+      /* locks must not be freed while held */
+      if (!waiter.woken || status == PY_LOCK_ACQUIRED)
+        PyThread_release_lock(waiter.lock);
+      PyThread_free_lock(waiter.lock);
+
+      waited = apsw_perf_counter_ns() - wait_start;
+      self->wait_ns += waited;
+      self->max_wait_ns = Py_MAX(self->max_wait_ns, waited);
+
+      connection = waiter.handed;
+      if (PyErr_Occurred())
+      {
+        if (connection)
+        {
+          int entry = ConnectionPool_find_entry(self, connection);
+          assert(entry >= 0);
+          Py_DECREF((PyObject *)connection);
+          ConnectionPool_make_available(self, entry);
+        }
+        return NULL;
+      }
+      if (!waiter.woken)
+      {
+        self->timeouts++;
+        PyErr_Format(PyExc_TimeoutError, "No connection became available within %d milliseconds", timeout);
+        return NULL;
+      }
+    }
+  }
+
+  elapsed = apsw_perf_counter_ns() - start;
+  self->checkouts++;
+  self->checkout_ns += elapsed;
+  self->max_checkout_ns = Py_MAX(self->max_checkout_ns, elapsed);
+
+  return connection;
+}
+
+/** .. method:: acquire(timeout: int = -1) -> Connection
+
+  Returns a connection from the pool for your exclusive use until you
+  :meth:`~ConnectionPool.release` it.
+
+  An idle connection is used if available, preferring the one last
+  used by this thread.  Otherwise a new connection is opened if the
+  pool is below its maximum size, or else this waits for a connection
+  to be released.
+
+  :param timeout: Maximum milliseconds to wait.  Negative waits
+     forever, and zero doesn't wait at all.
+
+  :raises TimeoutError: No connection became available in time
+*/
+static PyObject *
+ConnectionPool_acquire(ConnectionPool *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  int timeout = -1;
+
+  CHECK_POOL_CLOSED(NULL);
+
+  {
+    ConnectionPool_acquire_CHECK;
+    ARG_PROLOG(1, ConnectionPool_acquire_KWNAMES);
+    ARG_OPTIONAL ARG_int(timeout);
+    ARG_EPILOG(NULL, ConnectionPool_acquire_USAGE, );
+  }
+
+  return (PyObject *)ConnectionPool_acquire_internal(self, timeout);
+}
+
+/* returns 0 on success, -1 with an exception on error */
+static int
+ConnectionPool_release_internal(ConnectionPool *self, Connection *connection)
+{
+  int entry;
+
+  entry = ConnectionPool_find_entry(self, connection);
+  if (entry < 0 || !self->entries[entry].checked_out)
+  {
+    PyErr_Format(PyExc_ValueError, "The connection is not currently acquired from this pool");
+    return -1;
+  }
+
+  if (self->closed)
+  {
+    /* hold a reference while closing */
+    Py_INCREF((PyObject *)connection);
+    ConnectionPool_remove_entry(self, entry);
+    int res = Connection_close_internal(connection, 0);
+    Py_DECREF((PyObject *)connection);
+    return res ? -1 : 0;
+  }
+
+  if (connection->db && !sqlite3_get_autocommit(connection->db))
+  {
+    PyObject *vargs[] = {NULL, (PyObject *)connection, PyUnicode_FromString("ROLLBACK")};
+    PyObject *res = NULL;
+    if (vargs[2])
+      res = PyObject_VectorcallMethod(apst.execute, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    Py_XDECREF(vargs[2]);
+    Py_XDECREF(res);
+    if (!res)
+    {
+      /* a connection we can't get back into a good state is discarded */
+      entry = ConnectionPool_find_entry(self, connection);
+      if (entry >= 0)
+        ConnectionPool_discard_entry(self, entry);
+      return -1;
+    }
+    /* the rollback could run Python code that changes the entries */
+    entry = ConnectionPool_find_entry(self, connection);
+    if (entry < 0)
+      return 0;
+  }
+
+  if (!connection->db)
+    ConnectionPool_discard_entry(self, entry);
+  else
+    ConnectionPool_make_available(self, entry);
+
+  return 0;
+}
+
+/** .. method:: release(connection: Connection) -> None
+
+  Returns a connection obtained from :meth:`~ConnectionPool.acquire`
+  to the pool.  Any open transaction is rolled back.  If you closed the
+  connection, or the pool has been closed, then it is discarded
+  instead.
+
+  :raises ValueError: The connection is not currently acquired from
+    this pool
+*/
+static PyObject *
+ConnectionPool_release(ConnectionPool *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  Connection *connection = NULL;
+
+  {
+    ConnectionPool_release_CHECK;
+    ARG_PROLOG(1, ConnectionPool_release_KWNAMES);
+    ARG_MANDATORY ARG_Connection(connection);
+    ARG_EPILOG(NULL, ConnectionPool_release_USAGE, );
+  }
+
+  if (ConnectionPool_release_internal(self, connection))
+    return NULL;
+  Py_RETURN_NONE;
+}
+
+/** .. method:: release_idle(min_idle: int = 0) -> int
+
+  Writes out dirty pages (`sqlite3_db_cacheflush
+  <https://sqlite.org/c3ref/db_cacheflush.html>`__) and frees as much
+  memory as possible (`sqlite3_db_release_memory
+  <https://sqlite.org/c3ref/db_release_memory.html>`__) for
+  connections that have been idle in the pool for at least *min_idle*
+  milliseconds.  The connections (and their statement caches) remain
+  open.  You could call this periodically.
+
+  :returns: How many connections were processed
+*/
+static PyObject *
+ConnectionPool_release_idle(ConnectionPool *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  int min_idle = 0, processed = 0;
+  long long now = apsw_perf_counter_ns();
+  unsigned i;
+
+  CHECK_POOL_CLOSED(NULL);
+
+  {
+    ConnectionPool_release_idle_CHECK;
+    ARG_PROLOG(1, ConnectionPool_release_idle_KWNAMES);
+    ARG_OPTIONAL ARG_int(min_idle);
+    ARG_EPILOG(NULL, ConnectionPool_release_idle_USAGE, );
+  }
+
+  for (i = 0; i < self->count; i++)
+  {
+    PoolEntry *entry = &self->entries[i];
+    PyObject *res;
+    Connection *connection;
+    int entry_index;
+
+    if (entry->checked_out || now - entry->idle_since < min_idle * 1000000LL)
+      continue;
+    /* reserve it so flushing (which can run Python code in a VFS)
+       doesn't race with acquire */
+    entry->checked_out = 1;
+    connection = (Connection *)Py_NewRef((PyObject *)entry->connection);
+
+    res = Connection_cache_flush(connection);
+    if (res)
+    {
+      Py_DECREF(res);
+      res = Connection_release_memory(connection);
+    }
+    Py_XDECREF(res);
+
+    /* the entries could have been rearranged */
+    entry_index = ConnectionPool_find_entry(self, connection);
+    if (entry_index >= 0)
+      ConnectionPool_make_available(self, entry_index);
+    Py_DECREF((PyObject *)connection);
+    if (!res)
+      return NULL;
+    processed++;
+  }
+
+  return PyLong_FromLong(processed);
+}
+
+/* a query run by parallel_execute */
+typedef struct ParallelQuery
+{
+  APSWCursor *cursor;
+  sqlite3_stmt *stmt; /* NULL if there is nothing to run */
+  int numcols;
+  int res;       /* last sqlite3_step result */
+  int no_memory; /* row copy couldn't allocate */
+  Py_ssize_t nrows;
+  /* nrows * numcols values, with text and blob as u.i offsets into data */
+  APSWColumnValue *values;
+  Py_ssize_t values_size;
+  char *data;
+  size_t data_len, data_size;
+} ParallelQuery;
+
+/* runs queries first, first + step, ... on one connection */
+typedef struct ParallelWorker
+{
+  ParallelQuery *queries;
+  Py_ssize_t first, step, count;
+  PyThread_type_lock done; /* released on finishing when run in its own thread */
+} ParallelWorker;
+
+/* Copies the current row since SQLite's text and blob pointers are only
+   valid until the next step.  Called with the GIL released.  Returns
+   non-zero if memory couldn't be allocated. */
+static int
+parallel_query_save_row(ParallelQuery *query)
+{
+  APSWColumnValue *row;
+  int i;
+
+  if (query->numcols == 0)
+  {
+    query->nrows++;
+    return 0;
+  }
+
+  if ((query->nrows + 1) * query->numcols > query->values_size)
+  {
+    Py_ssize_t size = Py_MAX(query->values_size * 2, query->numcols * 16);
+    APSWColumnValue *values = PyMem_RawRealloc(query->values, sizeof(APSWColumnValue) * size);
+    if (!values)
+      return -1;
+    query->values = values;
+    query->values_size = size;
+  }
+
+  row = query->values + query->nrows * query->numcols;
+  read_row_values(query->stmt, query->numcols, row);
+
+  for (i = 0; i < query->numcols; i++)
+  {
+    if (row[i].type != SQLITE_TEXT && row[i].type != SQLITE_BLOB)
+      continue;
+    if (query->data_len + row[i].len > query->data_size)
+    {
+      size_t size = Py_MAX(query->data_size * 2, query->data_len + row[i].len + 4096);
+      char *data = PyMem_RawRealloc(query->data, size);
+      if (!data)
+        return -1;
+      query->data = data;
+      query->data_size = size;
+    }
+    if (row[i].len)
+      memcpy(query->data + query->data_len, row[i].u.p, row[i].len);
+    row[i].u.i = (sqlite3_int64)query->data_len;
+    query->data_len += row[i].len;
+  }
+
+  query->nrows++;
+  return 0;
+}
+
+/* Steps each of the worker's queries to completion.  Called with the GIL
+   released, stopping at the first query that fails. */
+static void
+parallel_worker_run(ParallelWorker *worker)
+{
+  Py_ssize_t i;
+
+  for (i = worker->first; i < worker->count; i += worker->step)
+  {
+    ParallelQuery *query = &worker->queries[i];
+    sqlite3_mutex *mutex;
+
+    if (!query->stmt)
+      continue;
+
+    mutex = sqlite3_db_mutex(sqlite3_db_handle(query->stmt));
+    sqlite3_mutex_enter(mutex);
+    while ((query->res = sqlite3_step(query->stmt)) == SQLITE_ROW)
+    {
+      if (parallel_query_save_row(query))
+      {
+        query->no_memory = 1;
+        break;
+      }
+    }
+    sqlite3_mutex_leave(mutex);
+
+    if (query->res != SQLITE_DONE)
+      break;
+  }
+}
+
+static void
+parallel_worker_thread(void *arg)
+{
+  ParallelWorker *worker = (ParallelWorker *)arg;
+
+  parallel_worker_run(worker);
+  PyThread_release_lock(worker->done);
+}
+
+/** .. method:: parallel_execute(queries: Iterable[str | tuple[str, Optional[Bindings]]], timeout: int = -1) -> list[list[Any]]
+
+  Runs read only queries at the same time on connections from the
+  pool, returning a list of each query's rows in the same order as
+  *queries*.  Each query is either a string, or a tuple of the string
+  and its bindings.
+
+  .. code-block:: python
+
+    orders, customers = pool.parallel_execute([
+        ("select * from orders where placed > ?", (yesterday,)),
+        "select count(*) from customers",
+    ])
+
+  The first connection is acquired waiting up to *timeout*
+  milliseconds, and then as many more as are available without
+  waiting.  The queries are divided between the connections, each
+  running its share in its own thread with the GIL released so that
+  multiple cores are used.  Once all the queries have finished the
+  rows are converted to Python objects, calling the connection's
+  :attr:`~Connection.row_trace` if set, and the connections are
+  released back to the pool.
+
+  The database should be in `WAL mode <https://sqlite.org/wal.html>`__
+  so that the readers don't block each other.  Functions you have
+  registered with the connections are called in the worker threads.
+
+  :raises TimeoutError: No connection became available in time
+  :raises ValueError: A query has more than one statement or is not
+    read only
+
+  -* sqlite3_stmt_readonly sqlite3_step
+*/
+static PyObject *
+ConnectionPool_parallel_execute(ConnectionPool *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *queries = NULL, *items = NULL, *results = NULL;
+  int timeout = -1;
+  Connection **connections = NULL;
+  ParallelQuery *pqueries = NULL;
+  ParallelWorker *workers = NULL;
+  Py_ssize_t nqueries, nconnections = 0, i;
+
+  CHECK_POOL_CLOSED(NULL);
+
+  {
+    ConnectionPool_parallel_execute_CHECK;
+    ARG_PROLOG(2, ConnectionPool_parallel_execute_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(queries);
+    ARG_OPTIONAL ARG_int(timeout);
+    ARG_EPILOG(NULL, ConnectionPool_parallel_execute_USAGE, );
+  }
+
+  items = PySequence_Fast(queries, "Expected an iterable of queries");
+  if (!items)
+    return NULL;
+  nqueries = PySequence_Fast_GET_SIZE(items);
+  if (nqueries == 0)
+  {
+    Py_DECREF(items);
+    return PyList_New(0);
+  }
+
+  connections = PyMem_Calloc(Py_MIN(nqueries, (Py_ssize_t)self->size), sizeof(Connection *));
+  workers = PyMem_Calloc(Py_MIN(nqueries, (Py_ssize_t)self->size), sizeof(ParallelWorker));
+  pqueries = PyMem_Calloc(nqueries, sizeof(ParallelQuery));
+  if (!connections || !workers || !pqueries)
+  {
+    PyErr_NoMemory();
+    goto finally;
+  }
+
+  connections[0] = ConnectionPool_acquire_internal(self, timeout);
+  if (!connections[0])
+    goto finally;
+  nconnections = 1;
+  while (nconnections < nqueries && ConnectionPool_available(self))
+  {
+    connections[nconnections] = ConnectionPool_acquire_internal(self, 0);
+    if (!connections[nconnections])
+      goto finally;
+    nconnections++;
+  }
+
+  for (i = 0; i < nqueries; i++)
+  {
+    PyObject *item = PySequence_Fast_GET_ITEM(items, i), *statement = item, *bindings = NULL;
+    ParallelQuery *query = &pqueries[i];
+    APSWStatementOptions options = {.can_cache = 1, .prepare_flags = 0, .explain = -1};
+
+    if (PyTuple_Check(item) && PyTuple_GET_SIZE(item) == 2)
+    {
+      statement = PyTuple_GET_ITEM(item, 0);
+      bindings = PyTuple_GET_ITEM(item, 1);
+      if (Py_IsNone(bindings))
+        bindings = NULL;
+    }
+    if (!PyUnicode_Check(statement))
+    {
+      PyErr_Format(PyExc_TypeError, "Expected a query str or (str, bindings) tuple, not %s", Py_TypeName(item));
+      goto finally;
+    }
+
+    query->res = SQLITE_DONE;
+    query->cursor = (APSWCursor *)PyObject_CallOneArg((PyObject *)&APSWCursorType, (PyObject *)connections[i % nconnections]);
+    if (!query->cursor)
+      goto finally;
+    if (APSWCursor_prepare_execute(query->cursor, statement, bindings, &options))
+      goto finally;
+    if (statementcache_hasmore(query->cursor->statement))
+    {
+      PyErr_Format(PyExc_ValueError, "parallel_execute queries must be a single statement: %R", statement);
+      goto finally;
+    }
+    query->stmt = query->cursor->statement->vdbestatement;
+    if (query->stmt)
+    {
+      if (!sqlite3_stmt_readonly(query->stmt))
+      {
+        PyErr_Format(PyExc_ValueError, "parallel_execute queries must be read only: %R", statement);
+        goto finally;
+      }
+      query->numcols = sqlite3_column_count(query->stmt);
+    }
+  }
+
+  /* the cursors are in use while the worker threads step them */
+  for (i = 0; i < nqueries; i++)
+  {
+    if (!INUSE_ACQUIRE(pqueries[i].cursor))
+    {
+      PyErr_Format(ExcThreadingViolation, INUSE_VIOLATION_MESSAGE);
+      while (i--)
+        INUSE_RELEASE(pqueries[i].cursor);
+      goto finally;
+    }
+  }
+
+  for (i = 0; i < nconnections; i++)
+  {
+    workers[i].queries = pqueries;
+    workers[i].first = i;
+    workers[i].step = nconnections;
+    workers[i].count = nqueries;
+    if (i == 0)
+      continue;
+    /* a worker without its own thread is run by this one */
+    workers[i].done = PyThread_allocate_lock();
+    if (!workers[i].done)
+      continue;
+    PyThread_acquire_lock(workers[i].done, WAIT_LOCK);
+    if (PyThread_start_new_thread(parallel_worker_thread, &workers[i]) == PYTHREAD_INVALID_THREAD_ID)
+    {
+      PyThread_release_lock(workers[i].done);
+      PyThread_free_lock(workers[i].done);
+      workers[i].done = NULL;
+    }
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  {
+    for (i = 0; i < nconnections; i++)
+      if (!workers[i].done)
+        parallel_worker_run(&workers[i]);
+    for (i = 1; i < nconnections; i++)
+      if (workers[i].done)
+        PyThread_acquire_lock(workers[i].done, WAIT_LOCK);
+  }
+  Py_END_ALLOW_THREADS;
+
+  for (i = 1; i < nconnections; i++)
+  {
+    if (workers[i].done)
+    {
+      PyThread_release_lock(workers[i].done);
+      PyThread_free_lock(workers[i].done);
+    }
+  }
+  for (i = 0; i < nqueries; i++)
+    INUSE_RELEASE(pqueries[i].cursor);
+
+  results = PyList_New(nqueries);
+  if (!results)
+    goto finally;
+
+  for (i = 0; i < nqueries; i++)
+  {
+    ParallelQuery *query = &pqueries[i];
+    APSWCursor *cursor = query->cursor;
+    PyObject *rows;
+    Py_ssize_t r;
+    int c;
+
+    if (query->no_memory)
+    {
+      PyErr_NoMemory();
+      goto finally;
+    }
+
+    rows = PyList_New(0);
+    if (!rows)
+      goto finally;
+    PyList_SET_ITEM(results, i, rows);
+
+    for (r = 0; r < query->nrows; r++)
+    {
+      APSWColumnValue *values = query->values + r * query->numcols;
+      PyObject *row;
+
+      for (c = 0; c < query->numcols; c++)
+        if (values[c].type == SQLITE_TEXT || values[c].type == SQLITE_BLOB)
+          values[c].u.p = query->data + values[c].u.i;
+
+      row = convert_values_to_pytuple(values, query->numcols);
+      if (!row)
+        goto finally;
+      if (cursor->rowtrace || cursor->connection->rowtrace)
+      {
+        PyObject *traced = APSWCursor_do_row_trace(cursor, row);
+        Py_DECREF(row);
+        if (!traced)
+          goto finally;
+        if (Py_IsNone(traced))
+        {
+          Py_DECREF(traced);
+          continue;
+        }
+        row = traced;
+      }
+      if (PyList_Append(rows, row))
+      {
+        Py_DECREF(row);
+        goto finally;
+      }
+      Py_DECREF(row);
+    }
+
+    /* this gets the error for a failed step */
+    cursor->status = C_DONE;
+    if (APSWCursor_close_internal(cursor, 0))
+      goto finally;
+  }
+
+finally:
+  if (pqueries)
+  {
+    for (i = 0; i < nqueries; i++)
+    {
+      if (pqueries[i].cursor)
+      {
+        APSWCursor_close_internal(pqueries[i].cursor, 2);
+        Py_DECREF((PyObject *)pqueries[i].cursor);
+      }
+      PyMem_RawFree(pqueries[i].values);
+      PyMem_RawFree(pqueries[i].data);
+    }
+  }
+  for (i = 0; i < nconnections; i++)
+  {
+    PY_ERR_FETCH(exc_save);
+    int res = ConnectionPool_release_internal(self, connections[i]);
+    if (exc_save)
+    {
+      if (res)
+        apsw_write_unraisable(NULL);
+      PY_ERR_RESTORE(exc_save);
+    }
+    Py_DECREF((PyObject *)connections[i]);
+  }
+  PyMem_Free(connections);
+  PyMem_Free(workers);
+  PyMem_Free(pqueries);
+  Py_DECREF(items);
+  if (PyErr_Occurred())
+    Py_CLEAR(results);
+  return results;
+}
+
+/** .. method:: stats() -> dict[str, int | float]
+
+  Returns information about the pool.
+
+  .. list-table::
+    :header-rows: 1
+    :widths: auto
+
+    * - Key
+      - Explanation
+    * - size
+      - Maximum number of connections
+    * - open
+      - Connections currently open (including being opened)
+    * - idle
+      - Open connections not currently acquired
+    * - waiting
+      - Threads currently waiting in :meth:`~ConnectionPool.acquire`
+    * - opened
+      - How many connections have been opened
+    * - checkouts
+      - How many times :meth:`~ConnectionPool.acquire` succeeded
+    * - affinity_hits
+      - How many of those returned the connection the thread used last
+    * - waits
+      - How many times :meth:`~ConnectionPool.acquire` had to wait
+    * - timeouts
+      - How many times :meth:`~ConnectionPool.acquire` timed out
+    * - checkout_time
+      - Total seconds spent in successful :meth:`~ConnectionPool.acquire`
+    * - max_checkout_time
+      - Longest successful :meth:`~ConnectionPool.acquire` in seconds
+    * - wait_time
+      - Total seconds spent waiting for a connection
+    * - max_wait_time
+      - Longest wait for a connection in seconds
+*/
+static PyObject *
+ConnectionPool_stats(ConnectionPool *self)
+{
+  unsigned i, idle = 0;
+
+  for (i = 0; i < self->count; i++)
+    if (!self->entries[i].checked_out)
+      idle++;
+
+  return Py_BuildValue("{s: I, s: I, s: I, s: I, s: K, s: K, s: K, s: K, s: K, s: d, s: d, s: d, s: d}",
+                       "size", self->size,
+                       "open", self->count,
+                       "idle", idle,
+                       "waiting", self->waiting,
+                       "opened", self->opened,
+                       "checkouts", self->checkouts,
+                       "affinity_hits", self->affinity_hits,
+                       "waits", self->waits,
+                       "timeouts", self->timeouts,
+                       "checkout_time", self->checkout_ns / 1e9,
+                       "max_checkout_time", self->max_checkout_ns / 1e9,
+                       "wait_time", self->wait_ns / 1e9,
+                       "max_wait_time", self->max_wait_ns / 1e9);
+}
+
+/** .. method:: close() -> None
+
+  Closes idle connections, and wakes waiting threads which get
+  :exc:`ConnectionClosedError`.  Connections that are currently
+  acquired are closed when they are released.  It is safe to call
+  this method multiple times.
+*/
+static PyObject *
+ConnectionPool_close(ConnectionPool *self)
+{
+  unsigned i;
+
+  self->closed = 1;
+
+  while (self->waiters)
+    ConnectionPool_wake_waiter(self, NULL);
+
+  for (i = 0; i < self->count;)
+  {
+    Connection *connection;
+    int res;
+
+    if (self->entries[i].checked_out)
+    {
+      i++;
+      continue;
+    }
+    connection = (Connection *)Py_NewRef((PyObject *)self->entries[i].connection);
+    ConnectionPool_remove_entry(self, i);
+    res = Connection_close_internal(connection, 0);
+    Py_DECREF((PyObject *)connection);
+    if (res)
+      return NULL;
+  }
+
+  Py_RETURN_NONE;
+}
+
+static int
+ConnectionPool_tp_traverse(ConnectionPool *self, visitproc visit, void *arg)
+{
+  unsigned i;
+  PoolWaiter *waiter;
+
+  Py_VISIT(self->open_args);
+  Py_VISIT(self->setup);
+  for (i = 0; i < self->count; i++)
+    Py_VISIT((PyObject *)self->entries[i].connection);
+  for (waiter = self->waiters; waiter; waiter = waiter->next)
+    Py_VISIT((PyObject *)waiter->handed);
+  return 0;
+}
+
+/* only called when unreachable so there can't be waiters or
+   connections being opened, which hold a reference */
+static int
+ConnectionPool_tp_clear(ConnectionPool *self)
+{
+  self->closed = 1;
+  while (self->count)
+    ConnectionPool_remove_entry(self, self->count - 1);
+  Py_CLEAR(self->open_args);
+  Py_CLEAR(self->setup);
+  return 0;
+}
+
+static void
+ConnectionPool_dealloc(ConnectionPool *self)
+{
+  PyObject_GC_UnTrack(self);
+  APSW_CLEAR_WEAKREFS;
+
+  /* there can't be waiters because they hold a reference */
+  assert(!self->waiters);
+  while (self->count)
+    ConnectionPool_remove_entry(self, self->count - 1);
+  PyMem_Free(self->entries);
+  Py_CLEAR(self->open_args);
+  Py_CLEAR(self->setup);
+
+  Py_TpFree((PyObject *)self);
+}
+
+static PyObject *
+ConnectionPool_tp_str(ConnectionPool *self)
+{
+  return PyUnicode_FromFormat("<apsw.ConnectionPool object %s%R open %u of %u at %p>",
+                              self->closed ? "(closed) " : "",
+                              self->open_args ? PyTuple_GET_ITEM(self->open_args, 0) : Py_None,
+                              self->count, self->size, self);
+}
+
+static PyMethodDef ConnectionPool_methods[] = {
+    {"acquire", (PyCFunction)ConnectionPool_acquire, METH_FASTCALL | METH_KEYWORDS,
+     ConnectionPool_acquire_DOC},
+    {"release", (PyCFunction)ConnectionPool_release, METH_FASTCALL | METH_KEYWORDS,
+     ConnectionPool_release_DOC},
+    {"release_idle", (PyCFunction)ConnectionPool_release_idle, METH_FASTCALL | METH_KEYWORDS,
+     ConnectionPool_release_idle_DOC},
+    {"parallel_execute", (PyCFunction)ConnectionPool_parallel_execute, METH_FASTCALL | METH_KEYWORDS,
+     ConnectionPool_parallel_execute_DOC},
+    {"stats", (PyCFunction)ConnectionPool_stats, METH_NOARGS,
+     ConnectionPool_stats_DOC},
+    {"close", (PyCFunction)ConnectionPool_close, METH_NOARGS,
+     ConnectionPool_close_DOC},
+    {0, 0, 0, 0}};
+
+static PyTypeObject ConnectionPoolType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "apsw.ConnectionPool",
+    .tp_basicsize = sizeof(ConnectionPool),
+    .tp_dealloc = (destructor)ConnectionPool_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC,
+    .tp_doc = ConnectionPool_class_DOC,
+    .tp_traverse = (traverseproc)ConnectionPool_tp_traverse,
+    .tp_clear = (inquiry)ConnectionPool_tp_clear,
+    .tp_weaklistoffset = offsetof(ConnectionPool, weakreflist),
+    .tp_methods = ConnectionPool_methods,
+    .tp_init = (initproc)ConnectionPool_init,
+    .tp_new = ConnectionPool_new,
+    .tp_str = (reprfunc)ConnectionPool_tp_str,
+};
@@ -122,6 +122,21 @@ convertutf8string(const char *str)
   return PyUnicode_FromStringAndSize(str, strlen(str));
 }
 
+/* A monotonic high resolution clock in nanoseconds for measuring
+   durations.  It can be called without the GIL. */
+static long long
+apsw_perf_counter_ns(void)
+{
+#if PY_VERSION_HEX < 0x030d0000
+  return _PyTime_GetPerfCounter();
+#else
+  PyTime_t t;
+  /* t is set to zero on failure */
+  PyTime_PerfCounterRaw(&t);
+  return t;
+#endif
+}
+
 #if PY_VERSION_HEX < 0x030d0000
 #undef PyLong_AsInt
 static int
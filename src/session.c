@@ -0,0 +1,1986 @@
+/*
+  Another Python Sqlite Wrapper
+
+  Session extension - recording, applying and combining changesets
+
+  See the accompanying LICENSE file.
+*/
+
+/**
+
+.. _session:
+
+Session extension
+*****************
+
+The `session extension <https://www.sqlite.org/sessionintro.html>`__
+records the changes made to tables, and produces compact binary
+*changesets* (or smaller *patchsets*) describing them.  Changesets can
+be applied to another copy of the database, inverted, combined, and
+examined.  This is a cheap way of keeping replicas up to date compared
+to diffing tables with queries, or recording each change in Python
+with :meth:`Connection.set_update_hook`.
+
+.. code-block:: python
+
+  session = apsw.Session(db, "main")
+  # record changes to all tables
+  session.attach()
+
+  db.execute("...")
+
+  changeset = session.changeset()
+
+  # and on the replica
+  apsw.Changeset(changeset).apply(replica)
+
+Only tables with a PRIMARY KEY are recorded.  The session extension
+is only present if SQLite was compiled with ``SQLITE_ENABLE_SESSION``
+and ``SQLITE_ENABLE_PREUPDATE_HOOK``, which ``--enable-all-extensions``
+does.  You can check with ``hasattr(apsw, "Session")``.
+
+Streaming
+=========
+
+Changesets don't have to fit in memory.  Methods ending in ``_stream``
+call an *output* function with each chunk as a :class:`memoryview`
+(only valid during the call) instead of returning :class:`bytes`.
+Anywhere a changeset is accepted, you can instead provide a function
+which is called with the maximum number of bytes wanted, and returns
+:class:`bytes` (or similar) with at most that many, with empty meaning
+the end.  For example ``file.read`` of a file opened in binary mode.
+*/
+
+#ifdef SQLITE_ENABLE_SESSION
+
+/* a changeset as a buffer, or a function returning chunks of one */
+typedef struct
+{
+  PyObject *stream; /* borrowed reference, NULL when buffer is used */
+  Py_buffer buffer;
+  Py_ssize_t offset; /* how much of buffer has been read by changeset_input_read */
+} ChangesetInput;
+
+/* where streamed output goes: a function, or collected in memory */
+typedef struct
+{
+  PyObject *stream; /* borrowed reference, NULL to collect */
+  char *data;
+  size_t len;
+  size_t allocated;
+} ChangesetOutput;
+
+/* returns zero on success, -1 with an exception on failure */
+static int
+changeset_input_init(ChangesetInput *input, PyObject *changeset)
+{
+  input->stream = NULL;
+  input->offset = 0;
+  if (PyCallable_Check(changeset))
+  {
+    input->stream = changeset;
+    return 0;
+  }
+  if (0 != PyObject_GetBuffer(changeset, &input->buffer, PyBUF_SIMPLE))
+    return -1;
+  if (input->buffer.len > INT_MAX)
+  {
+    PyErr_Format(PyExc_ValueError, "Changeset of %zd bytes is larger than SQLite supports", input->buffer.len);
+    PyBuffer_Release(&input->buffer);
+    return -1;
+  }
+  return 0;
+}
+
+static void
+changeset_input_release(ChangesetInput *input)
+{
+  if (!input->stream)
+    PyBuffer_Release(&input->buffer);
+}
+
+/* xInput for the streaming functions.  Called with the GIL released */
+static int
+changeset_input_read(void *pIn, void *pData, int *pnData)
+{
+  ChangesetInput *input = (ChangesetInput *)pIn;
+  PyGILState_STATE gilstate;
+  PyObject *chunk = NULL;
+  Py_buffer buffer;
+  int wanted = *pnData, res = SQLITE_ERROR;
+
+  if (!input->stream)
+  {
+    if (wanted > input->buffer.len - input->offset)
+      wanted = (int)(input->buffer.len - input->offset);
+    memcpy(pData, (char *)input->buffer.buf + input->offset, wanted);
+    input->offset += wanted;
+    *pnData = wanted;
+    return SQLITE_OK;
+  }
+
+  gilstate = PyGILState_Ensure();
+
+  MakeExistingException();
+
+  if (PyErr_Occurred())
+    goto finally;
+
+  PyObject *vargs[] = {NULL, PyLong_FromLong(wanted)};
+  if (vargs[1])
+    chunk = PyObject_Vectorcall(input->stream, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  Py_XDECREF(vargs[1]);
+  if (!chunk || 0 != PyObject_GetBuffer(chunk, &buffer, PyBUF_SIMPLE))
+    goto finally;
+  if (buffer.len > wanted)
+    PyErr_Format(PyExc_ValueError, "Changeset stream returned %zd bytes when at most %d were asked for", buffer.len,
+                 wanted);
+  else
+  {
+    memcpy(pData, buffer.buf, buffer.len);
+    *pnData = (int)buffer.len;
+    res = SQLITE_OK;
+  }
+  PyBuffer_Release(&buffer);
+
+finally:
+  if (PyErr_Occurred())
+    AddTraceBackHere(__FILE__, __LINE__, "changeset_input_read", "{s: O, s: i}", "stream", input->stream, "amount",
+                     wanted);
+  Py_XDECREF(chunk);
+  PyGILState_Release(gilstate);
+  return res;
+}
+
+/* xOutput for the streaming functions.  Called with the GIL released */
+static int
+changeset_output_write(void *pOut, const void *pData, int nData)
+{
+  ChangesetOutput *output = (ChangesetOutput *)pOut;
+  PyGILState_STATE gilstate;
+  PyObject *view = NULL, *result = NULL;
+  int res = SQLITE_ERROR;
+
+  if (!output->stream)
+  {
+    if (output->len + nData > output->allocated)
+    {
+      size_t allocated = output->allocated ? output->allocated : 65536;
+      char *data;
+      while (allocated < output->len + nData)
+        allocated *= 2;
+      data = PyMem_RawRealloc(output->data, allocated);
+      if (!data)
+        return SQLITE_NOMEM;
+      output->data = data;
+      output->allocated = allocated;
+    }
+    memcpy(output->data + output->len, pData, nData);
+    output->len += nData;
+    return SQLITE_OK;
+  }
+
+  gilstate = PyGILState_Ensure();
+
+  MakeExistingException();
+
+  if (PyErr_Occurred())
+    goto finally;
+
+  view = PyMemoryView_FromMemory((char *)pData, nData, PyBUF_READ);
+  if (!view)
+    goto finally;
+  PyObject *vargs[] = {NULL, view};
+  result = PyObject_Vectorcall(output->stream, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  if (0 != memoryview_release(view))
+    Py_CLEAR(result);
+  if (result)
+    res = SQLITE_OK;
+
+finally:
+  if (PyErr_Occurred())
+    AddTraceBackHere(__FILE__, __LINE__, "changeset_output_write", "{s: O, s: i}", "output", output->stream, "amount",
+                     nData);
+  Py_XDECREF(view);
+  Py_XDECREF(result);
+  PyGILState_Release(gilstate);
+  return res;
+}
+
+/* bytes of everything collected, or NULL with an exception if res is
+   an error.  Frees the collected memory. */
+static PyObject *
+changeset_output_finish(ChangesetOutput *output, int res)
+{
+  PyObject *result = NULL;
+
+  SET_EXC(res, NULL);
+  if (!PyErr_Occurred())
+    result = output->stream ? Py_NewRef(Py_None) : PyBytes_FromStringAndSize(output->data, output->len);
+  PyMem_RawFree(output->data);
+  output->data = NULL;
+  return result;
+}
+
+/* TABLECHANGE CODE */
+
+/** .. class:: TableChange
+
+  Describes one change in a changeset, provided by iterating over a
+  :class:`Changeset` and to the conflict handler of
+  :meth:`Changeset.apply`.  It is only valid until the next change, or
+  the conflict handler returns, after which accessing it raises
+  :exc:`ValueError`.
+
+  Columns are in table order, and columns whose values are not part of
+  the change are :attr:`apsw.no_change`.  That happens for columns not
+  updated, and non primary key columns in patchsets.
+*/
+
+typedef struct APSWTableChange
+{
+  PyObject_HEAD
+  sqlite3_changeset_iter *iter; /* NULL once out of scope */
+  int conflict_type;            /* zero when not in a conflict handler */
+} APSWTableChange;
+
+static PyTypeObject APSWTableChangeType;
+
+#define CHECK_TABLE_CHANGE(e)                                                \
+  do                                                                         \
+  {                                                                          \
+    if (!self->iter)                                                         \
+    {                                                                        \
+      PyErr_Format(PyExc_ValueError, "TableChange is out of scope");         \
+      return e;                                                              \
+    }                                                                        \
+  } while (0)
+
+static PyObject *
+tablechange_new(sqlite3_changeset_iter *iter, int conflict_type)
+{
+  APSWTableChange *change = (APSWTableChange *)_PyObject_New(&APSWTableChangeType);
+  if (change)
+  {
+    change->iter = iter;
+    change->conflict_type = conflict_type;
+  }
+  return (PyObject *)change;
+}
+
+static void
+tablechange_invalidate(PyObject *change)
+{
+  ((APSWTableChange *)change)->iter = NULL;
+}
+
+/* returns SQLITE_OK or an error code with the exception set */
+static int
+tablechange_op(APSWTableChange *change, const char **name, int *column_count, int *op, int *indirect)
+{
+  int res = sqlite3changeset_op(change->iter, name, column_count, op, indirect);
+  SET_EXC(res, NULL);
+  return res;
+}
+
+/* tuple of values from sqlite3changeset_old, new or conflict */
+static PyObject *
+tablechange_values(APSWTableChange *change, int column_count,
+                   int (*get)(sqlite3_changeset_iter *, int, sqlite3_value **))
+{
+  PyObject *values = PyTuple_New(column_count);
+  int i;
+
+  for (i = 0; values && i < column_count; i++)
+  {
+    sqlite3_value *value = NULL;
+    PyObject *item;
+    int res = get(change->iter, i, &value);
+    if (res != SQLITE_OK)
+    {
+      SET_EXC(res, NULL);
+      Py_CLEAR(values);
+      break;
+    }
+    item = value ? convert_value_to_pyobject(value, 0, 0) : Py_NewRef((PyObject *)&apsw_no_change_object);
+    if (!item)
+    {
+      Py_CLEAR(values);
+      break;
+    }
+    PyTuple_SET_ITEM(values, i, item);
+  }
+  return values;
+}
+
+/** .. attribute:: name
+  :type: str
+
+  Name of the table
+*/
+static PyObject *
+APSWTableChange_get_name(APSWTableChange *self)
+{
+  const char *name;
+  int column_count, op, indirect;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  if (tablechange_op(self, &name, &column_count, &op, &indirect))
+    return NULL;
+  return PyUnicode_FromString(name);
+}
+
+/** .. attribute:: column_count
+  :type: int
+
+  Number of columns in the table
+*/
+static PyObject *
+APSWTableChange_get_column_count(APSWTableChange *self)
+{
+  const char *name;
+  int column_count, op, indirect;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  if (tablechange_op(self, &name, &column_count, &op, &indirect))
+    return NULL;
+  return PyLong_FromLong(column_count);
+}
+
+/** .. attribute:: op
+  :type: str
+
+  The operation - ``INSERT``, ``UPDATE``, or ``DELETE``
+*/
+static PyObject *
+APSWTableChange_get_op(APSWTableChange *self)
+{
+  const char *name;
+  int column_count, op, indirect;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  if (tablechange_op(self, &name, &column_count, &op, &indirect))
+    return NULL;
+  return PyUnicode_FromString(op == SQLITE_INSERT ? "INSERT" : (op == SQLITE_DELETE ? "DELETE" : "UPDATE"));
+}
+
+/** .. attribute:: opcode
+  :type: int
+
+  The operation as ``SQLITE_INSERT``, ``SQLITE_UPDATE``, or ``SQLITE_DELETE``
+*/
+static PyObject *
+APSWTableChange_get_opcode(APSWTableChange *self)
+{
+  const char *name;
+  int column_count, op, indirect;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  if (tablechange_op(self, &name, &column_count, &op, &indirect))
+    return NULL;
+  return PyLong_FromLong(op);
+}
+
+/** .. attribute:: indirect
+  :type: bool
+
+  True if the change was made while the session was
+  :attr:`indirect <Session.indirect>`, such as by a trigger
+*/
+static PyObject *
+APSWTableChange_get_indirect(APSWTableChange *self)
+{
+  const char *name;
+  int column_count, op, indirect;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  if (tablechange_op(self, &name, &column_count, &op, &indirect))
+    return NULL;
+  return Py_NewRef(indirect ? Py_True : Py_False);
+}
+
+/** .. attribute:: old
+  :type: SQLiteValues | None
+
+  Values before an ``UPDATE`` or ``DELETE``, and None for ``INSERT``
+
+  -* sqlite3changeset_old
+*/
+static PyObject *
+APSWTableChange_get_old(APSWTableChange *self)
+{
+  const char *name;
+  int column_count, op, indirect;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  if (tablechange_op(self, &name, &column_count, &op, &indirect))
+    return NULL;
+  if (op == SQLITE_INSERT)
+    Py_RETURN_NONE;
+  return tablechange_values(self, column_count, sqlite3changeset_old);
+}
+
+/** .. attribute:: new
+  :type: SQLiteValues | None
+
+  Values after an ``UPDATE`` or ``INSERT``, and None for ``DELETE``
+
+  -* sqlite3changeset_new
+*/
+static PyObject *
+APSWTableChange_get_new(APSWTableChange *self)
+{
+  const char *name;
+  int column_count, op, indirect;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  if (tablechange_op(self, &name, &column_count, &op, &indirect))
+    return NULL;
+  if (op == SQLITE_DELETE)
+    Py_RETURN_NONE;
+  return tablechange_values(self, column_count, sqlite3changeset_new);
+}
+
+/** .. attribute:: pk_columns
+  :type: set[int]
+
+  Which columns make up the primary key
+
+  -* sqlite3changeset_pk
+*/
+static PyObject *
+APSWTableChange_get_pk_columns(APSWTableChange *self)
+{
+  PyObject *columns, *column;
+  unsigned char *pk = NULL;
+  int column_count = 0, res, i;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  res = sqlite3changeset_pk(self->iter, &pk, &column_count);
+  SET_EXC(res, NULL);
+  if (res != SQLITE_OK)
+    return NULL;
+
+  columns = PySet_New(NULL);
+  for (i = 0; columns && i < column_count; i++)
+  {
+    if (!pk[i])
+      continue;
+    column = PyLong_FromLong(i);
+    if (!column || 0 != PySet_Add(columns, column))
+      Py_CLEAR(columns);
+    Py_XDECREF(column);
+  }
+  return columns;
+}
+
+/** .. attribute:: conflict
+  :type: SQLiteValues | None
+
+  In the conflict handler for ``SQLITE_CHANGESET_DATA`` and
+  ``SQLITE_CHANGESET_CONFLICT`` the current values of the conflicting
+  row in the database, otherwise None
+
+  -* sqlite3changeset_conflict
+*/
+static PyObject *
+APSWTableChange_get_conflict(APSWTableChange *self)
+{
+  const char *name;
+  int column_count, op, indirect;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  if (self->conflict_type != SQLITE_CHANGESET_DATA && self->conflict_type != SQLITE_CHANGESET_CONFLICT)
+    Py_RETURN_NONE;
+  if (tablechange_op(self, &name, &column_count, &op, &indirect))
+    return NULL;
+  return tablechange_values(self, column_count, sqlite3changeset_conflict);
+}
+
+/** .. attribute:: fk_conflicts
+  :type: int | None
+
+  In the conflict handler for ``SQLITE_CHANGESET_FOREIGN_KEY`` how
+  many foreign key constraints would be violated, otherwise None.  The
+  other attributes are not meaningful in that case.
+
+  -* sqlite3changeset_fk_conflicts
+*/
+static PyObject *
+APSWTableChange_get_fk_conflicts(APSWTableChange *self)
+{
+  int count = 0, res;
+
+  CHECK_TABLE_CHANGE(NULL);
+
+  if (self->conflict_type != SQLITE_CHANGESET_FOREIGN_KEY)
+    Py_RETURN_NONE;
+  res = sqlite3changeset_fk_conflicts(self->iter, &count);
+  SET_EXC(res, NULL);
+  if (res != SQLITE_OK)
+    return NULL;
+  return PyLong_FromLong(count);
+}
+
+static PyObject *
+APSWTableChange_tp_str(APSWTableChange *self)
+{
+  const char *name;
+  int column_count, op, indirect;
+
+  if (!self->iter || self->conflict_type == SQLITE_CHANGESET_FOREIGN_KEY)
+    return PyUnicode_FromFormat("<apsw.TableChange %s at %p>", self->iter ? "foreign key conflict" : "out of scope",
+                                self);
+  if (tablechange_op(self, &name, &column_count, &op, &indirect))
+    return NULL;
+  return PyUnicode_FromFormat("<apsw.TableChange %s %s at %p>",
+                              op == SQLITE_INSERT ? "INSERT" : (op == SQLITE_DELETE ? "DELETE" : "UPDATE"), name, self);
+}
+
+static PyGetSetDef APSWTableChange_getset[] = {
+    {"name", (getter)APSWTableChange_get_name, NULL, TableChange_name_DOC},
+    {"column_count", (getter)APSWTableChange_get_column_count, NULL, TableChange_column_count_DOC},
+    {"op", (getter)APSWTableChange_get_op, NULL, TableChange_op_DOC},
+    {"opcode", (getter)APSWTableChange_get_opcode, NULL, TableChange_opcode_DOC},
+    {"indirect", (getter)APSWTableChange_get_indirect, NULL, TableChange_indirect_DOC},
+    {"old", (getter)APSWTableChange_get_old, NULL, TableChange_old_DOC},
+    {"new", (getter)APSWTableChange_get_new, NULL, TableChange_new_DOC},
+    {"pk_columns", (getter)APSWTableChange_get_pk_columns, NULL, TableChange_pk_columns_DOC},
+    {"conflict", (getter)APSWTableChange_get_conflict, NULL, TableChange_conflict_DOC},
+    {"fk_conflicts", (getter)APSWTableChange_get_fk_conflicts, NULL, TableChange_fk_conflicts_DOC},
+    /* sentinel */
+    {NULL, NULL, NULL, NULL}};
+
+static PyTypeObject APSWTableChangeType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "apsw.TableChange",
+    .tp_basicsize = sizeof(APSWTableChange),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = TableChange_class_DOC,
+    .tp_getset = APSWTableChange_getset,
+    .tp_str = (reprfunc)APSWTableChange_tp_str,
+};
+
+#undef CHECK_TABLE_CHANGE
+
+/* SESSION CODE */
+
+/** .. class:: Session
+
+  Records changes made to tables in one database of a
+  :class:`Connection`.  Wraps a `sqlite3_session
+  <https://www.sqlite.org/session/session.html>`__.
+*/
+
+typedef struct APSWSession
+{
+  PyObject_HEAD
+  int init_was_called;
+  int inuse;
+  Connection *connection;
+  sqlite3_session *session;
+  PyObject *table_filter;
+  PyObject *weakreflist;
+} APSWSession;
+
+static PyTypeObject APSWSessionType;
+
+#define CHECK_SESSION_CLOSED(e)                                         \
+  do                                                                    \
+  {                                                                     \
+    if (!self->session)                                                 \
+    {                                                                   \
+      PyErr_Format(ExcConnectionClosed, "The session has been closed"); \
+      return e;                                                         \
+    }                                                                   \
+  } while (0)
+
+static PyObject *
+APSWSession_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSED(kwds))
+{
+  APSWSession *self = (APSWSession *)type->tp_alloc(type, 0);
+  if (self)
+  {
+    self->init_was_called = 0;
+    INUSE_RELEASE(self);
+    self->connection = NULL;
+    self->session = NULL;
+    self->table_filter = NULL;
+    self->weakreflist = NULL;
+  }
+  return (PyObject *)self;
+}
+
+/** .. method:: __init__(db: Connection, schema: str)
+
+  Starts a session, which won't record anything until you
+  :meth:`attach` tables.
+
+  :param db: The connection, which must remain open.  Closing it
+     closes the session.
+  :param schema: `main`, `temp`, the name in `ATTACH <https://sqlite.org/lang_attach.html>`__
+
+  -* sqlite3session_create
+*/
+static int
+APSWSession_init(APSWSession *self, PyObject *args, PyObject *kwargs)
+{
+  Connection *db = NULL;
+  const char *schema = NULL;
+  PyObject *weakref;
+  int res;
+
+  {
+    Session_init_CHECK;
+    PREVENT_INIT_MULTIPLE_CALLS;
+    ARG_CONVERT_VARARGS_TO_FASTCALL;
+    ARG_PROLOG(2, Session_init_KWNAMES);
+    ARG_MANDATORY ARG_Connection(db);
+    ARG_MANDATORY ARG_str(schema);
+    ARG_EPILOG(-1, Session_init_USAGE, Py_XDECREF(fast_kwnames));
+  }
+
+  CHECK_CLOSED(db, -1);
+
+  _PYSQLITE_CALL_E(db->db, res = sqlite3session_create(db->db, schema, &self->session));
+  SET_EXC(res, db->db);
+  if (res != SQLITE_OK)
+    return -1;
+
+  self->connection = (Connection *)Py_NewRef((PyObject *)db);
+  weakref = PyWeakref_NewRef((PyObject *)self, NULL);
+  if (!weakref)
+    return -1;
+  res = PyList_Append(db->dependents, weakref);
+  Py_DECREF(weakref);
+  return res ? -1 : 0;
+}
+
+static void
+APSWSession_close_internal(APSWSession *self)
+{
+  if (self->session)
+  {
+    _PYSQLITE_CALL_V(sqlite3session_delete(self->session));
+    self->session = NULL;
+  }
+  if (self->connection)
+    Connection_remove_dependent(self->connection, (PyObject *)self);
+  Py_CLEAR(self->connection);
+  Py_CLEAR(self->table_filter);
+}
+
+static int
+APSWSession_tp_traverse(APSWSession *self, visitproc visit, void *arg)
+{
+  Py_VISIT(self->connection);
+  Py_VISIT(self->table_filter);
+  return 0;
+}
+
+static int
+APSWSession_tp_clear(APSWSession *self)
+{
+  APSWSession_close_internal(self);
+  return 0;
+}
+
+static void
+APSWSession_dealloc(APSWSession *self)
+{
+  PyObject_GC_UnTrack(self);
+  APSW_CLEAR_WEAKREFS;
+
+  APSWSession_close_internal(self);
+
+  Py_TpFree((PyObject *)self);
+}
+
+/** .. method:: close(force: bool = False) -> None
+
+  Ends the session.  It is also closed when the :class:`Connection`
+  is closed.  *force* is accepted for consistency with the other
+  close methods, as ending a session can't fail.
+
+  -* sqlite3session_delete
+*/
+static PyObject *
+APSWSession_close(APSWSession *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  int force = 0;
+
+  CHECK_USE(NULL);
+
+  {
+    Session_close_CHECK;
+    ARG_PROLOG(1, Session_close_KWNAMES);
+    ARG_OPTIONAL ARG_bool(force);
+    ARG_EPILOG(NULL, Session_close_USAGE, );
+  }
+
+  APSWSession_close_internal(self);
+
+  Py_RETURN_NONE;
+}
+
+/** .. method:: attach(name: Optional[str] = None) -> None
+
+  Records changes to the named table, or all tables if *name* is None.
+
+  -* sqlite3session_attach
+*/
+static PyObject *
+APSWSession_attach(APSWSession *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  const char *name = NULL;
+  int res;
+
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  {
+    Session_attach_CHECK;
+    ARG_PROLOG(1, Session_attach_KWNAMES);
+    ARG_OPTIONAL ARG_optional_str(name);
+    ARG_EPILOG(NULL, Session_attach_USAGE, );
+  }
+
+  PYSQLITE_SESSION_CALL(res = sqlite3session_attach(self->session, name));
+  SET_EXC(res, self->connection->db);
+  if (res != SQLITE_OK)
+    return NULL;
+
+  Py_RETURN_NONE;
+}
+
+/** .. method:: diff(from_schema: str, table: str) -> None
+
+  Records the changes needed to make *table* in this session's
+  database the same as in *from_schema*, such as another attached
+  database.  The table must have the same columns and primary key in
+  both.
+
+  -* sqlite3session_diff
+*/
+static PyObject *
+APSWSession_diff(APSWSession *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  const char *from_schema = NULL, *table = NULL;
+  char *errmsg = NULL;
+  int res;
+
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  {
+    Session_diff_CHECK;
+    ARG_PROLOG(2, Session_diff_KWNAMES);
+    ARG_MANDATORY ARG_str(from_schema);
+    ARG_MANDATORY ARG_str(table);
+    ARG_EPILOG(NULL, Session_diff_USAGE, );
+  }
+
+  PYSQLITE_SESSION_CALL(res = sqlite3session_diff(self->session, from_schema, table, &errmsg));
+  if (res != SQLITE_OK && errmsg)
+    apsw_set_errmsg(errmsg);
+  sqlite3_free(errmsg);
+  SET_EXC(res, self->connection->db);
+  if (res != SQLITE_OK)
+    return NULL;
+
+  Py_RETURN_NONE;
+}
+
+/* changeset or patchset as bytes */
+static PyObject *
+APSWSession_generate(APSWSession *self, int patchset)
+{
+  PyObject *result = NULL;
+  void *data = NULL;
+  int size = 0, res;
+
+  if (patchset)
+    PYSQLITE_SESSION_CALL(res = sqlite3session_patchset(self->session, &size, &data));
+  else
+    PYSQLITE_SESSION_CALL(res = sqlite3session_changeset(self->session, &size, &data));
+  SET_EXC(res, self->connection->db);
+  if (res == SQLITE_OK)
+    result = PyBytes_FromStringAndSize(data, size);
+  sqlite3_free(data);
+  return result;
+}
+
+/* changeset or patchset to an output function */
+static PyObject *
+APSWSession_generate_stream(APSWSession *self, PyObject *output, int patchset)
+{
+  ChangesetOutput out = {output, NULL, 0, 0};
+  int res;
+
+  if (patchset)
+    PYSQLITE_SESSION_CALL(res = sqlite3session_patchset_strm(self->session, changeset_output_write, &out));
+  else
+    PYSQLITE_SESSION_CALL(res = sqlite3session_changeset_strm(self->session, changeset_output_write, &out));
+  return changeset_output_finish(&out, res);
+}
+
+/** .. method:: changeset() -> bytes
+
+  Returns a changeset of all the recorded changes.  Rows changed
+  several times have one entry with the net effect.
+
+  -* sqlite3session_changeset
+*/
+static PyObject *
+APSWSession_changeset(APSWSession *self)
+{
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  return APSWSession_generate(self, 0);
+}
+
+/** .. method:: changeset_stream(output: SessionStreamOutput) -> None
+
+  Provides the changeset in chunks to *output*, without needing it
+  all in memory.
+
+  -* sqlite3session_changeset_strm
+*/
+static PyObject *
+APSWSession_changeset_stream(APSWSession *self, PyObject *const *fast_args, Py_ssize_t fast_nargs,
+                             PyObject *fast_kwnames)
+{
+  PyObject *output = NULL;
+
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  {
+    Session_changeset_stream_CHECK;
+    ARG_PROLOG(1, Session_changeset_stream_KWNAMES);
+    ARG_MANDATORY ARG_Callable(output);
+    ARG_EPILOG(NULL, Session_changeset_stream_USAGE, );
+  }
+
+  return APSWSession_generate_stream(self, output, 0);
+}
+
+/** .. method:: patchset() -> bytes
+
+  Returns a patchset of all the recorded changes.  Patchsets are
+  smaller than changesets because updates only include changed
+  columns and deletes only include the primary key, but can't be
+  inverted and detect fewer conflicts.
+
+  -* sqlite3session_patchset
+*/
+static PyObject *
+APSWSession_patchset(APSWSession *self)
+{
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  return APSWSession_generate(self, 1);
+}
+
+/** .. method:: patchset_stream(output: SessionStreamOutput) -> None
+
+  Provides the patchset in chunks to *output*, without needing it
+  all in memory.
+
+  -* sqlite3session_patchset_strm
+*/
+static PyObject *
+APSWSession_patchset_stream(APSWSession *self, PyObject *const *fast_args, Py_ssize_t fast_nargs,
+                            PyObject *fast_kwnames)
+{
+  PyObject *output = NULL;
+
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  {
+    Session_patchset_stream_CHECK;
+    ARG_PROLOG(1, Session_patchset_stream_KWNAMES);
+    ARG_MANDATORY ARG_Callable(output);
+    ARG_EPILOG(NULL, Session_patchset_stream_USAGE, );
+  }
+
+  return APSWSession_generate_stream(self, output, 1);
+}
+
+/* xFilter for the session.  Called with the GIL released the first
+   time a table is changed */
+static int
+session_table_filter(void *pCtx, const char *zTab)
+{
+  APSWSession *self = (APSWSession *)pCtx;
+  PyGILState_STATE gilstate;
+  PyObject *retval = NULL;
+  int res = 0;
+
+  gilstate = PyGILState_Ensure();
+
+  MakeExistingException();
+
+  if (PyErr_Occurred() || !self->table_filter)
+    goto finally;
+
+  /* the callback can't close the session (deleting it while SQLite is
+     still using it) or change the filter out from under us.  It is
+     already marked in use if called from one of the session's own
+     methods */
+  Py_INCREF((PyObject *)self);
+  int acquired = INUSE_ACQUIRE(self);
+  PyObject *vargs[] = {NULL, PyUnicode_FromString(zTab)};
+  if (vargs[1])
+    retval = PyObject_Vectorcall(self->table_filter, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  Py_XDECREF(vargs[1]);
+  if (acquired)
+    INUSE_RELEASE(self);
+  if (retval)
+    res = PyObject_IsTrueStrict(retval);
+  if (res < 0)
+    res = 0;
+  if (PyErr_Occurred())
+    AddTraceBackHere(__FILE__, __LINE__, "Session.table_filter", "{s: O, s: s, s: O}", "callback",
+                     self->table_filter, "name", zTab, "result", OBJ(retval));
+  Py_DECREF((PyObject *)self);
+
+finally:
+  Py_XDECREF(retval);
+  PyGILState_Release(gilstate);
+  return res;
+}
+
+/** .. method:: table_filter(callback: Optional[Callable[[str], bool]]) -> None
+
+  When :meth:`attach` was called with None for all tables, the
+  *callback* is called with each table name the first time it is
+  changed, and returns True if changes should be recorded.
+
+  -* sqlite3session_table_filter
+*/
+static PyObject *
+APSWSession_table_filter(APSWSession *self, PyObject *const *fast_args, Py_ssize_t fast_nargs,
+                         PyObject *fast_kwnames)
+{
+  PyObject *callback = NULL;
+
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  {
+    Session_table_filter_CHECK;
+    ARG_PROLOG(1, Session_table_filter_KWNAMES);
+    ARG_MANDATORY ARG_optional_Callable(callback);
+    ARG_EPILOG(NULL, Session_table_filter_USAGE, );
+  }
+
+  Py_CLEAR(self->table_filter);
+  self->table_filter = Py_XNewRef(callback);
+  PYSQLITE_VOID_CALL(sqlite3session_table_filter(self->session, callback ? session_table_filter : NULL, self));
+
+  Py_RETURN_NONE;
+}
+
+/** .. attribute:: enabled
+  :type: bool
+
+  Changes are only recorded while the session is enabled, which it
+  is initially.
+
+  -* sqlite3session_enable
+*/
+static PyObject *
+APSWSession_get_enabled(APSWSession *self)
+{
+  int enabled;
+
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  PYSQLITE_VOID_CALL(enabled = sqlite3session_enable(self->session, -1));
+  return Py_NewRef(enabled ? Py_True : Py_False);
+}
+
+static int
+APSWSession_set_enabled(APSWSession *self, PyObject *value)
+{
+  int enabled;
+
+  CHECK_USE(-1);
+  CHECK_SESSION_CLOSED(-1);
+
+  if (!PyBool_Check(value))
+  {
+    PyErr_Format(PyExc_TypeError, "Expected a bool, not %s", Py_TypeName(value));
+    return -1;
+  }
+  PYSQLITE_VOID_CALL(enabled = sqlite3session_enable(self->session, Py_IsTrue(value)));
+  (void)enabled;
+  return 0;
+}
+
+/** .. attribute:: indirect
+  :type: bool
+
+  Changes recorded while this is True are marked as
+  :attr:`indirect <TableChange.indirect>`.  It is initially False.
+
+  -* sqlite3session_indirect
+*/
+static PyObject *
+APSWSession_get_indirect(APSWSession *self)
+{
+  int indirect;
+
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  PYSQLITE_VOID_CALL(indirect = sqlite3session_indirect(self->session, -1));
+  return Py_NewRef(indirect ? Py_True : Py_False);
+}
+
+static int
+APSWSession_set_indirect(APSWSession *self, PyObject *value)
+{
+  int indirect;
+
+  CHECK_USE(-1);
+  CHECK_SESSION_CLOSED(-1);
+
+  if (!PyBool_Check(value))
+  {
+    PyErr_Format(PyExc_TypeError, "Expected a bool, not %s", Py_TypeName(value));
+    return -1;
+  }
+  PYSQLITE_VOID_CALL(indirect = sqlite3session_indirect(self->session, Py_IsTrue(value)));
+  (void)indirect;
+  return 0;
+}
+
+/** .. attribute:: is_empty
+  :type: bool
+
+  True if no changes have been recorded
+
+  -* sqlite3session_isempty
+*/
+static PyObject *
+APSWSession_get_is_empty(APSWSession *self)
+{
+  int empty;
+
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  PYSQLITE_VOID_CALL(empty = sqlite3session_isempty(self->session));
+  return Py_NewRef(empty ? Py_True : Py_False);
+}
+
+/** .. attribute:: memory_used
+  :type: int
+
+  Bytes of memory used by the session
+
+  -* sqlite3session_memory_used
+*/
+static PyObject *
+APSWSession_get_memory_used(APSWSession *self)
+{
+  sqlite3_int64 used;
+
+  CHECK_USE(NULL);
+  CHECK_SESSION_CLOSED(NULL);
+
+  PYSQLITE_VOID_CALL(used = sqlite3session_memory_used(self->session));
+  return PyLong_FromLongLong(used);
+}
+
+static PyObject *
+APSWSession_tp_str(APSWSession *self)
+{
+  return PyUnicode_FromFormat("<apsw.Session object from %S at %p>",
+                              self->connection ? (PyObject *)self->connection : apst.closed, self);
+}
+
+static PyGetSetDef APSWSession_getset[] = {
+    {"enabled", (getter)APSWSession_get_enabled, (setter)APSWSession_set_enabled, Session_enabled_DOC},
+    {"indirect", (getter)APSWSession_get_indirect, (setter)APSWSession_set_indirect, Session_indirect_DOC},
+    {"is_empty", (getter)APSWSession_get_is_empty, NULL, Session_is_empty_DOC},
+    {"memory_used", (getter)APSWSession_get_memory_used, NULL, Session_memory_used_DOC},
+    /* sentinel */
+    {NULL, NULL, NULL, NULL}};
+
+static PyMethodDef APSWSession_methods[] = {
+    {"close", (PyCFunction)APSWSession_close, METH_FASTCALL | METH_KEYWORDS, Session_close_DOC},
+    {"attach", (PyCFunction)APSWSession_attach, METH_FASTCALL | METH_KEYWORDS, Session_attach_DOC},
+    {"diff", (PyCFunction)APSWSession_diff, METH_FASTCALL | METH_KEYWORDS, Session_diff_DOC},
+    {"changeset", (PyCFunction)APSWSession_changeset, METH_NOARGS, Session_changeset_DOC},
+    {"changeset_stream", (PyCFunction)APSWSession_changeset_stream, METH_FASTCALL | METH_KEYWORDS,
+     Session_changeset_stream_DOC},
+    {"patchset", (PyCFunction)APSWSession_patchset, METH_NOARGS, Session_patchset_DOC},
+    {"patchset_stream", (PyCFunction)APSWSession_patchset_stream, METH_FASTCALL | METH_KEYWORDS,
+     Session_patchset_stream_DOC},
+    {"table_filter", (PyCFunction)APSWSession_table_filter, METH_FASTCALL | METH_KEYWORDS, Session_table_filter_DOC},
+    /* sentinel */
+    {0, 0, 0, 0}};
+
+static PyTypeObject APSWSessionType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "apsw.Session",
+    .tp_basicsize = sizeof(APSWSession),
+    .tp_dealloc = (destructor)APSWSession_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_doc = Session_class_DOC,
+    .tp_traverse = (traverseproc)APSWSession_tp_traverse,
+    .tp_clear = (inquiry)APSWSession_tp_clear,
+    .tp_weaklistoffset = offsetof(APSWSession, weakreflist),
+    .tp_methods = APSWSession_methods,
+    .tp_getset = APSWSession_getset,
+    .tp_init = (initproc)APSWSession_init,
+    .tp_new = APSWSession_new,
+    .tp_str = (reprfunc)APSWSession_tp_str,
+};
+
+#undef CHECK_SESSION_CLOSED
+
+/* CHANGESET CODE */
+
+/** .. class:: Changeset
+
+  A changeset or patchset, from :class:`bytes` (or anything supporting
+  the buffer protocol), or a function providing it in chunks as
+  described in :ref:`streaming <session>`.  A function can only be
+  read once, so only one operation can be done with it.
+*/
+
+typedef struct APSWChangeset
+{
+  PyObject_HEAD
+  int init_was_called;
+  PyObject *changeset; /* buffer or stream function */
+} APSWChangeset;
+
+typedef struct APSWChangesetIterator
+{
+  PyObject_HEAD
+  int inuse;
+  APSWChangeset *changeset; /* NULL once finished */
+  ChangesetInput input;
+  sqlite3_changeset_iter *iter;
+  PyObject *current; /* TableChange for the current change */
+} APSWChangesetIterator;
+
+static PyTypeObject APSWChangesetIteratorType;
+
+#define CHECK_CHANGESET_INIT(e)                                                    \
+  do                                                                               \
+  {                                                                                \
+    if (!self->changeset)                                                          \
+    {                                                                              \
+      PyErr_Format(PyExc_ValueError, "Changeset __init__ has not been called"); \
+      return e;                                                                    \
+    }                                                                              \
+  } while (0)
+
+static PyObject *
+APSWChangeset_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSED(kwds))
+{
+  APSWChangeset *self = (APSWChangeset *)type->tp_alloc(type, 0);
+  if (self)
+  {
+    self->init_was_called = 0;
+    self->changeset = NULL;
+  }
+  return (PyObject *)self;
+}
+
+/** .. method:: __init__(changeset: ChangesetInput)
+
+  :param changeset: The changeset as bytes, or a function returning
+     chunks of it
+*/
+static int
+APSWChangeset_init(APSWChangeset *self, PyObject *args, PyObject *kwargs)
+{
+  PyObject *changeset = NULL;
+
+  {
+    Changeset_init_CHECK;
+    PREVENT_INIT_MULTIPLE_CALLS;
+    ARG_CONVERT_VARARGS_TO_FASTCALL;
+    ARG_PROLOG(1, Changeset_init_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(changeset);
+    ARG_EPILOG(-1, Changeset_init_USAGE, Py_XDECREF(fast_kwnames));
+  }
+
+  if (!PyCallable_Check(changeset) && !PyObject_CheckBuffer(changeset))
+  {
+    PyErr_Format(PyExc_TypeError, "Expected bytes or a callable, not %s", Py_TypeName(changeset));
+    return -1;
+  }
+  self->changeset = Py_NewRef(changeset);
+  return 0;
+}
+
+static int
+APSWChangeset_tp_traverse(APSWChangeset *self, visitproc visit, void *arg)
+{
+  Py_VISIT(self->changeset);
+  return 0;
+}
+
+static int
+APSWChangeset_tp_clear(APSWChangeset *self)
+{
+  Py_CLEAR(self->changeset);
+  return 0;
+}
+
+static void
+APSWChangeset_dealloc(APSWChangeset *self)
+{
+  PyObject_GC_UnTrack(self);
+  Py_CLEAR(self->changeset);
+  Py_TpFree((PyObject *)self);
+}
+
+/* xFilter and xConflict for apply */
+typedef struct
+{
+  PyObject *filter;
+  PyObject *conflict;
+} ChangesetApplyContext;
+
+static int
+changeset_apply_filter(void *pCtx, const char *zTab)
+{
+  ChangesetApplyContext *context = (ChangesetApplyContext *)pCtx;
+  PyGILState_STATE gilstate;
+  PyObject *retval = NULL;
+  int res = 0;
+
+  gilstate = PyGILState_Ensure();
+
+  MakeExistingException();
+
+  if (PyErr_Occurred())
+    goto finally;
+
+  PyObject *vargs[] = {NULL, PyUnicode_FromString(zTab)};
+  if (vargs[1])
+    retval = PyObject_Vectorcall(context->filter, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  Py_XDECREF(vargs[1]);
+  if (retval)
+    res = PyObject_IsTrueStrict(retval);
+  if (res < 0)
+    res = 0;
+  if (PyErr_Occurred())
+    AddTraceBackHere(__FILE__, __LINE__, "Changeset.apply.filter", "{s: O, s: s, s: O}", "filter", context->filter,
+                     "name", zTab, "result", OBJ(retval));
+
+finally:
+  Py_XDECREF(retval);
+  PyGILState_Release(gilstate);
+  return res;
+}
+
+static int
+changeset_apply_conflict(void *pCtx, int eConflict, sqlite3_changeset_iter *p)
+{
+  ChangesetApplyContext *context = (ChangesetApplyContext *)pCtx;
+  PyGILState_STATE gilstate;
+  PyObject *change = NULL, *retval = NULL;
+  int res = SQLITE_CHANGESET_ABORT;
+
+  gilstate = PyGILState_Ensure();
+
+  MakeExistingException();
+
+  if (PyErr_Occurred() || !context->conflict)
+    goto finally;
+
+  change = tablechange_new(p, eConflict);
+  if (!change)
+    goto finally;
+
+  PyObject *vargs[] = {NULL, PyLong_FromLong(eConflict), change};
+  if (vargs[1])
+    retval = PyObject_Vectorcall(context->conflict, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  Py_XDECREF(vargs[1]);
+  tablechange_invalidate(change);
+  if (!retval)
+    goto finally;
+
+  if (PyLong_Check(retval))
+    res = PyLong_AsInt(retval);
+  else
+    PyErr_Format(PyExc_TypeError, "Conflict handler must return an int not %s", Py_TypeName(retval));
+  if (PyErr_Occurred() || (res != SQLITE_CHANGESET_OMIT && res != SQLITE_CHANGESET_REPLACE && res != SQLITE_CHANGESET_ABORT))
+  {
+    if (!PyErr_Occurred())
+      PyErr_Format(PyExc_ValueError, "Conflict handler returned %d, which isn't SQLITE_CHANGESET_OMIT, REPLACE, or ABORT",
+                   res);
+    res = SQLITE_CHANGESET_ABORT;
+  }
+
+finally:
+  if (PyErr_Occurred())
+    AddTraceBackHere(__FILE__, __LINE__, "Changeset.apply.conflict", "{s: O, s: i, s: O}", "conflict",
+                     OBJ(context->conflict), "type", eConflict, "result", OBJ(retval));
+  Py_XDECREF(change);
+  Py_XDECREF(retval);
+  PyGILState_Release(gilstate);
+  return res;
+}
+
+/** .. method:: apply(db: Connection, *, filter: Optional[Callable[[str], bool]] = None, conflict: Optional[Callable[[int, TableChange], int]] = None, flags: int = 0) -> None
+
+  Applies the changes to the ``main`` database of *db*, all inside a
+  savepoint so either all or none of them are made.  That includes
+  when *filter* or *conflict* raise an exception.
+
+  :param filter: Called with each table name, returning True if
+     changes to it should be applied.  All tables are applied if
+     None.
+  :param conflict: Called when a change can't be applied cleanly,
+     with the conflict type (such as ``SQLITE_CHANGESET_DATA``) and
+     a :class:`TableChange`.  It returns ``SQLITE_CHANGESET_OMIT`` to
+     skip the change, ``SQLITE_CHANGESET_REPLACE`` to apply it anyway,
+     or ``SQLITE_CHANGESET_ABORT`` to undo all the changes and raise
+     :exc:`AbortError`.  If None then every conflict aborts.
+  :param flags: ``SQLITE_CHANGESETAPPLY_`` constants such as
+     ``SQLITE_CHANGESETAPPLY_NOSAVEPOINT``
+
+  -* sqlite3changeset_apply_v2 sqlite3changeset_apply_v2_strm
+*/
+static PyObject *
+APSWChangeset_apply(APSWChangeset *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  Connection *db = NULL;
+  PyObject *filter = NULL, *conflict = NULL;
+  int flags = 0, res = SQLITE_OK;
+  ChangesetInput input;
+
+  CHECK_CHANGESET_INIT(NULL);
+
+  {
+    Changeset_apply_CHECK;
+    ARG_PROLOG(1, Changeset_apply_KWNAMES);
+    ARG_MANDATORY ARG_Connection(db);
+    ARG_OPTIONAL ARG_optional_Callable(filter);
+    ARG_OPTIONAL ARG_optional_Callable(conflict);
+    ARG_OPTIONAL ARG_int(flags);
+    ARG_EPILOG(NULL, Changeset_apply_USAGE, );
+  }
+
+  CHECK_CLOSED(db, NULL);
+
+  ChangesetApplyContext context = {filter, conflict};
+
+  if (changeset_input_init(&input, self->changeset))
+    return NULL;
+
+  if (!INUSE_ACQUIRE(db))
+  {
+    if (!PyErr_Occurred())
+      PyErr_Format(ExcThreadingViolation, INUSE_VIOLATION_MESSAGE);
+    changeset_input_release(&input);
+    return NULL;
+  }
+  /* An exception in filter can't stop SQLite applying changes to the
+     other tables, so everything is done inside our own savepoint which
+     is rolled back if there was any exception */
+  _PYSQLITE_CALL_E(db->db, res = sqlite3_exec(db->db, "SAVEPOINT \"apsw-changeset-apply\"", NULL, NULL, NULL));
+  if (res == SQLITE_OK)
+  {
+    if (input.stream)
+      _PYSQLITE_CALL_E(db->db, res = sqlite3changeset_apply_v2_strm(db->db, changeset_input_read, &input,
+                                                                    filter ? changeset_apply_filter : NULL,
+                                                                    changeset_apply_conflict, &context, NULL, NULL, flags));
+    else
+      _PYSQLITE_CALL_E(db->db, res = sqlite3changeset_apply_v2(db->db, (int)input.buffer.len, input.buffer.buf,
+                                                               filter ? changeset_apply_filter : NULL,
+                                                               changeset_apply_conflict, &context, NULL, NULL, flags));
+    SET_EXC(res, db->db);
+    if (!PyErr_Occurred())
+    {
+      _PYSQLITE_CALL_E(db->db, res = sqlite3_exec(db->db, "RELEASE \"apsw-changeset-apply\"", NULL, NULL, NULL));
+      SET_EXC(res, db->db);
+    }
+    if (PyErr_Occurred())
+      _PYSQLITE_CALL_V(sqlite3_exec(db->db, "ROLLBACK TO \"apsw-changeset-apply\"; RELEASE \"apsw-changeset-apply\"", NULL,
+                                    NULL, NULL));
+  }
+  INUSE_RELEASE(db);
+  changeset_input_release(&input);
+
+  SET_EXC(res, db->db);
+  if (PyErr_Occurred())
+    return NULL;
+
+  Py_RETURN_NONE;
+}
+
+/** .. method:: invert() -> bytes
+
+  Returns the changeset that undoes this one.  Patchsets can't be
+  inverted.
+
+  -* sqlite3changeset_invert sqlite3changeset_invert_strm
+*/
+static PyObject *
+APSWChangeset_invert(APSWChangeset *self)
+{
+  ChangesetInput input;
+  PyObject *result = NULL;
+  void *data = NULL;
+  int size = 0, res;
+
+  CHECK_CHANGESET_INIT(NULL);
+
+  if (changeset_input_init(&input, self->changeset))
+    return NULL;
+
+  if (input.stream)
+  {
+    ChangesetOutput out = {NULL, NULL, 0, 0};
+    _PYSQLITE_CALL_V(res = sqlite3changeset_invert_strm(changeset_input_read, &input, changeset_output_write, &out));
+    result = changeset_output_finish(&out, res);
+  }
+  else
+  {
+    _PYSQLITE_CALL_V(res = sqlite3changeset_invert((int)input.buffer.len, input.buffer.buf, &size, &data));
+    SET_EXC(res, NULL);
+    if (res == SQLITE_OK)
+      result = PyBytes_FromStringAndSize(data, size);
+    sqlite3_free(data);
+  }
+  changeset_input_release(&input);
+  return result;
+}
+
+/** .. method:: invert_stream(output: SessionStreamOutput) -> None
+
+  Provides the changeset that undoes this one in chunks to *output*.
+
+  -* sqlite3changeset_invert_strm
+*/
+static PyObject *
+APSWChangeset_invert_stream(APSWChangeset *self, PyObject *const *fast_args, Py_ssize_t fast_nargs,
+                            PyObject *fast_kwnames)
+{
+  PyObject *output = NULL;
+  ChangesetInput input;
+  int res;
+
+  CHECK_CHANGESET_INIT(NULL);
+
+  {
+    Changeset_invert_stream_CHECK;
+    ARG_PROLOG(1, Changeset_invert_stream_KWNAMES);
+    ARG_MANDATORY ARG_Callable(output);
+    ARG_EPILOG(NULL, Changeset_invert_stream_USAGE, );
+  }
+
+  if (changeset_input_init(&input, self->changeset))
+    return NULL;
+
+  ChangesetOutput out = {output, NULL, 0, 0};
+  _PYSQLITE_CALL_V(res = sqlite3changeset_invert_strm(changeset_input_read, &input, changeset_output_write, &out));
+  changeset_input_release(&input);
+  return changeset_output_finish(&out, res);
+}
+
+/* concatenates self and other to output, collecting it if output is NULL */
+static PyObject *
+APSWChangeset_concat_internal(APSWChangeset *self, PyObject *other, PyObject *output)
+{
+  ChangesetInput input_a, input_b;
+  ChangesetOutput out = {output, NULL, 0, 0};
+  PyObject *result = NULL;
+  void *data = NULL;
+  int size = 0, res;
+
+  if (changeset_input_init(&input_a, self->changeset))
+    return NULL;
+  if (changeset_input_init(&input_b, other))
+  {
+    changeset_input_release(&input_a);
+    return NULL;
+  }
+
+  if (!output && !input_a.stream && !input_b.stream)
+  {
+    _PYSQLITE_CALL_V(res = sqlite3changeset_concat((int)input_a.buffer.len, input_a.buffer.buf, (int)input_b.buffer.len,
+                                                   input_b.buffer.buf, &size, &data));
+    SET_EXC(res, NULL);
+    if (res == SQLITE_OK)
+      result = PyBytes_FromStringAndSize(data, size);
+    sqlite3_free(data);
+  }
+  else
+  {
+    _PYSQLITE_CALL_V(res = sqlite3changeset_concat_strm(changeset_input_read, &input_a, changeset_input_read, &input_b,
+                                                        changeset_output_write, &out));
+    result = changeset_output_finish(&out, res);
+  }
+  changeset_input_release(&input_a);
+  changeset_input_release(&input_b);
+  return result;
+}
+
+/** .. method:: concat(other: ChangesetInput) -> bytes
+
+  Returns a changeset with the effect of this one followed by *other*.
+  Use :class:`ChangesetBuilder` to combine more than two.
+
+  -* sqlite3changeset_concat sqlite3changeset_concat_strm
+*/
+static PyObject *
+APSWChangeset_concat(APSWChangeset *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *other = NULL;
+
+  CHECK_CHANGESET_INIT(NULL);
+
+  {
+    Changeset_concat_CHECK;
+    ARG_PROLOG(1, Changeset_concat_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(other);
+    ARG_EPILOG(NULL, Changeset_concat_USAGE, );
+  }
+
+  return APSWChangeset_concat_internal(self, other, NULL);
+}
+
+/** .. method:: concat_stream(other: ChangesetInput, output: SessionStreamOutput) -> None
+
+  Provides a changeset with the effect of this one followed by
+  *other* in chunks to *output*.
+
+  -* sqlite3changeset_concat_strm
+*/
+static PyObject *
+APSWChangeset_concat_stream(APSWChangeset *self, PyObject *const *fast_args, Py_ssize_t fast_nargs,
+                            PyObject *fast_kwnames)
+{
+  PyObject *other = NULL, *output = NULL;
+
+  CHECK_CHANGESET_INIT(NULL);
+
+  {
+    Changeset_concat_stream_CHECK;
+    ARG_PROLOG(2, Changeset_concat_stream_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(other);
+    ARG_MANDATORY ARG_Callable(output);
+    ARG_EPILOG(NULL, Changeset_concat_stream_USAGE, );
+  }
+
+  return APSWChangeset_concat_internal(self, other, output);
+}
+
+/** .. method:: __iter__() -> Iterator[TableChange]
+
+  Iterates over each change.  Each :class:`TableChange` is only valid
+  until the next one.
+
+  -* sqlite3changeset_start sqlite3changeset_start_strm
+*/
+static PyObject *
+APSWChangeset_iter(APSWChangeset *self)
+{
+  APSWChangesetIterator *it;
+  int res;
+
+  CHECK_CHANGESET_INIT(NULL);
+
+  it = PyObject_GC_New(APSWChangesetIterator, &APSWChangesetIteratorType);
+  if (!it)
+    return NULL;
+  INUSE_RELEASE(it);
+  it->changeset = NULL;
+  it->iter = NULL;
+  it->current = NULL;
+  PyObject_GC_Track(it);
+
+  if (changeset_input_init(&it->input, self->changeset))
+  {
+    Py_DECREF(it);
+    return NULL;
+  }
+  it->changeset = (APSWChangeset *)Py_NewRef((PyObject *)self);
+
+  if (it->input.stream)
+    _PYSQLITE_CALL_V(res = sqlite3changeset_start_strm(&it->iter, changeset_input_read, &it->input));
+  else
+    _PYSQLITE_CALL_V(res = sqlite3changeset_start(&it->iter, (int)it->input.buffer.len, it->input.buffer.buf));
+  SET_EXC(res, NULL);
+  if (PyErr_Occurred())
+  {
+    Py_DECREF(it);
+    return NULL;
+  }
+  return (PyObject *)it;
+}
+
+/* CHANGESET ITERATOR CODE */
+
+static void
+APSWChangesetIterator_finish(APSWChangesetIterator *self)
+{
+  if (self->current)
+  {
+    tablechange_invalidate(self->current);
+    Py_CLEAR(self->current);
+  }
+  if (self->iter)
+  {
+    _PYSQLITE_CALL_V(sqlite3changeset_finalize(self->iter));
+    self->iter = NULL;
+  }
+  if (self->changeset)
+  {
+    changeset_input_release(&self->input);
+    Py_CLEAR(self->changeset);
+  }
+}
+
+static int
+APSWChangesetIterator_tp_traverse(APSWChangesetIterator *self, visitproc visit, void *arg)
+{
+  Py_VISIT(self->changeset);
+  Py_VISIT(self->current);
+  return 0;
+}
+
+static int
+APSWChangesetIterator_tp_clear(APSWChangesetIterator *self)
+{
+  APSWChangesetIterator_finish(self);
+  return 0;
+}
+
+static void
+APSWChangesetIterator_dealloc(APSWChangesetIterator *self)
+{
+  PyObject_GC_UnTrack(self);
+  APSWChangesetIterator_finish(self);
+  Py_TpFree((PyObject *)self);
+}
+
+static PyObject *
+APSWChangesetIterator_next(APSWChangesetIterator *self)
+{
+  int res;
+
+  CHECK_USE(NULL);
+
+  if (self->current)
+  {
+    tablechange_invalidate(self->current);
+    Py_CLEAR(self->current);
+  }
+  if (!self->iter)
+    return NULL;
+
+  PYSQLITE_VOID_CALL(res = sqlite3changeset_next(self->iter));
+  if (res == SQLITE_ROW && !PyErr_Occurred())
+  {
+    self->current = tablechange_new(self->iter, 0);
+    return Py_XNewRef(self->current);
+  }
+  APSWChangesetIterator_finish(self);
+  if (res != SQLITE_DONE)
+    SET_EXC(res, NULL);
+  return NULL;
+}
+
+static PyTypeObject APSWChangesetIteratorType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "apsw.ChangesetIterator",
+    .tp_basicsize = sizeof(APSWChangesetIterator),
+    .tp_dealloc = (destructor)APSWChangesetIterator_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_traverse = (traverseproc)APSWChangesetIterator_tp_traverse,
+    .tp_clear = (inquiry)APSWChangesetIterator_tp_clear,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc)APSWChangesetIterator_next,
+};
+
+static PyMethodDef APSWChangeset_methods[] = {
+    {"apply", (PyCFunction)APSWChangeset_apply, METH_FASTCALL | METH_KEYWORDS, Changeset_apply_DOC},
+    {"invert", (PyCFunction)APSWChangeset_invert, METH_NOARGS, Changeset_invert_DOC},
+    {"invert_stream", (PyCFunction)APSWChangeset_invert_stream, METH_FASTCALL | METH_KEYWORDS,
+     Changeset_invert_stream_DOC},
+    {"concat", (PyCFunction)APSWChangeset_concat, METH_FASTCALL | METH_KEYWORDS, Changeset_concat_DOC},
+    {"concat_stream", (PyCFunction)APSWChangeset_concat_stream, METH_FASTCALL | METH_KEYWORDS,
+     Changeset_concat_stream_DOC},
+    /* sentinel */
+    {0, 0, 0, 0}};
+
+static PyTypeObject APSWChangesetType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "apsw.Changeset",
+    .tp_basicsize = sizeof(APSWChangeset),
+    .tp_dealloc = (destructor)APSWChangeset_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_doc = Changeset_class_DOC,
+    .tp_traverse = (traverseproc)APSWChangeset_tp_traverse,
+    .tp_clear = (inquiry)APSWChangeset_tp_clear,
+    .tp_methods = APSWChangeset_methods,
+    .tp_iter = (getiterfunc)APSWChangeset_iter,
+    .tp_init = (initproc)APSWChangeset_init,
+    .tp_new = APSWChangeset_new,
+};
+
+#undef CHECK_CHANGESET_INIT
+
+/* CHANGESET BUILDER CODE */
+
+/** .. class:: ChangesetBuilder
+
+  Combines any number of changesets (or patchsets) into one with
+  their net effect, such as to send a replica one changeset covering
+  a period of time.  Wraps a `sqlite3_changegroup
+  <https://www.sqlite.org/session/changegroup.html>`__.
+*/
+
+typedef struct APSWChangesetBuilder
+{
+  PyObject_HEAD
+  int inuse;
+  sqlite3_changegroup *group;
+  PyObject *weakreflist;
+} APSWChangesetBuilder;
+
+#define CHECK_BUILDER_CLOSED(e)                                                    \
+  do                                                                               \
+  {                                                                                \
+    if (!self->group)                                                              \
+    {                                                                              \
+      PyErr_Format(ExcConnectionClosed, "The ChangesetBuilder has been closed"); \
+      return e;                                                                    \
+    }                                                                              \
+  } while (0)
+
+static PyObject *
+APSWChangesetBuilder_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+  APSWChangesetBuilder *self;
+  int res;
+
+  if (PyTuple_GET_SIZE(args) || (kwds && PyDict_GET_SIZE(kwds)))
+    return PyErr_Format(PyExc_TypeError, "ChangesetBuilder takes no arguments");
+
+  self = (APSWChangesetBuilder *)type->tp_alloc(type, 0);
+  if (!self)
+    return NULL;
+  INUSE_RELEASE(self);
+  self->weakreflist = NULL;
+  res = sqlite3changegroup_new(&self->group);
+  SET_EXC(res, NULL);
+  if (res != SQLITE_OK)
+  {
+    self->group = NULL;
+    Py_DECREF(self);
+    return NULL;
+  }
+  return (PyObject *)self;
+}
+
+static void
+APSWChangesetBuilder_close_internal(APSWChangesetBuilder *self)
+{
+  if (self->group)
+  {
+    sqlite3changegroup_delete(self->group);
+    self->group = NULL;
+  }
+}
+
+static void
+APSWChangesetBuilder_dealloc(APSWChangesetBuilder *self)
+{
+  APSW_CLEAR_WEAKREFS;
+
+  APSWChangesetBuilder_close_internal(self);
+
+  Py_TpFree((PyObject *)self);
+}
+
+/** .. method:: close() -> None
+
+  Releases the memory used.  It is also released when the builder is
+  garbage collected.
+
+  -* sqlite3changegroup_delete
+*/
+static PyObject *
+APSWChangesetBuilder_close(APSWChangesetBuilder *self)
+{
+  CHECK_USE(NULL);
+
+  APSWChangesetBuilder_close_internal(self);
+
+  Py_RETURN_NONE;
+}
+
+/** .. method:: add(changeset: ChangesetInput) -> None
+
+  Adds the changes, combining them with those already added.  All
+  the changesets added must be changesets, or all must be patchsets.
+
+  -* sqlite3changegroup_add sqlite3changegroup_add_strm
+*/
+static PyObject *
+APSWChangesetBuilder_add(APSWChangesetBuilder *self, PyObject *const *fast_args, Py_ssize_t fast_nargs,
+                         PyObject *fast_kwnames)
+{
+  PyObject *changeset = NULL;
+  ChangesetInput input;
+  int res;
+
+  CHECK_USE(NULL);
+  CHECK_BUILDER_CLOSED(NULL);
+
+  {
+    ChangesetBuilder_add_CHECK;
+    ARG_PROLOG(1, ChangesetBuilder_add_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(changeset);
+    ARG_EPILOG(NULL, ChangesetBuilder_add_USAGE, );
+  }
+
+  if (changeset_input_init(&input, changeset))
+    return NULL;
+
+  if (input.stream)
+    INUSE_CALL_ELSE(_PYSQLITE_CALL_V(res = sqlite3changegroup_add_strm(self->group, changeset_input_read, &input)),
+                    res = SQLITE_MISUSE);
+  else
+    INUSE_CALL_ELSE(
+        _PYSQLITE_CALL_V(res = sqlite3changegroup_add(self->group, (int)input.buffer.len, input.buffer.buf)),
+        res = SQLITE_MISUSE);
+  changeset_input_release(&input);
+
+  SET_EXC(res, NULL);
+  if (PyErr_Occurred())
+    return NULL;
+
+  Py_RETURN_NONE;
+}
+
+/** .. method:: output() -> bytes
+
+  Returns the combined changeset.
+
+  -* sqlite3changegroup_output
+*/
+static PyObject *
+APSWChangesetBuilder_output(APSWChangesetBuilder *self)
+{
+  PyObject *result = NULL;
+  void *data = NULL;
+  int size = 0, res;
+
+  CHECK_USE(NULL);
+  CHECK_BUILDER_CLOSED(NULL);
+
+  INUSE_CALL_ELSE(_PYSQLITE_CALL_V(res = sqlite3changegroup_output(self->group, &size, &data)), res = SQLITE_MISUSE);
+  SET_EXC(res, NULL);
+  if (res == SQLITE_OK)
+    result = PyBytes_FromStringAndSize(data, size);
+  sqlite3_free(data);
+  return result;
+}
+
+/** .. method:: output_stream(output: SessionStreamOutput) -> None
+
+  Provides the combined changeset in chunks to *output*.
+
+  -* sqlite3changegroup_output_strm
+*/
+static PyObject *
+APSWChangesetBuilder_output_stream(APSWChangesetBuilder *self, PyObject *const *fast_args, Py_ssize_t fast_nargs,
+                                   PyObject *fast_kwnames)
+{
+  PyObject *output = NULL;
+  int res;
+
+  CHECK_USE(NULL);
+  CHECK_BUILDER_CLOSED(NULL);
+
+  {
+    ChangesetBuilder_output_stream_CHECK;
+    ARG_PROLOG(1, ChangesetBuilder_output_stream_KWNAMES);
+    ARG_MANDATORY ARG_Callable(output);
+    ARG_EPILOG(NULL, ChangesetBuilder_output_stream_USAGE, );
+  }
+
+  ChangesetOutput out = {output, NULL, 0, 0};
+  INUSE_CALL_ELSE(_PYSQLITE_CALL_V(res = sqlite3changegroup_output_strm(self->group, changeset_output_write, &out)),
+                  res = SQLITE_MISUSE);
+  return changeset_output_finish(&out, res);
+}
+
+static PyMethodDef APSWChangesetBuilder_methods[] = {
+    {"close", (PyCFunction)APSWChangesetBuilder_close, METH_NOARGS, ChangesetBuilder_close_DOC},
+    {"add", (PyCFunction)APSWChangesetBuilder_add, METH_FASTCALL | METH_KEYWORDS, ChangesetBuilder_add_DOC},
+    {"output", (PyCFunction)APSWChangesetBuilder_output, METH_NOARGS, ChangesetBuilder_output_DOC},
+    {"output_stream", (PyCFunction)APSWChangesetBuilder_output_stream, METH_FASTCALL | METH_KEYWORDS,
+     ChangesetBuilder_output_stream_DOC},
+    /* sentinel */
+    {0, 0, 0, 0}};
+
+static PyTypeObject APSWChangesetBuilderType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+        .tp_name = "apsw.ChangesetBuilder",
+    .tp_basicsize = sizeof(APSWChangesetBuilder),
+    .tp_dealloc = (destructor)APSWChangesetBuilder_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = ChangesetBuilder_class_DOC,
+    .tp_weaklistoffset = offsetof(APSWChangesetBuilder, weakreflist),
+    .tp_methods = APSWChangesetBuilder_methods,
+    .tp_new = APSWChangesetBuilder_new,
+};
+
+#undef CHECK_BUILDER_CLOSED
+
+/* returns zero on success, -1 on error */
+static int
+add_session_constants(PyObject *module)
+{
+  if (PyModule_AddIntConstant(module, "SQLITE_CHANGESET_DATA", SQLITE_CHANGESET_DATA)
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESET_NOTFOUND", SQLITE_CHANGESET_NOTFOUND)
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESET_CONFLICT", SQLITE_CHANGESET_CONFLICT)
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESET_CONSTRAINT", SQLITE_CHANGESET_CONSTRAINT)
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESET_FOREIGN_KEY", SQLITE_CHANGESET_FOREIGN_KEY)
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESET_OMIT", SQLITE_CHANGESET_OMIT)
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESET_REPLACE", SQLITE_CHANGESET_REPLACE)
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESET_ABORT", SQLITE_CHANGESET_ABORT)
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESETAPPLY_NOSAVEPOINT", SQLITE_CHANGESETAPPLY_NOSAVEPOINT)
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESETAPPLY_INVERT", SQLITE_CHANGESETAPPLY_INVERT)
+#ifdef SQLITE_CHANGESETAPPLY_IGNORENOOP
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESETAPPLY_IGNORENOOP", SQLITE_CHANGESETAPPLY_IGNORENOOP)
+#endif
+#ifdef SQLITE_CHANGESETAPPLY_FKNOACTION
+      || PyModule_AddIntConstant(module, "SQLITE_CHANGESETAPPLY_FKNOACTION", SQLITE_CHANGESETAPPLY_FKNOACTION)
+#endif
+  )
+    return -1;
+  return 0;
+}
+
+#endif /* SQLITE_ENABLE_SESSION */
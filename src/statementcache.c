@@ -23,10 +23,27 @@
 
    This second implementation is simpler and allows having multiple
    entries for the same query.  The primary data structure is an array
-   of hash values.  Finding an entry is a linear search (fast on
-   modern cpus).  Entries are removed while in use. When finished they
-   are placed back in a circular order, which then evicts the oldest
-   entry.
+   of hash values.  Entries are removed while in use. When finished
+   they are placed back in a circular order, which then evicts the
+   oldest entry.
+
+   Finding an entry used to be a linear search of the hash values,
+   which is fast on modern cpus for the default size, but shows up in
+   profiles with caches of thousands of entries.  An index of buckets
+   by hash value is now used, with each bucket being a chain of array
+   positions (linked by position in the chain array).  Multiple entries
+   for the same query are in the same chain.
+
+   Eviction used to be in circular order which evicts the oldest
+   entry.  It is now cost aware (GreedyDual-Size-Frequency without the
+   size term as every entry takes one slot) with the time taken to
+   prepare each statement measured.  An entry's priority
+   is the cache inflation value plus its prepare time multiplied by
+   its uses.  The entry with the lowest priority is evicted (found with
+   a binary min-heap), and the inflation value becomes its priority.
+   That way statements that are cheap to prepare or rarely reused are
+   evicted first, while entries that are no longer used still age out
+   as the inflation value rises.
 
    A copy of the query has to be kept around for doing equality
    comparisons when looking in the cache.  But sqlite also keeps a
@@ -50,25 +67,48 @@ typedef struct APSWStatement
                                   (the utf8 could have more than one query) */
   Py_hash_t hash;              /* hash of all of utf8 */
   APSWStatementOptions options;
-  unsigned uses; /* how many times the prepared statement has been (re)used */
+  unsigned uses;        /* how many times the prepared statement has been (re)used */
+  long long prepare_ns; /* how long sqlite3_prepare_v3 took */
+  /* profiling, updated when Connection.profile_statements is on */
+  sqlite3_int64 rows;   /* result rows returned */
+  long long step_ns;    /* time spent in sqlite3_step */
+  long long convert_ns; /* time spent converting result values into Python objects */
+  /* apsw.Row column names, made on first use */
+  PyObject *row_fields; /* tuple of (names tuple, dict of name to index) */
+  int row_fields_reprepares; /* SQLITE_STMTSTATUS_REPREPARE when row_fields was made */
+  /* Connection.register_converter callables, made on first use */
+  PyObject *column_converters;        /* tuple of callable or None per column, or None if no column has one */
+  unsigned column_converters_version; /* Connection converters_version when column_converters was made */
+  int column_converters_reprepares;   /* SQLITE_STMTSTATUS_REPREPARE when column_converters was made */
 } APSWStatement;
 
-/* recycle bin for APSWStatements to avoid repeated malloc/free calls */
-#define SC_STATEMENT_RECYCLE_BIN_ENTRIES 4
+/* per connection recycle bin for APSWStatements to avoid repeated
+   malloc/free calls.  Each cursor has at most one statement outstanding
+   so this covers several cursors in use at once */
+#define SC_STATEMENT_RECYCLE_BIN_ENTRIES 16
 
 typedef struct StatementCache
 {
   Py_hash_t *hashes;      /* array of hash values */
   APSWStatement **caches; /* corresponding statements */
+  unsigned *buckets;      /* first array position for each hash bucket */
+  unsigned *chain;        /* next array position in the same bucket */
+  unsigned bucket_mask;   /* number of buckets (a power of two) minus one */
+  double *priorities;     /* eviction priority of each array position */
+  unsigned *heap;         /* min-heap of occupied array positions by priority */
+  unsigned *heap_pos;     /* where each occupied array position is in heap */
+  unsigned heap_size;     /* how many are in heap (and occupied) */
+  unsigned *free_slots;   /* stack of unoccupied array positions */
+  unsigned free_count;    /* how many are in free_slots */
+  double inflation;       /* priority of the most recent eviction */
   sqlite3 *db;            /* db to work against */
 #if SC_STATEMENT_RECYCLE_BIN_ENTRIES > 0
   APSWStatement *recycle_bin[SC_STATEMENT_RECYCLE_BIN_ENTRIES];
   unsigned recycle_bin_next;
 #endif
 
-  unsigned highest_used;  /* largest entry we have used - no point scanning beyond */
-  unsigned maxentries;    /* maximum number of entries */
-  unsigned next_eviction; /* which entry is evicted next */
+  unsigned highest_used; /* largest entry we have used - no point scanning beyond */
+  unsigned maxentries;   /* maximum number of entries */
   /* stats tracking */
   unsigned evictions; /* how many there have been */
   unsigned no_cache;  /* can cache was false */
@@ -76,6 +116,9 @@ typedef struct StatementCache
   unsigned misses;    /* not found in cache */
   unsigned no_vdbe;   /* no bytecode emitted */
   unsigned too_big;   /* query was bigger than SC_MAX_ITEM_SIZE */
+  unsigned recycle_hits;   /* APSWStatement came from recycle bin */
+  unsigned recycle_misses; /* APSWStatement had to be allocated */
+  long long prepare_ns; /* total time spent in sqlite3_prepare_v3 */
 } StatementCache;
 
 /* we don't bother caching larger than this many bytes */
@@ -84,17 +127,112 @@ typedef struct StatementCache
 /* the hash value we use for unoccupied */
 #define SC_SENTINEL_HASH (-1)
 
+/* end of a bucket chain */
+#define SC_NO_ENTRY (~0u)
+
+static void
+statementcache_heap_swap(StatementCache *sc, unsigned a, unsigned b)
+{
+  unsigned tmp = sc->heap[a];
+
+  sc->heap[a] = sc->heap[b];
+  sc->heap[b] = tmp;
+  sc->heap_pos[sc->heap[a]] = a;
+  sc->heap_pos[sc->heap[b]] = b;
+}
+
+/* restores heap order for the item at heap position pos */
+static void
+statementcache_heap_fix(StatementCache *sc, unsigned pos)
+{
+  while (pos > 0 && sc->priorities[sc->heap[pos]] < sc->priorities[sc->heap[(pos - 1) / 2]])
+  {
+    statementcache_heap_swap(sc, pos, (pos - 1) / 2);
+    pos = (pos - 1) / 2;
+  }
+  for (;;)
+  {
+    unsigned smallest = pos, child = 2 * pos + 1;
+
+    if (child < sc->heap_size && sc->priorities[sc->heap[child]] < sc->priorities[sc->heap[smallest]])
+      smallest = child;
+    child++;
+    if (child < sc->heap_size && sc->priorities[sc->heap[child]] < sc->priorities[sc->heap[smallest]])
+      smallest = child;
+    if (smallest == pos)
+      break;
+    statementcache_heap_swap(sc, pos, smallest);
+    pos = smallest;
+  }
+}
+
+static void
+statementcache_heap_add(StatementCache *sc, unsigned i)
+{
+  assert(sc->heap_size < sc->maxentries);
+  sc->heap[sc->heap_size] = i;
+  sc->heap_pos[i] = sc->heap_size;
+  sc->heap_size++;
+  statementcache_heap_fix(sc, sc->heap_size - 1);
+}
+
+static void
+statementcache_heap_remove(StatementCache *sc, unsigned i)
+{
+  unsigned pos = sc->heap_pos[i];
+
+  assert(sc->heap_size > 0 && sc->heap[pos] == i);
+  sc->heap_size--;
+  if (pos != sc->heap_size)
+  {
+    statementcache_heap_swap(sc, pos, sc->heap_size);
+    statementcache_heap_fix(sc, pos);
+  }
+}
+
+/* adds array position i to the index */
+static void
+statementcache_index_add(StatementCache *sc, unsigned i)
+{
+  unsigned bucket = (unsigned)(sc->hashes[i] & sc->bucket_mask);
+
+  assert(sc->hashes[i] != SC_SENTINEL_HASH);
+  sc->chain[i] = sc->buckets[bucket];
+  sc->buckets[bucket] = i;
+}
+
+/* removes array position i from the index.  prev is the position
+   before it in the chain if known, else SC_NO_ENTRY to look for it */
+static void
+statementcache_index_remove(StatementCache *sc, unsigned i, unsigned prev)
+{
+  unsigned bucket = (unsigned)(sc->hashes[i] & sc->bucket_mask);
+
+  if (prev == SC_NO_ENTRY && sc->buckets[bucket] != i)
+  {
+    for (prev = sc->buckets[bucket]; sc->chain[prev] != i; prev = sc->chain[prev])
+      assert(prev != SC_NO_ENTRY);
+  }
+  if (prev == SC_NO_ENTRY)
+    sc->buckets[bucket] = sc->chain[i];
+  else
+    sc->chain[prev] = sc->chain[i];
+  sc->chain[i] = SC_NO_ENTRY;
+}
+
 static int
 statementcache_free_statement(StatementCache *sc, APSWStatement *s)
 {
   int res;
 
   Py_CLEAR(s->query);
+  Py_CLEAR(s->row_fields);
+  Py_CLEAR(s->column_converters);
 
   PYSQLITE_SC_CALL(res = sqlite3_finalize(s->vdbestatement));
 
 #if SC_STATEMENT_RECYCLE_BIN_ENTRIES > 0
-  if (sc->recycle_bin_next + 1 < SC_STATEMENT_RECYCLE_BIN_ENTRIES)
+  if (sc->recycle_bin_next < SC_STATEMENT_RECYCLE_BIN_ENTRIES)
   {
     sc->recycle_bin[sc->recycle_bin_next++] = s;
   }
@@ -124,6 +262,7 @@ statementcache_finalize(StatementCache *sc, APSWStatement *statement)
   if (statement->hash != SC_SENTINEL_HASH)
   {
     APSWStatement *evictee = NULL;
+    unsigned slot;
 
     PYSQLITE_SC_CALL(res = sqlite3_reset(statement->vdbestatement));
 
@@ -136,17 +275,24 @@ statementcache_finalize(StatementCache *sc, APSWStatement *statement)
     if (res == SQLITE_OK && PyErr_Occurred())
       res = SQLITE_ERROR;
 
-    if (sc->caches[sc->next_eviction])
+    if (sc->free_count)
+      slot = sc->free_slots[--sc->free_count];
+    else
     {
-      assert(sc->hashes[sc->next_eviction] != SC_SENTINEL_HASH);
-      evictee = sc->caches[sc->next_eviction];
+      /* evict the lowest priority */
+      slot = sc->heap[0];
+      assert(sc->caches[slot] && sc->hashes[slot] != SC_SENTINEL_HASH);
+      evictee = sc->caches[slot];
+      sc->inflation = sc->priorities[slot];
+      statementcache_index_remove(sc, slot, SC_NO_ENTRY);
+      statementcache_heap_remove(sc, slot);
     }
-    sc->hashes[sc->next_eviction] = statement->hash;
-    sc->caches[sc->next_eviction] = statement;
-    sc->highest_used = Py_MAX(sc->highest_used, sc->next_eviction);
-    sc->next_eviction++;
-    if (sc->next_eviction == sc->maxentries)
-      sc->next_eviction = 0;
+    sc->hashes[slot] = statement->hash;
+    sc->caches[slot] = statement;
+    sc->priorities[slot] = sc->inflation + (double)statement->prepare_ns * statement->uses;
+    statementcache_index_add(sc, slot);
+    statementcache_heap_add(sc, slot);
+    sc->highest_used = Py_MAX(sc->highest_used, slot);
     if (evictee)
     {
       statementcache_free_statement(sc, evictee);
@@ -194,18 +340,22 @@ statementcache_prepare_internal(StatementCache *sc, const char *utf8, Py_ssize_t
   const char *orig_tail = NULL;
   sqlite3_stmt *vdbestatement = NULL;
   int res = SQLITE_OK;
+  long long prepare_ns = 0;
 
   *statement_out = NULL;
   if (sc->maxentries && utf8size < SC_MAX_ITEM_SIZE && options->can_cache)
   {
-    unsigned i;
+    unsigned i, prev = SC_NO_ENTRY;
     hash = apsw_hash_bytes((void*)utf8, utf8size);
 
-    for (i = 0; i <= sc->highest_used; i++)
+    for (i = sc->buckets[hash & sc->bucket_mask]; i != SC_NO_ENTRY; prev = i, i = sc->chain[i])
     {
       if (sc->hashes[i] == hash && sc->caches[i]->utf8_size == utf8size && 0 == memcmp(utf8, sc->caches[i]->utf8, utf8size) && 0 == memcmp(&sc->caches[i]->options, options, sizeof(APSWStatementOptions)))
       {
         /* cache hit */
+        statementcache_index_remove(sc, i, prev);
+        statementcache_heap_remove(sc, i);
+        sc->free_slots[sc->free_count++] = i;
         sc->hashes[i] = SC_SENTINEL_HASH;
         statement = sc->caches[i];
         sc->caches[i] = NULL;
@@ -240,7 +390,10 @@ statementcache_prepare_internal(StatementCache *sc, const char *utf8, Py_ssize_t
 
   assert(0 == utf8[utf8size]);
   /* note that prepare can return ok while a python level exception occurred that couldn't be reported */
-  PYSQLITE_SC_CALL(res = sqlite3_prepare_v3(sc->db, utf8, utf8size + 1, options->prepare_flags, &vdbestatement, &tail));
+  PYSQLITE_SC_CALL((prepare_ns = apsw_perf_counter_ns(),
+                    res = sqlite3_prepare_v3(sc->db, utf8, utf8size + 1, options->prepare_flags, &vdbestatement, &tail),
+                    prepare_ns = apsw_perf_counter_ns() - prepare_ns));
+  sc->prepare_ns += prepare_ns;
   if (res != SQLITE_OK || PyErr_Occurred())
   {
     SET_EXC(res, sc->db);
@@ -278,10 +431,14 @@ statementcache_prepare_internal(StatementCache *sc, const char *utf8, Py_ssize_t
 
 #if SC_STATEMENT_RECYCLE_BIN_ENTRIES > 0
   if (sc->recycle_bin_next)
+  {
     statement = sc->recycle_bin[--sc->recycle_bin_next];
+    sc->recycle_hits++;
+  }
   else
 #endif
   {
+    sc->recycle_misses++;
     statement = PyMem_Calloc(1, sizeof(APSWStatement));
     if (!statement)
     {
@@ -303,6 +460,12 @@ statementcache_prepare_internal(StatementCache *sc, const char *utf8, Py_ssize_t
   statement->query_size = tail - utf8;
   statement->utf8_size = utf8size;
   statement->uses = 1;
+  statement->prepare_ns = prepare_ns;
+  statement->rows = 0;
+  statement->step_ns = 0;
+  statement->convert_ns = 0;
+  statement->row_fields = NULL;
+  statement->column_converters = NULL;
   memcpy(&statement->options, options, sizeof(APSWStatementOptions));
 
   if (vdbestatement && tail == orig_tail && !statementcache_hasmore(statement))
@@ -383,6 +546,12 @@ statementcache_free(StatementCache *sc)
   if (sc)
   {
     PyMem_Free(sc->hashes);
+    PyMem_Free(sc->buckets);
+    PyMem_Free(sc->chain);
+    PyMem_Free(sc->priorities);
+    PyMem_Free(sc->heap);
+    PyMem_Free(sc->heap_pos);
+    PyMem_Free(sc->free_slots);
     if (sc->caches)
     {
       unsigned i;
@@ -413,8 +582,20 @@ statementcache_init(sqlite3 *db, unsigned size)
   res = (StatementCache *)PyMem_Calloc(1, sizeof(StatementCache));
   if (res)
   {
+    unsigned nbuckets = 1;
+
+    /* at least as many buckets as entries */
+    while (nbuckets < size)
+      nbuckets *= 2;
     res->hashes = size ? PyMem_Calloc(size, sizeof(Py_hash_t)) : 0;
     res->caches = size ? PyMem_Calloc(size, sizeof(APSWStatement *)) : 0;
+    res->chain = size ? PyMem_Calloc(size, sizeof(unsigned)) : 0;
+    res->buckets = size ? PyMem_Calloc(nbuckets, sizeof(unsigned)) : 0;
+    res->priorities = size ? PyMem_Calloc(size, sizeof(double)) : 0;
+    res->heap = size ? PyMem_Calloc(size, sizeof(unsigned)) : 0;
+    res->heap_pos = size ? PyMem_Calloc(size, sizeof(unsigned)) : 0;
+    res->free_slots = size ? PyMem_Calloc(size, sizeof(unsigned)) : 0;
+    res->bucket_mask = nbuckets - 1;
     res->maxentries = size;
     res->db = db;
     if (res->hashes)
@@ -423,8 +604,26 @@ statementcache_init(sqlite3 *db, unsigned size)
       for (i = 0; i <= res->highest_used; i++)
         res->hashes[i] = SC_SENTINEL_HASH;
     }
+    if (res->chain)
+    {
+      unsigned i;
+      for (i = 0; i < size; i++)
+        res->chain[i] = SC_NO_ENTRY;
+    }
+    if (res->free_slots)
+    {
+      /* lowest position is used first */
+      for (res->free_count = 0; res->free_count < size; res->free_count++)
+        res->free_slots[res->free_count] = size - 1 - res->free_count;
+    }
+    if (res->buckets)
+    {
+      unsigned i;
+      for (i = 0; i < nbuckets; i++)
+        res->buckets[i] = SC_NO_ENTRY;
+    }
   }
-  if (!res || (size && !res->hashes) || (size && !res->caches))
+  if (!res || (size && (!res->hashes || !res->caches || !res->chain || !res->buckets || !res->priorities || !res->heap || !res->heap_pos || !res->free_slots)))
   {
     statementcache_free(res);
     res = NULL;
@@ -440,7 +639,7 @@ statementcache_stats(StatementCache *sc, int include_entries)
      update this */
   PyObject *res = NULL, *entries = NULL, *entry = NULL;
 
-  res = Py_BuildValue("{s: I, s: I, s: I, s: I, s: I, s: I, s: I, s: I, s: I}",
+  res = Py_BuildValue("{s: I, s: I, s: I, s: I, s: I, s: I, s: I, s: I, s: I, s: d, s: I, s: I}",
                       "size", sc->maxentries,
                       "evictions", sc->evictions,
                       "no_cache", sc->no_cache,
@@ -449,7 +648,10 @@ statementcache_stats(StatementCache *sc, int include_entries)
                       "misses", sc->misses,
                       "too_big", sc->too_big,
                       "no_cache", sc->no_cache,
-                      "max_cacheable_bytes", SC_MAX_ITEM_SIZE);
+                      "max_cacheable_bytes", SC_MAX_ITEM_SIZE,
+                      "prepare_time", sc->prepare_ns / 1e9,
+                      "recycle_hits", sc->recycle_hits,
+                      "recycle_misses", sc->recycle_misses);
   if (res && include_entries)
   {
     int pycres;
@@ -463,12 +665,25 @@ statementcache_stats(StatementCache *sc, int include_entries)
       if (sc->hashes[i] != SC_SENTINEL_HASH)
       {
         APSWStatement *stmt = sc->caches[i];
-        entry = Py_BuildValue("{s: s#, s: O, s: i, s: i, s: I}",
+        sqlite3_stmt *vdbe = stmt->vdbestatement;
+        entry = Py_BuildValue("{s: s#, s: O, s: i, s: i, s: I, s: d, s: d, s: i, s: i, s: i, s: i, s: i, s: i, s: i, s: L, s: d, s: d}",
                               "query", stmt->utf8, stmt->query_size,
                               "has_more", (stmt->query_size == stmt->utf8_size) ? Py_False : Py_True,
                               "prepare_flags", stmt->options.prepare_flags,
                               "explain", stmt->options.explain,
-                              "uses", stmt->uses);
+                              "uses", stmt->uses,
+                              "prepare_time", stmt->prepare_ns / 1e9,
+                              "priority", sc->priorities[i] / 1e9,
+                              "fullscan_steps", sqlite3_stmt_status(vdbe, SQLITE_STMTSTATUS_FULLSCAN_STEP, 0),
+                              "sorts", sqlite3_stmt_status(vdbe, SQLITE_STMTSTATUS_SORT, 0),
+                              "autoindexes", sqlite3_stmt_status(vdbe, SQLITE_STMTSTATUS_AUTOINDEX, 0),
+                              "vm_steps", sqlite3_stmt_status(vdbe, SQLITE_STMTSTATUS_VM_STEP, 0),
+                              "reprepares", sqlite3_stmt_status(vdbe, SQLITE_STMTSTATUS_REPREPARE, 0),
+                              "runs", sqlite3_stmt_status(vdbe, SQLITE_STMTSTATUS_RUN, 0),
+                              "memory_used", sqlite3_stmt_status(vdbe, SQLITE_STMTSTATUS_MEMUSED, 0),
+                              "rows", (long long)stmt->rows,
+                              "step_time", stmt->step_ns / 1e9,
+                              "convert_time", stmt->convert_ns / 1e9);
         if (!entry)
           goto fail;
         pycres = PyList_Append(entries, entry);
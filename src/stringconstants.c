@@ -28,6 +28,8 @@ static struct _apsw_string_table
     PyObject *Mapping;
     PyObject *sNULL;
     PyObject *Next;
+    PyObject *NextColumns;
+    PyObject *NextRows;
     PyObject *Open;
     PyObject *Release;
     PyObject *Rename;
@@ -41,6 +43,7 @@ static struct _apsw_string_table
     PyObject *UpdateDeleteRow;
     PyObject *UpdateInsertRow;
     PyObject *add_note;
+    PyObject *array;
     PyObject *can_cache;
     PyObject *close;
     PyObject *connection_hooks;
@@ -51,11 +54,16 @@ static struct _apsw_string_table
     PyObject *executemany;
     PyObject *extendedresult;
     PyObject *final;
+    PyObject *frombytes;
     PyObject *get;
     PyObject *inverse;
+    PyObject *readinto;
+    PyObject *release;
     PyObject *result;
     PyObject *step;
+    PyObject *step_batch;
     PyObject *value;
+    PyObject *write;
     PyObject *xAccess;
     PyObject *xCheckReservedLock;
     PyObject *xClose;
@@ -73,10 +81,13 @@ static struct _apsw_string_table
     PyObject *xGetLastError;
     PyObject *xGetSystemCall;
     PyObject *xLock;
+    PyObject *xMmap;
     PyObject *xNextSystemCall;
     PyObject *xOpen;
     PyObject *xRandomness;
     PyObject *xRead;
+    PyObject *xReadBatch;
+    PyObject *xReadInto;
     PyObject *xSectorSize;
     PyObject *xSetSystemCall;
     PyObject *xSleep;
@@ -111,6 +122,8 @@ fini_apsw_strings(void)
     Py_CLEAR(apst.Mapping);
     Py_CLEAR(apst.sNULL);
     Py_CLEAR(apst.Next);
+    Py_CLEAR(apst.NextColumns);
+    Py_CLEAR(apst.NextRows);
     Py_CLEAR(apst.Open);
     Py_CLEAR(apst.Release);
     Py_CLEAR(apst.Rename);
@@ -124,6 +137,7 @@ fini_apsw_strings(void)
     Py_CLEAR(apst.UpdateDeleteRow);
     Py_CLEAR(apst.UpdateInsertRow);
     Py_CLEAR(apst.add_note);
+    Py_CLEAR(apst.array);
     Py_CLEAR(apst.can_cache);
     Py_CLEAR(apst.close);
     Py_CLEAR(apst.connection_hooks);
@@ -134,11 +148,16 @@ fini_apsw_strings(void)
     Py_CLEAR(apst.executemany);
     Py_CLEAR(apst.extendedresult);
     Py_CLEAR(apst.final);
+    Py_CLEAR(apst.frombytes);
     Py_CLEAR(apst.get);
     Py_CLEAR(apst.inverse);
+    Py_CLEAR(apst.readinto);
+    Py_CLEAR(apst.release);
     Py_CLEAR(apst.result);
     Py_CLEAR(apst.step);
+    Py_CLEAR(apst.step_batch);
     Py_CLEAR(apst.value);
+    Py_CLEAR(apst.write);
     Py_CLEAR(apst.xAccess);
     Py_CLEAR(apst.xCheckReservedLock);
     Py_CLEAR(apst.xClose);
@@ -156,10 +175,13 @@ fini_apsw_strings(void)
     Py_CLEAR(apst.xGetLastError);
     Py_CLEAR(apst.xGetSystemCall);
     Py_CLEAR(apst.xLock);
+    Py_CLEAR(apst.xMmap);
     Py_CLEAR(apst.xNextSystemCall);
     Py_CLEAR(apst.xOpen);
     Py_CLEAR(apst.xRandomness);
     Py_CLEAR(apst.xRead);
+    Py_CLEAR(apst.xReadBatch);
+    Py_CLEAR(apst.xReadInto);
     Py_CLEAR(apst.xSectorSize);
     Py_CLEAR(apst.xSetSystemCall);
     Py_CLEAR(apst.xSleep);
@@ -173,7 +195,7 @@ fini_apsw_strings(void)
 static int
 init_apsw_strings()
 {
-    if ((0 == (apst.closed = PyUnicode_FromString("(closed)"))) || (0 == (apst.s_1e999 = PyUnicode_FromString("-1e999"))) || (0 == (apst.s0_0 = PyUnicode_FromString("0.0"))) || (0 == (apst.s1e999 = PyUnicode_FromString("1e999"))) || (0 == (apst.Begin = PyUnicode_FromString("Begin"))) || (0 == (apst.BestIndex = PyUnicode_FromString("BestIndex"))) || (0 == (apst.BestIndexObject = PyUnicode_FromString("BestIndexObject"))) || (0 == (apst.Close = PyUnicode_FromString("Close"))) || (0 == (apst.Column = PyUnicode_FromString("Column"))) || (0 == (apst.ColumnNoChange = PyUnicode_FromString("ColumnNoChange"))) || (0 == (apst.Commit = PyUnicode_FromString("Commit"))) || (0 == (apst.Connect = PyUnicode_FromString("Connect"))) || (0 == (apst.Create = PyUnicode_FromString("Create"))) || (0 == (apst.Destroy = PyUnicode_FromString("Destroy"))) || (0 == (apst.Disconnect = PyUnicode_FromString("Disconnect"))) || (0 == (apst.Eof = PyUnicode_FromString("Eof"))) || (0 == (apst.Filter = PyUnicode_FromString("Filter"))) || (0 == (apst.FindFunction = PyUnicode_FromString("FindFunction"))) || (0 == (apst.Integrity = PyUnicode_FromString("Integrity"))) || (0 == (apst.Mapping = PyUnicode_FromString("Mapping"))) || (0 == (apst.sNULL = PyUnicode_FromString("NULL"))) || (0 == (apst.Next = PyUnicode_FromString("Next"))) || (0 == (apst.Open = PyUnicode_FromString("Open"))) || (0 == (apst.Release = PyUnicode_FromString("Release"))) || (0 == (apst.Rename = PyUnicode_FromString("Rename"))) || (0 == (apst.Rollback = PyUnicode_FromString("Rollback"))) || (0 == (apst.RollbackTo = PyUnicode_FromString("RollbackTo"))) || (0 == (apst.Rowid = PyUnicode_FromString("Rowid"))) || (0 == (apst.Savepoint = PyUnicode_FromString("Savepoint"))) || (0 == (apst.ShadowName = PyUnicode_FromString("ShadowName"))) || (0 == (apst.Sync = PyUnicode_FromString("Sync"))) || (0 == (apst.UpdateChangeRow = PyUnicode_FromString("UpdateChangeRow"))) || (0 == (apst.UpdateDeleteRow = PyUnicode_FromString("UpdateDeleteRow"))) || (0 == (apst.UpdateInsertRow = PyUnicode_FromString("UpdateInsertRow"))) || (0 == (apst.add_note = PyUnicode_FromString("add_note"))) || (0 == (apst.can_cache = PyUnicode_FromString("can_cache"))) || (0 == (apst.close = PyUnicode_FromString("close"))) || (0 == (apst.connection_hooks = PyUnicode_FromString("connection_hooks"))) || (0 == (apst.cursor = PyUnicode_FromString("cursor"))) || (0 == (apst.error_offset = PyUnicode_FromString("error_offset"))) || (0 == (apst.excepthook = PyUnicode_FromString("excepthook"))) || (0 == (apst.execute = PyUnicode_FromString("execute"))) || (0 == (apst.executemany = PyUnicode_FromString("executemany"))) || (0 == (apst.extendedresult = PyUnicode_FromString("extendedresult"))) || (0 == (apst.final = PyUnicode_FromString("final"))) || (0 == (apst.get = PyUnicode_FromString("get"))) || (0 == (apst.inverse = PyUnicode_FromString("inverse"))) || (0 == (apst.result = PyUnicode_FromString("result"))) || (0 == (apst.step = PyUnicode_FromString("step"))) || (0 == (apst.value = PyUnicode_FromString("value"))) || (0 == (apst.xAccess = PyUnicode_FromString("xAccess"))) || (0 == (apst.xCheckReservedLock = PyUnicode_FromString("xCheckReservedLock"))) || (0 == (apst.xClose = PyUnicode_FromString("xClose"))) || (0 == (apst.xCurrentTime = PyUnicode_FromString("xCurrentTime"))) || (0 == (apst.xCurrentTimeInt64 = PyUnicode_FromString("xCurrentTimeInt64"))) || (0 == (apst.xDelete = PyUnicode_FromString("xDelete"))) || (0 == (apst.xDeviceCharacteristics = PyUnicode_FromString("xDeviceCharacteristics"))) || (0 == (apst.xDlClose = PyUnicode_FromString("xDlClose"))) || (0 == (apst.xDlError = PyUnicode_FromString("xDlError"))) || (0 == (apst.xDlOpen = PyUnicode_FromString("xDlOpen"))) || (0 == (apst.xDlSym = PyUnicode_FromString("xDlSym"))) || (0 == (apst.xFileControl = PyUnicode_FromString("xFileControl"))) || (0 == (apst.xFileSize = PyUnicode_FromString("xFileSize"))) || (0 == (apst.xFullPathname = PyUnicode_FromString("xFullPathname"))) || (0 == (apst.xGetLastError = PyUnicode_FromString("xGetLastError"))) || (0 == (apst.xGetSystemCall = PyUnicode_FromString("xGetSystemCall"))) || (0 == (apst.xLock = PyUnicode_FromString("xLock"))) || (0 == (apst.xNextSystemCall = PyUnicode_FromString("xNextSystemCall"))) || (0 == (apst.xOpen = PyUnicode_FromString("xOpen"))) || (0 == (apst.xRandomness = PyUnicode_FromString("xRandomness"))) || (0 == (apst.xRead = PyUnicode_FromString("xRead"))) || (0 == (apst.xSectorSize = PyUnicode_FromString("xSectorSize"))) || (0 == (apst.xSetSystemCall = PyUnicode_FromString("xSetSystemCall"))) || (0 == (apst.xSleep = PyUnicode_FromString("xSleep"))) || (0 == (apst.xSync = PyUnicode_FromString("xSync"))) || (0 == (apst.xTruncate = PyUnicode_FromString("xTruncate"))) || (0 == (apst.xUnlock = PyUnicode_FromString("xUnlock"))) || (0 == (apst.xWrite = PyUnicode_FromString("xWrite"))))
+    if ((0 == (apst.closed = PyUnicode_FromString("(closed)"))) || (0 == (apst.s_1e999 = PyUnicode_FromString("-1e999"))) || (0 == (apst.s0_0 = PyUnicode_FromString("0.0"))) || (0 == (apst.s1e999 = PyUnicode_FromString("1e999"))) || (0 == (apst.Begin = PyUnicode_FromString("Begin"))) || (0 == (apst.BestIndex = PyUnicode_FromString("BestIndex"))) || (0 == (apst.BestIndexObject = PyUnicode_FromString("BestIndexObject"))) || (0 == (apst.Close = PyUnicode_FromString("Close"))) || (0 == (apst.Column = PyUnicode_FromString("Column"))) || (0 == (apst.ColumnNoChange = PyUnicode_FromString("ColumnNoChange"))) || (0 == (apst.Commit = PyUnicode_FromString("Commit"))) || (0 == (apst.Connect = PyUnicode_FromString("Connect"))) || (0 == (apst.Create = PyUnicode_FromString("Create"))) || (0 == (apst.Destroy = PyUnicode_FromString("Destroy"))) || (0 == (apst.Disconnect = PyUnicode_FromString("Disconnect"))) || (0 == (apst.Eof = PyUnicode_FromString("Eof"))) || (0 == (apst.Filter = PyUnicode_FromString("Filter"))) || (0 == (apst.FindFunction = PyUnicode_FromString("FindFunction"))) || (0 == (apst.Integrity = PyUnicode_FromString("Integrity"))) || (0 == (apst.Mapping = PyUnicode_FromString("Mapping"))) || (0 == (apst.sNULL = PyUnicode_FromString("NULL"))) || (0 == (apst.Next = PyUnicode_FromString("Next"))) || (0 == (apst.NextColumns = PyUnicode_FromString("NextColumns"))) || (0 == (apst.NextRows = PyUnicode_FromString("NextRows"))) || (0 == (apst.Open = PyUnicode_FromString("Open"))) || (0 == (apst.Release = PyUnicode_FromString("Release"))) || (0 == (apst.Rename = PyUnicode_FromString("Rename"))) || (0 == (apst.Rollback = PyUnicode_FromString("Rollback"))) || (0 == (apst.RollbackTo = PyUnicode_FromString("RollbackTo"))) || (0 == (apst.Rowid = PyUnicode_FromString("Rowid"))) || (0 == (apst.Savepoint = PyUnicode_FromString("Savepoint"))) || (0 == (apst.ShadowName = PyUnicode_FromString("ShadowName"))) || (0 == (apst.Sync = PyUnicode_FromString("Sync"))) || (0 == (apst.UpdateChangeRow = PyUnicode_FromString("UpdateChangeRow"))) || (0 == (apst.UpdateDeleteRow = PyUnicode_FromString("UpdateDeleteRow"))) || (0 == (apst.UpdateInsertRow = PyUnicode_FromString("UpdateInsertRow"))) || (0 == (apst.add_note = PyUnicode_FromString("add_note"))) || (0 == (apst.array = PyUnicode_FromString("array"))) || (0 == (apst.can_cache = PyUnicode_FromString("can_cache"))) || (0 == (apst.close = PyUnicode_FromString("close"))) || (0 == (apst.connection_hooks = PyUnicode_FromString("connection_hooks"))) || (0 == (apst.cursor = PyUnicode_FromString("cursor"))) || (0 == (apst.error_offset = PyUnicode_FromString("error_offset"))) || (0 == (apst.excepthook = PyUnicode_FromString("excepthook"))) || (0 == (apst.execute = PyUnicode_FromString("execute"))) || (0 == (apst.executemany = PyUnicode_FromString("executemany"))) || (0 == (apst.extendedresult = PyUnicode_FromString("extendedresult"))) || (0 == (apst.final = PyUnicode_FromString("final"))) || (0 == (apst.frombytes = PyUnicode_FromString("frombytes"))) || (0 == (apst.get = PyUnicode_FromString("get"))) || (0 == (apst.inverse = PyUnicode_FromString("inverse"))) || (0 == (apst.readinto = PyUnicode_FromString("readinto"))) || (0 == (apst.release = PyUnicode_FromString("release"))) || (0 == (apst.result = PyUnicode_FromString("result"))) || (0 == (apst.step = PyUnicode_FromString("step"))) || (0 == (apst.step_batch = PyUnicode_FromString("step_batch"))) || (0 == (apst.value = PyUnicode_FromString("value"))) || (0 == (apst.write = PyUnicode_FromString("write"))) || (0 == (apst.xAccess = PyUnicode_FromString("xAccess"))) || (0 == (apst.xCheckReservedLock = PyUnicode_FromString("xCheckReservedLock"))) || (0 == (apst.xClose = PyUnicode_FromString("xClose"))) || (0 == (apst.xCurrentTime = PyUnicode_FromString("xCurrentTime"))) || (0 == (apst.xCurrentTimeInt64 = PyUnicode_FromString("xCurrentTimeInt64"))) || (0 == (apst.xDelete = PyUnicode_FromString("xDelete"))) || (0 == (apst.xDeviceCharacteristics = PyUnicode_FromString("xDeviceCharacteristics"))) || (0 == (apst.xDlClose = PyUnicode_FromString("xDlClose"))) || (0 == (apst.xDlError = PyUnicode_FromString("xDlError"))) || (0 == (apst.xDlOpen = PyUnicode_FromString("xDlOpen"))) || (0 == (apst.xDlSym = PyUnicode_FromString("xDlSym"))) || (0 == (apst.xFileControl = PyUnicode_FromString("xFileControl"))) || (0 == (apst.xFileSize = PyUnicode_FromString("xFileSize"))) || (0 == (apst.xFullPathname = PyUnicode_FromString("xFullPathname"))) || (0 == (apst.xGetLastError = PyUnicode_FromString("xGetLastError"))) || (0 == (apst.xGetSystemCall = PyUnicode_FromString("xGetSystemCall"))) || (0 == (apst.xLock = PyUnicode_FromString("xLock"))) || (0 == (apst.xMmap = PyUnicode_FromString("xMmap"))) || (0 == (apst.xNextSystemCall = PyUnicode_FromString("xNextSystemCall"))) || (0 == (apst.xOpen = PyUnicode_FromString("xOpen"))) || (0 == (apst.xRandomness = PyUnicode_FromString("xRandomness"))) || (0 == (apst.xRead = PyUnicode_FromString("xRead"))) || (0 == (apst.xReadBatch = PyUnicode_FromString("xReadBatch"))) || (0 == (apst.xReadInto = PyUnicode_FromString("xReadInto"))) || (0 == (apst.xSectorSize = PyUnicode_FromString("xSectorSize"))) || (0 == (apst.xSetSystemCall = PyUnicode_FromString("xSetSystemCall"))) || (0 == (apst.xSleep = PyUnicode_FromString("xSleep"))) || (0 == (apst.xSync = PyUnicode_FromString("xSync"))) || (0 == (apst.xTruncate = PyUnicode_FromString("xTruncate"))) || (0 == (apst.xUnlock = PyUnicode_FromString("xUnlock"))) || (0 == (apst.xWrite = PyUnicode_FromString("xWrite"))))
     {
         fini_apsw_strings();
         return -1;
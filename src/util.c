@@ -19,7 +19,9 @@
   sqlite3_step with the GIL released, we don't want Cursor_execute
   called on another thread since that will thrash what the first
   thread is doing.  We use a member of Connection, Blob and Cursor
-  named 'inuse' to provide the simple exclusion.
+  named 'inuse' to provide the simple exclusion.  Without a GIL (free
+  threaded Python) checking and setting inuse are atomic operations so
+  that two threads can't both claim the object.
 
   - The GIL has to be released around all SQLite calls that take the
   database mutex (which is most of them).  If the GIL is kept even for
@@ -64,6 +66,72 @@
     Py_END_ALLOW_THREADS;                                              \
   } while (0)
 
+/* Operations on the inuse member.  INUSE_ACQUIRE returns non-zero if
+   it changed inuse from 0 to 1, and zero if it was already in use.
+
+   With the GIL, CHECK_USE having passed means acquiring inuse always
+   succeeds.  Without it another thread could get in between.
+   INUSE_CALL_ELSE then doesn't run x, raises ThreadingViolation and
+   runs failed instead, while INUSE_CALL (used where the caller has no
+   way of reporting an error) waits for the other thread to finish
+   its call. */
+#ifdef Py_GIL_DISABLED
+#define INUSE_GET(o) _Py_atomic_load_int(&(o)->inuse)
+#define INUSE_ACQUIRE(o) apsw_inuse_acquire(&(o)->inuse)
+#define INUSE_RELEASE(o) _Py_atomic_store_int(&(o)->inuse, 0)
+
+static int
+apsw_inuse_acquire(int *inuse)
+{
+  int expected = 0;
+  return _Py_atomic_compare_exchange_int(inuse, &expected, 1);
+}
+
+static void
+apsw_inuse_acquire_wait(int *inuse)
+{
+  while (!apsw_inuse_acquire(inuse))
+  {
+    /* lets the other thread and stop the world operations proceed */
+    Py_BEGIN_ALLOW_THREADS
+    Py_END_ALLOW_THREADS;
+  }
+}
+
+#define INUSE_CALL_ELSE(x, failed)                                     \
+  do                                                                   \
+  {                                                                    \
+    if (INUSE_ACQUIRE(self))                                           \
+    {                                                                  \
+      {                                                                \
+        x;                                                             \
+      }                                                                \
+      assert(INUSE_GET(self) == 1);                                    \
+      INUSE_RELEASE(self);                                             \
+    }                                                                  \
+    else                                                               \
+    {                                                                  \
+      if (!PyErr_Occurred())                                           \
+        PyErr_Format(ExcThreadingViolation, INUSE_VIOLATION_MESSAGE); \
+      failed;                                                          \
+    }                                                                  \
+  } while (0)
+
+#define INUSE_CALL(x)                          \
+  do                                           \
+  {                                            \
+    apsw_inuse_acquire_wait(&self->inuse);     \
+    {                                          \
+      x;                                       \
+    }                                          \
+    assert(INUSE_GET(self) == 1);              \
+    INUSE_RELEASE(self);                       \
+  } while (0)
+#else
+#define INUSE_GET(o) ((o)->inuse)
+#define INUSE_ACQUIRE(o) ((o)->inuse ? 0 : ((o)->inuse = 1))
+#define INUSE_RELEASE(o) ((o)->inuse = 0)
+
 #define INUSE_CALL(x)         \
   do                          \
   {                           \
@@ -76,11 +144,16 @@
     self->inuse = 0;          \
   } while (0)
 
+#define INUSE_CALL_ELSE(x, failed) INUSE_CALL(x)
+#endif
+
+#define INUSE_VIOLATION_MESSAGE "You are trying to use the same object concurrently in two threads or re-entrantly within the same thread which is not allowed."
+
 /* call from blob code */
-#define PYSQLITE_BLOB_CALL(y) INUSE_CALL(_PYSQLITE_CALL_E(self->connection->db, y))
+#define PYSQLITE_BLOB_CALL(y) INUSE_CALL_ELSE(_PYSQLITE_CALL_E(self->connection->db, y), res = SQLITE_MISUSE)
 
 /* call from connection code */
-#define PYSQLITE_CON_CALL(y) INUSE_CALL(_PYSQLITE_CALL_E(self->db, y))
+#define PYSQLITE_CON_CALL(y) INUSE_CALL_ELSE(_PYSQLITE_CALL_E(self->db, y), res = SQLITE_MISUSE)
 
 /* call from cursor code - same as blob */
 #define PYSQLITE_CUR_CALL PYSQLITE_BLOB_CALL
@@ -92,7 +165,10 @@
 #define PYSQLITE_VOID_CALL(y) INUSE_CALL(_PYSQLITE_CALL_V(y))
 
 /* call from backup code */
-#define PYSQLITE_BACKUP_CALL(y) INUSE_CALL(_PYSQLITE_CALL_E(self->dest->db, y))
+#define PYSQLITE_BACKUP_CALL(y) INUSE_CALL_ELSE(_PYSQLITE_CALL_E(self->dest->db, y), res = SQLITE_MISUSE)
+
+/* call from session code - same as blob */
+#define PYSQLITE_SESSION_CALL PYSQLITE_BLOB_CALL
 
 /*
    The default Python PyErr_WriteUnraisable is almost useless, and barely used
@@ -323,6 +399,51 @@ convert_value_to_pyobject_not_in(sqlite3_value *value)
   return convert_value_to_pyobject(value, 0, 0);
 }
 
+/* array.array used by fetchmany_columns and aggregate batches */
+static PyObject *array_array;
+
+/* array.array of typecode filled with a copy of the memory */
+static PyObject *
+array_from_memory(const char *typecode, void *data, size_t len)
+{
+  PyObject *array = NULL, *memview = NULL, *res = NULL;
+
+  array = PyObject_CallFunction(array_array, "s", typecode);
+  if (!array)
+    goto finally;
+  if (len)
+  {
+    memview = PyMemoryView_FromMemory(data, len, PyBUF_READ);
+    if (!memview)
+      goto finally;
+    PyObject *vargs[] = {NULL, array, memview};
+    res = PyObject_VectorcallMethod(apst.frombytes, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    if (!res)
+      goto finally;
+  }
+finally:
+  Py_XDECREF(memview);
+  Py_XDECREF(res);
+  if (PyErr_Occurred())
+    Py_CLEAR(array);
+  return array;
+}
+
+/* A memoryview handed to Python only points into our buffer until
+   the call returns, so it is released and any exports kept beyond
+   that are an error. Returns -1 on error. */
+static int
+memoryview_release(PyObject *view)
+{
+  PyObject *res = NULL;
+  CHAIN_EXC_BEGIN
+  PyObject *vargs[] = {NULL, view};
+  res = PyObject_VectorcallMethod(apst.release, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  CHAIN_EXC_END;
+  Py_XDECREF(res);
+  return res ? 0 : -1;
+}
+
 /* Converts column to PyObject.  Returns a new reference. Almost identical to above
    but we cannot just use sqlite3_column_value and then call the above function as
    SQLite doesn't allow that ("unprotected values") */
@@ -372,18 +493,150 @@ convert_column_to_pyobject(sqlite3_stmt *stmt, int col)
   }
 }
 
+/* A column value read or bound while the GIL is released.  SQLite's
+   pointers for text and blob remain valid until the statement is stepped
+   or reset, and the column is not read again.  When binding the pointers
+   belong to Python objects that are kept alive by the caller. */
+typedef struct APSWColumnValue
+{
+  int type;
+  Py_ssize_t len;
+  union
+  {
+    sqlite3_int64 i;
+    double d;
+    const void *p;
+  } u;
+} APSWColumnValue;
+
+/* rows with up to this many columns don't need a memory allocation */
+#define ROW_STACK_COLUMNS 32
+
+/* Reads every column of the current row.  This must be called with the GIL
+   released.  The db mutex is held for the whole row so the SQLite calls
+   don't each have to acquire it. */
+static void
+read_row_values(sqlite3_stmt *stmt, int numcols, APSWColumnValue *values)
+{
+  int i;
+  sqlite3_mutex *mutex = sqlite3_db_mutex(sqlite3_db_handle(stmt));
+
+  sqlite3_mutex_enter(mutex);
+  for (i = 0; i < numcols; i++)
+  {
+    values[i].type = sqlite3_column_type(stmt, i);
+    switch (values[i].type)
+    {
+    case SQLITE_INTEGER:
+      values[i].u.i = sqlite3_column_int64(stmt, i);
+      break;
+    case SQLITE_FLOAT:
+      values[i].u.d = sqlite3_column_double(stmt, i);
+      break;
+    case SQLITE_TEXT:
+      values[i].u.p = sqlite3_column_text(stmt, i);
+      values[i].len = sqlite3_column_bytes(stmt, i);
+      break;
+    case SQLITE_BLOB:
+      values[i].u.p = sqlite3_column_blob(stmt, i);
+      values[i].len = sqlite3_column_bytes(stmt, i);
+      break;
+    }
+  }
+  sqlite3_mutex_leave(mutex);
+}
+
+/* Converts values previously read into items, which must start out
+   NULL and belong to a container (tuple or apsw.Row) that releases
+   them.  Returns -1 with an exception on failure. */
+static int
+convert_values_to_items(const APSWColumnValue *values, int numcols, PyObject **items)
+{
+  PyObject *item;
+  int i;
+
+  for (i = 0; i < numcols; i++)
+  {
+    switch (values[i].type)
+    {
+    case SQLITE_INTEGER:
+      item = PyLong_FromLongLong(values[i].u.i);
+      break;
+    case SQLITE_FLOAT:
+      item = PyFloat_FromDouble(values[i].u.d);
+      break;
+    case SQLITE_TEXT:
+      item = PyUnicode_FromStringAndSize(values[i].u.p, values[i].len);
+      break;
+    case SQLITE_BLOB:
+      item = PyBytes_FromStringAndSize(values[i].u.p, values[i].len);
+      break;
+    default:
+      item = Py_NewRef(Py_None);
+    }
+    if (!item)
+      return -1;
+    items[i] = item;
+  }
+  return 0;
+}
+
+/* Makes a tuple from values previously read.  Returns a new
+   reference. */
+static PyObject *
+convert_values_to_pytuple(const APSWColumnValue *values, int numcols)
+{
+  PyObject *row = PyTuple_New(numcols);
+  if (row && convert_values_to_items(values, numcols, PySequence_Fast_ITEMS(row)))
+    Py_CLEAR(row);
+  return row;
+}
+
+/* Converts all the columns of the current row into items belonging to
+   row, which is a new tuple or apsw.Row with the items NULL.  Returns
+   row, or NULL with row released on failure.  Unlike calling
+   convert_column_to_pyobject for each column, the GIL is only released
+   once for the whole row, which is an improvement when other threads
+   are contending for the GIL. */
+#undef convert_row_to_pyobject
+static PyObject *
+convert_row_to_pyobject(sqlite3_stmt *stmt, int numcols, PyObject *row, PyObject **items)
+{
+#include "faultinject.h"
+  APSWColumnValue stack_values[ROW_STACK_COLUMNS], *values = stack_values;
+
+  if (numcols > ROW_STACK_COLUMNS)
+  {
+    values = PyMem_Malloc(sizeof(APSWColumnValue) * numcols);
+    if (!values)
+    {
+      Py_DECREF(row);
+      return PyErr_NoMemory();
+    }
+  }
+
+  _PYSQLITE_CALL_V(read_row_values(stmt, numcols, values));
+
+  if (convert_values_to_items(values, numcols, items))
+    Py_CLEAR(row);
+
+  if (values != stack_values)
+    PyMem_Free(values);
+  return row;
+}
+
 /* Some macros used for frequent operations */
 
 /* used by Connection and Cursor */
-#define CHECK_USE(e)                                                                                                                                                           \
-  do                                                                                                                                                                           \
-  {                                                                                                                                                                            \
-    if (self->inuse)                                                                                                                                                           \
-    { /* raise exception if we aren't already in one */                                                                                                                        \
-      if (!PyErr_Occurred())                                                                                                                                                   \
-        PyErr_Format(ExcThreadingViolation, "You are trying to use the same object concurrently in two threads or re-entrantly within the same thread which is not allowed."); \
-      return e;                                                                                                                                                                \
-    }                                                                                                                                                                          \
+#define CHECK_USE(e)                                                  \
+  do                                                                  \
+  {                                                                   \
+    if (INUSE_GET(self))                                              \
+    { /* raise exception if we aren't already in one */               \
+      if (!PyErr_Occurred())                                          \
+        PyErr_Format(ExcThreadingViolation, INUSE_VIOLATION_MESSAGE); \
+      return e;                                                       \
+    }                                                                 \
   } while (0)
 
 /* used by Connection */
@@ -285,10 +285,23 @@ typedef struct
 
 static PyTypeObject APSWVFSType;
 
+typedef struct APSWVFSFileCache APSWVFSFileCache;
+
 typedef struct /* inherits */
 {
   const struct sqlite3_io_methods *pMethods; /* structure sqlite needs */
   PyObject *file;
+  int read_into;                  /* call xReadInto with a memoryview instead of xRead */
+  int write_view;                 /* call xWrite with a memoryview instead of bytes */
+  int read_batch;                 /* call xReadBatch to fill the cache */
+  APSWVFSFileCache *cache;        /* block cache if enabled by URI parameter */
+  int has_mmap;                   /* xMmap was provided so xFetch is supported */
+  sqlite3_int64 mmap_limit;       /* from SQLITE_FCNTL_MMAP_SIZE */
+  Py_buffer mapping;              /* from xMmap */
+  int mapped;                     /* is mapping valid */
+  int map_tried;                  /* has xMmap been called since the last unmap */
+  int map_short;                  /* was a fetch beyond the end of mapping */
+  int nfetched;                   /* outstanding xFetch pointers */
 } APSWSQLite3File;
 
 /* this is only used if there is inheritance */
@@ -314,6 +327,13 @@ static PyTypeObject APSWURIFilenameType;
 
 static const struct sqlite3_io_methods apsw_io_methods_v1;
 static const struct sqlite3_io_methods apsw_io_methods_v2;
+static const struct sqlite3_io_methods apsw_io_methods_v3;
+static const struct sqlite3_io_methods apsw_io_methods_v3_noshm;
+
+static APSWVFSFileCache *vfscache_new(unsigned block_size, unsigned nblocks, unsigned readahead_max);
+static void vfscache_free(APSWVFSFileCache *c);
+static void vfscache_clear(APSWVFSFileCache *c);
+static void vfscache_invalidate(APSWVFSFileCache *c, sqlite3_int64 offset, sqlite3_int64 amount);
 
 typedef struct
 {
@@ -606,6 +626,77 @@ apswvfspy_xFullPathname(APSWVFS *self, PyObject *const *fast_args, Py_ssize_t fa
   return result;
 }
 
+/* Is the named method of file the one inherited unchanged from
+   VFSFile?  Returns -1 on error, 0 if not/missing, and 1 if it is */
+static int
+apswvfsfile_method_is_base(PyObject *file, PyObject *name)
+{
+  PyObject *method = NULL, *basemethod = NULL;
+  int res;
+
+  method = PyObject_GetAttr((PyObject *)Py_TYPE(file), name);
+  if (!method)
+  {
+    if (!PyErr_ExceptionMatches(PyExc_AttributeError))
+      return -1;
+    PyErr_Clear();
+    return 0;
+  }
+  basemethod = PyObject_GetAttr((PyObject *)&APSWVFSFileType, name);
+  res = basemethod ? (method == basemethod) : -1;
+  Py_DECREF(method);
+  Py_XDECREF(basemethod);
+  return res;
+}
+
+/* Decides if SQLite's buffers can be handed directly to file.
+   xReadInto is used when present, unless it is the VFSFile one while
+   xRead has been overridden.  xReadBatch is similarly only used if it
+   is not the VFSFile one, or neither xRead nor xReadInto were
+   overridden.  xWrite gets a memoryview when it is the
+   VFSFile one, or the class provides its own xReadInto and so is
+   expected to be buffer aware.  xMmap is only used if it is not the
+   VFSFile one which always returns None.  Returns -1 on error. */
+static int
+apswvfsfile_detect_buffer_methods(APSWSQLite3File *apswfile, PyObject *file)
+{
+  int has_read_into, read_into_base, read_base, write_base, read_batch_base, mmap_base;
+
+  has_read_into = PyObject_HasAttr(file, apst.xReadInto);
+  read_into_base = apswvfsfile_method_is_base(file, apst.xReadInto);
+  if (read_into_base < 0)
+    return -1;
+  read_base = apswvfsfile_method_is_base(file, apst.xRead);
+  if (read_base < 0)
+    return -1;
+  write_base = apswvfsfile_method_is_base(file, apst.xWrite);
+  if (write_base < 0)
+    return -1;
+  read_batch_base = apswvfsfile_method_is_base(file, apst.xReadBatch);
+  if (read_batch_base < 0)
+    return -1;
+  mmap_base = apswvfsfile_method_is_base(file, apst.xMmap);
+  if (mmap_base < 0)
+    return -1;
+
+  apswfile->read_into = has_read_into && (!read_into_base || read_base);
+  apswfile->write_view = write_base || (has_read_into && !read_into_base);
+  apswfile->read_batch = PyObject_HasAttr(file, apst.xReadBatch) && (!read_batch_base || (read_base && read_into_base));
+  apswfile->has_mmap = PyObject_HasAttr(file, apst.xMmap) && !mmap_base;
+  return 0;
+}
+
+/* Releases the xMmap buffer so the next xFetch asks for it again.  The
+   GIL must be held and there must be no outstanding fetches */
+static void
+apswvfsfile_unmap(APSWSQLite3File *apswfile)
+{
+  assert(apswfile->nfetched == 0);
+  if (apswfile->mapped)
+    PyBuffer_Release(&apswfile->mapping);
+  apswfile->mapped = apswfile->map_tried = apswfile->map_short = 0;
+}
+
 static int
 apswvfs_xOpen(sqlite3_vfs *vfs, const char *zName, sqlite3_file *file, int inflags, int *pOutFlags)
 {
@@ -618,6 +709,10 @@ apswvfs_xOpen(sqlite3_vfs *vfs, const char *zName, sqlite3_file *file, int infla
 
   VFSPREAMBLE;
 
+  apswfile->cache = NULL;
+  apswfile->mapped = apswfile->map_tried = apswfile->map_short = apswfile->nfetched = 0;
+  apswfile->mmap_limit = 0;
+
   flags = PyList_New(2);
   if (!flags)
     goto finally;
@@ -677,11 +772,39 @@ apswvfs_xOpen(sqlite3_vfs *vfs, const char *zName, sqlite3_file *file, int infla
     apswfile->pMethods = &apsw_io_methods_v1;
   }
 
+  if (apswvfsfile_detect_buffer_methods(apswfile, pyresult))
+    goto finally;
+  if (apswfile->has_mmap)
+    apswfile->pMethods = (apswfile->pMethods == &apsw_io_methods_v2) ? &apsw_io_methods_v3 : &apsw_io_methods_v3_noshm;
+
+  if ((inflags & SQLITE_OPEN_MAIN_DB) && zName)
+  {
+    sqlite3_int64 nblocks = sqlite3_uri_int64(zName, "apsw_cache", 0),
+                  block_size = sqlite3_uri_int64(zName, "apsw_cache_block", 4096),
+                  readahead = sqlite3_uri_int64(zName, "apsw_readahead", 64);
+    if (nblocks > 0)
+    {
+      if (block_size < 512 || block_size > 65536 || (block_size & (block_size - 1)) || nblocks > 0x7fffffff / block_size || readahead < 0)
+      {
+        PyErr_Format(PyExc_ValueError, "apsw_cache_block must be a power of two between 512 and 65536, apsw_readahead must not be negative, "
+                                       "and the cache must be less than 2GB.  Got apsw_cache=%lld apsw_cache_block=%lld apsw_readahead=%lld",
+                     nblocks, block_size, readahead);
+        goto finally;
+      }
+      apswfile->cache = vfscache_new((unsigned)block_size, (unsigned)nblocks, readahead > 0x7fffffff ? 0x7fffffff : (unsigned)readahead);
+      if (!apswfile->cache)
+        goto finally;
+    }
+  }
+
   apswfile->file = Py_NewRef(pyresult);
   result = SQLITE_OK;
 
 finally:
   assert(PyErr_Occurred() ? (result != SQLITE_OK) : 1);
+  /* SQLite calls xClose if pMethods is set even on failure */
+  if (result != SQLITE_OK)
+    apswfile->pMethods = NULL;
   Py_XDECREF(pyresult);
   Py_XDECREF(flags);
   Py_XDECREF(nameobject);
@@ -2144,58 +2267,522 @@ finally:
   return res;
 }
 
+/* Reads from Python via xReadInto or xRead, setting nread to how
+   many bytes were provided which can be less than amount for a short
+   read.  Returns SQLITE_OK or an error code with a Python exception
+   set.  The GIL is held by caller */
 static int
-apswvfsfile_xRead(sqlite3_file *file, void *bufout, int amount, sqlite3_int64 offset)
+apswvfsfile_read_python(APSWSQLite3File *apswfile, void *bufout, int amount, sqlite3_int64 offset, int *nread)
 {
   int result = SQLITE_ERROR;
-  PyObject *pybuf = NULL;
+  PyObject *view = NULL, *pyresult = NULL;
   int asrb = -1;
   Py_buffer py3buffer;
+  long long count = -1;
 
-  FILEPREAMBLE;
+  if (apswfile->read_into)
+  {
+    view = PyMemoryView_FromMemory(bufout, amount, PyBUF_WRITE);
+    if (!view)
+      goto finally;
+
+    PyObject *vargs[] = {NULL, apswfile->file, view, PyLong_FromLongLong(offset)};
+    if (vargs[3])
+      pyresult = PyObject_VectorcallMethod(apst.xReadInto, vargs + 1, 3 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    Py_XDECREF(vargs[3]);
+
+    if (0 != memoryview_release(view))
+      goto finally;
+
+    if (!pyresult)
+      goto finally;
+
+    if (PyLong_Check(pyresult))
+      count = PyLong_AsLongLong(pyresult);
+    if (PyErr_Occurred())
+      goto finally;
+    if (count < 0 || count > amount)
+    {
+      PyErr_Format(PyExc_ValueError, "xReadInto should return the number of bytes read between 0 and %d, not %R", amount, pyresult);
+      goto finally;
+    }
+    *nread = (int)count;
+    result = SQLITE_OK;
+    goto finally;
+  }
 
   PyObject *vargs[] = {NULL, apswfile->file, PyLong_FromLong(amount), PyLong_FromLongLong(offset)};
   if (vargs[2] && vargs[3])
-    pybuf = PyObject_VectorcallMethod(apst.xRead, vargs + 1, 3 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    pyresult = PyObject_VectorcallMethod(apst.xRead, vargs + 1, 3 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
   Py_XDECREF(vargs[2]);
   Py_XDECREF(vargs[3]);
-  if (!pybuf)
-  {
-    assert(PyErr_Occurred());
-    result = MakeSqliteMsgFromPyException(NULL);
+  if (!pyresult)
     goto finally;
-  }
-  if (!PyObject_CheckBuffer(pybuf))
+
+  if (!PyObject_CheckBuffer(pyresult))
   {
     PyErr_Format(PyExc_TypeError, "Object returned from xRead should be buffer (bytes etc)");
     goto finally;
   }
 
-  asrb = PyObject_GetBufferContiguous(pybuf, &py3buffer, PyBUF_SIMPLE);
+  asrb = PyObject_GetBufferContiguous(pyresult, &py3buffer, PyBUF_SIMPLE);
   if (asrb != 0)
-  {
-    assert(PyErr_Occurred());
     goto finally;
+
+  *nread = (py3buffer.len < amount) ? (int)py3buffer.len : amount;
+  memcpy(bufout, py3buffer.buf, *nread);
+  result = SQLITE_OK;
+
+finally:
+  if (PyErr_Occurred())
+  {
+    result = MakeSqliteMsgFromPyException(NULL);
+    AddTraceBackHere(__FILE__, __LINE__, apswfile->read_into ? "apswvfsfile_xReadInto" : "apswvfsfile_xRead", "{s: i, s: L, s: O}",
+                     "amount", amount, "offset", offset, "result", OBJ(pyresult));
   }
+  if (asrb == 0)
+    PyBuffer_Release(&py3buffer);
+  Py_XDECREF(view);
+  Py_XDECREF(pyresult);
+  return result;
+}
+
+/* Block cache with read-ahead.
+
+   Python VFS files can be slow to read from, especially when each
+   read is a network round trip.  When the main database is opened
+   with the apsw_cache URI parameter giving a number of blocks, reads
+   are served from a cache of file contents in fixed size blocks.
+   Missing blocks are fetched in as few Python calls as possible, and
+   when reads are sequential the fetch is extended by a read-ahead
+   window that doubles with each sequential read.
+
+   Blocks are found via buckets by block number (each bucket being a
+   chain of slots) and evicted least recently used first.  Each slot
+   records how many bytes are valid so short reads at the end of the
+   file behave the same as uncached.
+
+   SQLite expects the file could have been changed by another
+   connection whenever it starts a read transaction, so the cache is
+   cleared then.  That is a shared lock in rollback journal mode, and a
+   shared wal-index lock in wal mode.  Immutable databases are not
+   locked so the cache is kept.  Writes and truncation through this
+   file invalidate the affected blocks.  Read-ahead is limited to the
+   file size, found once per transaction.
+*/
+
+struct APSWVFSFileCache
+{
+  unsigned block_size;        /* size of each block (a power of two) */
+  unsigned nblocks;           /* how many blocks can be cached */
+  unsigned readahead_max;     /* limit on the read-ahead window in blocks */
+  unsigned readahead;         /* current read-ahead window in blocks */
+  sqlite3_int64 next_block;   /* block a sequential read would start at */
+  sqlite3_int64 first_short;  /* lowest block cached with fewer than block_size bytes */
+  sqlite3_int64 file_size;    /* size when read-ahead was last needed or -1 if not known */
+  sqlite3_int64 *keys;        /* block number in each slot */
+  unsigned *lengths;          /* valid bytes in each slot */
+  unsigned *buckets;          /* first slot for each bucket */
+  unsigned *chain;            /* next slot in the same bucket */
+  unsigned bucket_mask;       /* number of buckets (a power of two) minus one */
+  unsigned *lru_prev;         /* towards more recently used */
+  unsigned *lru_next;         /* towards less recently used */
+  unsigned lru_head;          /* most recently used slot */
+  unsigned lru_tail;          /* least recently used slot */
+  unsigned *free_slots;       /* stack of unoccupied slots */
+  unsigned free_count;        /* how many are in free_slots */
+  unsigned char *data;        /* nblocks * block_size bytes */
+};
+
+/* end of a chain or list */
+#define VFSCACHE_NO_SLOT (~0u)
+
+static void
+vfscache_clear(APSWVFSFileCache *c)
+{
+  unsigned i;
+  for (i = 0; i <= c->bucket_mask; i++)
+    c->buckets[i] = VFSCACHE_NO_SLOT;
+  for (i = 0; i < c->nblocks; i++)
+    c->free_slots[i] = c->nblocks - 1 - i;
+  c->free_count = c->nblocks;
+  c->lru_head = c->lru_tail = VFSCACHE_NO_SLOT;
+  c->first_short = LLONG_MAX;
+  c->file_size = -1;
+  c->next_block = -1;
+  c->readahead = 0;
+}
 
-  if (py3buffer.len < amount)
+static void
+vfscache_free(APSWVFSFileCache *c)
+{
+  if (!c)
+    return;
+  PyMem_Free(c->keys);
+  PyMem_Free(c->lengths);
+  PyMem_Free(c->buckets);
+  PyMem_Free(c->chain);
+  PyMem_Free(c->lru_prev);
+  PyMem_Free(c->lru_next);
+  PyMem_Free(c->free_slots);
+  PyMem_Free(c->data);
+  PyMem_Free(c);
+}
+
+/* Returns NULL with an exception set on failure */
+static APSWVFSFileCache *
+vfscache_new(unsigned block_size, unsigned nblocks, unsigned readahead_max)
+{
+  APSWVFSFileCache *c = PyMem_Calloc(1, sizeof(APSWVFSFileCache));
+  if (!c)
+    return (APSWVFSFileCache *)PyErr_NoMemory();
+
+  c->block_size = block_size;
+  c->nblocks = nblocks;
+  c->readahead_max = (readahead_max < nblocks) ? readahead_max : nblocks - 1;
+  c->bucket_mask = 1;
+  while (c->bucket_mask < nblocks)
+    c->bucket_mask *= 2;
+  c->bucket_mask -= 1;
+
+  c->keys = PyMem_Calloc(nblocks, sizeof(sqlite3_int64));
+  c->lengths = PyMem_Calloc(nblocks, sizeof(unsigned));
+  c->buckets = PyMem_Calloc(c->bucket_mask + 1, sizeof(unsigned));
+  c->chain = PyMem_Calloc(nblocks, sizeof(unsigned));
+  c->lru_prev = PyMem_Calloc(nblocks, sizeof(unsigned));
+  c->lru_next = PyMem_Calloc(nblocks, sizeof(unsigned));
+  c->free_slots = PyMem_Calloc(nblocks, sizeof(unsigned));
+  c->data = PyMem_Calloc(nblocks, block_size);
+  if (!c->keys || !c->lengths || !c->buckets || !c->chain || !c->lru_prev || !c->lru_next || !c->free_slots || !c->data)
   {
-    result = SQLITE_IOERR_SHORT_READ;
-    memset(bufout, 0, amount);
-    memcpy(bufout, py3buffer.buf, py3buffer.len);
+    vfscache_free(c);
+    return (APSWVFSFileCache *)PyErr_NoMemory();
+  }
+
+  vfscache_clear(c);
+  return c;
+}
+
+static unsigned
+vfscache_bucket(APSWVFSFileCache *c, sqlite3_int64 block)
+{
+  sqlite3_uint64 h = (sqlite3_uint64)block * 0x9E3779B97F4A7C15ull;
+  return (unsigned)(h >> 32) & c->bucket_mask;
+}
+
+static unsigned
+vfscache_find(APSWVFSFileCache *c, sqlite3_int64 block)
+{
+  unsigned slot = c->buckets[vfscache_bucket(c, block)];
+  while (slot != VFSCACHE_NO_SLOT && c->keys[slot] != block)
+    slot = c->chain[slot];
+  return slot;
+}
+
+static void
+vfscache_lru_unlink(APSWVFSFileCache *c, unsigned slot)
+{
+  if (c->lru_prev[slot] != VFSCACHE_NO_SLOT)
+    c->lru_next[c->lru_prev[slot]] = c->lru_next[slot];
+  else
+    c->lru_head = c->lru_next[slot];
+  if (c->lru_next[slot] != VFSCACHE_NO_SLOT)
+    c->lru_prev[c->lru_next[slot]] = c->lru_prev[slot];
+  else
+    c->lru_tail = c->lru_prev[slot];
+}
+
+static void
+vfscache_lru_push(APSWVFSFileCache *c, unsigned slot)
+{
+  c->lru_prev[slot] = VFSCACHE_NO_SLOT;
+  c->lru_next[slot] = c->lru_head;
+  if (c->lru_head != VFSCACHE_NO_SLOT)
+    c->lru_prev[c->lru_head] = slot;
+  c->lru_head = slot;
+  if (c->lru_tail == VFSCACHE_NO_SLOT)
+    c->lru_tail = slot;
+}
+
+static void
+vfscache_touch(APSWVFSFileCache *c, unsigned slot)
+{
+  if (c->lru_head == slot)
+    return;
+  vfscache_lru_unlink(c, slot);
+  vfscache_lru_push(c, slot);
+}
+
+static void
+vfscache_remove(APSWVFSFileCache *c, unsigned slot)
+{
+  unsigned *link = &c->buckets[vfscache_bucket(c, c->keys[slot])];
+  while (*link != slot)
+    link = &c->chain[*link];
+  *link = c->chain[slot];
+  vfscache_lru_unlink(c, slot);
+  c->free_slots[c->free_count++] = slot;
+}
+
+static void
+vfscache_insert(APSWVFSFileCache *c, sqlite3_int64 block, const unsigned char *data, unsigned length)
+{
+  unsigned slot = vfscache_find(c, block), bucket;
+
+  if (slot == VFSCACHE_NO_SLOT)
+  {
+    if (!c->free_count)
+      vfscache_remove(c, c->lru_tail);
+    slot = c->free_slots[--c->free_count];
+    c->keys[slot] = block;
+    bucket = vfscache_bucket(c, block);
+    c->chain[slot] = c->buckets[bucket];
+    c->buckets[bucket] = slot;
+    vfscache_lru_push(c, slot);
   }
   else
+    vfscache_touch(c, slot);
+
+  memcpy(c->data + (size_t)slot * c->block_size, data, length);
+  c->lengths[slot] = length;
+  if (length < c->block_size && block < c->first_short)
+    c->first_short = block;
+}
+
+/* Drops cached blocks overlapping a write.  Writing at or beyond a
+   short block could also extend it so everything is dropped then. */
+static void
+vfscache_invalidate(APSWVFSFileCache *c, sqlite3_int64 offset, sqlite3_int64 amount)
+{
+  sqlite3_int64 block, first = offset / c->block_size, last = (offset + amount - 1) / c->block_size;
+  unsigned slot;
+
+  if (c->file_size >= 0 && offset + amount > c->file_size)
+    c->file_size = offset + amount;
+
+  if (last >= c->first_short)
   {
-    memcpy(bufout, py3buffer.buf, amount);
-    result = SQLITE_OK;
+    vfscache_clear(c);
+    return;
+  }
+  for (block = first; block <= last; block++)
+  {
+    slot = vfscache_find(c, block);
+    if (slot != VFSCACHE_NO_SLOT)
+      vfscache_remove(c, slot);
   }
+}
 
-finally:
-  if (PyErr_Occurred())
-    AddTraceBackHere(__FILE__, __LINE__, "apswvfsfile_xRead", "{s: i, s: L, s: O}", "amount", amount, "offset", offset, "result", OBJ(pybuf));
-  if (asrb == 0)
+/* Fills missing blocks between first and last inclusive, using one
+   xReadBatch call if available, else a read per run of missing blocks */
+static int
+vfscache_fetch(APSWSQLite3File *apswfile, sqlite3_int64 first, sqlite3_int64 last)
+{
+  APSWVFSFileCache *c = apswfile->cache;
+  int result = SQLITE_OK, nread;
+  sqlite3_int64 block, start, offset;
+  PyObject *reads = NULL, *pyresult = NULL, *item = NULL;
+  Py_ssize_t i;
+  unsigned count, b, length;
+  unsigned char *fetch = NULL;
+  Py_buffer py3buffer;
+
+  if (apswfile->read_batch)
+  {
+    reads = PyList_New(0);
+    if (!reads)
+      goto finally;
+  }
+
+  for (block = first; block <= last; block++)
+  {
+    if (vfscache_find(c, block) != VFSCACHE_NO_SLOT)
+      continue;
+    for (start = block; block + 1 <= last && vfscache_find(c, block + 1) == VFSCACHE_NO_SLOT; block++)
+      ;
+    count = (unsigned)(block - start + 1);
+    offset = start * c->block_size;
+
+    if (reads)
+    {
+      item = Py_BuildValue("(IL)", count * c->block_size, offset);
+      if (!item || 0 != PyList_Append(reads, item))
+        goto finally;
+      Py_CLEAR(item);
+      continue;
+    }
+
+    fetch = PyMem_Malloc((size_t)count * c->block_size);
+    if (!fetch)
+    {
+      PyErr_NoMemory();
+      goto finally;
+    }
+    result = apswvfsfile_read_python(apswfile, fetch, (int)(count * c->block_size), offset, &nread);
+    if (result != SQLITE_OK)
+      goto finally;
+    for (b = 0; b < count; b++)
+    {
+      length = (nread > (int)(b * c->block_size)) ? (unsigned)(nread - b * c->block_size) : 0;
+      vfscache_insert(c, start + b, fetch + (size_t)b * c->block_size, length < c->block_size ? length : c->block_size);
+    }
+    PyMem_Free(fetch);
+    fetch = NULL;
+  }
+
+  if (!reads || PyList_GET_SIZE(reads) == 0)
+    goto finally;
+
+  PyObject *vargs[] = {NULL, apswfile->file, reads};
+  pyresult = PyObject_VectorcallMethod(apst.xReadBatch, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  if (!pyresult)
+    goto finally;
+
+  if (!PySequence_Check(pyresult) || PySequence_Size(pyresult) != PyList_GET_SIZE(reads))
+  {
+    if (!PyErr_Occurred())
+      PyErr_Format(PyExc_ValueError, "xReadBatch should return a sequence of %zd buffers", PyList_GET_SIZE(reads));
+    goto finally;
+  }
+
+  for (i = 0; i < PyList_GET_SIZE(reads); i++)
+  {
+    PyObject *read = PyList_GET_ITEM(reads, i);
+    count = (unsigned)(PyLong_AsUnsignedLong(PyTuple_GET_ITEM(read, 0)) / c->block_size);
+    start = PyLong_AsLongLong(PyTuple_GET_ITEM(read, 1)) / c->block_size;
+
+    item = PySequence_GetItem(pyresult, i);
+    if (!item || 0 != PyObject_GetBufferContiguous(item, &py3buffer, PyBUF_SIMPLE))
+      goto finally;
+    if (py3buffer.len > (Py_ssize_t)count * c->block_size)
+    {
+      PyBuffer_Release(&py3buffer);
+      PyErr_Format(PyExc_ValueError, "xReadBatch item %zd is longer than the %u bytes requested", i, count * c->block_size);
+      goto finally;
+    }
+    for (b = 0; b < count; b++)
+    {
+      length = (py3buffer.len > (Py_ssize_t)(b * c->block_size)) ? (unsigned)(py3buffer.len - b * c->block_size) : 0;
+      vfscache_insert(c, start + b, (unsigned char *)py3buffer.buf + (size_t)b * c->block_size,
+                      length < c->block_size ? length : c->block_size);
+    }
     PyBuffer_Release(&py3buffer);
-  Py_XDECREF(pybuf);
+    Py_CLEAR(item);
+  }
+
+finally:
+  if (PyErr_Occurred() && result == SQLITE_OK)
+  {
+    result = MakeSqliteMsgFromPyException(NULL);
+    AddTraceBackHere(__FILE__, __LINE__, "apswvfsfile_xReadBatch", "{s: L, s: L, s: O, s: O}", "first_block", first,
+                     "last_block", last, "reads", OBJ(reads), "result", OBJ(pyresult));
+  }
+  PyMem_Free(fetch);
+  Py_XDECREF(item);
+  Py_XDECREF(reads);
+  Py_XDECREF(pyresult);
+  return result;
+}
+
+static int
+vfscache_read(APSWSQLite3File *apswfile, unsigned char *bufout, int amount, sqlite3_int64 offset, int *nread)
+{
+  APSWVFSFileCache *c = apswfile->cache;
+  sqlite3_int64 block, first = offset / c->block_size, last = (offset + amount - 1) / c->block_size, end;
+  unsigned slot, start, avail, want;
+  int missing = 0, result;
+
+  /* too big to cache */
+  if (last - first + 1 > c->nblocks)
+    return apswvfsfile_read_python(apswfile, bufout, amount, offset, nread);
+
+  if (first == c->next_block)
+    c->readahead = c->readahead ? c->readahead * 2 : 1;
+  else
+    c->readahead = 0;
+  if (c->readahead > c->readahead_max)
+    c->readahead = c->readahead_max;
+  c->next_block = last + 1;
+
+  end = last + c->readahead;
+  if (end - first + 1 > c->nblocks)
+    end = first + c->nblocks - 1;
+
+  /* SQLite never reads beyond the end of the file, but read-ahead
+     would, which some VFS (eg using mmap) do not tolerate */
+  if (end > last)
+  {
+    if (c->file_size < 0)
+    {
+      result = apswfile->pMethods->xFileSize((sqlite3_file *)apswfile, &c->file_size);
+      if (result != SQLITE_OK)
+      {
+        c->file_size = -1;
+        return result;
+      }
+    }
+    if (end > (c->file_size - 1) / c->block_size)
+      end = (c->file_size - 1) / c->block_size;
+    if (end < last)
+      end = last;
+  }
+
+  /* make what we already have most recently used so fetching doesn't
+     evict it */
+  for (block = end; block >= first; block--)
+  {
+    slot = vfscache_find(c, block);
+    if (slot != VFSCACHE_NO_SLOT)
+      vfscache_touch(c, slot);
+    else if (block <= last)
+      missing = 1;
+  }
+
+  if (missing)
+  {
+    result = vfscache_fetch(apswfile, first, end);
+    if (result != SQLITE_OK)
+      return result;
+  }
+
+  *nread = 0;
+  for (block = first; block <= last; block++)
+  {
+    slot = vfscache_find(c, block);
+    assert(slot != VFSCACHE_NO_SLOT);
+    start = (block == first) ? (unsigned)(offset % c->block_size) : 0;
+    want = c->block_size - start;
+    if (want > (unsigned)(amount - *nread))
+      want = (unsigned)(amount - *nread);
+    avail = (c->lengths[slot] > start) ? c->lengths[slot] - start : 0;
+    if (avail > want)
+      avail = want;
+    memcpy(bufout + *nread, c->data + (size_t)slot * c->block_size + start, avail);
+    *nread += (int)avail;
+    if (avail < want)
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int
+apswvfsfile_xRead(sqlite3_file *file, void *bufout, int amount, sqlite3_int64 offset)
+{
+  int result, nread = 0;
+
+  FILEPREAMBLE;
+
+  if (apswfile->cache)
+    result = vfscache_read(apswfile, bufout, amount, offset, &nread);
+  else
+    result = apswvfsfile_read_python(apswfile, bufout, amount, offset, &nread);
+
+  if (result == SQLITE_OK && nread < amount)
+  {
+    memset((char *)bufout + nread, 0, amount - nread);
+    result = SQLITE_IOERR_SHORT_READ;
+  }
+
   FILEPOSTAMBLE;
   return result;
 }
@@ -2259,6 +2846,224 @@ apswvfsfilepy_xRead(APSWVFSFile *self, PyObject *const *fast_args, Py_ssize_t fa
   return NULL;
 }
 
+/** .. method:: xReadInto(buffer: memoryview, offset: int) -> int
+
+    Optional alternative to :meth:`xRead` that reads directly into
+    SQLite's *buffer*, avoiding allocating and copying a bytes for
+    every read.  The *buffer* length is the amount to read.  It is
+    used instead of :meth:`xRead` when present on the file returned
+    from :meth:`VFS.xOpen`, unless it is this inherited
+    implementation while :meth:`xRead` has been overridden.
+
+    The *buffer* is only valid during the call, and is released
+    afterwards.  An error is reported if you still have exports
+    (eg a numpy array) from it.
+
+    When your class provides its own xReadInto, it is considered
+    buffer aware and :meth:`xWrite` will also be called with a
+    read only :class:`memoryview` instead of bytes, with the
+    same lifetime.
+
+    :param buffer: Writable memory to fill
+    :param offset: Where to start reading.
+    :returns: Number of bytes read which will be less than the buffer length
+      for a short read
+*/
+static PyObject *
+apswvfsfilepy_xReadInto(APSWVFSFile *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *buffer = NULL;
+  sqlite3_int64 offset;
+  Py_buffer py3buffer;
+  int res, amount;
+
+  CHECKVFSFILEPY;
+  VFSFILENOTIMPLEMENTED(xRead, 1);
+
+  {
+    VFSFile_xReadInto_CHECK;
+    ARG_PROLOG(2, VFSFile_xReadInto_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(buffer);
+    ARG_MANDATORY ARG_int64(offset);
+    ARG_EPILOG(NULL, VFSFile_xReadInto_USAGE, );
+  }
+
+  if (0 != PyObject_GetBufferContiguous(buffer, &py3buffer, PyBUF_WRITABLE | PyBUF_SIMPLE))
+    return NULL;
+
+  if (py3buffer.len > INT_MAX)
+  {
+    PyBuffer_Release(&py3buffer);
+    return PyErr_Format(PyExc_ValueError, "buffer is too large");
+  }
+  amount = (int)py3buffer.len;
+
+  res = self->base->pMethods->xRead(self->base, py3buffer.buf, amount, offset);
+
+  if (res == SQLITE_IOERR_SHORT_READ)
+  {
+    /* We don't know how short the read was, so look for first
+         non-trailing null byte.  */
+    while (amount && ((char *)py3buffer.buf)[amount - 1] == 0)
+      amount--;
+    res = SQLITE_OK;
+  }
+
+  PyBuffer_Release(&py3buffer);
+
+  if (res == SQLITE_OK)
+    return PyLong_FromLong(amount);
+
+  SET_EXC(res, NULL);
+  return NULL;
+}
+
+/** .. method:: xReadBatch(reads: list[tuple[int, int]]) -> list[bytes]
+
+    Does multiple reads in one call, with each item of *reads* being
+    ``(amount, offset)`` as for :meth:`xRead`.  You should return a
+    sequence of buffers (bytes etc) with one per read, each being
+    shorter than *amount* only at the end of the file.
+
+    This is used to fill the block cache for main database files
+    opened with the following `URI parameters <https://sqlite.org/uri.html>`__.
+    It is a good place to issue concurrent or combined requests, such
+    as a single multi-range HTTP request.  If xReadBatch isn't
+    available then :meth:`xReadInto` or :meth:`xRead` are called once
+    per read instead.
+
+    .. list-table::
+      :header-rows: 1
+      :widths: auto
+
+      * - Parameter
+        - Default
+        - Description
+      * - ``apsw_cache``
+        - ``0``
+        - How many blocks to cache.  Zero disables the cache.
+      * - ``apsw_cache_block``
+        - ``4096``
+        - Size of each block, which must be a power of two between
+          512 and 65536.  Using your database page size is best.
+      * - ``apsw_readahead``
+        - ``64``
+        - Maximum number of blocks to read ahead.  The read-ahead
+          starts at one block on the first sequential read, and doubles
+          on each sequential read after.
+
+    The cache is cleared at the start of each read transaction,
+    because another connection could have changed the file.  It is
+    kept across transactions with ``immutable=1`` because there is no
+    locking, and with ``pragma locking_mode=EXCLUSIVE``.  Writes
+    through the file discard the affected blocks.  :meth:`xFileSize` is
+    called once per transaction so read-ahead stops at the end of the
+    file.
+*/
+static PyObject *
+apswvfsfilepy_xReadBatch(APSWVFSFile *self, PyObject *const *fast_args, Py_ssize_t fast_nargs, PyObject *fast_kwnames)
+{
+  PyObject *reads = NULL, *result = NULL, *item;
+  Py_ssize_t i;
+  int amount, res;
+  sqlite3_int64 offset;
+
+  CHECKVFSFILEPY;
+  VFSFILENOTIMPLEMENTED(xRead, 1);
+
+  {
+    VFSFile_xReadBatch_CHECK;
+    ARG_PROLOG(1, VFSFile_xReadBatch_KWNAMES);
+    ARG_MANDATORY ARG_pyobject(reads);
+    ARG_EPILOG(NULL, VFSFile_xReadBatch_USAGE, );
+  }
+
+  reads = PySequence_Fast(reads, "Expected a sequence of (amount, offset) tuples");
+  if (!reads)
+    return NULL;
+
+  result = PyList_New(PySequence_Fast_GET_SIZE(reads));
+  if (!result)
+    goto error;
+
+  for (i = 0; i < PySequence_Fast_GET_SIZE(reads); i++)
+  {
+    item = PySequence_Fast_GET_ITEM(reads, i);
+    if (!PyTuple_Check(item))
+    {
+      PyErr_Format(PyExc_TypeError, "Expected (amount, offset) tuple not %s", Py_TypeName(item));
+      goto error;
+    }
+    if (!PyArg_ParseTuple(item, "iL", &amount, &offset))
+      goto error;
+    if (amount < 0)
+    {
+      PyErr_Format(PyExc_ValueError, "amount can't be negative");
+      goto error;
+    }
+
+    item = PyBytes_FromStringAndSize(NULL, amount);
+    if (!item)
+      goto error;
+
+    res = self->base->pMethods->xRead(self->base, PyBytes_AS_STRING(item), amount, offset);
+    if (res == SQLITE_IOERR_SHORT_READ)
+    {
+      /* We don't know how short the read was, so look for first
+         non-trailing null byte.  */
+      while (amount && PyBytes_AS_STRING(item)[amount - 1] == 0)
+        amount--;
+      if (_PyBytes_Resize(&item, amount))
+        goto error;
+    }
+    else if (res != SQLITE_OK)
+    {
+      Py_DECREF(item);
+      SET_EXC(res, NULL);
+      goto error;
+    }
+    PyList_SET_ITEM(result, i, item);
+  }
+
+  Py_DECREF(reads);
+  return result;
+
+error:
+  Py_DECREF(reads);
+  Py_XDECREF(result);
+  return NULL;
+}
+
+/** .. method:: xMmap() -> Optional[mmap.mmap | bytes | bytearray | memoryview]
+
+    Override this to let SQLite access the file contents directly in
+    memory, when `memory mapped I/O <https://sqlite.org/mmap.html>`__
+    is enabled with a non-zero `mmap_size
+    <https://sqlite.org/pragma.html#pragma_mmap_size>`__.  Return an
+    object supporting the buffer protocol, such as :class:`mmap.mmap`,
+    covering the file contents from the start, or None to use
+    :meth:`xRead`.  This implementation returns None.
+
+    SQLite then reads pages by using pointers into the buffer instead
+    of calling :meth:`xRead`, except for pages beyond the end of the
+    buffer or the mmap_size.  The buffer is held (so an
+    :class:`mmap.mmap` can't be closed or resized) until SQLite no
+    longer needs it, such as when the file is truncated or closed.
+    If the file grows, xMmap is called again at the start of a
+    later transaction.
+
+    The buffer contents must always be the same as the file.  Writes
+    are still made via :meth:`xWrite`, so you should use a shared
+    mapping of the file so those writes are visible in it.
+*/
+static PyObject *
+apswvfsfilepy_xMmap(APSWVFSFile *self)
+{
+  CHECKVFSFILEPY;
+
+  Py_RETURN_NONE;
+}
+
 static int
 apswvfsfile_xWrite(sqlite3_file *file, const void *buffer, int amount, sqlite3_int64 offset)
 {
@@ -2266,16 +3071,23 @@ apswvfsfile_xWrite(sqlite3_file *file, const void *buffer, int amount, sqlite3_i
   int result = SQLITE_OK;
   FILEPREAMBLE;
 
-  /* Performance opportunity: We currently duplicate the buffer passed
-     by SQLite which involvces a memory copy.  A memoryview could be used
-     instead but the underlying buffer passed by SQLite goes out of scope
-     after this function returns.  Sp we'd have to detect the callee
-     hanging on to the memoryview. */
-  PyObject *vargs[] = {NULL, apswfile->file, PyBytes_FromStringAndSize(buffer, amount), PyLong_FromLongLong(offset)};
+  /* The buffer passed by SQLite goes out of scope after this function
+     returns, so a memoryview is only used for buffer aware files and
+     is released afterwards to detect the callee hanging on to it.
+     Otherwise the data is duplicated into bytes. */
+  if (apswfile->cache)
+    vfscache_invalidate(apswfile->cache, offset, amount);
+
+  if (apswfile->write_view)
+    pybuf = PyMemoryView_FromMemory((char *)buffer, amount, PyBUF_READ);
+  else
+    pybuf = PyBytes_FromStringAndSize(buffer, amount);
+  PyObject *vargs[] = {NULL, apswfile->file, pybuf, PyLong_FromLongLong(offset)};
   if (vargs[2] && vargs[3])
     pyresult = PyObject_VectorcallMethod(apst.xWrite, vargs + 1, 3 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
-  Py_XDECREF(vargs[2]);
   Py_XDECREF(vargs[3]);
+  if (pybuf && apswfile->write_view && 0 != memoryview_release(pybuf))
+    Py_CLEAR(pyresult);
 
   if (!pyresult)
   {
@@ -2283,6 +3095,7 @@ apswvfsfile_xWrite(sqlite3_file *file, const void *buffer, int amount, sqlite3_i
     result = MakeSqliteMsgFromPyException(NULL);
     AddTraceBackHere(__FILE__, __LINE__, "apswvfsfile_xWrite", "{s: i, s: L, s: O}", "amount", amount, "offset", offset, "data", OBJ(pybuf));
   }
+  Py_XDECREF(pybuf);
   Py_XDECREF(pyresult);
   FILEPOSTAMBLE;
   return result;
@@ -2296,6 +3109,9 @@ apswvfsfile_xWrite(sqlite3_file *file, const void *buffer, int amount, sqlite3_i
   underlying operating system to do a partial write. You will need to
   write the remaining data.
 
+  *data* is a :class:`memoryview` only valid during the call when
+  the file is buffer aware as described in :meth:`xReadInto`.
+
   :param offset: Where to start writing.
 */
 
@@ -2397,6 +3213,13 @@ apswvfsfile_xLock(sqlite3_file *file, int flag)
   PyObject *pyresult = NULL;
   FILEPREAMBLE;
 
+  /* starting a read transaction */
+  if (apswfile->cache && flag == SQLITE_LOCK_SHARED)
+    vfscache_clear(apswfile->cache);
+  /* let xMmap provide a bigger mapping or one if it didn't before */
+  if (flag == SQLITE_LOCK_SHARED && !apswfile->nfetched && (apswfile->map_short || (apswfile->map_tried && !apswfile->mapped)))
+    apswvfsfile_unmap(apswfile);
+
   PyObject *vargs[] = {NULL, apswfile->file, PyLong_FromLong(flag)};
   if (vargs[2])
     pyresult = PyObject_VectorcallMethod(apst.xLock, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
@@ -2455,6 +3278,10 @@ apswvfsfile_xTruncate(sqlite3_file *file, sqlite3_int64 size)
   int result = SQLITE_ERROR;
   PyObject *pyresult = NULL;
   FILEPREAMBLE;
+  if (apswfile->cache)
+    vfscache_clear(apswfile->cache);
+  if (!apswfile->nfetched)
+    apswvfsfile_unmap(apswfile);
   PyObject *vargs[] = {NULL, apswfile->file, PyLong_FromLongLong(size)};
   if (vargs[2])
     pyresult = PyObject_VectorcallMethod(apst.xTruncate, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
@@ -2838,6 +3665,18 @@ apswvfsfile_xFileControl(sqlite3_file *file, int op, void *pArg)
     goto end;
   }
 
+  /* We provide xFetch so the limit is tracked here (as unix and windows
+     vfs do), changing only when there are no outstanding fetches */
+  if (op == SQLITE_FCNTL_MMAP_SIZE && apswfile->has_mmap)
+  {
+    sqlite3_int64 limit = *(sqlite3_int64 *)pArg;
+    if (limit >= 0 && !apswfile->nfetched)
+      apswfile->mmap_limit = limit;
+    *(sqlite3_int64 *)pArg = apswfile->mmap_limit;
+    result = SQLITE_OK;
+    goto end;
+  }
+
   PyObject *vargs[] = {NULL, apswfile->file, PyLong_FromLong(op), PyLong_FromVoidPtr(pArg)};
   if (vargs[2] && vargs[3])
     pyresult = PyObject_VectorcallMethod(apst.xFileControl, vargs + 1, 3 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
@@ -2933,6 +3772,13 @@ apswvfsfile_xClose(sqlite3_file *file)
   PyObject *pyresult = NULL;
   FILEPREAMBLE;
 
+  /* release what we hold of the file's memory first, so it can close
+     its own mappings */
+  apswfile->nfetched = 0;
+  apswvfsfile_unmap(apswfile);
+  vfscache_free(apswfile->cache);
+  apswfile->cache = NULL;
+
   PyObject *vargs[] = {NULL, apswfile->file};
   pyresult = PyObject_VectorcallMethod(apst.xClose, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
 
@@ -2998,6 +3844,9 @@ static int
 apswproxyxShmLock(sqlite3_file *file, int offset, int n, int flags)
 {
   APSWPROXYBASE;
+  /* starting a wal read transaction */
+  if (apswfile->cache && (flags & SQLITE_SHM_LOCK) && (flags & SQLITE_SHM_SHARED))
+    vfscache_clear(apswfile->cache);
   return f->base->pMethods->xShmLock(f->base, offset, n, flags);
 }
 
@@ -3022,6 +3871,78 @@ apswproxyxShmUnmap(sqlite3_file *file, int deleteFlag)
   return f->base->pMethods->xShmUnmap(f->base, deleteFlag);
 }
 
+/* asks Python for the mapping */
+static int
+apswvfsfile_map(sqlite3_file *file)
+{
+  int result = SQLITE_OK;
+  PyObject *pyresult = NULL;
+  FILEPREAMBLE;
+
+  apswfile->map_tried = 1;
+
+  PyObject *vargs[] = {NULL, apswfile->file};
+  pyresult = PyObject_VectorcallMethod(apst.xMmap, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  if (pyresult && !Py_IsNone(pyresult) && 0 == PyObject_GetBufferContiguous(pyresult, &apswfile->mapping, PyBUF_SIMPLE))
+    apswfile->mapped = 1;
+
+  if (PyErr_Occurred())
+  {
+    result = MakeSqliteMsgFromPyException(NULL);
+    AddTraceBackHere(__FILE__, __LINE__, "apswvfsfile.xMmap", "{s: O}", "result", OBJ(pyresult));
+  }
+  Py_XDECREF(pyresult);
+  FILEPOSTAMBLE;
+  return result;
+}
+
+/* Once there is a mapping, fetches are answered without the GIL */
+static int
+apswvfsfile_xFetch(sqlite3_file *file, sqlite3_int64 offset, int amount, void **pp)
+{
+  APSWSQLite3File *apswfile = (APSWSQLite3File *)(void *)file;
+  int result = SQLITE_OK;
+
+  *pp = NULL;
+  if (offset + amount > apswfile->mmap_limit)
+    return SQLITE_OK;
+
+  if (!apswfile->mapped && !apswfile->map_tried)
+    result = apswvfsfile_map(file);
+
+  if (apswfile->mapped)
+  {
+    if (offset + amount <= apswfile->mapping.len)
+    {
+      *pp = (char *)apswfile->mapping.buf + offset;
+      apswfile->nfetched++;
+    }
+    else
+      apswfile->map_short = 1;
+  }
+  return result;
+}
+
+static int
+apswvfsfile_xUnfetch(sqlite3_file *file, sqlite3_int64 Py_UNUSED(offset), void *p)
+{
+  APSWSQLite3File *apswfile = (APSWSQLite3File *)(void *)file;
+
+  if (p)
+  {
+    assert(apswfile->nfetched > 0);
+    apswfile->nfetched--;
+  }
+  else if (apswfile->map_tried)
+  {
+    /* SQLite wants everything unmapped */
+    PyGILState_STATE gilstate = PyGILState_Ensure();
+    apswvfsfile_unmap(apswfile);
+    PyGILState_Release(gilstate);
+  }
+  return SQLITE_OK;
+}
+
 static const struct sqlite3_io_methods apsw_io_methods_v1 =
     {
         1,                                  /* version */
@@ -3064,8 +3985,57 @@ static const struct sqlite3_io_methods apsw_io_methods_v2 =
         apswproxyxShmUnmap                  /* shmunmap */
 };
 
+static const struct sqlite3_io_methods apsw_io_methods_v3 =
+    {
+        3,                                  /* version */
+        apswvfsfile_xClose,                 /* close */
+        apswvfsfile_xRead,                  /* read */
+        apswvfsfile_xWrite,                 /* write */
+        apswvfsfile_xTruncate,              /* truncate */
+        apswvfsfile_xSync,                  /* sync */
+        apswvfsfile_xFileSize,              /* filesize */
+        apswvfsfile_xLock,                  /* lock */
+        apswvfsfile_xUnlock,                /* unlock */
+        apswvfsfile_xCheckReservedLock,     /* checkreservedlock */
+        apswvfsfile_xFileControl,           /* filecontrol */
+        apswvfsfile_xSectorSize,            /* sectorsize */
+        apswvfsfile_xDeviceCharacteristics, /* device characteristics */
+        apswproxyxShmMap,                   /* shmmap */
+        apswproxyxShmLock,                  /* shmlock */
+        apswproxyxShmBarrier,               /* shmbarrier */
+        apswproxyxShmUnmap,                 /* shmunmap */
+        apswvfsfile_xFetch,                 /* fetch */
+        apswvfsfile_xUnfetch                /* unfetch */
+};
+
+static const struct sqlite3_io_methods apsw_io_methods_v3_noshm =
+    {
+        3,                                  /* version */
+        apswvfsfile_xClose,                 /* close */
+        apswvfsfile_xRead,                  /* read */
+        apswvfsfile_xWrite,                 /* write */
+        apswvfsfile_xTruncate,              /* truncate */
+        apswvfsfile_xSync,                  /* sync */
+        apswvfsfile_xFileSize,              /* filesize */
+        apswvfsfile_xLock,                  /* lock */
+        apswvfsfile_xUnlock,                /* unlock */
+        apswvfsfile_xCheckReservedLock,     /* checkreservedlock */
+        apswvfsfile_xFileControl,           /* filecontrol */
+        apswvfsfile_xSectorSize,            /* sectorsize */
+        apswvfsfile_xDeviceCharacteristics, /* device characteristics */
+        0,                                  /* shmmap */
+        0,                                  /* shmlock */
+        0,                                  /* shmbarrier */
+        0,                                  /* shmunmap */
+        apswvfsfile_xFetch,                 /* fetch */
+        apswvfsfile_xUnfetch                /* unfetch */
+};
+
 static PyMethodDef APSWVFSFile_methods[] = {
     {"xRead", (PyCFunction)apswvfsfilepy_xRead, METH_FASTCALL | METH_KEYWORDS, VFSFile_xRead_DOC},
+    {"xReadBatch", (PyCFunction)apswvfsfilepy_xReadBatch, METH_FASTCALL | METH_KEYWORDS, VFSFile_xReadBatch_DOC},
+    {"xMmap", (PyCFunction)apswvfsfilepy_xMmap, METH_NOARGS, VFSFile_xMmap_DOC},
+    {"xReadInto", (PyCFunction)apswvfsfilepy_xReadInto, METH_FASTCALL | METH_KEYWORDS, VFSFile_xReadInto_DOC},
     {"xUnlock", (PyCFunction)apswvfsfilepy_xUnlock, METH_FASTCALL | METH_KEYWORDS, VFSFile_xUnlock_DOC},
     {"xLock", (PyCFunction)apswvfsfilepy_xLock, METH_FASTCALL | METH_KEYWORDS, VFSFile_xLock_DOC},
     {"xClose", (PyCFunction)apswvfsfilepy_xClose, METH_NOARGS, VFSFile_xClose_DOC},
@@ -63,6 +63,7 @@ typedef struct SqliteIndexInfo
 {
   PyObject_HEAD
       sqlite3_index_info *index_info;
+  int cacheable; /* cleared if results could depend on more than the query shape */
 } SqliteIndexInfo;
 
 #define CHECK_INDEX(ret)                                                                         \
@@ -203,6 +204,7 @@ SqliteIndexInfo_get_aConstraint_collation(SqliteIndexInfo *self, PyObject *const
   }
   CHECK_RANGE(nConstraint);
 
+  self->cacheable = 0;
   return convertutf8string(sqlite3_vtab_collation(self->index_info, which));
 }
 
@@ -228,6 +230,7 @@ SqliteIndexInfo_get_aConstraint_rhs(SqliteIndexInfo *self, PyObject *const *fast
   }
   CHECK_RANGE(nConstraint);
 
+  self->cacheable = 0;
   res = sqlite3_vtab_rhs_value(self->index_info, which, &pval);
   if (res == SQLITE_NOTFOUND)
     Py_RETURN_NONE;
@@ -436,6 +439,7 @@ SqliteIndexInfo_set_aConstraintUsage_in(SqliteIndexInfo *self, PyObject *const *
 
   if (sqlite3_vtab_in(self->index_info, which, -1))
   {
+    self->cacheable = 0;
     sqlite3_vtab_in(self->index_info, which, filter_all);
     Py_RETURN_NONE;
   }
@@ -707,6 +711,60 @@ SqliteIndexInfo_get_distinct(SqliteIndexInfo *self)
   return PyLong_FromLong(sqlite3_vtab_distinct(self->index_info));
 }
 
+/* which usable constraint has op, or -1 */
+static int
+index_info_find_constraint(sqlite3_index_info *index_info, unsigned char op)
+{
+  int i;
+
+  for (i = 0; i < index_info->nConstraint; i++)
+    if (index_info->aConstraint[i].op == op && index_info->aConstraint[i].usable)
+      return i;
+  return -1;
+}
+
+/** .. attribute:: limit_constraint
+  :type: int
+
+  (Read-only) Which constraint is the usable `LIMIT
+  <https://sqlite.org/lang_select.html#limitoffset>`__, or -1 if there
+  isn't one.  If you set its :meth:`argvIndex
+  <IndexInfo.set_aConstraintUsage_argvIndex>` then
+  :meth:`VTCursor.Filter` gets the limit value, and you only need to
+  provide that many rows (after any offset).
+
+  SQLite only provides LIMIT (and OFFSET) when your table is the only
+  one in the query, and there are no constraints you haven't consumed.
+
+  .. code-block:: python
+
+    if index_info.limit_constraint >= 0:
+        index_info.set_aConstraintUsage_argvIndex(index_info.limit_constraint, 1)
+*/
+static PyObject *
+SqliteIndexInfo_get_limit_constraint(SqliteIndexInfo *self)
+{
+  CHECK_INDEX(NULL);
+
+  return PyLong_FromLong(index_info_find_constraint(self->index_info, SQLITE_INDEX_CONSTRAINT_LIMIT));
+}
+
+/** .. attribute:: offset_constraint
+  :type: int
+
+  (Read-only) Which constraint is the usable OFFSET, or -1 if there
+  isn't one.  See :attr:`~IndexInfo.limit_constraint`.  If you use it
+  then also set its :meth:`omit <IndexInfo.set_aConstraintUsage_omit>`
+  so that SQLite doesn't skip the offset rows again.
+*/
+static PyObject *
+SqliteIndexInfo_get_offset_constraint(SqliteIndexInfo *self)
+{
+  CHECK_INDEX(NULL);
+
+  return PyLong_FromLong(index_info_find_constraint(self->index_info, SQLITE_INDEX_CONSTRAINT_OFFSET));
+}
+
 static PyGetSetDef SqliteIndexInfo_getsetters[] = {
     {"nConstraint", (getter)SqliteIndexInfo_get_nConstraint, NULL, IndexInfo_nConstraint_DOC},
     {"nOrderBy", (getter)SqliteIndexInfo_get_nOrderBy, NULL, IndexInfo_nOrderBy_DOC},
@@ -718,6 +776,8 @@ static PyGetSetDef SqliteIndexInfo_getsetters[] = {
     {"idxFlags", (getter)SqliteIndexInfo_get_idxFlags, (setter)SqliteIndexInfo_set_idxFlags, IndexInfo_idxFlags_DOC},
     {"colUsed", (getter)SqliteIndexInfo_get_colUsed, NULL, IndexInfo_colUsed_DOC},
     {"distinct", (getter)SqliteIndexInfo_get_distinct, NULL, IndexInfo_distinct_DOC},
+    {"limit_constraint", (getter)SqliteIndexInfo_get_limit_constraint, NULL, IndexInfo_limit_constraint_DOC},
+    {"offset_constraint", (getter)SqliteIndexInfo_get_offset_constraint, NULL, IndexInfo_offset_constraint_DOC},
     /* sentinel */
     {NULL, NULL, NULL, NULL}};
 
@@ -792,6 +852,26 @@ Any number of tables referring to the same module can be made this
 way.
 */
 
+/* A remembered xBestIndex result.  The key describes the inputs in
+   sqlite3_index_info.  Memory is from sqlite3_malloc so plans can be
+   used without the GIL. */
+typedef struct apsw_vtable_plan
+{
+  int *key;
+  int key_len;
+  int res; /* SQLITE_OK or SQLITE_CONSTRAINT */
+  struct sqlite3_index_constraint_usage *usage;
+  int idxNum;
+  char *idxStr;
+  int orderByConsumed;
+  double estimatedCost;
+  sqlite3_int64 estimatedRows;
+  int idxFlags;
+} apsw_vtable_plan;
+
+/* how many plans are remembered per table */
+#define VTABLE_PLAN_CACHE_SIZE 16
+
 typedef struct
 {
   sqlite3_vtab used_by_sqlite; /* I don't touch this */
@@ -799,9 +879,16 @@ typedef struct
   PyObject *functions;         /* functions returned by vtabFindFunction */
   int bestindex_object;        /* 0: tuples are passed to xBestIndex, 1: object is */
   int use_no_change;           /* 1: we understand no_change updating */
+  int cache_best_index;        /* 1: xBestIndex results are remembered */
+  apsw_vtable_plan *plans[VTABLE_PLAN_CACHE_SIZE];
+  unsigned next_plan;          /* which plan is replaced next */
+  char *filter_idxStr;         /* last idxStr passed to xFilter */
+  PyObject *filter_pyidxStr;   /* which as a Python str */
   Connection *connection;
 } apsw_vtable;
 
+static void apswvtab_plans_free(apsw_vtable *avi);
+
 static int
 apswvtabCreateOrConnect(sqlite3 *db,
                         void *pAux,
@@ -896,6 +983,7 @@ apswvtabCreateOrConnect(sqlite3 *db,
   assert((void *)avi == (void *)&(avi->used_by_sqlite)); /* detect if weird padding happens */
   avi->bestindex_object = vti->bestindex_object;
   avi->use_no_change = vti->use_no_change;
+  avi->cache_best_index = vti->cache_best_index;
   avi->connection = self;
 
   *pVTab = (sqlite3_vtab *)avi;
@@ -1084,6 +1172,9 @@ apswvtabDestroyOrDisconnect(sqlite3_vtab *pVtab, PyObject *methodname, const cha
   {
     Py_DECREF(vtable);
     Py_XDECREF(((apsw_vtable *)pVtab)->functions);
+    Py_XDECREF(((apsw_vtable *)pVtab)->filter_pyidxStr);
+    sqlite3_free(((apsw_vtable *)pVtab)->filter_idxStr);
+    apswvtab_plans_free((apsw_vtable *)pVtab);
     PyMem_Free(pVtab);
   }
 
@@ -1136,7 +1227,7 @@ apswvtabDisconnect(sqlite3_vtab *pVTab)
   SQLite.
 */
 static int
-apswvtabBestIndexObject(sqlite3_vtab *pVtab, sqlite3_index_info *in_index_info)
+apswvtabBestIndexObject(sqlite3_vtab *pVtab, sqlite3_index_info *in_index_info, int *cacheable)
 {
   PyGILState_STATE gilstate;
   PyObject *vtable;
@@ -1157,6 +1248,7 @@ apswvtabBestIndexObject(sqlite3_vtab *pVtab, sqlite3_index_info *in_index_info)
     goto finally;
 
   index_info->index_info = in_index_info;
+  index_info->cacheable = 1;
 
   PyObject *vargs[] = {NULL, vtable, (PyObject *)index_info};
 
@@ -1179,7 +1271,10 @@ finally:
                      "self", vtable, "index_info", OBJ((PyObject *)index_info), "res", OBJ(res));
   }
   if (index_info)
+  {
+    *cacheable = index_info->cacheable;
     index_info->index_info = NULL;
+  }
   Py_XDECREF((PyObject *)index_info);
   Py_XDECREF(res);
   PyGILState_Release(gilstate);
@@ -1369,7 +1464,7 @@ finally:
 */
 
 static int
-apswvtabBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *indexinfo)
+apswvtabBestIndexTuples(sqlite3_vtab *pVtab, sqlite3_index_info *indexinfo)
 {
   PyGILState_STATE gilstate;
   PyObject *vtable;
@@ -1379,9 +1474,6 @@ apswvtabBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *indexinfo)
   int nconstraints = 0;
   int sqliteres = SQLITE_OK;
 
-  if (((apsw_vtable *)pVtab)->bestindex_object)
-    return apswvtabBestIndexObject(pVtab, indexinfo);
-
   gilstate = PyGILState_Ensure();
 
   MakeExistingException();
@@ -1652,6 +1744,151 @@ finally:
   return sqliteres;
 }
 
+/* Makes the key describing the inputs, or NULL if out of memory.  The
+   collation and right hand side values aren't included, so a plan
+   where those were looked at isn't cacheable. */
+static int *
+apswvtab_plan_key(sqlite3_index_info *indexinfo, int *key_len)
+{
+  int *key, *k, i;
+
+  *key_len = 5 + 4 * indexinfo->nConstraint + 2 * indexinfo->nOrderBy;
+  key = k = sqlite3_malloc64(sizeof(int) * *key_len);
+  if (!key)
+    return NULL;
+
+  *k++ = indexinfo->nConstraint;
+  *k++ = indexinfo->nOrderBy;
+  *k++ = (int)(indexinfo->colUsed & 0xffffffff);
+  *k++ = (int)(indexinfo->colUsed >> 32);
+  *k++ = sqlite3_vtab_distinct(indexinfo);
+  for (i = 0; i < indexinfo->nConstraint; i++)
+  {
+    *k++ = indexinfo->aConstraint[i].iColumn;
+    *k++ = indexinfo->aConstraint[i].op;
+    *k++ = indexinfo->aConstraint[i].usable;
+    *k++ = sqlite3_vtab_in(indexinfo, i, -1);
+  }
+  for (i = 0; i < indexinfo->nOrderBy; i++)
+  {
+    *k++ = indexinfo->aOrderBy[i].iColumn;
+    *k++ = indexinfo->aOrderBy[i].desc;
+  }
+  assert(k - key == *key_len);
+  return key;
+}
+
+static void
+apswvtab_plan_free(apsw_vtable_plan *plan)
+{
+  if (plan)
+  {
+    sqlite3_free(plan->key);
+    sqlite3_free(plan->usage);
+    sqlite3_free(plan->idxStr);
+    sqlite3_free(plan);
+  }
+}
+
+static void
+apswvtab_plans_free(apsw_vtable *avi)
+{
+  int i;
+
+  for (i = 0; i < VTABLE_PLAN_CACHE_SIZE; i++)
+  {
+    apswvtab_plan_free(avi->plans[i]);
+    avi->plans[i] = NULL;
+  }
+}
+
+/* Remembers the outputs in indexinfo, taking ownership of key */
+static void
+apswvtab_plan_add(apsw_vtable *avi, int *key, int key_len, int res, sqlite3_index_info *indexinfo)
+{
+  apsw_vtable_plan *plan = sqlite3_malloc64(sizeof(apsw_vtable_plan));
+
+  if (!plan)
+  {
+    sqlite3_free(key);
+    return;
+  }
+  plan->key = key;
+  plan->key_len = key_len;
+  plan->res = res;
+  plan->usage = sqlite3_malloc64(sizeof(struct sqlite3_index_constraint_usage) * (indexinfo->nConstraint + 1));
+  plan->idxNum = indexinfo->idxNum;
+  plan->idxStr = indexinfo->idxStr ? sqlite3_mprintf("%s", indexinfo->idxStr) : NULL;
+  plan->orderByConsumed = indexinfo->orderByConsumed;
+  plan->estimatedCost = indexinfo->estimatedCost;
+  plan->estimatedRows = indexinfo->estimatedRows;
+  plan->idxFlags = indexinfo->idxFlags;
+  if (!plan->usage || (indexinfo->idxStr && !plan->idxStr))
+  {
+    apswvtab_plan_free(plan);
+    return;
+  }
+  memcpy(plan->usage, indexinfo->aConstraintUsage, sizeof(struct sqlite3_index_constraint_usage) * indexinfo->nConstraint);
+
+  apswvtab_plan_free(avi->plans[avi->next_plan]);
+  avi->plans[avi->next_plan] = plan;
+  avi->next_plan = (avi->next_plan + 1) % VTABLE_PLAN_CACHE_SIZE;
+}
+
+/* Copies a remembered plan's outputs into indexinfo, returning the
+   xBestIndex result */
+static int
+apswvtab_plan_apply(const apsw_vtable_plan *plan, sqlite3_index_info *indexinfo)
+{
+  if (plan->idxStr)
+  {
+    indexinfo->idxStr = sqlite3_mprintf("%s", plan->idxStr);
+    if (!indexinfo->idxStr)
+      return SQLITE_NOMEM;
+    indexinfo->needToFreeIdxStr = 1;
+  }
+  memcpy(indexinfo->aConstraintUsage, plan->usage, sizeof(struct sqlite3_index_constraint_usage) * indexinfo->nConstraint);
+  indexinfo->idxNum = plan->idxNum;
+  indexinfo->orderByConsumed = plan->orderByConsumed;
+  indexinfo->estimatedCost = plan->estimatedCost;
+  indexinfo->estimatedRows = plan->estimatedRows;
+  indexinfo->idxFlags = plan->idxFlags;
+  return plan->res;
+}
+
+static int
+apswvtabBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *indexinfo)
+{
+  apsw_vtable *avi = (apsw_vtable *)pVtab;
+  int *key = NULL, key_len = 0, cacheable = 1, res, i;
+
+  if (avi->cache_best_index)
+  {
+    key = apswvtab_plan_key(indexinfo, &key_len);
+    for (i = 0; key && i < VTABLE_PLAN_CACHE_SIZE; i++)
+    {
+      apsw_vtable_plan *plan = avi->plans[i];
+      if (plan && plan->key_len == key_len && 0 == memcmp(plan->key, key, sizeof(int) * key_len))
+      {
+        sqlite3_free(key);
+        return apswvtab_plan_apply(plan, indexinfo);
+      }
+    }
+  }
+
+  if (avi->bestindex_object)
+    res = apswvtabBestIndexObject(pVtab, indexinfo, &cacheable);
+  else
+    res = apswvtabBestIndexTuples(pVtab, indexinfo);
+
+  if (key && cacheable && (res == SQLITE_OK || res == SQLITE_CONSTRAINT))
+    apswvtab_plan_add(avi, key, key_len, res, indexinfo);
+  else
+    sqlite3_free(key);
+
+  return res;
+}
+
 /** .. method:: Begin() -> None
 
   This function is used as part of transactions.  You do not have to
@@ -1735,11 +1972,21 @@ apswvtabRollback(sqlite3_vtab *pVtab)
   Returns a :class:`cursor <VTCursor>` object.
 */
 
+/* values for apsw_vtable_cursor.batch */
+#define VTCURSOR_BATCH_NONE 0    /* Eof/Column/Next are called */
+#define VTCURSOR_BATCH_ROWS 1    /* NextRows is called */
+#define VTCURSOR_BATCH_COLUMNS 2 /* NextColumns is called */
+
 typedef struct
 {
   sqlite3_vtab_cursor used_by_sqlite; /* I don't touch this */
   PyObject *cursor;                   /* Object implementing cursor */
   int use_no_change;
+  int batch;              /* VTCURSOR_BATCH_ values */
+  PyObject *batch_data;   /* tuple of rows or columns from the last batch */
+  Py_ssize_t batch_size;  /* rows in the batch */
+  Py_ssize_t batch_pos;   /* current row in the batch */
+  sqlite3_int64 rowid;    /* rows visited since Filter */
 } apsw_vtable_cursor;
 
 static int
@@ -1768,6 +2015,10 @@ apswvtabOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor)
   assert((void *)avc == (void *)&(avc->used_by_sqlite)); /* detect if weird padding happens */
   avc->cursor = res;
   avc->use_no_change = ((apsw_vtable *)pVtab)->use_no_change;
+  if (PyObject_HasAttr(res, apst.NextRows))
+    avc->batch = VTCURSOR_BATCH_ROWS;
+  else if (PyObject_HasAttr(res, apst.NextColumns))
+    avc->batch = VTCURSOR_BATCH_COLUMNS;
   res = NULL;
   *ppCursor = (sqlite3_vtab_cursor *)avc;
   goto finally;
@@ -2277,8 +2528,165 @@ The :class:`VTCursor` object is used for iterating over a table.
 There may be many cursors simultaneously so each one needs to keep
 track of where in the table it is.
 
+Calling :meth:`~VTCursor.Eof`, :meth:`~VTCursor.Column` for each
+column, and :meth:`~VTCursor.Next` means several Python calls for
+every row.  If your cursor has a :meth:`~VTCursor.NextRows` or
+:meth:`~VTCursor.NextColumns` method then it is used instead, with
+each call returning multiple rows.  SQLite's requests for the end of
+data, column values, and moving to the next row are answered from the
+returned rows, only calling your method again once they have all been
+used.
+
+Columns past the end of a provided row (for example `hidden
+<https://sqlite.org/vtab.html#hidden_columns_in_virtual_tables>`__
+columns with the same value for every row) are requested by calling
+:meth:`~VTCursor.Column` as normal.  The rowid is the number of rows
+visited since :meth:`~VTCursor.Filter`, so don't use batches if rowid
+values matter to you, or declare the table ``WITHOUT rowid``.
+
+*/
+
+/** .. method:: NextRows() -> Optional[Sequence[Sequence[SQLiteValue]]]
+
+  Optional.  Returns the next rows, with each row being a sequence of
+  column values.  Return None or an empty sequence when there are no
+  more rows.  It is called after :meth:`~VTCursor.Filter`, and then
+  each time the previous rows have been used.  :meth:`~VTCursor.Eof`,
+  :meth:`~VTCursor.Next` and :meth:`~VTCursor.Rowid` are then not
+  called.
+*/
+
+/** .. method:: NextColumns() -> Optional[Sequence[Sequence[SQLiteValue]]]
+
+  Optional.  Like :meth:`~VTCursor.NextRows` except the result is a
+  sequence of columns, with each column being a sequence of values of
+  the same length such as a :class:`list` or :class:`array.array`.
 */
 
+/* Gets the current batch row's value for ncolumn as a new reference.
+   Returns 1 if found, 0 if it isn't provided by the batch, and -1 on
+   error */
+static int
+apswvtab_batch_value(apsw_vtable_cursor *avc, int ncolumn, PyObject **value)
+{
+  PyObject *seq;
+  Py_ssize_t index, len;
+
+  if (ncolumn < 0)
+    return 0;
+
+  if (avc->batch == VTCURSOR_BATCH_ROWS)
+  {
+    seq = PyTuple_GET_ITEM(avc->batch_data, avc->batch_pos);
+    index = ncolumn;
+  }
+  else
+  {
+    if (ncolumn >= PyTuple_GET_SIZE(avc->batch_data))
+      return 0;
+    seq = PyTuple_GET_ITEM(avc->batch_data, ncolumn);
+    index = avc->batch_pos;
+  }
+
+  if (PyTuple_CheckExact(seq) || PyList_CheckExact(seq))
+  {
+    /* lists are checked every time because they could be changed */
+    if (index >= PySequence_Fast_GET_SIZE(seq))
+      return 0;
+    *value = Py_NewRef(PySequence_Fast_GET_ITEM(seq, index));
+    return 1;
+  }
+
+  len = PySequence_Size(seq);
+  if (len < 0)
+    return -1;
+  if (index >= len)
+    return 0;
+  *value = PySequence_GetItem(seq, index);
+  return *value ? 1 : -1;
+}
+
+/* Replaces the batch with the next one from NextRows or NextColumns.
+   An empty batch means the end of the data.  Returns -1 on error. */
+static int
+apswvtab_next_batch(apsw_vtable_cursor *avc)
+{
+  PyObject *res;
+  Py_ssize_t i;
+
+  Py_CLEAR(avc->batch_data);
+  avc->batch_size = avc->batch_pos = 0;
+
+  PyObject *vargs[] = {NULL, avc->cursor};
+  res = PyObject_VectorcallMethod((avc->batch == VTCURSOR_BATCH_ROWS) ? apst.NextRows : apst.NextColumns, vargs + 1,
+                                  1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+  if (!res)
+    return -1;
+  if (Py_IsNone(res))
+  {
+    Py_DECREF(res);
+    return 0;
+  }
+
+  /* a copy so the Python code can't change the number of items */
+  avc->batch_data = PySequence_Tuple(res);
+  Py_DECREF(res);
+  if (!avc->batch_data)
+    return -1;
+
+  if (avc->batch == VTCURSOR_BATCH_ROWS)
+  {
+    avc->batch_size = PyTuple_GET_SIZE(avc->batch_data);
+    return 0;
+  }
+
+  for (i = 0; i < PyTuple_GET_SIZE(avc->batch_data); i++)
+  {
+    Py_ssize_t len = PySequence_Size(PyTuple_GET_ITEM(avc->batch_data, i));
+    if (len < 0)
+      goto error;
+    if (i && len != avc->batch_size)
+    {
+      PyErr_Format(PyExc_ValueError, "NextColumns column %zd has %zd values but column 0 has %zd", i, len,
+                   avc->batch_size);
+      goto error;
+    }
+    avc->batch_size = len;
+  }
+  return 0;
+
+error:
+  Py_CLEAR(avc->batch_data);
+  avc->batch_size = 0;
+  return -1;
+}
+
+/* Returns idxStr as a new reference to a Python str, reusing the
+   previous one if it is the same.  A query runs Filter with the same
+   idxStr for each row of an outer loop. */
+static PyObject *
+apswvtab_filter_idxstr(apsw_vtable *avi, const char *idxStr)
+{
+  PyObject *res;
+  char *copy;
+
+  if (!idxStr)
+    Py_RETURN_NONE;
+  if (avi->filter_idxStr && 0 == strcmp(avi->filter_idxStr, idxStr))
+    return Py_NewRef(avi->filter_pyidxStr);
+
+  res = convertutf8string(idxStr);
+  copy = res ? sqlite3_mprintf("%s", idxStr) : NULL;
+  if (copy)
+  {
+    sqlite3_free(avi->filter_idxStr);
+    Py_XDECREF(avi->filter_pyidxStr);
+    avi->filter_idxStr = copy;
+    avi->filter_pyidxStr = Py_NewRef(res);
+  }
+  return res;
+}
+
 /** .. method:: Filter(indexnum: int, indexname: str, constraintargs: Optional[tuple]) -> None
 
   This method is always called first to initialize an iteration to the
@@ -2321,13 +2729,22 @@ apswvtabFilter(sqlite3_vtab_cursor *pCursor, int idxNum, const char *idxStr,
     PyTuple_SET_ITEM(argv, i, value);
   }
 
-  PyObject *vargs[] = {NULL, cursor, PyLong_FromLong(idxNum), convertutf8string(idxStr), argv};
+  PyObject *vargs[] = {NULL, cursor, PyLong_FromLong(idxNum), apswvtab_filter_idxstr((apsw_vtable *)pCursor->pVtab, idxStr), argv};
   if (vargs[2] && vargs[3])
     res = PyObject_VectorcallMethod(apst.Filter, vargs + 1, 4 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
   Py_XDECREF(vargs[2]);
   Py_XDECREF(vargs[3]);
   if (res)
-    goto finally; /* result is ignored */
+  {
+    apsw_vtable_cursor *avc = (apsw_vtable_cursor *)pCursor;
+
+    /* result is ignored */
+    if (!avc->batch)
+      goto finally;
+    avc->rowid = 0;
+    if (!apswvtab_next_batch(avc))
+      goto finally;
+  }
 
 pyexception: /* we had an exception in python code */
   assert(PyErr_Occurred());
@@ -2362,6 +2779,9 @@ apswvtabEof(sqlite3_vtab_cursor *pCursor)
   PyGILState_STATE gilstate;
   int sqliteres = 0; /* nb a true/false value not error code */
 
+  if (((apsw_vtable_cursor *)pCursor)->batch)
+    return ((apsw_vtable_cursor *)pCursor)->batch_pos >= ((apsw_vtable_cursor *)pCursor)->batch_size;
+
   gilstate = PyGILState_Ensure();
   cursor = ((apsw_vtable_cursor *)pCursor)->cursor;
 
@@ -2440,11 +2860,20 @@ apswvtabColumn(sqlite3_vtab_cursor *pCursor, sqlite3_context *result, int ncolum
 
   assert(!PyErr_Occurred());
 
-  PyObject *vargs[] = {NULL, cursor, PyLong_FromLong(ncolumn)};
-  if (vargs[2])
+  if (((apsw_vtable_cursor *)pCursor)->batch && !nc)
+  {
+    if (apswvtab_batch_value((apsw_vtable_cursor *)pCursor, ncolumn, &res) < 0)
+      goto pyexception;
+  }
+
+  if (!res)
   {
-    res = PyObject_VectorcallMethod(nc ? apst.ColumnNoChange : apst.Column, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
-    Py_DECREF(vargs[2]);
+    PyObject *vargs[] = {NULL, cursor, PyLong_FromLong(ncolumn)};
+    if (vargs[2])
+    {
+      res = PyObject_VectorcallMethod(nc ? apst.ColumnNoChange : apst.Column, vargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+      Py_DECREF(vargs[2]);
+    }
   }
 
   if (!res)
@@ -2489,14 +2918,30 @@ apswvtabNext(sqlite3_vtab_cursor *pCursor)
   PyObject *cursor, *res = NULL;
   PyGILState_STATE gilstate;
   int sqliteres = SQLITE_OK;
+  apsw_vtable_cursor *avc = (apsw_vtable_cursor *)pCursor;
+
+  if (avc->batch)
+  {
+    avc->rowid++;
+    if (++avc->batch_pos < avc->batch_size)
+      return SQLITE_OK;
+  }
 
   gilstate = PyGILState_Ensure();
 
-  cursor = ((apsw_vtable_cursor *)pCursor)->cursor;
-  PyObject *vargs[] = {NULL, cursor};
-  res = PyObject_VectorcallMethod(apst.Next, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
-  if (res)
-    goto finally;
+  cursor = avc->cursor;
+  if (avc->batch)
+  {
+    if (!apswvtab_next_batch(avc))
+      goto finally;
+  }
+  else
+  {
+    PyObject *vargs[] = {NULL, cursor};
+    res = PyObject_VectorcallMethod(apst.Next, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    if (res)
+      goto finally;
+  }
 
   /* pyexception:  we had an exception in python code */
   assert(PyErr_Occurred());
@@ -2528,6 +2973,7 @@ apswvtabClose(sqlite3_vtab_cursor *pCursor)
   MakeExistingException();
 
   cursor = ((apsw_vtable_cursor *)pCursor)->cursor;
+  Py_CLEAR(((apsw_vtable_cursor *)pCursor)->batch_data);
   PyObject *vargs[] = {NULL, cursor};
   CHAIN_EXC(
       res = PyObject_VectorcallMethod(apst.Close, vargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL));
@@ -2559,6 +3005,12 @@ apswvtabRowid(sqlite3_vtab_cursor *pCursor, sqlite3_int64 *pRowid)
   PyGILState_STATE gilstate;
   int sqliteres = SQLITE_OK;
 
+  if (((apsw_vtable_cursor *)pCursor)->batch)
+  {
+    *pRowid = ((apsw_vtable_cursor *)pCursor)->rowid;
+    return SQLITE_OK;
+  }
+
   gilstate = PyGILState_Ensure();
 
   MakeExistingException();
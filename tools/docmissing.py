@@ -124,7 +124,14 @@ for name, obj in (
                 "Cursor",
                 "Blob",
                 "Backup",
+                "BlobView",
+                "Row",
+                "ConnectionPool",
                 "IndexInfo",
+                "Session",
+                "Changeset",
+                "TableChange",
+                "ChangesetBuilder",
                 "VFSFcntlPragma",
             ):
                 continue
@@ -273,6 +273,7 @@ def analyze_signature(s: str) -> list[dict]:
 
     pos = 1
     nesting = 0
+    in_string = False
     name = ""
     after_name = ""
     skip_to_next = False
@@ -292,6 +293,12 @@ def analyze_signature(s: str) -> list[dict]:
 
     for pos in range(1, len(s) - 1):
         c = s[pos]
+        # string default values can contain commas and brackets
+        if c == '"' or in_string:
+            after_name += c
+            if c == '"':
+                in_string = not in_string
+            continue
         if c in nest_start or nesting:
             after_name += c
             if c in nest_start:
@@ -381,18 +388,65 @@ type_overrides = {
     "Blob.reopen": {
         "rowid": "int64"
     },
+    "Blob.reopen_each": {
+        "rowids": "PyObject"
+    },
+    "Blob.copy_to": {
+        "destination": "PyObject"
+    },
+    "Blob.copy_from": {
+        "source": "PyObject"
+    },
+    "Changeset.__init__": {
+        "changeset": "PyObject"
+    },
+    "Changeset.concat": {
+        "other": "PyObject"
+    },
+    "Changeset.concat_stream": {
+        "other": "PyObject",
+        "output": "Callable[[memoryview], None]"
+    },
+    "Changeset.invert_stream": {
+        "output": "Callable[[memoryview], None]"
+    },
+    "ChangesetBuilder.add": {
+        "changeset": "PyObject"
+    },
+    "ChangesetBuilder.output_stream": {
+        "output": "Callable[[memoryview], None]"
+    },
+    "ConnectionPool.parallel_execute": {
+        "queries": "Iterable"
+    },
     "Connection.blob_open": {
         "rowid": "int64"
     },
+    "Connection.create_aggregate_function": {
+        "arg_types": "PyObject",
+    },
+    "Connection.create_scalar_function": {
+        "arg_types": "PyObject",
+        "return_type": "PyObject",
+    },
     "Connection.drop_modules": {
         "keep": "PyObject"
     },
+    "Connection.export_query": {
+        "destination": "PyObject",
+    },
     "Connection.file_control": {
         "pointer": "pointer"
     },
     "Connection.read": {
         "offset": "int64",
     },
+    "Connection.register_adapter": {
+        "klass": "PyObject",
+    },
+    "Connection.register_converter": {
+        "decltype": "strtype",
+    },
     "Connection.set_last_insert_rowid": {
         "rowid": "int64"
     },
@@ -403,6 +457,12 @@ type_overrides = {
         "statements": "strtype",
         "sequenceofbindings": "Sequence"
     },
+    "Session.changeset_stream": {
+        "output": "Callable[[memoryview], None]"
+    },
+    "Session.patchset_stream": {
+        "output": "Callable[[memoryview], None]"
+    },
     "URIFilename.uri_int": {
         "default": "int64",
     },
@@ -416,6 +476,13 @@ type_overrides = {
     "VFSFile.xRead": {
         "offset": "int64"
     },
+    "VFSFile.xReadBatch": {
+        "reads": "PyObject"
+    },
+    "VFSFile.xReadInto": {
+        "buffer": "PyObject",
+        "offset": "int64"
+    },
     "VFSFile.xTruncate": {
         "newsize": "int64"
     },
@@ -513,6 +580,8 @@ def do_argparse(item):
             if param["default"]:
                 if param["default"] == "None":
                     default_check = f"{ pname } == 0"
+                elif len(param["default"]) > 1 and param["default"][0] == param["default"][-1] == '"':
+                    default_check = f"0 == strcmp({ pname }, { param['default'] })"
                 else:
                     breakpoint()
                     pass
@@ -576,6 +645,7 @@ def do_argparse(item):
                 "Optional[AggregateFactory]",
                 "Optional[Authorizer]",
                 "Optional[CommitHook]",
+                "Optional[UpdateHook]",
                 "Optional[WindowFactory]",
         }:
             # the above are all callables and we don't check beyond that
@@ -877,6 +947,8 @@ if __name__ == '__main__':
                         "Connection.execute",
                         "Connection.executemany",
                         "Blob.__exit__",
+                        "Row.__getattr__",
+                        "Row.__getitem__",
                 }:
                     missing.append(item["name"])
 
@@ -76,7 +76,7 @@ returns = {
     # return a pointer, NULL on failure
     "pointer":
     """
-            convert_value_to_pyobject convert_column_to_pyobject  allocfunccbinfo
+            convert_value_to_pyobject convert_column_to_pyobject convert_row_to_pyobject allocfunccbinfo
             apsw_strdup convertutf8string MakeExistingException get_window_function_context
 
             PyModule_Create2 PyErr_NewExceptionWithDoc PySet_New
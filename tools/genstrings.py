@@ -17,7 +17,8 @@ names = ""
 # virtual table
 names += """
 Begin BestIndex BestIndexObject Close Column ColumnNoChange Commit
-Connect Create Destroy Disconnect Eof Filter FindFunction Next Open
+Connect Create Destroy Disconnect Eof Filter FindFunction Next NextColumns
+NextRows Open
 Release Rename Rollback RollbackTo Rowid Savepoint ShadowName Sync
 UpdateChangeRow UpdateDeleteRow UpdateInsertRow Integrity
 """
@@ -27,7 +28,7 @@ names += """
 xAccess xCheckReservedLock xClose xCurrentTime xCurrentTimeInt64
 xDeviceCharacteristics xFileControl xFileSize xGetLastError
 xGetSystemCall xDelete xDlClose xDlError xDlOpen xDlSym xFullPathname
-xLock xNextSystemCall xOpen xRandomness xRead xSectorSize
+xLock xMmap xNextSystemCall xOpen xRandomness xRead xReadBatch xReadInto xSectorSize
 xSetSystemCall xSleep xSync xTruncate xUnlock xWrite
 """
 
@@ -35,9 +36,10 @@ xSetSystemCall xSleep xSync xTruncate xUnlock xWrite
 names +="""
 close connection_hooks cursor error_offset excepthook execute
 executemany extendedresult get Mapping result add_note
-can_cache
+can_cache array frombytes release
 
-step final value inverse
+step step_batch final value inverse
+readinto write
 
 NULL 0.0 -1e999 1e999
 (closed)
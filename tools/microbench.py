@@ -0,0 +1,425 @@
+#!/usr/bin/env python3
+
+# Micro benchmarks of individual C code paths.  Unlike apsw.speedtest
+# which measures whole workloads, each benchmark here does the minimum
+# around one path so changes to it show up clearly.
+#
+# Results can be saved as JSON and compared against a saved baseline,
+# and each benchmark can be run under "perf stat" to get hardware
+# counters.
+
+from __future__ import annotations
+
+import argparse
+import json
+import os
+import platform
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from typing import Callable
+
+import apsw
+
+# name -> (description, setup function returning (op, values per op))
+benchmarks: dict[str, tuple[str, Callable[[], tuple[Callable[[], None], int]]]] = {}
+
+
+def benchmark(name: str, description: str):
+    "Registers a benchmark"
+
+    def register(setup):
+        assert name not in benchmarks
+        benchmarks[name] = (description, setup)
+        return setup
+
+    return register
+
+
+# the values each type benchmark uses
+type_values = {
+    "int": 123456789,
+    "float": 3.14159,
+    "str": "hello world " * 4,
+    "bytes": b"\x01\x02\x03" * 16,
+    "null": None,
+}
+
+ROWS = 1000
+
+
+def table_of(con: apsw.Connection, value) -> None:
+    con.execute("create table t(x)")
+    con.executemany("insert into t values(?)", ((value, ) for _ in range(ROWS)))
+
+
+@benchmark("statementcache_hit", "Execute the same query so the prepared statement is reused")
+def setup_statementcache_hit():
+    con = apsw.Connection("")
+    sql = "select 1"
+
+    def op():
+        con.execute(sql)
+
+    return op, 1
+
+
+@benchmark("statementcache_miss", "Execute queries not in the statement cache")
+def setup_statementcache_miss():
+    con = apsw.Connection("")
+    # more distinct queries than the cache holds
+    queries = [f"select { i }" for i in range(1000)]
+    position = 0
+
+    def op():
+        nonlocal position
+        con.execute(queries[position])
+        position = (position + 1) % len(queries)
+
+    return op, 1
+
+
+def setup_binding(value):
+    con = apsw.Connection("")
+    count = 64
+    # the where clause is never true so only binding is measured
+    sql = "select 1 where 0 and coalesce(" + ", ".join("?" * count) + ")"
+    bindings = (value, ) * count
+
+    def op():
+        con.execute(sql, bindings)
+
+    return op, count
+
+
+def setup_column(value):
+    con = apsw.Connection("")
+    table_of(con, value)
+    sql = "select x from t"
+
+    def op():
+        for _ in con.execute(sql):
+            pass
+
+    return op, ROWS
+
+
+for kind, value in type_values.items():
+    benchmark(f"bind_{ kind }", f"Bind a { kind } value")(lambda value=value: setup_binding(value))
+    benchmark(f"column_{ kind }", f"Convert a { kind } column value to Python")(lambda value=value: setup_column(value))
+
+
+@benchmark("udf_scalar", "Call a Python scalar function")
+def setup_udf_scalar():
+    con = apsw.Connection("")
+    table_of(con, 1)
+    con.create_scalar_function("f", lambda x: x, 1, deterministic=True)
+    sql = "select f(x) from t"
+
+    def op():
+        for _ in con.execute(sql):
+            pass
+
+    return op, ROWS
+
+
+@benchmark("udf_aggregate", "Call a Python aggregate function step")
+def setup_udf_aggregate():
+    con = apsw.Connection("")
+    table_of(con, 1)
+
+    class Sum:
+
+        def __init__(self):
+            self.total = 0
+
+        def step(self, x):
+            self.total += x
+
+        def final(self):
+            return self.total
+
+    con.create_aggregate_function("f", Sum)
+    sql = "select f(x) from t"
+
+    def op():
+        con.execute(sql).get
+
+    return op, ROWS
+
+
+@benchmark("udf_window", "Call Python window function step, inverse and value")
+def setup_udf_window():
+    con = apsw.Connection("")
+    table_of(con, 1)
+
+    class Window:
+
+        def __init__(self):
+            self.total = 0
+
+        def step(self, x):
+            self.total += x
+
+        def inverse(self, x):
+            self.total -= x
+
+        def value(self):
+            return self.total
+
+        def final(self):
+            return self.total
+
+    con.create_window_function("f", Window)
+    sql = "select f(x) over (rows between 1 preceding and 1 following) from t"
+
+    def op():
+        for _ in con.execute(sql):
+            pass
+
+    return op, ROWS
+
+
+class PassThroughVFS(apsw.VFS):
+    "Inherits everything so all file calls go through the Python shims"
+
+    def __init__(self):
+        super().__init__("microbench", "")
+
+    def xOpen(self, name, flags):
+        return apsw.VFSFile("", name, flags)
+
+
+def setup_vfs(use_python: bool, write: bool):
+    vfs = PassThroughVFS() if use_python else None
+    directory = tempfile.mkdtemp(prefix="microbench")
+    filename = os.path.join(directory, "db")
+    con = apsw.Connection(filename, vfs="microbench" if use_python else None)
+    con.execute("pragma page_size=4096; pragma cache_size=1; pragma mmap_size=0; pragma journal_mode=off")
+    pages = 256
+    con.execute(
+        "create table t(x); with recursive c(n) as (select 1 union all select n + 1 from c where n < ?)"
+        " insert into t select zeroblob(3000) from c", (pages, ))
+
+    if write:
+        sql = "update t set x=zeroblob(3000)"
+    else:
+        sql = "select length(x) from t"
+
+    def op():
+        for _ in con.execute(sql):
+            pass
+
+    # keep objects alive, and clean up at exit
+    op.keep = (vfs, con, directory)  # type: ignore[attr-defined]
+    cleanup.append(lambda: (con.close(), shutil.rmtree(directory, ignore_errors=True)))
+    return op, pages
+
+
+cleanup: list[Callable[[], None]] = []
+
+for python in (False, True):
+    for write in (False, True):
+        name = f"vfs_{ 'write' if write else 'read' }_{ 'python' if python else 'native' }"
+        benchmark(name, f"Page { 'writes' if write else 'reads' } through { 'a Python' if python else 'the default' } VFS")(
+            lambda python=python, write=write: setup_vfs(python, write))
+
+
+def setup_blob(kind: str):
+    con = apsw.Connection("")
+    size = 1024 * 1024
+    chunk = 4096
+    con.execute("create table t(x); insert into t values(zeroblob(?))", (size, ))
+    blob = con.blob_open("main", "t", "x", 1, kind == "write")
+    buffer = bytearray(chunk)
+    data = b"\xaa" * chunk
+
+    if kind == "read":
+
+        def op():
+            blob.seek(0)
+            while blob.read(chunk):
+                pass
+    elif kind == "read_into":
+
+        def op():
+            blob.seek(0)
+            for _ in range(size // chunk):
+                blob.read_into(buffer)
+    else:
+
+        def op():
+            blob.seek(0)
+            for _ in range(size // chunk):
+                blob.write(data)
+
+    return op, size // chunk
+
+
+for kind in ("read", "read_into", "write"):
+    benchmark(f"blob_{ kind }", f"Blob { kind } in 4kb chunks")(lambda kind=kind: setup_blob(kind))
+
+
+def run(name: str, rounds: int, round_time: float) -> dict:
+    "Runs one benchmark returning its results"
+    op, values = benchmarks[name][1]()
+
+    # calibrate how many calls make up a round
+    number = 1
+    while True:
+        start = time.perf_counter()
+        for _ in range(number):
+            op()
+        elapsed = time.perf_counter() - start
+        if elapsed >= round_time / 10:
+            break
+        number *= 2
+    number = max(1, int(number * round_time / max(elapsed, 1e-9)))
+
+    per_value: list[float] = []
+    for _ in range(rounds):
+        start = time.perf_counter()
+        for _ in range(number):
+            op()
+        per_value.append((time.perf_counter() - start) / number / values * 1e9)
+
+    return {
+        "ns_per_value": statistics.median(per_value),
+        "min": min(per_value),
+        "stdev": statistics.stdev(per_value) if len(per_value) > 1 else 0.0,
+        "values_per_op": values,
+        "ops_per_round": number,
+        "rounds": rounds,
+    }
+
+
+perf_events = "cycles,instructions,branch-misses,cache-misses"
+
+
+def run_perf(name: str, options: argparse.Namespace) -> dict:
+    "Runs one benchmark in a child process under perf stat"
+    with tempfile.NamedTemporaryFile(suffix=".json") as output:
+        cmd = [
+            "perf", "stat", "-x", ",", "-e", perf_events, sys.executable, os.path.abspath(__file__), "--run-one", name,
+            "--rounds",
+            str(options.rounds), "--round-time",
+            str(options.round_time), "--output", output.name
+        ]
+        proc = subprocess.run(cmd, capture_output=True, text=True)
+        if proc.returncode:
+            sys.exit(f"perf stat failed for { name }\n{ proc.stderr }")
+        result = json.load(open(output.name))["benchmarks"][name]
+
+    # the counters cover the whole child process including setup
+    counters: dict[str, int | None] = {}
+    for line in proc.stderr.splitlines():
+        fields = line.split(",")
+        if len(fields) < 3:
+            continue
+        # hybrid processors report each core type as cpu_core/cycles/ etc
+        event = fields[2].strip("/").split("/")[-1]
+        if event not in perf_events.split(","):
+            continue
+        try:
+            counters[event] = (counters.get(event) or 0) + int(fields[0])
+        except ValueError:
+            # <not supported> or <not counted>
+            counters.setdefault(event, None)
+    result["perf"] = counters
+    return result
+
+
+def compare(results: dict, baseline: dict, threshold: float) -> int:
+    "Prints comparison returning how many benchmarks regressed"
+    regressions = 0
+    print(f"\n{ 'benchmark':24}{ 'baseline':>12}{ 'now':>12}{ 'change':>10}")
+    for name, now in results["benchmarks"].items():
+        if name not in baseline["benchmarks"]:
+            print(f"{ name:24}{ '-':>12}{ now['ns_per_value']:12.1f}{ 'new':>10}")
+            continue
+        before = baseline["benchmarks"][name]["ns_per_value"]
+        change = (now["ns_per_value"] - before) / before * 100
+        flag = ""
+        if change > threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{ name:24}{ before:12.1f}{ now['ns_per_value']:12.1f}{ change:+9.1f}%{ flag }")
+    return regressions
+
+
+parser = argparse.ArgumentParser(description="Micro benchmarks of APSW C code paths")
+parser.add_argument("--list", action="store_true", help="List the benchmarks and exit")
+parser.add_argument("--filter", help="Only run benchmarks whose name matches this regular expression")
+parser.add_argument("--rounds", type=int, default=7, help="Timed rounds per benchmark [%(default)s]")
+parser.add_argument("--round-time",
+                    type=float,
+                    default=0.1,
+                    help="Approximate seconds each round takes [%(default)s]")
+parser.add_argument("--output", help="Write results as JSON to this file")
+parser.add_argument("--compare", metavar="BASELINE", help="Compare against results previously saved with --output")
+parser.add_argument("--threshold",
+                    type=float,
+                    default=5.0,
+                    help="Percentage slower than the baseline counted as a regression [%(default)s]")
+parser.add_argument("--perf",
+                    action="store_true",
+                    help="Run each benchmark in its own process under perf stat recording " + perf_events)
+parser.add_argument("--run-one", help=argparse.SUPPRESS)
+
+options = parser.parse_args()
+
+if options.list:
+    for name, (description, _) in benchmarks.items():
+        print(f"{ name:24}{ description }")
+    sys.exit(0)
+
+if options.run_one:
+    names = [options.run_one]
+else:
+    names = [name for name in benchmarks if not options.filter or re.search(options.filter, name)]
+    if not names:
+        sys.exit("No benchmarks match the filter")
+
+if options.perf and not shutil.which("perf"):
+    sys.exit("perf is not available")
+
+results = {
+    "apsw_version": apsw.apsw_version(),
+    "sqlite_version": apsw.sqlite_lib_version(),
+    "python": sys.version,
+    "platform": platform.platform(),
+    "benchmarks": {},
+}
+
+try:
+    if not options.run_one:
+        print(f"{ 'benchmark':24}{ 'ns/value':>12}{ 'min':>12}{ 'stdev':>10}")
+    for name in names:
+        if options.perf:
+            result = run_perf(name, options)
+        else:
+            result = run(name, options.rounds, options.round_time)
+        results["benchmarks"][name] = result
+        if not options.run_one:
+            print(f"{ name:24}{ result['ns_per_value']:12.1f}{ result['min']:12.1f}{ result['stdev']:10.1f}",
+                  end="")
+            if "perf" in result:
+                print("  ", " ".join(f"{ k }={ v }" for k, v in result["perf"].items()), end="")
+            print(flush=True)
+finally:
+    for c in cleanup:
+        c()
+
+if options.output:
+    with open(options.output, "w") as f:
+        json.dump(results, f, indent=2)
+
+if options.compare:
+    with open(options.compare) as f:
+        baseline = json.load(f)
+    if compare(results, baseline, options.threshold):
+        sys.exit(1)